@@ -33,6 +33,7 @@
 #include "KoCanvasObserverBase.h"
 #include "KoCanvasSupervisor.h"
 #include "KoToolManager_p.h"
+#include "KoShapeManager.h"
 
 #include <FlakeDebug.h>
 #include <QMouseEvent>
@@ -169,6 +170,12 @@ void KoCanvasControllerWidget::Private::unsetCanvas()
     }
 }
 
+void KoCanvasControllerWidget::Private::beginInteraction()
+{
+    if (canvas && canvas->shapeManager())
+        canvas->shapeManager()->beginInteraction();
+}
+
 ////////////
 KoCanvasControllerWidget::KoCanvasControllerWidget(KActionCollection * actionCollection, QWidget *parent)
     : QAbstractScrollArea(parent)
@@ -199,6 +206,9 @@ KoCanvasControllerWidget::KoCanvasControllerWidget(KActionCollection * actionCol
 
     connect(horizontalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateCanvasOffsetX()));
     connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateCanvasOffsetY()));
+    // only scrolling by the user paints drafts, not moving the document offset from code
+    connect(horizontalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(beginInteraction()));
+    connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(beginInteraction()));
     connect(d->viewportWidget, SIGNAL(sizeChanged()), this, SLOT(updateCanvasOffsetX()));
     connect(proxyObject, SIGNAL(moveDocumentOffset(QPoint)), d->viewportWidget, SLOT(documentOffsetMoved(QPoint)));
 }
@@ -438,6 +448,7 @@ void KoCanvasControllerWidget::zoomBy(const QPoint &center, qreal zoom)
     setPreferredCenterFractionX(1.0 * center.x() / documentSize().width());
     setPreferredCenterFractionY(1.0 * center.y() / documentSize().height());
 
+    d->beginInteraction();
     const bool oldIgnoreScrollSignals = d->ignoreScrollSignals;
     d->ignoreScrollSignals = true;
     proxyObject->emitZoomRelative(zoom, preferredCenter());
@@ -499,6 +510,7 @@ void KoCanvasControllerWidget::setVastScrolling(qreal factor)
 void KoCanvasControllerWidget::pan(const QPoint &distance)
 {
     QPoint sourcePoint = scrollBarValue();
+    d->beginInteraction();
     setScrollBarValue(sourcePoint + distance);
 }
 
@@ -564,6 +576,7 @@ void KoCanvasControllerWidget::zoomRelativeToPoint(const QPoint &widgetPoint, qr
     const QPoint offset = scrollBarValue();
     const QPoint mousePos(widgetPoint + offset);
 
+    d->beginInteraction();
     const bool oldIgnoreScrollSignals = d->ignoreScrollSignals;
     d->ignoreScrollSignals = true;
     proxyObject->emitZoomRelative(zoomCoeff, mousePos);
@@ -189,6 +189,7 @@ protected:
 
 private:
     Q_PRIVATE_SLOT(d, void activate())
+    Q_PRIVATE_SLOT(d, void beginInteraction())
 
     Private * const d;
 };
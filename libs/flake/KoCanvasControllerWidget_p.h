@@ -69,6 +69,9 @@ public:
     void activate();
     void unsetCanvas();
 
+    /// lets the shapes of the canvas paint drafts until the user stops zooming or panning
+    void beginInteraction();
+
     KoCanvasControllerWidget *q;
     KoCanvasBase *canvas;
     Viewport *viewportWidget;
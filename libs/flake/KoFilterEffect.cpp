@@ -24,6 +24,10 @@
 #include <QImage>
 #include <QString>
 #include <QRectF>
+#include <QAtomicInt>
+
+// shared by all effects and stacks, so no two changes get the same version
+static QAtomicInt s_lastVersion;
 
 class Q_DECL_HIDDEN KoFilterEffect::Private
 {
@@ -31,6 +35,7 @@ public:
     Private()
         : filterRect(0, 0, 1, 1)
         , requiredInputCount(1), maximalInputCount(1)
+        , version(0)
     {
         // add the default input
         inputs.append(QString());
@@ -43,6 +48,7 @@ public:
     QString output;
     int requiredInputCount;
     int maximalInputCount;
+    uint version;
 };
 
 KoFilterEffect::KoFilterEffect(const QString &id, const QString &name)
@@ -70,6 +76,7 @@ QString KoFilterEffect::id() const
 void KoFilterEffect::setFilterRect(const QRectF &filterRect)
 {
     d->filterRect = filterRect;
+    parametersChanged();
 }
 
 QRectF KoFilterEffect::filterRect() const
@@ -93,31 +100,40 @@ QList<QString> KoFilterEffect::inputs() const
 
 void KoFilterEffect::addInput(const QString &input)
 {
-    if (d->inputs.count() < d->maximalInputCount)
+    if (d->inputs.count() < d->maximalInputCount) {
         d->inputs.append(input);
+        parametersChanged();
+    }
 }
 
 void KoFilterEffect::insertInput(int index, const QString &input)
 {
-    if (d->inputs.count() < d->maximalInputCount)
+    if (d->inputs.count() < d->maximalInputCount) {
         d->inputs.insert(index, input);
+        parametersChanged();
+    }
 }
 
 void KoFilterEffect::setInput(int index, const QString &input)
 {
-    if (index < d->inputs.count())
+    if (index < d->inputs.count()) {
         d->inputs[index] = input;
+        parametersChanged();
+    }
 }
 
 void KoFilterEffect::removeInput(int index)
 {
-    if (d->inputs.count() > d->requiredInputCount)
+    if (d->inputs.count() > d->requiredInputCount) {
         d->inputs.removeAt(index);
+        parametersChanged();
+    }
 }
 
 void KoFilterEffect::setOutput(const QString &output)
 {
     d->output = output;
+    parametersChanged();
 }
 
 QString KoFilterEffect::output() const
@@ -125,6 +141,16 @@ QString KoFilterEffect::output() const
     return d->output;
 }
 
+uint KoFilterEffect::version() const
+{
+    return d->version;
+}
+
+uint KoFilterEffect::nextVersion()
+{
+    return uint(s_lastVersion.fetchAndAddOrdered(1)) + 1;
+}
+
 int KoFilterEffect::requiredInputCount() const
 {
     return d->requiredInputCount;
@@ -155,6 +181,11 @@ void KoFilterEffect::save(KoXmlWriter &/*writer*/)
 {
 }
 
+void KoFilterEffect::parametersChanged()
+{
+    d->version = nextVersion();
+}
+
 void KoFilterEffect::setRequiredInputCount(int count)
 {
     d->requiredInputCount = qMax(0, count);
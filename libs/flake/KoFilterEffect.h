@@ -118,6 +118,12 @@ public:
      */
     int maximalInputCount() const;
 
+    /**
+     * Returns a number that changes whenever a parameter of the effect changes.
+     * It is never the same after two changes, not even of different effects.
+     */
+    uint version() const;
+
     /**
      * Apply the effect on an image.
      * @param image the image the filter should be applied to
@@ -147,6 +153,9 @@ public:
     virtual void save(KoXmlWriter &writer);
 
 protected:
+    /// Derived classes call this from the setters of their parameters
+    void parametersChanged();
+
     /// Sets the required number of input images
     void setRequiredInputCount(int count);
 
@@ -163,6 +172,10 @@ protected:
     void saveCommonAttributes(KoXmlWriter &writer);
 
 private:
+    friend class KoFilterEffectStack;
+    /// @return a version no effect or stack had before
+    static uint nextVersion();
+
     class Private;
     Private* const d;
 };
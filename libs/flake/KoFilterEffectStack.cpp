@@ -19,10 +19,17 @@
 
 #include "KoFilterEffectStack.h"
 #include "KoFilterEffect.h"
+#include "KoFilterEffectRenderContext.h"
+#include "KoViewConverter.h"
+#include "KoFilterEffectRegistry.h"
+#include "KoFilterEffectLoadingContext.h"
 #include "KoXmlWriter.h"
+#include "KoXmlReader.h"
 
+#include <QBuffer>
 #include <QRectF>
 #include <QAtomicInt>
+#include <QMutex>
 #include <QSet>
 #include <QDebug>
 
@@ -31,6 +38,7 @@ class Q_DECL_HIDDEN KoFilterEffectStack::Private
 public:
     Private()
     : clipRect(-0.1, -0.1, 1.2, 1.2) // initialize as per svg spec
+    , version(0)
     {
     }
 
@@ -42,6 +50,9 @@ public:
     QList<KoFilterEffect*> filterEffects;
     QRectF clipRect;
     QAtomicInt refCount;
+    uint version;
+    // held while the effects are applied, which can happen in another thread
+    mutable QMutex mutex;
 };
 
 KoFilterEffectStack::KoFilterEffectStack()
@@ -66,14 +77,20 @@ bool KoFilterEffectStack::isEmpty() const
 
 void KoFilterEffectStack::insertFilterEffect(int index, KoFilterEffect * filter)
 {
-    if (filter)
+    if (filter) {
+        QMutexLocker locker(&d->mutex);
         d->filterEffects.insert(index, filter);
+        d->version = KoFilterEffect::nextVersion();
+    }
 }
 
 void KoFilterEffectStack::appendFilterEffect(KoFilterEffect *filter)
 {
-    if (filter)
+    if (filter) {
+        QMutexLocker locker(&d->mutex);
         d->filterEffects.append(filter);
+        d->version = KoFilterEffect::nextVersion();
+    }
 }
 
 void KoFilterEffectStack::removeFilterEffect(int index)
@@ -86,12 +103,16 @@ KoFilterEffect* KoFilterEffectStack::takeFilterEffect(int index)
 {
     if (index >= d->filterEffects.size())
         return 0;
+    QMutexLocker locker(&d->mutex);
+    d->version = KoFilterEffect::nextVersion();
     return d->filterEffects.takeAt(index);
 }
 
 void KoFilterEffectStack::setClipRect(const QRectF &clipRect)
 {
+    QMutexLocker locker(&d->mutex);
     d->clipRect = clipRect;
+    d->version = KoFilterEffect::nextVersion();
 }
 
 QRectF KoFilterEffectStack::clipRect() const
@@ -108,6 +129,113 @@ QRectF KoFilterEffectStack::clipRectForBoundingRect(const QRectF &boundingRect)
     return QRectF(x, y, w, h);
 }
 
+uint KoFilterEffectStack::version() const
+{
+    // the versions all come from one counter, so the latest change has the highest
+    uint version = d->version;
+    foreach (const KoFilterEffect *effect, d->filterEffects) {
+        version = qMax(version, effect->version());
+    }
+    return version;
+}
+
+QImage KoFilterEffectStack::applyFilterEffects(const QHash<QString, QImage> &inputs, const QRectF &shapeBound,
+                                               const KoViewConverter &converter) const
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->filterEffects.isEmpty())
+        return QImage();
+
+    const QRect imageRect = inputs.value(QString()).rect();
+    // determine the offset of the clipping rect from the shapes origin
+    const QPointF clippingOffset = converter.documentToView(clipRectForBoundingRect(shapeBound)).topLeft();
+
+    QHash<QString, QImage> imageBuffers = inputs;
+
+    KoFilterEffectRenderContext renderContext(converter);
+    renderContext.setShapeBoundingBox(shapeBound);
+
+    QImage result;
+    // Filter
+    foreach (KoFilterEffect *filterEffect, d->filterEffects) {
+        QRectF filterRegion = filterEffect->filterRectForBoundingRect(shapeBound);
+        filterRegion = converter.documentToView(filterRegion);
+        QRect subRegion = filterRegion.translated(-clippingOffset).toRect();
+        // set current filter region
+        renderContext.setFilterRegion(subRegion & imageRect);
+
+        if (filterEffect->maximalInputCount() <= 1) {
+            QList<QString> inputs = filterEffect->inputs();
+            QString input = inputs.count() ? inputs.first() : QString();
+            // get input image from image buffers and apply the filter effect
+            QImage image = imageBuffers.value(input);
+            if (!image.isNull()) {
+                result = filterEffect->processImage(imageBuffers.value(input), renderContext);
+            }
+        } else {
+            QVector<QImage> inputImages;
+            foreach(const QString &input, filterEffect->inputs()) {
+                QImage image = imageBuffers.value(input);
+                if (!image.isNull())
+                    inputImages.append(imageBuffers.value(input));
+            }
+            // apply the filter effect
+            if (filterEffect->inputs().count() == inputImages.count())
+                result = filterEffect->processImages(inputImages, renderContext);
+        }
+        // store result of effect
+        imageBuffers.insert(filterEffect->output(), result);
+    }
+
+    return imageBuffers.value(d->filterEffects.last()->output());
+}
+
+KoFilterEffectStack *KoFilterEffectStack::clone() const
+{
+    // the effects are copied by saving and loading them again
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    KoXmlWriter writer(&buffer);
+    writer.startElement("filter");
+    {
+        QMutexLocker locker(&d->mutex);
+        foreach (KoFilterEffect *effect, d->filterEffects) {
+            effect->save(writer);
+        }
+    }
+    writer.endElement();
+    buffer.close();
+
+    KoXmlDocument document;
+    if (!document.setContent(buffer.data())) {
+        return 0;
+    }
+
+    KoFilterEffectStack *stack = new KoFilterEffectStack();
+    stack->setClipRect(d->clipRect);
+    KoFilterEffectLoadingContext context(QString(""));
+    KoFilterEffectRegistry *registry = KoFilterEffectRegistry::instance();
+    const KoXmlElement filter = document.documentElement();
+    for (KoXmlNode n = filter.firstChild(); !n.isNull(); n = n.nextSibling()) {
+        KoXmlElement primitive = n.toElement();
+        KoFilterEffect *filterEffect = registry->createFilterEffectFromXml(primitive, context);
+        if (!filterEffect) {
+            delete stack;
+            return 0;
+        }
+        // the common attributes are not loaded by the effects themselves
+        const QRectF subRegion(primitive.attribute("x").toDouble(), primitive.attribute("y").toDouble(),
+                               primitive.attribute("width").toDouble(), primitive.attribute("height").toDouble());
+        if (primitive.hasAttribute("in"))
+            filterEffect->setInput(0, primitive.attribute("in"));
+        if (primitive.hasAttribute("result"))
+            filterEffect->setOutput(primitive.attribute("result"));
+        filterEffect->setFilterRect(subRegion);
+        stack->appendFilterEffect(filterEffect);
+    }
+    return stack;
+}
+
 bool KoFilterEffectStack::ref()
 {
     return d->refCount.ref();
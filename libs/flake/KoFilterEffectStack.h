@@ -23,8 +23,11 @@
 #include "flake_export.h"
 
 #include <QList>
+#include <QHash>
+#include <QImage>
 
 class KoFilterEffect;
+class KoViewConverter;
 class KoXmlWriter;
 
 class QRectF;
@@ -96,6 +99,37 @@ public:
     /// Returns the clipping rectangle for the given bounding rect
     QRectF clipRectForBoundingRect(const QRectF &boundingRect) const;
 
+    /**
+     * Returns a number that changes whenever filter effects are added to or
+     * removed from the stack, the clipping rectangle changes or a parameter
+     * of one of the filter effects changes.
+     */
+    uint version() const;
+
+    /**
+     * Applies the filter effects one after the other and returns the image
+     * of the last one.
+     *
+     * This may be called from another thread than the one changing the
+     * stack; adding or removing filter effects waits until it is done.
+     *
+     * @param inputs the images of the standard inputs the filter effects
+     *   require, by name, with the source graphic also under the empty name.
+     *   They cover the clipping rectangle of @p shapeBound in view coordinates.
+     * @param shapeBound the bounding box of the shape in shape coordinates
+     * @param converter the converter the inputs were painted with
+     */
+    QImage applyFilterEffects(const QHash<QString, QImage> &inputs, const QRectF &shapeBound,
+                              const KoViewConverter &converter) const;
+
+    /**
+     * Creates a copy of the stack with copies of all filter effects, which
+     * can be applied in another thread while this stack is edited.
+     *
+     * @return the copy, or 0 if one of the effects could not be copied
+     */
+    KoFilterEffectStack *clone() const;
+
     /**
      * Increments the use-value.
      * Returns true if the new value is non-zero, false otherwise.
@@ -0,0 +1,241 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "KoImageCache.h"
+
+#include <QHash>
+#include <QMutex>
+
+/// the default of KoImageCache::memoryLimit()
+#define DEFAULT_IMAGE_CACHE_LIMIT (256 * 1024 * 1024)
+
+namespace {
+    struct CacheKey {
+        CacheKey(qint64 imageKey, const QSize &size, QImage::Format format)
+            : imageKey(imageKey), size(size), format(format) {}
+
+        bool operator==(const CacheKey &other) const {
+            return imageKey == other.imageKey && size == other.size && format == other.format;
+        }
+
+        qint64 imageKey;
+        QSize size;
+        QImage::Format format;
+    };
+
+    uint qHash(const CacheKey &key, uint seed = 0)
+    {
+        return ::qHash(key.imageKey, seed) ^ ::qHash((key.size.width() << 16) ^ key.size.height(), seed)
+            ^ uint(key.format);
+    }
+
+    /// an image in the cache, linked in the order of use
+    struct CacheEntry {
+        CacheEntry(const CacheKey &key, const QImage &image)
+            : key(key), image(image), previous(0), next(0) {}
+
+        CacheKey key;
+        QImage image;
+        CacheEntry *previous; // used more recently
+        CacheEntry *next;     // used less recently
+    };
+}
+
+Q_GLOBAL_STATIC(KoImageCache, s_imageCache)
+
+KoImageCache::Statistics::Statistics()
+    : hits(0),
+    misses(0),
+    insertions(0),
+    evictions(0),
+    memoryUsage(0),
+    count(0)
+{
+}
+
+class Q_DECL_HIDDEN KoImageCache::Private
+{
+public:
+    Private()
+        : mostRecent(0),
+        leastRecent(0),
+        memoryUsage(0),
+        memoryLimit(DEFAULT_IMAGE_CACHE_LIMIT)
+    {
+    }
+
+    ~Private()
+    {
+        qDeleteAll(entries);
+    }
+
+    void unlink(CacheEntry *entry)
+    {
+        if (entry->previous)
+            entry->previous->next = entry->next;
+        else
+            mostRecent = entry->next;
+        if (entry->next)
+            entry->next->previous = entry->previous;
+        else
+            leastRecent = entry->previous;
+        entry->previous = entry->next = 0;
+    }
+
+    void linkFirst(CacheEntry *entry)
+    {
+        entry->next = mostRecent;
+        if (mostRecent)
+            mostRecent->previous = entry;
+        mostRecent = entry;
+        if (!leastRecent)
+            leastRecent = entry;
+    }
+
+    void removeEntry(CacheEntry *entry)
+    {
+        unlink(entry);
+        entries.remove(entry->key);
+        memoryUsage -= entry->image.byteCount();
+        delete entry;
+    }
+
+    /// drops the least recently used images until the memory usage fits into the limit
+    void evict()
+    {
+        while (leastRecent && memoryUsage > memoryLimit) {
+            removeEntry(leastRecent);
+            ++statistics.evictions;
+        }
+    }
+
+    mutable QMutex mutex;
+    QHash<CacheKey, CacheEntry*> entries;
+    CacheEntry *mostRecent;
+    CacheEntry *leastRecent;
+    qint64 memoryUsage;
+    qint64 memoryLimit;
+    Statistics statistics;
+};
+
+KoImageCache *KoImageCache::instance()
+{
+    return s_imageCache();
+}
+
+KoImageCache::KoImageCache()
+    : d(new Private())
+{
+}
+
+KoImageCache::~KoImageCache()
+{
+    delete d;
+}
+
+QImage KoImageCache::find(qint64 imageKey, const QSize &size, QImage::Format format)
+{
+    QMutexLocker locker(&d->mutex);
+    CacheEntry *entry = d->entries.value(CacheKey(imageKey, size, format));
+    if (!entry) {
+        ++d->statistics.misses;
+        return QImage();
+    }
+    ++d->statistics.hits;
+    if (entry != d->mostRecent) {
+        d->unlink(entry);
+        d->linkFirst(entry);
+    }
+    return entry->image;
+}
+
+bool KoImageCache::contains(qint64 imageKey, const QSize &size, QImage::Format format) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entries.contains(CacheKey(imageKey, size, format));
+}
+
+void KoImageCache::insert(qint64 imageKey, const QImage &image)
+{
+    if (image.isNull())
+        return;
+
+    const CacheKey key(imageKey, image.size(), image.format());
+    QMutexLocker locker(&d->mutex);
+    CacheEntry *entry = d->entries.value(key);
+    if (entry)
+        d->removeEntry(entry);
+    if (image.byteCount() > d->memoryLimit)
+        return;
+
+    entry = new CacheEntry(key, image);
+    d->entries.insert(key, entry);
+    d->linkFirst(entry);
+    d->memoryUsage += image.byteCount();
+    ++d->statistics.insertions;
+    d->evict();
+}
+
+void KoImageCache::remove(qint64 imageKey)
+{
+    QMutexLocker locker(&d->mutex);
+    CacheEntry *entry = d->mostRecent;
+    while (entry) {
+        CacheEntry *next = entry->next;
+        if (entry->key.imageKey == imageKey)
+            d->removeEntry(entry);
+        entry = next;
+    }
+}
+
+void KoImageCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    qDeleteAll(d->entries);
+    d->entries.clear();
+    d->mostRecent = d->leastRecent = 0;
+    d->memoryUsage = 0;
+}
+
+void KoImageCache::setMemoryLimit(qint64 bytes)
+{
+    QMutexLocker locker(&d->mutex);
+    d->memoryLimit = qMax<qint64>(0, bytes);
+    d->evict();
+}
+
+qint64 KoImageCache::memoryLimit() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->memoryLimit;
+}
+
+KoImageCache::Statistics KoImageCache::statistics() const
+{
+    QMutexLocker locker(&d->mutex);
+    Statistics statistics = d->statistics;
+    statistics.memoryUsage = d->memoryUsage;
+    statistics.count = d->entries.count();
+    return statistics;
+}
+
+void KoImageCache::resetStatistics()
+{
+    QMutexLocker locker(&d->mutex);
+    d->statistics = Statistics();
+}
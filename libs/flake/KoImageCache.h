@@ -0,0 +1,94 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOIMAGECACHE_H
+#define KOIMAGECACHE_H
+
+#include "flake_export.h"
+
+#include <QImage>
+
+/**
+ * A process wide cache of decoded images.
+ *
+ * The decoded image data of all KoImageData objects, in all image collections,
+ * goes here: the decoded images themselves and their scaled variants. An entry
+ * is found by the key of the image data together with the size and the format
+ * of the variant. The cache holds at most memoryLimit() bytes; when it gets
+ * full the entries that were not used for the longest time are dropped.
+ *
+ * All methods are thread safe.
+ */
+class FLAKE_EXPORT KoImageCache
+{
+public:
+    /// Counters of the cache, see statistics()
+    struct Statistics {
+        Statistics();
+
+        qint64 hits;        ///< find() calls that returned an image
+        qint64 misses;      ///< find() calls that returned a null image
+        qint64 insertions;  ///< images inserted
+        qint64 evictions;   ///< images dropped because the cache was full
+        qint64 memoryUsage; ///< bytes the images in the cache take
+        int count;          ///< number of images in the cache
+    };
+
+    /// @return the cache shared by the whole process
+    static KoImageCache *instance();
+
+    KoImageCache();
+    ~KoImageCache();
+
+    /**
+     * @return the variant of the image with @p imageKey at the given size and
+     * format, or a null image if it is not in the cache.
+     */
+    QImage find(qint64 imageKey, const QSize &size, QImage::Format format);
+
+    /// @return true if find() would return an image, without counting it as a hit or a miss
+    bool contains(qint64 imageKey, const QSize &size, QImage::Format format) const;
+
+    /**
+     * Add a variant of the image with @p imageKey. It is stored under the size
+     * and format of @p image, replacing an earlier image with those.
+     * Images bigger than the memory limit are not stored.
+     */
+    void insert(qint64 imageKey, const QImage &image);
+
+    /// drop all variants of the image with @p imageKey
+    void remove(qint64 imageKey);
+
+    /// drop all images
+    void clear();
+
+    /// Set the number of bytes the images may take together; 0 disables the cache
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+private:
+    Q_DISABLE_COPY(KoImageCache)
+
+    class Private;
+    Private * const d;
+};
+
+#endif // KOIMAGECACHE_H
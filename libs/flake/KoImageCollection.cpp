@@ -20,6 +20,7 @@
 #include "KoImageCollection.h"
 #include "KoImageData.h"
 #include "KoImageData_p.h"
+#include "KoImageCache.h"
 #include "KoShapeSavingContext.h"
 
 #include <KoStoreDevice.h>
@@ -70,6 +71,7 @@ bool KoImageCollection::completeSaving(KoStore *store, KoXmlWriter *manifestWrit
     QMap<qint64, QString>::ConstIterator imagesToSaveIter(imagesToSave.begin());
 
     QMap<qint64, KoImageDataPrivate *>::ConstIterator knownImagesIter(d->images.constBegin());
+    QMimeDatabase db;
 
     while (imagesToSaveIter != imagesToSave.constEnd()) {
         if (knownImagesIter == d->images.constEnd()) {
@@ -80,14 +82,23 @@ bool KoImageCollection::completeSaving(KoStore *store, KoXmlWriter *manifestWrit
         }
         else if (knownImagesIter.key() == imagesToSaveIter.key()) {
             KoImageDataPrivate *imageData = knownImagesIter.value();
-            if (store->open(imagesToSaveIter.value())) {
+            const QString mimetype(db.mimeTypeForFile(imagesToSaveIter.value(), QMimeDatabase::MatchExtension).name());
+            // png, jpeg & co are compressed already, just copy them
+            const bool storeOnly = KoStore::isCompressedMimeType(mimetype);
+            const bool compressionEnabled = store->isCompressionEnabled();
+            if (storeOnly) {
+                store->setCompressionEnabled(false);
+            }
+            const bool opened = store->open(imagesToSaveIter.value());
+            if (storeOnly) {
+                store->setCompressionEnabled(compressionEnabled);
+            }
+            if (opened) {
                 KoStoreDevice device(store);
                 bool ok = imageData->saveData(device);
                 store->close();
                 // TODO error handling
                 if (ok) {
-                    QMimeDatabase db;
-                    const QString mimetype(db.mimeTypeForFile(imagesToSaveIter.value(), QMimeDatabase::MatchExtension).name());
                     manifestWriter->addManifestEntry(imagesToSaveIter.value(), mimetype);
                 } else {
                     warnFlake << "saving image" << imagesToSaveIter.value() << "failed";
@@ -206,3 +217,13 @@ void KoImageCollection::removeOnKey(qint64 imageDataKey)
 {
     d->images.remove(imageDataKey);
 }
+
+void KoImageCollection::setMemoryLimit(qint64 bytes)
+{
+    KoImageCache::instance()->setMemoryLimit(bytes);
+}
+
+qint64 KoImageCollection::memoryLimit()
+{
+    return KoImageCache::instance()->memoryLimit();
+}
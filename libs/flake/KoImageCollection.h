@@ -104,6 +104,17 @@ public:
      */
     void update(qint64 oldKey, qint64 newKey);
 
+    /**
+     * Set the amount of memory the decoded images may use together, shared by
+     * all collections. The images that were not used for the longest time are
+     * released first when it is exceeded.
+     * @see KoImageCache
+     */
+    static void setMemoryLimit(qint64 bytes);
+
+    /// @return the amount of memory the decoded images may use together
+    static qint64 memoryLimit();
+
 private:
     KoImageData *cacheImage(KoImageData *data);
 
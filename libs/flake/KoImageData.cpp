@@ -35,11 +35,32 @@
 #include <QCryptographicHash>
 #include <QTemporaryFile>
 #include <QPainter>
+#include <QImageReader>
 
 /// the maximum amount of bytes the image can be while we store it in memory instead of
 /// spooling it to disk in a temp-file.
 #define MAX_MEMORY_IMAGESIZE 90000
 
+/**
+ * @return true if @p data is a file in the format of @p suffix, so it can be
+ * written out unchanged under that suffix
+ */
+static bool isEncodedAs(const QByteArray &data, const QString &suffix)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QByteArray format = QImageReader::imageFormat(&buffer).toLower();
+    QByteArray wanted = suffix.toLatin1().toLower();
+    if (format == "jpg") {
+        format = "jpeg";
+    }
+    if (wanted == "jpg") {
+        wanted = "jpeg";
+    }
+    return !format.isEmpty() && format == wanted;
+}
+
 KoImageData::KoImageData()
     : d(0)
 {
@@ -61,6 +82,7 @@ KoImageData::KoImageData(KoImageDataPrivate *priv)
 
 KoImageData::~KoImageData()
 {
+    KoImagePyramidNotifier::removeListener(this);
     if (d && !d->refCount.deref())
         delete d;
 }
@@ -92,16 +114,25 @@ QPixmap KoImageData::pixmap(const QSize &size)
             return tmp;
         }
         case KoImageDataPrivate::StateNotLoaded:
-            image(); // forces load
-            // fall through
         case KoImageDataPrivate::StateImageLoaded:
-        case KoImageDataPrivate::StateImageOnly:
-            if (!d->image.isNull()) {
+        case KoImageDataPrivate::StateImageOnly: {
+            // scale from the smallest decoded level that is big enough, so zooming
+            // does not need to decode and scale the full image every time
+            QImage source = d->coveringLevel(wantedSize);
+            if (source.isNull()) {
+                source = image(); // forces load
+                if (!source.isNull())
+                    source = d->addToCache(source);
+            }
+            if (!source.isNull()) {
                 // create pixmap from image.
                 // this is the highest quality and lowest memory usage way of doing the conversion.
-                d->pixmap = QPixmap::fromImage(d->image.scaled(wantedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+                if (source.size() != wantedSize)
+                    source = source.scaled(wantedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                d->pixmap = QPixmap::fromImage(source);
             }
         }
+        }
 
         if (d->dataStoreState == KoImageDataPrivate::StateImageLoaded) {
             if (d->cleanCacheTimer.isActive())
@@ -113,6 +144,38 @@ QPixmap KoImageData::pixmap(const QSize &size)
     return d->pixmap;
 }
 
+QImage KoImageData::scaledImage(const QSize &targetSize)
+{
+    if (!d || targetSize.isEmpty() || !isValid())
+        return QImage();
+    KoImagePyramidNotifier::instance()->addListener(d->key, this);
+    return d->requestScaledImage(targetSize);
+}
+
+QSize KoImageData::pixelSize() const
+{
+    if (!d)
+        return QSize();
+    if (!d->pixelSize.isValid()) {
+        if (!d->image.isNull()) {
+            d->pixelSize = d->image.size();
+        } else if (d->dataStoreState == KoImageDataPrivate::StateNotLoaded) {
+            // only the header is read
+            QImageReader reader;
+            if (d->temporaryFile) {
+                reader.setFileName(d->temporaryFile->fileName());
+                reader.setFormat(d->suffix.toLatin1());
+            } else {
+                reader.setFileName(d->imageLocation.toLocalFile());
+            }
+            d->pixelSize = reader.size();
+        }
+        if (!d->pixelSize.isValid())
+            return image().size();
+    }
+    return d->pixelSize;
+}
+
 bool KoImageData::hasCachedPixmap() const
 {
     return d && !d->pixmap.isNull();
@@ -215,6 +278,7 @@ void KoImageData::setImage(const QImage &image, KoImageCollection *collection)
             QCryptographicHash md5(QCryptographicHash::Md5);
             md5.addData(ba);
             d->key = KoImageDataPrivate::generateKey(md5.result());
+            d->encodedData = ba; // that is what saving would write
         }
         if (oldKey != 0 && d->collection) {
             d->collection->update(oldKey, d->key);
@@ -254,6 +318,9 @@ void KoImageData::setImage(const QString &url, KoStore *store, KoImageCollection
             if (!lossy && device.size() < MAX_MEMORY_IMAGESIZE) {
                 QByteArray data = device.readAll();
                 if (d->image.loadFromData(data)) {
+                    if (isEncodedAs(data, d->suffix)) {
+                        d->encodedData = data;
+                    }
                     QCryptographicHash md5(QCryptographicHash::Md5);
                     md5.addData(data);
                     qint64 oldKey = d->key;
@@ -292,6 +359,9 @@ void KoImageData::setImage(const QByteArray &imageData, KoImageCollection *colle
         if (d == 0) {
             d = new KoImageDataPrivate(this);
             d->refCount.ref();
+        } else {
+            d->pixelSize = QSize();
+            d->pyramid.reset(new KoImagePyramid);
         }
 
         d->suffix = "png"; // good default for non-lossy storage.
@@ -305,12 +375,19 @@ void KoImageData::setImage(const QByteArray &imageData, KoImageCollection *colle
                 d->errorCode = OpenFailed;
             }
             d->image = image;
+            // only png data can be saved as is, anything else is encoded to png on save
+            if (isEncodedAs(imageData, d->suffix)) {
+                d->encodedData = imageData;
+            } else {
+                d->encodedData.clear();
+            }
             d->dataStoreState = KoImageDataPrivate::StateImageOnly;
         }
 
         if (imageData.size() > MAX_MEMORY_IMAGESIZE
                 || d->errorCode == OpenFailed) {
             d->image = QImage();
+            d->encodedData.clear();
             // store image data
             QBuffer buffer;
             buffer.setData(imageData);
@@ -77,6 +77,23 @@ public:
      */
     QPixmap pixmap(const QSize &targetSize = QSize());
 
+    /**
+     * Returns the image scaled to @p targetSize without decoding or scaling it
+     * on the calling thread.
+     *
+     * Decoded images are kept in KoImageCache as a pyramid of halved resolutions. When the
+     * exact size is not available yet the level closest to it is returned, and
+     * the exact size is rendered in the background; scaledImageReady() is
+     * emitted when it is done. Returns a null image if nothing was decoded yet.
+     */
+    QImage scaledImage(const QSize &targetSize);
+
+    /**
+     * The size of the image in pixels. Unlike image().size() this does not
+     * decode the image.
+     */
+    QSize pixelSize() const;
+
     /**
      * Return the internal store of the image.
      * @see isValid(), hasCachedImage()
@@ -112,6 +129,10 @@ public:
     /// \internal
     KoImageDataPrivate *priv() { return d; }
 
+Q_SIGNALS:
+    /// emitted when an image asked for with scaledImage() has been rendered
+    void scaledImageReady();
+
 private:
     friend class KoImageCollection;
     friend class TestImageCollection;
@@ -22,6 +22,7 @@
 
 #include "KoImageData_p.h"
 #include "KoImageCollection.h"
+#include "KoImageCache.h"
 
 #include <QApplication>
 #include <QTemporaryFile>
@@ -30,6 +31,200 @@
 #include <QFileInfo>
 #include <FlakeDebug.h>
 #include <QBuffer>
+#include <QThreadPool>
+
+Q_GLOBAL_STATIC(KoImagePyramidNotifier, s_pyramidNotifier)
+
+KoImagePyramid::KoImagePyramid()
+    : format(QImage::Format_Invalid)
+{
+}
+
+QSize KoImagePyramid::levelSize(const QSize &size, int level)
+{
+    return QSize(size.width() >> level, size.height() >> level);
+}
+
+QImage::Format KoImagePyramid::cacheFormat(const QImage &image)
+{
+    return image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+}
+
+QImage KoImagePyramid::coveringLevel(qint64 key, const QSize &pixelSize, QImage::Format format,
+        const QSize &size, int *level)
+{
+    if (!pixelSize.isValid() || format == QImage::Format_Invalid)
+        return QImage();
+
+    // the deepest level still covering the size, then up to the full image
+    int deepest = 0;
+    while (true) {
+        const QSize next = levelSize(pixelSize, deepest + 1);
+        if (next.isEmpty() || next.width() < size.width() || next.height() < size.height())
+            break;
+        ++deepest;
+    }
+    KoImageCache *cache = KoImageCache::instance();
+    for (int i = deepest; i >= 0; --i) {
+        const QSize candidate = levelSize(pixelSize, i);
+        if (!cache->contains(key, candidate, format))
+            continue;
+        // it may have been dropped by another thread in between
+        const QImage image = cache->find(key, candidate, format);
+        if (!image.isNull()) {
+            if (level)
+                *level = i;
+            return image;
+        }
+    }
+    return QImage();
+}
+
+QImage KoImagePyramid::nearestLevel(qint64 key, const QSize &pixelSize, QImage::Format format,
+        const QSize &size)
+{
+    QImage image = coveringLevel(key, pixelSize, format, size);
+    if (!image.isNull() || !pixelSize.isValid() || format == QImage::Format_Invalid)
+        return image;
+
+    // all cached levels are smaller, the biggest of them is the closest
+    KoImageCache *cache = KoImageCache::instance();
+    for (int i = 0; !levelSize(pixelSize, i).isEmpty(); ++i) {
+        const QSize candidate = levelSize(pixelSize, i);
+        if (candidate.width() >= size.width() && candidate.height() >= size.height())
+            continue;
+        if (cache->contains(key, candidate, format)) {
+            image = cache->find(key, candidate, format);
+            if (!image.isNull())
+                return image;
+        }
+    }
+    return QImage();
+}
+
+KoImagePyramidJob::KoImagePyramidJob(const QSharedPointer<KoImagePyramid> &pyramid, qint64 key, const QImage &image,
+        const QString &fileName, const QByteArray &format, const QSize &size)
+    : m_pyramid(pyramid),
+    m_key(key),
+    m_image(image),
+    m_fileName(fileName),
+    m_format(format),
+    m_size(size)
+{
+}
+
+void KoImagePyramidJob::run()
+{
+    QSize pixelSize;
+    QImage::Format format;
+    {
+        QMutexLocker locker(&m_pyramid->mutex);
+        if (m_pyramid->pendingSize != m_size)
+            return; // another size was asked for in the meantime
+        pixelSize = m_pyramid->pixelSize;
+        format = m_pyramid->format;
+    }
+
+    KoImageCache *cache = KoImageCache::instance();
+    int index = 0;
+    QImage level = KoImagePyramid::coveringLevel(m_key, pixelSize, format, m_size, &index);
+    if (level.isNull() && pixelSize.isValid() && cache->contains(m_key, pixelSize, format)) {
+        // scaling up, from the full image
+        level = cache->find(m_key, pixelSize, format);
+    }
+    if (level.isNull()) {
+        // no cached level is big enough, start from the full image
+        level = m_image;
+        if (level.isNull() && !m_fileName.isEmpty())
+            level.load(m_fileName, m_format.isEmpty() ? 0 : m_format.constData());
+        if (level.isNull()) {
+            QMutexLocker locker(&m_pyramid->mutex);
+            if (m_pyramid->pendingSize == m_size)
+                m_pyramid->pendingSize = QSize();
+            return;
+        }
+        format = KoImagePyramid::cacheFormat(level);
+        level = level.convertToFormat(format);
+        pixelSize = level.size();
+        {
+            QMutexLocker locker(&m_pyramid->mutex);
+            m_pyramid->pixelSize = pixelSize;
+            m_pyramid->format = format;
+        }
+        cache->insert(m_key, level);
+        index = 0;
+    }
+
+    // go down the pyramid as long as the next level still covers the wanted size
+    while (true) {
+        const QSize half = KoImagePyramid::levelSize(pixelSize, index + 1);
+        if (half.isEmpty() || half.width() < m_size.width() || half.height() < m_size.height())
+            break;
+        level = level.scaled(half, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        cache->insert(m_key, level);
+        ++index;
+    }
+    if (level.size() != m_size)
+        cache->insert(m_key, level.scaled(m_size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+
+    {
+        QMutexLocker locker(&m_pyramid->mutex);
+        if (m_pyramid->pendingSize == m_size)
+            m_pyramid->pendingSize = QSize();
+    }
+
+    KoImagePyramidNotifier::instance()->notifyUpdated(m_key);
+}
+
+KoImagePyramidNotifier::KoImagePyramidNotifier()
+{
+    // the queued notifications have to arrive in the gui thread
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+}
+
+KoImagePyramidNotifier *KoImagePyramidNotifier::instance()
+{
+    return s_pyramidNotifier();
+}
+
+void KoImagePyramidNotifier::addListener(qint64 key, KoImageData *data)
+{
+    if (!m_listeners.contains(key, data))
+        m_listeners.insert(key, data);
+}
+
+void KoImagePyramidNotifier::removeListener(KoImageData *data)
+{
+    if (!s_pyramidNotifier.exists() || s_pyramidNotifier.isDestroyed())
+        return;
+    QMultiHash<qint64, KoImageData *> &listeners = s_pyramidNotifier()->m_listeners;
+    QMultiHash<qint64, KoImageData *>::iterator it = listeners.begin();
+    while (it != listeners.end()) {
+        if (it.value() == data)
+            it = listeners.erase(it);
+        else
+            ++it;
+    }
+}
+
+void KoImagePyramidNotifier::notifyUpdated(qint64 key)
+{
+    QMetaObject::invokeMethod(this, "pyramidUpdated", Qt::QueuedConnection, Q_ARG(qint64, key));
+}
+
+void KoImagePyramidNotifier::pyramidUpdated(qint64 key)
+{
+    const QList<KoImageData *> listeners = m_listeners.values(key);
+    foreach (KoImageData *data, listeners) {
+        if (data->priv()->key != key) {
+            // the image got replaced since it asked
+            m_listeners.remove(key, data);
+            continue;
+        }
+        emit data->scaledImageReady();
+    }
+}
 
 KoImageDataPrivate::KoImageDataPrivate(KoImageData *q)
     : collection(0),
@@ -37,6 +232,7 @@ KoImageDataPrivate::KoImageDataPrivate(KoImageData *q)
     key(0),
     refCount(0),
     dataStoreState(StateEmpty),
+    pyramid(new KoImagePyramid),
     temporaryFile(0)
 {
     cleanCacheTimer.setSingleShot(true);
@@ -90,12 +286,21 @@ bool KoImageDataPrivate::saveData(QIODevice &device)
         return true;
     case KoImageDataPrivate::StateImageLoaded:
     case KoImageDataPrivate::StateImageOnly: {
-        // save image
-        QBuffer buffer;
-        QImageWriter writer(&buffer, suffix.toLatin1());
-        bool result = writer.write(image);
-        device.write(buffer.data(), buffer.size());
-        return result;
+        if (encodedData.isEmpty()) {
+            // save image, and keep the result for the next time
+            QBuffer buffer;
+            QImageWriter writer(&buffer, suffix.toLatin1());
+            if (!writer.write(image)) {
+                device.write(buffer.data(), buffer.size());
+                return false;
+            }
+            encodedData = buffer.data();
+        }
+        if (device.write(encodedData) != encodedData.size()) {
+            return false;
+        }
+        releaseEncodedData();
+        return true;
       }
     }
     return false;
@@ -135,6 +340,25 @@ void KoImageDataPrivate::copyToTemporary(QIODevice &device)
     dataStoreState = StateNotLoaded;
 }
 
+void KoImageDataPrivate::releaseEncodedData()
+{
+    QTemporaryFile *file = new QTemporaryFile(QDir::tempPath() + "/" + qAppName() + QLatin1String("_XXXXXX"));
+    if (!file->open() || file->write(encodedData) != encodedData.size()) {
+        warnFlake << "open temporary file for writing failed";
+        delete file;
+        return;
+    }
+    file->close();
+
+    delete temporaryFile;
+    temporaryFile = file;
+    encodedData.clear();
+    // the image can be loaded again from the file now
+    if (dataStoreState == StateImageOnly) {
+        dataStoreState = StateImageLoaded;
+    }
+}
+
 void KoImageDataPrivate::cleanupImageCache()
 {
     if (dataStoreState == KoImageDataPrivate::StateImageLoaded) {
@@ -152,6 +376,81 @@ void KoImageDataPrivate::clear()
     key = 0;
     image = QImage();
     pixmap = QPixmap();
+    pixelSize = QSize();
+    // a job still running for the old image fills the old pyramid
+    pyramid.reset(new KoImagePyramid);
+    encodedData.clear();
+}
+
+QImage KoImageDataPrivate::requestScaledImage(const QSize &size)
+{
+    QSize levelZeroSize;
+    QImage::Format format;
+    {
+        QMutexLocker locker(&pyramid->mutex);
+        levelZeroSize = pyramid->pixelSize;
+        format = pyramid->format;
+    }
+
+    if (format != QImage::Format_Invalid) {
+        const QImage exact = KoImageCache::instance()->find(key, size, format);
+        if (!exact.isNull())
+            return exact;
+    }
+    QImage nearest = KoImagePyramid::nearestLevel(key, levelZeroSize, format, size);
+
+    bool schedule = false;
+    {
+        QMutexLocker locker(&pyramid->mutex);
+        if (pyramid->pendingSize != size) {
+            pyramid->pendingSize = size;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        QString fileName;
+        QByteArray fileFormat;
+        if (image.isNull()) {
+            if (temporaryFile) {
+                fileName = temporaryFile->fileName();
+                fileFormat = suffix.toLatin1();
+            } else if (imageLocation.isLocalFile()) {
+                fileName = imageLocation.toLocalFile();
+            }
+        }
+        QThreadPool::globalInstance()->start(new KoImagePyramidJob(pyramid, key, image, fileName, fileFormat, size));
+    }
+
+    if (nearest.isNull())
+        nearest = image;
+    return nearest;
+}
+
+QImage KoImageDataPrivate::coveringLevel(const QSize &size) const
+{
+    QMutexLocker locker(&pyramid->mutex);
+    return KoImagePyramid::coveringLevel(key, pyramid->pixelSize, pyramid->format, size);
+}
+
+QImage KoImageDataPrivate::addToCache(const QImage &decoded)
+{
+    const QImage::Format format = KoImagePyramid::cacheFormat(decoded);
+    const QImage level = decoded.convertToFormat(format);
+    KoImageCache::instance()->insert(key, level);
+
+    // the cache holds the image now, don't keep a second copy of it around;
+    // it can be loaded again when the cache dropped it
+    if (dataStoreState == StateImageLoaded) {
+        image = QImage();
+        dataStoreState = StateNotLoaded;
+    }
+    // an image that is the only copy is kept as it is, converting it could lose
+    // colors or precision; it shares its data with the cache if it has the format already
+
+    QMutexLocker locker(&pyramid->mutex);
+    pyramid->pixelSize = level.size();
+    pyramid->format = format;
+    return level;
 }
 
 qint64 KoImageDataPrivate::generateKey(const QByteArray &bytes)
@@ -29,12 +29,111 @@
 #include <QPixmap>
 #include <QTimer>
 #include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSharedPointer>
 
 #include "KoImageData.h"
 
 class KoImageCollection;
 class QTemporaryFile;
 
+/**
+ * The pyramid of decoded resolutions of an image.
+ *
+ * Level 0 is the full image and every next level has half the width and
+ * height of the one before. The levels themselves, and the image scaled to
+ * the sizes asked for, are kept in KoImageCache under the key of the image
+ * data; this holds what is needed to find them again. It is shared between
+ * the image data and the background jobs, all access has to hold the mutex.
+ */
+class KoImagePyramid
+{
+public:
+    KoImagePyramid();
+
+    /// @return the size of @p level of the pyramid of an image of @p size
+    static QSize levelSize(const QSize &size, int level);
+
+    /// @return the format @p image is kept in the cache in, the fastest one to paint
+    static QImage::Format cacheFormat(const QImage &image);
+
+    /**
+     * @return the smallest cached level of the image with @p key covering
+     * @p size, or a null image. @p level is set to the index of that level.
+     * @param pixelSize the size of level 0
+     */
+    static QImage coveringLevel(qint64 key, const QSize &pixelSize, QImage::Format format,
+            const QSize &size, int *level = 0);
+
+    /// like coveringLevel(), but falls back to the biggest cached level smaller than @p size
+    static QImage nearestLevel(qint64 key, const QSize &pixelSize, QImage::Format format,
+            const QSize &size);
+
+    /// the size of level 0, invalid until the image was decoded
+    QSize pixelSize;
+    /// the format of the levels in the cache
+    QImage::Format format;
+    /// the size the background job is rendering, invalid if there is none
+    QSize pendingSize;
+
+    mutable QMutex mutex;
+};
+
+/**
+ * Decodes an image into its pyramid and renders it at the wanted size,
+ * run in QThreadPool::globalInstance().
+ */
+class KoImagePyramidJob : public QRunnable
+{
+public:
+    /**
+     * @param image the decoded image if there is one already
+     * @param fileName the file to decode the image from otherwise
+     */
+    KoImagePyramidJob(const QSharedPointer<KoImagePyramid> &pyramid, qint64 key, const QImage &image,
+            const QString &fileName, const QByteArray &format, const QSize &size);
+
+    virtual void run();
+
+private:
+    QSharedPointer<KoImagePyramid> m_pyramid;
+    qint64 m_key;
+    QImage m_image;
+    QString m_fileName;
+    QByteArray m_format;
+    QSize m_size;
+};
+
+/**
+ * Tells the image data objects that a background job for their key finished.
+ * Only the image data registered for that key are told; the jobs report from
+ * the worker thread, so the notification is queued to the gui thread.
+ */
+class KoImagePyramidNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    KoImagePyramidNotifier();
+
+    static KoImagePyramidNotifier *instance();
+
+    /// tell @p data when the pyramid of @p key got updated
+    void addListener(qint64 key, KoImageData *data);
+    /// forget @p data, called when it gets deleted
+    static void removeListener(KoImageData *data);
+
+    /// thread safe, called from the jobs
+    void notifyUpdated(qint64 key);
+
+private Q_SLOTS:
+    void pyramidUpdated(qint64 key);
+
+private:
+    QMultiHash<qint64, KoImageData *> m_listeners;
+};
+
 class KoImageDataPrivate
 {
 public:
@@ -55,11 +154,30 @@ public:
     /// take the data from \a device and store it in the temporaryFile
     void copyToTemporary(QIODevice &device);
 
+    /**
+     * Move the encodedData into the temporaryFile once it was saved, so the
+     * next save copies it from there without keeping it in memory.
+     */
+    void releaseEncodedData();
+
     /// clean the image cache.
     void cleanupImageCache();
 
     void clear();
 
+    /// @see KoImageData::scaledImage()
+    QImage requestScaledImage(const QSize &size);
+
+    /// @return the smallest cached level covering @p size, or a null image
+    QImage coveringLevel(const QSize &size) const;
+
+    /**
+     * Puts the @p decoded image into the cache as level 0 and returns it as
+     * cached. The own copy in @c image is released if it can be loaded again,
+     * otherwise it is kept in its original format.
+     */
+    QImage addToCache(const QImage &decoded);
+
     static qint64 generateKey(const QByteArray &bytes);
 
     enum DataStoreState {
@@ -84,8 +202,16 @@ public:
     QImage image;
     /// screen optimized cached version.
     QPixmap pixmap;
+    /// the size of the image in pixels, read from the file header when not yet decoded
+    QSize pixelSize;
+    QSharedPointer<KoImagePyramid> pyramid;
 
     QTemporaryFile *temporaryFile;
+    /// The encoded file the image in StateImageOnly/StateImageLoaded was
+    /// created from, written out unchanged when saving so that unchanged
+    /// images are not encoded again on every save. It is moved to the
+    /// temporaryFile by the first save, see releaseEncodedData().
+    QByteArray encodedData;
 };
 
 #endif /* KOIMAGEDATA_P_H */
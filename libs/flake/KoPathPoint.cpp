@@ -93,6 +93,9 @@ KoPathPoint &KoPathPoint::operator=(const KoPathPoint &rhs)
     d->activeControlPoint1 = rhs.d->activeControlPoint1;
     d->activeControlPoint2 = rhs.d->activeControlPoint2;
 
+    if (d->shape)
+        d->shape->notifyPointsChanged();
+
     return (*this);
 }
 
@@ -116,8 +119,10 @@ bool KoPathPoint::operator == (const KoPathPoint &rhs) const
 void KoPathPoint::setPoint(const QPointF &point)
 {
     d->point = point;
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::setControlPoint1(const QPointF &point)
@@ -126,8 +131,10 @@ void KoPathPoint::setControlPoint1(const QPointF &point)
 
     d->controlPoint1 = point;
     d->activeControlPoint1 = true;
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::setControlPoint2(const QPointF &point)
@@ -136,8 +143,10 @@ void KoPathPoint::setControlPoint2(const QPointF &point)
 
     d->controlPoint2 = point;
     d->activeControlPoint2 = true;
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::removeControlPoint1()
@@ -145,8 +154,10 @@ void KoPathPoint::removeControlPoint1()
     d->activeControlPoint1 = false;
     d->properties &= ~IsSmooth;
     d->properties &= ~IsSymmetric;
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::removeControlPoint2()
@@ -154,8 +165,10 @@ void KoPathPoint::removeControlPoint2()
     d->activeControlPoint2 = false;
     d->properties &= ~IsSmooth;
     d->properties &= ~IsSymmetric;
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::setProperties(PointProperties properties)
@@ -171,8 +184,10 @@ void KoPathPoint::setProperties(PointProperties properties)
         d->properties &= ~IsSymmetric;
     }
 
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::setProperty(PointProperty property)
@@ -199,6 +214,9 @@ void KoPathPoint::setProperty(PointProperty property)
         d->properties &= ~IsSymmetric;
         d->properties &= ~IsSmooth;
     }
+
+    if (d->shape)
+        d->shape->notifyPointsChanged();
 }
 
 void KoPathPoint::unsetProperty(PointProperty property)
@@ -225,6 +243,9 @@ void KoPathPoint::unsetProperty(PointProperty property)
     default: return;
     }
     d->properties &= ~property;
+
+    if (d->shape)
+        d->shape->notifyPointsChanged();
 }
 
 bool KoPathPoint::activeControlPoint1() const
@@ -251,8 +272,10 @@ void KoPathPoint::map(const QTransform &matrix)
     d->controlPoint1 = matrix.map(d->controlPoint1);
     d->controlPoint2 = matrix.map(d->controlPoint2);
 
-    if (d->shape)
+    if (d->shape) {
+        d->shape->notifyPointsChanged();
         d->shape->notifyChanged();
+    }
 }
 
 void KoPathPoint::paint(QPainter &painter, int handleRadius, PointTypes types, bool active)
@@ -305,6 +328,8 @@ void KoPathPoint::setParent(KoPathShape* parent)
     // don't set to zero
     //Q_ASSERT(parent);
     d->shape = parent;
+    if (d->shape)
+        d->shape->notifyPointsChanged();
 }
 
 QRectF KoPathPoint::boundingRect(bool active) const
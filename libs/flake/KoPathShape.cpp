@@ -61,7 +61,13 @@ KoPathShapePrivate::KoPathShapePrivate(KoPathShape *q)
     : KoTosContainerPrivate(q),
     fillRule(Qt::OddEvenFill),
     startMarker(KoMarkerData::MarkerStart),
-    endMarker(KoMarkerData::MarkerEnd)
+    endMarker(KoMarkerData::MarkerEnd),
+    pointsVersion(1),
+    outlineVersion(0),
+    flattenedOutlineVersion(0),
+    strokeVersion(0),
+    boundingRectVersion(0),
+    boundingRectLineWidth(0)
 {
 }
 
@@ -367,6 +373,7 @@ void KoPathShape::clear()
         delete subpath;
     }
     m_subpaths.clear();
+    notifyPointsChanged();
 }
 
 void KoPathShape::paint(QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext)
@@ -445,10 +452,27 @@ void KoPathShape::paintPoints(QPainter &painter, const KoViewConverter &converte
     }
 }
 
+void KoPathShape::notifyPointsChanged()
+{
+    Q_D(KoPathShape);
+    ++d->pointsVersion;
+}
+
 QPainterPath KoPathShape::outline() const
 {
+    Q_D(const KoPathShape);
+    if (d->outlineVersion != d->pointsVersion) {
+        d->outline = d->buildOutline();
+        d->outlineVersion = d->pointsVersion;
+    }
+    return d->outline;
+}
+
+QPainterPath KoPathShapePrivate::buildOutline() const
+{
+    Q_Q(const KoPathShape);
     QPainterPath path;
-    foreach(KoSubpath * subpath, m_subpaths) {
+    foreach(KoSubpath * subpath, q->m_subpaths) {
         KoPathPoint * lastPoint = subpath->first();
         bool activeCP = false;
         foreach(KoPathPoint * currPoint, *subpath) {
@@ -510,6 +534,7 @@ QPainterPath KoPathShape::outline() const
 
 QRectF KoPathShape::boundingRect() const
 {
+    Q_D(const KoPathShape);
     QTransform transform = absoluteTransformation(0);
     // calculate the bounding rect of the transformed outline
     QRectF bb;
@@ -518,7 +543,14 @@ QRectF KoPathShape::boundingRect() const
     if (lineBorder) {
         pen.setWidthF(lineBorder->lineWidth());
     }
-    bb = transform.map(pathStroke(pen)).boundingRect();
+    if (d->boundingRectVersion != d->pointsVersion || d->boundingRectLineWidth != pen.widthF()
+            || d->boundingRectTransform != transform) {
+        d->strokeBoundingRect = transform.map(pathStroke(pen)).boundingRect();
+        d->boundingRectVersion = d->pointsVersion;
+        d->boundingRectLineWidth = pen.widthF();
+        d->boundingRectTransform = transform;
+    }
+    bb = d->strokeBoundingRect;
 
     if (stroke()) {
         KoInsets inset;
@@ -589,6 +621,7 @@ KoPathPoint * KoPathShape::moveTo(const QPointF &p)
     KoSubpath * path = new KoSubpath;
     path->push_back(point);
     m_subpaths.push_back(path);
+    notifyPointsChanged();
     return point;
 }
 
@@ -602,6 +635,7 @@ KoPathPoint * KoPathShape::lineTo(const QPointF &p)
     KoPathPoint * lastPoint = m_subpaths.last()->last();
     d->updateLast(&lastPoint);
     m_subpaths.last()->push_back(point);
+    notifyPointsChanged();
     return point;
 }
 
@@ -617,6 +651,7 @@ KoPathPoint * KoPathShape::curveTo(const QPointF &c1, const QPointF &c2, const Q
     KoPathPoint * point = new KoPathPoint(this, p, KoPathPoint::StopSubpath);
     point->setControlPoint1(c2);
     m_subpaths.last()->push_back(point);
+    notifyPointsChanged();
     return point;
 }
 
@@ -631,6 +666,7 @@ KoPathPoint * KoPathShape::curveTo(const QPointF &c, const QPointF &p)
     lastPoint->setControlPoint2(c);
     KoPathPoint * point = new KoPathPoint(this, p, KoPathPoint::StopSubpath);
     m_subpaths.last()->push_back(point);
+    notifyPointsChanged();
 
     return point;
 }
@@ -759,6 +795,7 @@ void KoPathShapePrivate::map(const QTransform &matrix)
             (*it)->map(matrix);
         }
     }
+    q->notifyPointsChanged();
 }
 
 void KoPathShapePrivate::updateLast(KoPathPoint **lastPoint)
@@ -777,6 +814,7 @@ void KoPathShapePrivate::updateLast(KoPathPoint **lastPoint)
         KoSubpath *path = new KoSubpath;
         path->push_back(newLastPoint);
         q->m_subpaths.push_back(path);
+        q->notifyPointsChanged();
         *lastPoint = newLastPoint;
     } else {
         // the subpath was not closed so the formerly last point
@@ -956,6 +994,7 @@ bool KoPathShape::insertPoint(KoPathPoint* point, const KoPathPointIndex &pointI
     point->setProperties(properties);
     point->setParent(this);
     subpath->insert(pointIndex.second , point);
+    notifyPointsChanged();
     return true;
 }
 
@@ -968,6 +1007,7 @@ KoPathPoint * KoPathShape::removePoint(const KoPathPointIndex &pointIndex)
         return 0;
 
     KoPathPoint * point = subpath->takeAt(pointIndex.second);
+    notifyPointsChanged();
 
     //don't do anything (not even crash), if there was only one point
     if (pointCount()==0) {
@@ -1019,6 +1059,7 @@ bool KoPathShape::breakAfter(const KoPathPointIndex &pointIndex)
 
     // insert the new subpath after the broken one
     m_subpaths.insert(pointIndex.first + 1, newSubpath);
+    notifyPointsChanged();
 
     return true;
 }
@@ -1047,6 +1088,7 @@ bool KoPathShape::join(int subpathIndex)
 
     // delete it as it is no longer possible to use it
     delete nextSubpath;
+    notifyPointsChanged();
 
     return true;
 }
@@ -1064,6 +1106,7 @@ bool KoPathShape::moveSubpath(int oldSubpathIndex, int newSubpathIndex)
 
     m_subpaths.removeAt(oldSubpathIndex);
     m_subpaths.insert(newSubpathIndex, subpath);
+    notifyPointsChanged();
 
     return true;
 }
@@ -1087,6 +1130,7 @@ KoPathPointIndex KoPathShape::openSubpath(const KoPathPointIndex &pointIndex)
     for (int i = 0; i < pointIndex.second; ++i) {
         subpath->append(subpath->takeFirst());
     }
+    notifyPointsChanged();
     // make the first point a start node
     subpath->first()->setProperty(KoPathPoint::StartSubpath);
     // make the last point an end node
@@ -1114,6 +1158,7 @@ KoPathPointIndex KoPathShape::closeSubpath(const KoPathPointIndex &pointIndex)
     for (int i = 0; i < pointIndex.second; ++i) {
         subpath->append(subpath->takeFirst());
     }
+    notifyPointsChanged();
     subpath->first()->setProperty(KoPathPoint::StartSubpath);
     subpath->last()->setProperty(KoPathPoint::StopSubpath);
 
@@ -1135,6 +1180,7 @@ bool KoPathShape::reverseSubpath(int subpathIndex)
         p->reverse();
         subpath->prepend(p);
     }
+    notifyPointsChanged();
 
     // adjust the position dependent properties
     KoPathPoint *first = subpath->first();
@@ -1162,8 +1208,10 @@ KoSubpath * KoPathShape::removeSubpath(int subpathIndex)
     Q_D(KoPathShape);
     KoSubpath *subpath = d->subPath(subpathIndex);
 
-    if (subpath != 0)
+    if (subpath != 0) {
         m_subpaths.removeAt(subpathIndex);
+        notifyPointsChanged();
+    }
 
     return subpath;
 }
@@ -1174,6 +1222,7 @@ bool KoPathShape::addSubpath(KoSubpath * subpath, int subpathIndex)
         return false;
 
     m_subpaths.insert(subpathIndex, subpath);
+    notifyPointsChanged();
 
     return true;
 }
@@ -1220,6 +1269,7 @@ bool KoPathShape::separate(QList<KoPathShape*> & separatedPaths)
 
         foreach(KoPathPoint* point, *subpath) {
             KoPathPoint *newPoint = new KoPathPoint(*point);
+            newPoint->setParent(shape);
             newPoint->map(myMatrix);
             newSubpath->append(newPoint);
         }
@@ -1257,6 +1307,7 @@ void KoPathShapePrivate::closeMergeSubpath(KoSubpath *subpath)
             firstPoint->setControlPoint1(lastPoint->controlPoint1());
         // remove last point
         delete subpath->takeLast();
+        q_func()->notifyPointsChanged();
         // the new last point closes the subpath now
         lastPoint = subpath->last();
         lastPoint->setProperty(KoPathPoint::StopSubpath);
@@ -1476,8 +1527,19 @@ bool KoPathShape::hitTest(const QPointF &position) const
     if (parent() && parent()->isClipped(this) && ! parent()->hitTest(position))
         return false;
 
+    Q_D(const KoPathShape);
     QPointF point = absoluteTransformation(0).inverted().map(position);
-    const QPainterPath outlinePath = outline();
+    // curves are flattened once, instead of on every containment test
+    if (d->flattenedOutlineVersion != d->pointsVersion) {
+        const QPainterPath path = outline();
+        d->flattenedOutline = QPainterPath();
+        d->flattenedOutline.setFillRule(path.fillRule());
+        foreach (const QPolygonF &polygon, path.toSubpathPolygons()) {
+            d->flattenedOutline.addPolygon(polygon);
+        }
+        d->flattenedOutlineVersion = d->pointsVersion;
+    }
+    const QPainterPath outlinePath = d->flattenedOutline;
     if (stroke()) {
         KoInsets insets;
         stroke()->strokeInsets(this, insets);
@@ -1511,6 +1573,8 @@ void KoPathShape::setMarker(const KoMarkerData &markerData)
     else {
         d->endMarker = markerData;
     }
+    // the markers are part of the stroke
+    notifyPointsChanged();
 }
 
 void KoPathShape::setMarker(KoMarker *marker, KoMarkerData::MarkerPosition position)
@@ -1529,6 +1593,7 @@ void KoPathShape::setMarker(KoMarker *marker, KoMarkerData::MarkerPosition posit
         }
         d->endMarker.setMarker(marker);
     }
+    notifyPointsChanged();
 }
 
 KoMarker *KoPathShape::marker(KoMarkerData::MarkerPosition position) const
@@ -1557,9 +1622,13 @@ KoMarkerData KoPathShape::markerData(KoMarkerData::MarkerPosition position) cons
 
 QPainterPath KoPathShape::pathStroke(const QPen &pen) const
 {
+    Q_D(const KoPathShape);
     if (m_subpaths.isEmpty()) {
         return QPainterPath();
     }
+    if (d->strokeVersion == d->pointsVersion && d->strokePen == pen) {
+        return d->stroke;
+    }
     QPainterPath pathOutline;
 
     QPainterPathStroker stroker;
@@ -1718,7 +1787,8 @@ QPainterPath KoPathShape::pathStroke(const QPen &pen) const
         firstSubpath->last() = lastSegments.first.second();
     }
 
-    QPainterPath path = stroker.createStroke(outline());
+    // while points are replaced the cached outline does not match
+    QPainterPath path = stroker.createStroke((firstPoint || lastPoint) ? d->buildOutline() : outline());
 
     if (firstPoint) {
         firstSubpath->first() = firstPoint;
@@ -1736,5 +1806,8 @@ QPainterPath KoPathShape::pathStroke(const QPen &pen) const
     pathOutline.addPath(path);
     pathOutline.setFillRule(Qt::WindingFill);
 
+    d->stroke = pathOutline;
+    d->strokePen = pen;
+    d->strokeVersion = d->pointsVersion;
     return pathOutline;
 }
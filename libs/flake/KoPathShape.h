@@ -96,6 +96,16 @@ public:
     virtual QSizeF size() const;
 
     QPainterPath pathStroke(const QPen &pen) const;
+
+    /**
+     * @brief Tells the shape that its points have changed
+     *
+     * The outline, the stroke and the bounding rect are cached until this is
+     * called. KoPathPoint and the functions of this class call it themselves,
+     * so it is only needed by code that changes the subpaths directly.
+     */
+    void notifyPointsChanged();
+
     /**
      * Resize the shape
      *
@@ -22,11 +22,18 @@
 #include "KoTosContainer_p.h"
 #include "KoMarkerData.h"
 
+#include <QPainterPath>
+#include <QPen>
+#include <QTransform>
+
 class KoPathShapePrivate : public KoTosContainerPrivate
 {
 public:
     explicit KoPathShapePrivate(KoPathShape *q);
 
+    /// builds the outline from the points, without using the cache
+    QPainterPath buildOutline() const;
+
     QRectF handleRect(const QPointF &p, qreal radius) const;
     /// Applies the viewbox transformation defined in the given element
     void applyViewboxTransformation(const KoXmlElement &element);
@@ -91,6 +98,24 @@ public:
 
     KoMarkerData startMarker;
     KoMarkerData endMarker;
+
+    /**
+     * Geometry derived from the points. Each entry is valid as long as its
+     * version matches pointsVersion, which KoPathShape::notifyPointsChanged()
+     * increments.
+     */
+    uint pointsVersion;
+    mutable uint outlineVersion;
+    mutable QPainterPath outline;
+    mutable uint flattenedOutlineVersion;
+    mutable QPainterPath flattenedOutline; // only straight lines, for hit testing
+    mutable uint strokeVersion;
+    mutable QPen strokePen;
+    mutable QPainterPath stroke;
+    mutable uint boundingRectVersion;
+    mutable qreal boundingRectLineWidth;
+    mutable QTransform boundingRectTransform;
+    mutable QRectF strokeBoundingRect;
 };
 
 #endif
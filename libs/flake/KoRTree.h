@@ -29,9 +29,12 @@
 #include <QPointF>
 #include <QRectF>
 #include <QVarLengthArray>
+#include <QtMath>
 
 #include <QDebug>
 
+#include <algorithm>
+
 // #define CALLIGRA_RTREE_DEBUG
 #ifdef CALLIGRA_RTREE_DEBUG
 #include <QPainter>
@@ -45,6 +48,10 @@
  *
  * It only supports 2 dimensional bounding boxes which are represented by a QRectF.
  * For node splitting the Quadratic-Cost Algorithm is used as described by Guttman.
+ *
+ * A tree for many items known up front is better built with bulkLoad(), which
+ * packs the nodes with the Sort-Tile-Recursive algorithm described in
+ * "STR: A Simple and Efficient Algorithm for R-Tree Packing" by Leutenegger et al.
  */
 template <typename T>
 class KoRTree
@@ -74,6 +81,18 @@ public:
      */
     virtual void insert(const QRectF& bb, const T& data);
 
+    /**
+     * @brief Replace the content of the tree with the given data items
+     *
+     * The tree is built bottom up with tightly packed nodes, which is a lot
+     * faster than inserting the items one by one and gives a tree that is
+     * faster to query. The items count as inserted in the order of @p items.
+     * The tree can be changed with insert() and remove() afterwards.
+     *
+     * @param items the bounding boxes and data items
+     */
+    void bulkLoad(const QList<QPair<QRectF, T> > &items);
+
     /**
      * @brief Remove a data item from the tree
      *
@@ -104,6 +123,30 @@ public:
      */
     QList<T> contains(const QPointF &point) const;
 
+    /**
+     * @brief Call @p visitor for every data item which intersects rect
+     *
+     * Unlike intersects() this does not allocate memory, but the items are
+     * visited in no particular order.
+     *
+     * @param rect where the objects have to be in
+     * @param visitor callable taking a const T&
+     */
+    template <typename Visitor>
+    void visitIntersecting(const QRectF &rect, Visitor visitor) const;
+
+    /**
+     * @brief Call @p visitor for every data item which contains the point
+     *
+     * Unlike contains() this does not allocate memory, but the items are
+     * visited in no particular order.
+     *
+     * @param point which should be contained in the objects
+     * @param visitor callable taking a const T&
+     */
+    template <typename Visitor>
+    void visitContaining(const QPointF &point, Visitor visitor) const;
+
     /**
      * @brief Find all data rectangles
      * The order is NOT guaranteed to be the same as that used by values().
@@ -166,6 +209,16 @@ protected:
         virtual void keys(QList<QRectF> & result) const = 0;
         virtual void values(QMap<int, T> & result) const = 0;
 
+        // direct access to the children for the visitor queries
+        virtual Node * childNode(int index) const {
+            Q_UNUSED(index);
+            return 0;
+        }
+        virtual const T * childData(int index) const {
+            Q_UNUSED(index);
+            return 0;
+        }
+
         virtual Node * parent() const {
             return m_parent;
         }
@@ -258,6 +311,10 @@ class NonLeafNode : virtual public Node
 
         virtual Node * getNode(int index) const;
 
+        virtual Node * childNode(int index) const {
+            return m_childs[index];
+        }
+
 #ifdef CALLIGRA_RTREE_DEBUG
         virtual void paint(QPainter & p, int level) const;
         virtual void debug(QString line) const;
@@ -293,6 +350,10 @@ class LeafNode : virtual public Node
         virtual const T& getData(int index) const;
         virtual int getDataId(int index) const;
 
+        virtual const T * childData(int index) const {
+            return &m_data[index];
+        }
+
         virtual bool isLeaf() const {
             return true;
         }
@@ -320,6 +381,10 @@ class LeafNode : virtual public Node
     QPair<int, int> pickNext(Node * node, QVector<bool> & marker, Node * group1, Node * group2);
     virtual void adjustTree(Node * node1, Node * node2);
     void insertHelper(const QRectF& bb, const T& data, int id);
+    static QRectF insertionBoundingBox(const QRectF& bb);
+
+    // methods for bulk loading
+    void packNodes(const QVector<QRectF>& rects, QVector<int>& order, QVector<int>& nodeEnds) const;
 
     // methods for delete
     void insert(Node * node);
@@ -355,7 +420,7 @@ void KoRTree<T>::insert(const QRectF& bb, const T& data)
 }
 
 template <typename T>
-void KoRTree<T>::insertHelper(const QRectF& bb, const T& data, int id)
+QRectF KoRTree<T>::insertionBoundingBox(const QRectF& bb)
 {
     QRectF nbb(bb.normalized());
     // This has to be done as it is not possible to use QRectF::united() with a isNull()
@@ -374,6 +439,13 @@ void KoRTree<T>::insertHelper(const QRectF& bb, const T& data, int id)
             nbb.setHeight(0.0001);
         }
     }
+    return nbb;
+}
+
+template <typename T>
+void KoRTree<T>::insertHelper(const QRectF& bb, const T& data, int id)
+{
+    QRectF nbb(insertionBoundingBox(bb));
 
     LeafNode * leaf = m_root->chooseLeaf(nbb);
     //qDebug() << " leaf" << leaf->nodeId() << nbb;
@@ -399,6 +471,101 @@ void KoRTree<T>::insertHelper(const QRectF& bb, const T& data, int id)
     }
 }
 
+template <typename T>
+void KoRTree<T>::bulkLoad(const QList<QPair<QRectF, T> > &items)
+{
+    clear();
+    if (items.isEmpty()) {
+        return;
+    }
+
+    QVector<QRectF> rects(items.size());
+    for (int i = 0; i < items.size(); ++i) {
+        rects[i] = insertionBoundingBox(items[i].first);
+    }
+    const int firstId = LeafNode::dataIdCounter;
+    LeafNode::dataIdCounter += items.size();
+
+    QVector<int> order;
+    QVector<int> nodeEnds;
+    packNodes(rects, order, nodeEnds);
+
+    QVector<Node *> nodes;
+    QVector<QRectF> nodeRects;
+    int start = 0;
+    foreach (int end, nodeEnds) {
+        LeafNode * leaf = createLeafNode(m_capacity + 1, 0, 0);
+        for (int i = start; i < end; ++i) {
+            const int index = order[i];
+            leaf->insert(rects[index], items[index].second, firstId + index);
+            m_leafMap[items[index].second] = leaf;
+        }
+        nodes.append(leaf);
+        nodeRects.append(leaf->boundingBox());
+        start = end;
+    }
+
+    int level = 0;
+    while (nodes.size() > 1) {
+        ++level;
+        packNodes(nodeRects, order, nodeEnds);
+
+        QVector<Node *> parents;
+        QVector<QRectF> parentRects;
+        start = 0;
+        foreach (int end, nodeEnds) {
+            NonLeafNode * parent = createNonLeafNode(m_capacity + 1, level, 0);
+            for (int i = start; i < end; ++i) {
+                parent->insert(nodeRects[order[i]], nodes[order[i]]);
+            }
+            parents.append(parent);
+            parentRects.append(parent->boundingBox());
+            start = end;
+        }
+        nodes.swap(parents);
+        nodeRects.swap(parentRects);
+    }
+
+    delete m_root;
+    m_root = nodes.first();
+}
+
+template <typename T>
+void KoRTree<T>::packNodes(const QVector<QRectF>& rects, QVector<int>& order, QVector<int>& nodeEnds) const
+{
+    // Sort-Tile-Recursive: sort by x, cut into vertical slices of about
+    // sqrt(nodes) nodes each, sort each slice by y and cut it into nodes.
+    // The items are spread evenly so that no node ends up nearly empty.
+    const int count = rects.size();
+    const int nodeCount = (count + m_capacity - 1) / m_capacity;
+    const int sliceCount = qCeil(qSqrt(nodeCount));
+
+    order.resize(count);
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&rects](int a, int b) {
+        return rects[a].center().x() < rects[b].center().x();
+    });
+
+    nodeEnds.clear();
+    int sliceStart = 0;
+    for (int slice = 0; slice < sliceCount; ++slice) {
+        const int sliceEnd = sliceStart + (count - sliceStart) / (sliceCount - slice);
+        std::sort(order.begin() + sliceStart, order.begin() + sliceEnd, [&rects](int a, int b) {
+            return rects[a].center().y() < rects[b].center().y();
+        });
+        const int sliceNodes = (sliceEnd - sliceStart + m_capacity - 1) / m_capacity;
+        int nodeStart = sliceStart;
+        for (int node = 0; node < sliceNodes; ++node) {
+            const int nodeEnd = nodeStart + (sliceEnd - nodeStart) / (sliceNodes - node);
+            nodeEnds.append(nodeEnd);
+            nodeStart = nodeEnd;
+        }
+        sliceStart = sliceEnd;
+    }
+}
+
 template <typename T>
 void KoRTree<T>::insert(Node * node)
 {
@@ -470,6 +637,50 @@ QList<T> KoRTree<T>::contains(const QPointF &point) const
     return found.values();
 }
 
+template <typename T>
+template <typename Visitor>
+void KoRTree<T>::visitIntersecting(const QRectF &rect, Visitor visitor) const
+{
+    QVarLengthArray<const Node *, 64> stack;
+    stack.append(m_root);
+    while (!stack.isEmpty()) {
+        const Node * node = stack[stack.size() - 1];
+        stack.resize(stack.size() - 1);
+        const bool leaf = node->isLeaf();
+        for (int i = 0; i < node->childCount(); ++i) {
+            if (node->childBoundingBox(i).intersects(rect)) {
+                if (leaf) {
+                    visitor(*node->childData(i));
+                } else {
+                    stack.append(node->childNode(i));
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+template <typename Visitor>
+void KoRTree<T>::visitContaining(const QPointF &point, Visitor visitor) const
+{
+    QVarLengthArray<const Node *, 64> stack;
+    stack.append(m_root);
+    while (!stack.isEmpty()) {
+        const Node * node = stack[stack.size() - 1];
+        stack.resize(stack.size() - 1);
+        const bool leaf = node->isLeaf();
+        for (int i = 0; i < node->childCount(); ++i) {
+            if (node->childBoundingBox(i).contains(point)) {
+                if (leaf) {
+                    visitor(*node->childData(i));
+                } else {
+                    stack.append(node->childNode(i));
+                }
+            }
+        }
+    }
+}
+
 template <typename T>
 QList<QRectF> KoRTree<T>::keys() const
 {
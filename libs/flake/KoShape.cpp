@@ -49,6 +49,7 @@
 #include "KoEventActionRegistry.h"
 #include "KoOdfWorkaround.h"
 #include "KoFilterEffectStack.h"
+#include "KoImageCache.h"
 #include <KoSnapData.h>
 #include <KoElementReference.h>
 
@@ -64,6 +65,7 @@
 #include <KoStyleStack.h>
 #include <KoBorder.h>
 
+#include <QAtomicInt>
 #include <QPainter>
 #include <QVariant>
 #include <QPainterPath>
@@ -77,6 +79,8 @@
 
 // KoShapePrivate
 
+static QAtomicInt s_nextCacheId;
+
 KoShapePrivate::KoShapePrivate(KoShape *shape)
     : q_ptr(shape),
       size(50, 50),
@@ -103,7 +107,11 @@ KoShapePrivate::KoShapePrivate(KoShape *shape)
       textRunAroundThreshold(0.0),
       textRunAroundContour(KoShape::ContourFull),
       anchor(0),
-      minimumHeight(0.0)
+      minimumHeight(0.0),
+      cacheId(s_nextCacheId.fetchAndAddRelaxed(1)),
+      contentVersion(0),
+      filterResultKey(0),
+      filterJobKey(0)
 {
     // All interactions allowed by default
     allowedInteractions = KoShape::MoveAllowed
@@ -140,11 +148,14 @@ KoShapePrivate::~KoShapePrivate()
         delete filterEffectStack;
     delete clipPath;
     qDeleteAll(eventActions);
+    if (filterResultKey)
+        KoImageCache::instance()->remove(filterResultKey);
 }
 
 void KoShapePrivate::shapeChanged(KoShape::ChangeType type)
 {
     Q_Q(KoShape);
+    contentChanged();
     if (parent)
         parent->model()->childChanged(q, type);
     q->shapeChanged(type);
@@ -152,6 +163,13 @@ void KoShapePrivate::shapeChanged(KoShape::ChangeType type)
         shape->shapeChanged(type, q);
 }
 
+void KoShapePrivate::contentChanged() const
+{
+    for (const KoShape *shape = q_ptr; shape; shape = shape->parent()) {
+        ++shape->d_ptr->contentVersion;
+    }
+}
+
 void KoShapePrivate::updateStroke()
 {
     Q_Q(KoShape);
@@ -587,6 +605,7 @@ int KoShape::zIndex() const
 void KoShape::update() const
 {
     Q_D(const KoShape);
+    d->contentChanged();
 
     if (!d->shapeManagers.empty()) {
         QRectF rect(boundingRect());
@@ -604,6 +623,7 @@ void KoShape::update(const QRectF &rect) const
     }
 
     Q_D(const KoShape);
+    d->contentChanged();
 
     if (!d->shapeManagers.empty() && isVisible()) {
         QRectF rc(absoluteTransformation(0).mapRect(rect));
@@ -1055,7 +1075,11 @@ int KoShape::runThrough()
 void KoShape::setRunThrough(short int runThrough)
 {
     Q_D(KoShape);
+    if (d->runThrough == runThrough)
+        return;
     d->runThrough = runThrough;
+    // the run through changes the stacking order, like the z-index does
+    notifyChanged();
 }
 
 void KoShape::setVisible(bool on)
@@ -2365,6 +2389,7 @@ void KoShape::setFilterEffectStack(KoFilterEffectStack *filterEffectStack)
     if (d->filterEffectStack) {
         d->filterEffectStack->ref();
     }
+    d->contentChanged();
     notifyChanged();
 }
 
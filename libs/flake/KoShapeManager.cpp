@@ -42,11 +42,22 @@
 #include <KoRTree.h>
 #include "KoClipPath.h"
 #include "KoShapePaintingContext.h"
+#include "KoImageCache.h"
 
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QPainter>
 #include <QTimer>
 #include <FlakeDebug.h>
 
+#include <algorithm>
+#include <qmath.h>
+
+/// the width and height of the tiles of the tiled painting, in pixels
+#define TILE_SIZE 256
+
+Q_GLOBAL_STATIC(KoFilterEffectJobNotifier, s_filterEffectJobNotifier)
 
 void KoShapeManager::Private::updateTree()
 {
@@ -103,11 +114,249 @@ void KoShapeManager::Private::paintGroup(KoShapeGroup *group, QPainter &painter,
     }
 }
 
+void KoShapeManager::Private::paintWithoutFilterEffects(KoShape *shape, QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext)
+{
+    painter.save();
+    KoShapeGroup *group = dynamic_cast<KoShapeGroup*>(shape);
+    if (group) {
+        // the children of a group with filter effects are only painted with the group,
+        // they bring the transformation of the group themselves
+        painter.setTransform(group->absoluteTransformation(&converter).inverted(), true);
+        paintGroup(group, painter, converter, paintContext);
+    } else {
+        shape->paint(painter, converter, paintContext);
+        if (shape->stroke()) {
+            shape->stroke()->paint(shape, painter, converter);
+        }
+    }
+    painter.restore();
+}
+
+void KoShapeManager::Private::updatePaintOrder()
+{
+    if (!paintOrderPending.isEmpty()) {
+        if (paintOrderPending.count() > paintOrder.count() / 8) {
+            paintOrder = shapes.toVector();
+            std::stable_sort(paintOrder.begin(), paintOrder.end(), KoShape::compareShapeZIndex);
+        } else {
+            QSet<KoShape *> &pending = paintOrderPending;
+            paintOrder.erase(std::remove_if(paintOrder.begin(), paintOrder.end(),
+                                            [&pending](KoShape *shape) { return pending.contains(shape); }),
+                             paintOrder.end());
+            // removed shapes might already be deleted, so only touch the ones still managed
+            foreach (KoShape *shape, paintOrderPending) {
+                if (shapeSet.contains(shape)) {
+                    paintOrder.insert(std::upper_bound(paintOrder.begin(), paintOrder.end(), shape, KoShape::compareShapeZIndex), shape);
+                }
+            }
+        }
+        paintOrderPending.clear();
+        paintOrderIndexValid = false;
+    }
+
+    if (!paintOrderIndexValid) {
+        paintOrderIndex.clear();
+        paintOrderIndex.reserve(paintOrder.count());
+        for (int i = 0; i < paintOrder.count(); ++i) {
+            paintOrderIndex.insert(paintOrder.at(i), i);
+        }
+        paintOrderIndexValid = true;
+    }
+}
+
+void KoShapeManager::Private::markChildrenPaintOrderPending(KoShapeContainer *container)
+{
+    foreach (KoShape *child, container->shapes()) {
+        if (shapeSet.contains(child)) {
+            paintOrderPending.insert(child);
+        }
+        KoShapeContainer *childContainer = dynamic_cast<KoShapeContainer*>(child);
+        if (childContainer) {
+            markChildrenPaintOrderPending(childContainer);
+        }
+    }
+}
+
+void KoShapeManager::Private::sortByPaintOrder(QList<KoShape *> &shapes)
+{
+    updatePaintOrder();
+    const QHash<KoShape *, int> &index = paintOrderIndex;
+    std::sort(shapes.begin(), shapes.end(), [&index](KoShape *s1, KoShape *s2) {
+        return index.value(s1) < index.value(s2);
+    });
+}
+
+QList<KoShape *> KoShapeManager::Private::paintableShapes(const QList<KoShape *> &unsortedShapes)
+{
+    // filter all hidden shapes from the list
+    // also filter shapes with a parent which has filter effects applied
+    QList<KoShape*> sortedShapes;
+    QSet<KoShape*> filteredParents;
+    foreach (KoShape *shape, unsortedShapes) {
+        if (!shape->isVisible(true))
+            continue;
+        bool addShapeToList = true;
+        // check if one of the shapes ancestors have filter effects
+        KoShapeContainer *parent = shape->parent();
+        while (parent) {
+            // parent must be part of the shape manager to be taken into account
+            if (!shapeSet.contains(parent))
+                break;
+            if (parent->filterEffectStack() && !parent->filterEffectStack()->isEmpty()) {
+                addShapeToList = false;
+                break;
+            }
+            parent = parent->parent();
+        }
+        if (addShapeToList) {
+            sortedShapes.append(shape);
+        } else if (parent && !filteredParents.contains(parent)) {
+            // the parent paints all its children at once, so only add it once
+            filteredParents.insert(parent);
+            sortedShapes.append(parent);
+        }
+    }
+
+    sortByPaintOrder(sortedShapes);
+    return sortedShapes;
+}
+
+void KoShapeManager::Private::paintShapes(const QList<KoShape *> &shapes, QPainter &painter, const KoViewConverter &converter, bool forPrint,
+                                          KoShapePaintingContext::LevelOfDetail levelOfDetail)
+{
+    foreach (KoShape *shape, shapes) {
+        if (shape->parent() != 0 && shape->parent()->isClipped(shape))
+            continue;
+
+        painter.save();
+
+        // apply shape clipping
+        KoClipPath::applyClipping(shape, painter, converter);
+
+        // let the painting strategy paint the shape
+        KoShapePaintingContext paintContext(canvas, forPrint); //FIXME
+        paintContext.levelOfDetail = levelOfDetail;
+        strategy->paint(shape, painter, converter, paintContext);
+
+        painter.restore();
+    }
+}
+
+bool KoShapeManager::Private::paintTiled(QPainter &painter, const KoViewConverter &converter,
+                                         KoShapePaintingContext::LevelOfDetail levelOfDetail)
+{
+    // the tiles are drawn pixel for pixel, so the painter may only move them by whole pixels
+    const QTransform transform = painter.deviceTransform();
+    if (!painter.hasClipping() || transform.type() > QTransform::TxTranslate
+            || transform.dx() != qRound(transform.dx()) || transform.dy() != qRound(transform.dy())) {
+        return false;
+    }
+
+    qreal zoomX, zoomY;
+    converter.zoom(&zoomX, &zoomY);
+    // the shapes paint differently depending on what the canvas asks to show
+    const KoShapePaintingContext context(canvas, false);
+    const uint paintFlags = uint(context.showFormattingCharacters)
+        | uint(context.showTextShapeOutlines) << 1
+        | uint(context.showTableBorders) << 2
+        | uint(context.showSectionBounds) << 3
+        | uint(context.showSpellChecking) << 4
+        | uint(context.showSelections) << 5
+        | uint(context.showInlineObjectVisualization) << 6
+        | uint(context.showAnnotations) << 7;
+    const QRect clipRect = painter.clipRegion().boundingRect();
+    const int firstColumn = qFloor(qreal(clipRect.left()) / TILE_SIZE);
+    const int lastColumn = qFloor(qreal(clipRect.right()) / TILE_SIZE);
+    const int firstRow = qFloor(qreal(clipRect.top()) / TILE_SIZE);
+    const int lastRow = qFloor(qreal(clipRect.bottom()) / TILE_SIZE);
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QRect tileRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+            // include the pixel around the tile that antialiasing may touch
+            const QRectF documentRect = converter.viewToDocument(QRectF(tileRect).adjusted(-1, -1, 1, 1));
+            QList<KoShape *> unsortedShapes;
+            tree.visitIntersecting(documentRect, [&unsortedShapes](KoShape *shape) {
+                unsortedShapes.append(shape);
+            });
+            const QList<KoShape *> shapes = paintableShapes(unsortedShapes);
+
+            // every run of shapes of the same layer gets a tile of its own, so
+            // changing one layer does not require painting the others again
+            int run = 0;
+            int begin = 0;
+            while (begin < shapes.count()) {
+                const KoShapeLayer *layer = layerOf(shapes.at(begin));
+                int end = begin + 1;
+                while (end < shapes.count() && layerOf(shapes.at(end)) == layer) {
+                    ++end;
+                }
+                const QList<KoShape *> runShapes = shapes.mid(begin, end - begin);
+
+                // a tile is only reused for exactly the shapes it was painted with; when
+                // shapes were added, removed or moved in or out of it the runs shift
+                const KoShapeManagerTileKey key(zoomX, zoomY, paintFlags, column, row, run);
+                const KoShapeManagerTile *tile = tiles.object(key);
+                if (tile && tile->shapes == runShapes) {
+                    painter.drawImage(tileRect.topLeft(), tile->image);
+                } else {
+                    QImage image(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+                    image.fill(0);
+                    QPainter tilePainter(&image);
+                    tilePainter.setRenderHints(painter.renderHints());
+                    tilePainter.translate(-tileRect.topLeft());
+                    tilePainter.setClipRect(tileRect);
+                    tilePainter.setPen(Qt::NoPen);
+                    tilePainter.setBrush(Qt::NoBrush);
+                    paintShapes(runShapes, tilePainter, converter, false, levelOfDetail);
+                    tilePainter.end();
+
+                    painter.drawImage(tileRect.topLeft(), image);
+                    if (levelOfDetail == KoShapePaintingContext::FullDetail) {
+                        tiles.insert(key, new KoShapeManagerTile(runShapes, layer, documentRect, image),
+                                     image.byteCount() / 1024);
+                    }
+                }
+
+                begin = end;
+                ++run;
+            }
+        }
+    }
+    return true;
+}
+
+void KoShapeManager::Private::invalidateTiles(const QRectF &rect, const KoShape *shape)
+{
+    if (tiles.isEmpty())
+        return;
+
+    const KoShapeLayer *layer = shape ? layerOf(shape) : 0;
+    foreach (const KoShapeManagerTileKey &key, tiles.keys()) {
+        const KoShapeManagerTile *tile = tiles.object(key);
+        if ((!shape || tile->layer == layer) && tile->documentRect.intersects(rect)) {
+            tiles.remove(key);
+        }
+    }
+}
+
+const KoShapeLayer *KoShapeManager::Private::layerOf(const KoShape *shape)
+{
+    const KoShapeLayer *layer = 0;
+    for (; shape; shape = shape->parent()) {
+        const KoShapeLayer *shapeLayer = dynamic_cast<const KoShapeLayer *>(shape);
+        if (shapeLayer)
+            layer = shapeLayer;
+    }
+    return layer;
+}
+
 KoShapeManager::KoShapeManager(KoCanvasBase *canvas, const QList<KoShape *> &shapes)
         : d(new Private(this, canvas))
 {
     Q_ASSERT(d->canvas); // not optional.
     connect(d->selection, SIGNAL(selectionChanged()), this, SIGNAL(selectionChanged()));
+    connect(&d->refinementTimer, SIGNAL(timeout()), this, SLOT(endInteraction()));
     setShapes(shapes);
 }
 
@@ -116,10 +365,16 @@ KoShapeManager::KoShapeManager(KoCanvasBase *canvas)
 {
     Q_ASSERT(d->canvas); // not optional.
     connect(d->selection, SIGNAL(selectionChanged()), this, SIGNAL(selectionChanged()));
+    connect(&d->refinementTimer, SIGNAL(timeout()), this, SLOT(endInteraction()));
 }
 
 KoShapeManager::~KoShapeManager()
 {
+    KoFilterEffectJobNotifier::removeManager(this);
+    // the jobs this shape manager started can not report back to their shapes anymore
+    foreach (const Private::PendingFilterResult &pending, d->filterJobs) {
+        pending.shape->priv()->filterJobKey = 0;
+    }
     foreach(KoShape *shape, d->shapes) {
         shape->priv()->removeShapeManager(this);
     }
@@ -140,18 +395,45 @@ void KoShapeManager::setShapes(const QList<KoShape *> &shapes, Repaint repaint)
     d->aggregate4update.clear();
     d->tree.clear();
     d->shapes.clear();
+    d->shapeSet.clear();
+    d->paintOrder.clear();
+    d->paintOrderPending.clear();
+    d->paintOrderIndexValid = false;
+    d->tiles.clear();
+
+    d->settingShapes = true;
     foreach(KoShape *shape, shapes) {
         addShape(shape, repaint);
     }
+    d->settingShapes = false;
+
+    // bulk loading is much faster than inserting the shapes one by one
+    QList<QPair<QRectF, KoShape *> > treeItems;
+    foreach(KoShape *shape, d->shapes) {
+        if (! dynamic_cast<KoShapeGroup*>(shape) && ! dynamic_cast<KoShapeLayer*>(shape)) {
+            treeItems.append(qMakePair(shape->boundingRect(), shape));
+        }
+    }
+    d->tree.bulkLoad(treeItems);
+
+    Private::DetectCollision detector;
+    foreach(KoShape *shape, d->shapes) {
+        detector.detect(d->tree, shape, shape->zIndex());
+    }
+    detector.fireSignals();
 }
 
 void KoShapeManager::addShape(KoShape *shape, Repaint repaint)
 {
-    if (d->shapes.contains(shape))
+    if (d->shapeSet.contains(shape))
         return;
     shape->priv()->addShapeManager(this);
     d->shapes.append(shape);
-    if (! dynamic_cast<KoShapeGroup*>(shape) && ! dynamic_cast<KoShapeLayer*>(shape)) {
+    d->shapeSet.insert(shape);
+    d->paintOrderPending.insert(shape);
+    // a tile may still show a deleted shape that had the same address
+    d->invalidateTiles(shape->boundingRect(), shape);
+    if (! d->settingShapes && ! dynamic_cast<KoShapeGroup*>(shape) && ! dynamic_cast<KoShapeLayer*>(shape)) {
         QRectF br(shape->boundingRect());
         d->tree.insert(br, shape);
     }
@@ -168,9 +450,11 @@ void KoShapeManager::addShape(KoShape *shape, Repaint repaint)
         }
     }
 
-    Private::DetectCollision detector;
-    detector.detect(d->tree, shape, shape->zIndex());
-    detector.fireSignals();
+    if (! d->settingShapes) {
+        Private::DetectCollision detector;
+        detector.detect(d->tree, shape, shape->zIndex());
+        detector.fireSignals();
+    }
 }
 
 void KoShapeManager::addAdditional(KoShape *shape)
@@ -196,6 +480,19 @@ void KoShapeManager::remove(KoShape *shape)
     d->aggregate4update.remove(shape);
     d->tree.remove(shape);
     d->shapes.removeAll(shape);
+    d->shapeSet.remove(shape);
+    d->paintOrderPending.insert(shape);
+    QHash<qint64, Private::PendingFilterResult>::iterator it = d->filterJobs.begin();
+    while (it != d->filterJobs.end()) {
+        if (it->shape == shape) {
+            // nobody tells the shape when the job is done, so other shape managers may start another one
+            if (shape->priv()->filterJobKey == it.key())
+                shape->priv()->filterJobKey = 0;
+            it = d->filterJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
 
     // remove the children of a KoShapeContainer
     KoShapeContainer *container = dynamic_cast<KoShapeContainer*>(shape);
@@ -224,58 +521,41 @@ void KoShapeManager::paint(QPainter &painter, const KoViewConverter &converter,
     painter.setPen(Qt::NoPen);  // painters by default have a black stroke, lets turn that off.
     painter.setBrush(Qt::NoBrush);
 
-    QList<KoShape*> unsortedShapes;
-    if (painter.hasClipping()) {
-        QRectF rect = converter.viewToDocument(painter.clipRegion().boundingRect());
-        unsortedShapes = d->tree.intersects(rect);
-    } else {
-        unsortedShapes = shapes();
-        warnFlake << "KoShapeManager::paint  Painting with a painter that has no clipping will lead to too much being painted!";
-    }
-
-    // filter all hidden shapes from the list
-    // also filter shapes with a parent which has filter effects applied
-    QList<KoShape*> sortedShapes;
-    foreach (KoShape *shape, unsortedShapes) {
-        if (!shape->isVisible(true))
-            continue;
-        bool addShapeToList = true;
-        // check if one of the shapes ancestors have filter effects
-        KoShapeContainer *parent = shape->parent();
-        while (parent) {
-            // parent must be part of the shape manager to be taken into account
-            if (!d->shapes.contains(parent))
-                break;
-            if (parent->filterEffectStack() && !parent->filterEffectStack()->isEmpty()) {
-                addShapeToList = false;
-                break;
+    // while the user zooms or pans only a draft is painted
+    const KoShapePaintingContext::LevelOfDetail levelOfDetail = d->interacting && !forPrint
+        ? KoShapePaintingContext::DraftDetail : KoShapePaintingContext::FullDetail;
+    const bool smoothPixmaps = painter.testRenderHint(QPainter::SmoothPixmapTransform);
+    if (levelOfDetail == KoShapePaintingContext::DraftDetail)
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+    if (levelOfDetail == KoShapePaintingContext::DraftDetail) {
+        // remember what to paint again at full detail when the interaction is over
+        if (painter.hasClipping()) {
+            d->draftRect |= converter.viewToDocument(painter.clipRegion().boundingRect());
+        } else {
+            foreach (KoShape *shape, d->shapes) {
+                if (!shape->parent() && shape->isVisible())
+                    d->draftRect |= shape->boundingRect();
             }
-            parent = parent->parent();
-        }
-        if (addShapeToList) {
-            sortedShapes.append(shape);
-        } else if (parent) {
-            sortedShapes.append(parent);
         }
     }
 
-    qSort(sortedShapes.begin(), sortedShapes.end(), KoShape::compareShapeZIndex);
-
-    foreach (KoShape *shape, sortedShapes) {
-        if (shape->parent() != 0 && shape->parent()->isClipped(shape))
-            continue;
-
-        painter.save();
-
-        // apply shape clipping
-        KoClipPath::applyClipping(shape, painter, converter);
-
-        // let the painting strategy paint the shape
-        KoShapePaintingContext paintContext(d->canvas, forPrint); //FIXME
-        d->strategy->paint(shape, painter, converter, paintContext);
+    const bool paintedTiled = d->tiledPainting && !forPrint && d->paintTiled(painter, converter, levelOfDetail);
+    if (!paintedTiled) {
+        QList<KoShape*> unsortedShapes;
+        if (painter.hasClipping()) {
+            QRectF rect = converter.viewToDocument(painter.clipRegion().boundingRect());
+            d->tree.visitIntersecting(rect, [&unsortedShapes](KoShape *shape) {
+                unsortedShapes.append(shape);
+            });
+        } else {
+            unsortedShapes = shapes();
+            warnFlake << "KoShapeManager::paint  Painting with a painter that has no clipping will lead to too much being painted!";
+        }
 
-        painter.restore();
+        d->paintShapes(d->paintableShapes(unsortedShapes), painter, converter, forPrint, levelOfDetail);
     }
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, smoothPixmaps);
 
 #ifdef CALLIGRA_RTREE_DEBUG
     // paint tree
@@ -301,7 +581,8 @@ void KoShapeManager::paintShape(KoShape *shape, QPainter &painter, const KoViewC
         painter.setOpacity(1.0-transparency);
     }
 
-    if (shape->shadow()) {
+    const bool draft = paintContext.levelOfDetail == KoShapePaintingContext::DraftDetail;
+    if (shape->shadow() && !draft) {
         painter.save();
         shape->shadow()->paint(shape, painter, converter);
         painter.restore();
@@ -324,114 +605,243 @@ void KoShapeManager::paintShape(KoShape *shape, QPainter &painter, const KoViewC
         QRectF zoomedClipRegion = converter.documentToView(clipRegion);
         // determine the offset of the clipping rect from the shapes origin
         QPointF clippingOffset = zoomedClipRegion.topLeft();
-
-        // Initialize the buffer image
-        QImage sourceGraphic(zoomedClipRegion.size().toSize(), QImage::Format_ARGB32_Premultiplied);
-        sourceGraphic.fill(qRgba(0,0,0,0));
-
-        QHash<QString, QImage> imageBuffers;
-
-        QSet<QString> requiredStdInputs = shape->filterEffectStack()->requiredStandarsInputs();
-
-        if (requiredStdInputs.contains("SourceGraphic") || requiredStdInputs.contains("SourceAlpha")) {
-            // Init the buffer painter
-            QPainter imagePainter(&sourceGraphic);
-            imagePainter.translate(-1.0f*clippingOffset);
-            imagePainter.setPen(Qt::NoPen);
-            imagePainter.setBrush(Qt::NoBrush);
-            imagePainter.setRenderHint(QPainter::Antialiasing, painter.testRenderHint(QPainter::Antialiasing));
-
-            // Paint the shape on the image
-            KoShapeGroup *group = dynamic_cast<KoShapeGroup*>(shape);
-            if (group) {
-                // the childrens matrix contains the groups matrix as well
-                // so we have to compensate for that before painting the children
-                imagePainter.setTransform(group->absoluteTransformation(&converter).inverted(), true);
-                d->paintGroup(group, imagePainter, converter, paintContext);
-            } else {
-                imagePainter.save();
-                shape->paint(imagePainter, converter, paintContext);
-                imagePainter.restore();
-                if (shape->stroke()) {
-                    imagePainter.save();
-                    shape->stroke()->paint(shape, imagePainter, converter);
-                    imagePainter.restore();
+        const QSize resultSize = zoomedClipRegion.size().toSize();
+
+        // the filter effects are only applied again when the shape or the zoom changed
+        KoImageCache *cache = KoImageCache::instance();
+        const qint64 key = d->filterResultKey(shape, converter, painter.testRenderHint(QPainter::Antialiasing));
+        QImage result = cache->find(key, resultSize, QImage::Format_ARGB32_Premultiplied);
+        if (result.isNull()) {
+            KoShapePrivate *shapePrivate = shape->priv();
+            qreal zoomX, zoomY;
+            converter.zoom(&zoomX, &zoomY);
+            const int deviceType = painter.device()->devType();
+
+            const QImage previousResult = shapePrivate->filterResultKey
+                ? cache->find(shapePrivate->filterResultKey, shapePrivate->filterResultSize, QImage::Format_ARGB32_Premultiplied)
+                : QImage();
+            // while there is an older result to show apply the effects in the background,
+            // but not when printing as that is done only once; drafts only show the older result
+            const bool asynchronous = !previousResult.isNull() && (draft || (qFuzzyCompare(zoomX, zoomY)
+                && deviceType != QInternal::Printer && deviceType != QInternal::Picture));
+            // the shape may be shown by other shape managers that started the job already
+            const bool startJob = asynchronous && !draft && shapePrivate->filterJobKey != key;
+            // the job works on a copy of the effects, they may be edited while it runs;
+            // effects that cannot be copied are applied right away
+            KoFilterEffectStack *stack = startJob ? shape->filterEffectStack()->clone() : 0;
+
+            if (asynchronous && (!startJob || stack)) {
+                if (stack) {
+                    shapePrivate->filterJobKey = key;
+                    Private::PendingFilterResult pending = { shape, resultSize };
+                    d->filterJobs.insert(key, pending);
+                    const QHash<QString, QImage> inputs = d->filterInputs(shape, zoomedClipRegion, painter, converter, paintContext);
+                    KoFilterEffectJobNotifier::instance()->addJob(key, this);
+                    QThreadPool::globalInstance()->start(new KoFilterEffectJob(stack, inputs, shapeBound, zoomX, key));
                 }
-                imagePainter.end();
+                // show the older result, scaled to the new size, until the job is done
+                painter.save();
+                painter.drawImage(zoomedClipRegion, previousResult);
+                painter.restore();
+                return;
             }
-        }
-        if (requiredStdInputs.contains("SourceAlpha")) {
-            QImage sourceAlpha = sourceGraphic;
-            sourceAlpha.fill(qRgba(0,0,0,255));
-            sourceAlpha.setAlphaChannel(sourceGraphic.alphaChannel());
-            imageBuffers.insert("SourceAlpha", sourceAlpha);
-        }
-        if (requiredStdInputs.contains("FillPaint")) {
-            QImage fillPaint = sourceGraphic;
-            if (shape->background()) {
-                QPainter fillPainter(&fillPaint);
-                QPainterPath fillPath;
-                fillPath.addRect(fillPaint.rect().adjusted(-1,-1,1,1));
-                shape->background()->paint(fillPainter, converter, paintContext, fillPath);
-            } else {
-                fillPaint.fill(qRgba(0,0,0,0));
+            if (draft) {
+                // the effects are applied when the interaction is over
+                d->paintWithoutFilterEffects(shape, painter, converter, paintContext);
+                return;
             }
-            imageBuffers.insert("FillPaint", fillPaint);
-        }
 
-        imageBuffers.insert("SourceGraphic", sourceGraphic);
-        imageBuffers.insert(QString(), sourceGraphic);
-
-        KoFilterEffectRenderContext renderContext(converter);
-        renderContext.setShapeBoundingBox(shapeBound);
-
-        QImage result;
-        QList<KoFilterEffect*> filterEffects = shape->filterEffectStack()->filterEffects();
-        // Filter
-        foreach (KoFilterEffect *filterEffect, filterEffects) {
-            QRectF filterRegion = filterEffect->filterRectForBoundingRect(shapeBound);
-            filterRegion = converter.documentToView(filterRegion);
-            QRect subRegion = filterRegion.translated(-clippingOffset).toRect();
-            // set current filter region
-            renderContext.setFilterRegion(subRegion & sourceGraphic.rect());
-
-            if (filterEffect->maximalInputCount() <= 1) {
-                QList<QString> inputs = filterEffect->inputs();
-                QString input = inputs.count() ? inputs.first() : QString();
-                // get input image from image buffers and apply the filter effect
-                QImage image = imageBuffers.value(input);
-                if (!image.isNull()) {
-                    result = filterEffect->processImage(imageBuffers.value(input), renderContext);
-                }
-            } else {
-                QVector<QImage> inputImages;
-                foreach(const QString &input, filterEffect->inputs()) {
-                    QImage image = imageBuffers.value(input);
-                    if (!image.isNull())
-                        inputImages.append(imageBuffers.value(input));
-                }
-                // apply the filter effect
-                if (filterEffect->inputs().count() == inputImages.count())
-                    result = filterEffect->processImages(inputImages, renderContext);
-            }
-            // store result of effect
-            imageBuffers.insert(filterEffect->output(), result);
+            const QHash<QString, QImage> inputs = d->filterInputs(shape, zoomedClipRegion, painter, converter, paintContext);
+            result = shape->filterEffectStack()->applyFilterEffects(inputs, shapeBound, converter);
+            if (result.isNull())
+                return;
+            cache->insert(key, result);
+            shapePrivate->filterResultKey = key;
+            shapePrivate->filterResultSize = resultSize;
         }
 
-        KoFilterEffect *lastEffect = filterEffects.last();
-
         // Paint the result
         painter.save();
-        painter.drawImage(clippingOffset, imageBuffers.value(lastEffect->output()));
+        painter.drawImage(clippingOffset, result);
         painter.restore();
     }
 }
 
+QHash<QString, QImage> KoShapeManager::Private::filterInputs(KoShape *shape, const QRectF &zoomedClipRegion, QPainter &painter,
+                                                            const KoViewConverter &converter, KoShapePaintingContext &paintContext)
+{
+    // determine the offset of the clipping rect from the shapes origin
+    QPointF clippingOffset = zoomedClipRegion.topLeft();
+
+    // Initialize the buffer image
+    QImage sourceGraphic(zoomedClipRegion.size().toSize(), QImage::Format_ARGB32_Premultiplied);
+    sourceGraphic.fill(qRgba(0,0,0,0));
+
+    QHash<QString, QImage> imageBuffers;
+
+    QSet<QString> requiredStdInputs = shape->filterEffectStack()->requiredStandarsInputs();
+
+    if (requiredStdInputs.contains("SourceGraphic") || requiredStdInputs.contains("SourceAlpha")) {
+        // Init the buffer painter
+        QPainter imagePainter(&sourceGraphic);
+        imagePainter.translate(-1.0f*clippingOffset);
+        imagePainter.setPen(Qt::NoPen);
+        imagePainter.setBrush(Qt::NoBrush);
+        imagePainter.setRenderHint(QPainter::Antialiasing, painter.testRenderHint(QPainter::Antialiasing));
+
+        // Paint the shape on the image
+        KoShapeGroup *group = dynamic_cast<KoShapeGroup*>(shape);
+        if (group) {
+            // the childrens matrix contains the groups matrix as well
+            // so we have to compensate for that before painting the children
+            imagePainter.setTransform(group->absoluteTransformation(&converter).inverted(), true);
+            paintGroup(group, imagePainter, converter, paintContext);
+        } else {
+            imagePainter.save();
+            shape->paint(imagePainter, converter, paintContext);
+            imagePainter.restore();
+            if (shape->stroke()) {
+                imagePainter.save();
+                shape->stroke()->paint(shape, imagePainter, converter);
+                imagePainter.restore();
+            }
+            imagePainter.end();
+        }
+    }
+    if (requiredStdInputs.contains("SourceAlpha")) {
+        QImage sourceAlpha = sourceGraphic;
+        sourceAlpha.fill(qRgba(0,0,0,255));
+        sourceAlpha.setAlphaChannel(sourceGraphic.alphaChannel());
+        imageBuffers.insert("SourceAlpha", sourceAlpha);
+    }
+    if (requiredStdInputs.contains("FillPaint")) {
+        QImage fillPaint = sourceGraphic;
+        if (shape->background()) {
+            QPainter fillPainter(&fillPaint);
+            QPainterPath fillPath;
+            fillPath.addRect(fillPaint.rect().adjusted(-1,-1,1,1));
+            shape->background()->paint(fillPainter, converter, paintContext, fillPath);
+        } else {
+            fillPaint.fill(qRgba(0,0,0,0));
+        }
+        imageBuffers.insert("FillPaint", fillPaint);
+    }
+
+    imageBuffers.insert("SourceGraphic", sourceGraphic);
+    imageBuffers.insert(QString(), sourceGraphic);
+    return imageBuffers;
+}
+
+qint64 KoShapeManager::Private::filterResultKey(const KoShape *shape, const KoViewConverter &converter, bool antialiasing)
+{
+    qreal zoomX, zoomY;
+    converter.zoom(&zoomX, &zoomY);
+    const KoShapePrivate *shapePrivate = const_cast<KoShape *>(shape)->priv();
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << shapePrivate->cacheId << shapePrivate->contentVersion
+           << shape->filterEffectStack()->version() << zoomX << zoomY << antialiasing;
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    qint64 key;
+    memcpy(&key, hash.constData(), sizeof(key));
+    return key;
+}
+
+void KoShapeManager::Private::filterResultReady(qint64 key, const QImage &result)
+{
+    if (!filterJobs.contains(key))
+        return; // the shape was removed or deleted in the mean time, drop the result
+    const PendingFilterResult pending = filterJobs.take(key);
+    KoShapePrivate *shapePrivate = pending.shape->priv();
+    if (shapePrivate->filterJobKey == key)
+        shapePrivate->filterJobKey = 0;
+    if (result.isNull())
+        return;
+    KoImageCache::instance()->insert(key, result);
+    shapePrivate->filterResultKey = key;
+    shapePrivate->filterResultSize = pending.size;
+
+    // repaint in all shape managers that show the shape, without marking the
+    // shape as changed, which would apply the effects again
+    QRectF rect = pending.shape->boundingRect();
+    foreach (KoShapeManager *manager, shapePrivate->shapeManagers) {
+        manager->update(rect, pending.shape);
+    }
+}
+
+KoFilterEffectJob::KoFilterEffectJob(KoFilterEffectStack *stack, const QHash<QString, QImage> &inputs,
+                                     const QRectF &shapeBound, qreal zoom, qint64 key)
+    : QRunnable(),
+      m_stack(stack),
+      m_inputs(inputs),
+      m_shapeBound(shapeBound),
+      m_key(key)
+{
+    m_converter.setZoom(zoom);
+    setAutoDelete(true);
+}
+
+KoFilterEffectJob::~KoFilterEffectJob()
+{
+    delete m_stack;
+}
+
+void KoFilterEffectJob::run()
+{
+    const QImage result = m_stack->applyFilterEffects(m_inputs, m_shapeBound, m_converter);
+    QMetaObject::invokeMethod(KoFilterEffectJobNotifier::instance(), "jobFinished", Qt::QueuedConnection,
+                              Q_ARG(qint64, m_key), Q_ARG(QImage, result));
+}
+
+KoFilterEffectJobNotifier::KoFilterEffectJobNotifier()
+{
+    // the results have to arrive in the gui thread
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+}
+
+KoFilterEffectJobNotifier *KoFilterEffectJobNotifier::instance()
+{
+    return s_filterEffectJobNotifier();
+}
+
+void KoFilterEffectJobNotifier::addJob(qint64 key, KoShapeManager *manager)
+{
+    m_jobs.insert(key, manager);
+}
+
+void KoFilterEffectJobNotifier::removeManager(KoShapeManager *manager)
+{
+    if (!s_filterEffectJobNotifier.exists() || s_filterEffectJobNotifier.isDestroyed())
+        return;
+    QHash<qint64, KoShapeManager *> &jobs = s_filterEffectJobNotifier()->m_jobs;
+    QHash<qint64, KoShapeManager *>::iterator it = jobs.begin();
+    while (it != jobs.end()) {
+        if (it.value() == manager)
+            it = jobs.erase(it);
+        else
+            ++it;
+    }
+}
+
+void KoFilterEffectJobNotifier::jobFinished(qint64 key, const QImage &result)
+{
+    KoShapeManager *manager = m_jobs.take(key);
+    if (manager) {
+        QMetaObject::invokeMethod(manager, "filterResultReady", Qt::DirectConnection,
+                                  Q_ARG(qint64, key), Q_ARG(QImage, result));
+    }
+}
+
 KoShape *KoShapeManager::shapeAt(const QPointF &position, KoFlake::ShapeSelection selection, bool omitHiddenShapes)
 {
     d->updateTree();
-    QList<KoShape*> sortedShapes(d->tree.contains(position));
-    qSort(sortedShapes.begin(), sortedShapes.end(), KoShape::compareShapeZIndex);
+    QList<KoShape*> sortedShapes;
+    d->tree.visitContaining(position, [&sortedShapes](KoShape *shape) {
+        sortedShapes.append(shape);
+    });
+    d->sortByPaintOrder(sortedShapes);
     KoShape *firstUnselectedShape = 0;
     for (int count = sortedShapes.count() - 1; count >= 0; count--) {
         KoShape *shape = sortedShapes.at(count);
@@ -479,19 +889,15 @@ KoShape *KoShapeManager::shapeAt(const QPointF &position, KoFlake::ShapeSelectio
 QList<KoShape *> KoShapeManager::shapesAt(const QRectF &rect, bool omitHiddenShapes)
 { 
     d->updateTree();
-    QList<KoShape*> intersectedShapes(d->tree.intersects(rect));
-    
-    for (int count = intersectedShapes.count() - 1; count >= 0; count--) {
-     
-        KoShape *shape = intersectedShapes.at(count);
-       
-        if (omitHiddenShapes && ! shape->isVisible(true)) {
-            intersectedShapes.removeAt(count);
-        } else {
-            const QPainterPath outline = shape->absoluteTransformation(0).map(shape->outline());
-            if (! outline.intersects(rect) && ! outline.contains(rect)) { 
-                intersectedShapes.removeAt(count);
-            }
+    // use intersects() rather than the visitor, callers rely on the shapes
+    // coming in the order they were added
+    QList<KoShape*> intersectedShapes;
+    foreach (KoShape *shape, d->tree.intersects(rect)) {
+        if (omitHiddenShapes && ! shape->isVisible(true))
+            continue;
+        const QPainterPath outline = shape->absoluteTransformation(0).map(shape->outline());
+        if (outline.intersects(rect) || outline.contains(rect)) {
+            intersectedShapes.append(shape);
         }
     }
     return intersectedShapes;
@@ -499,6 +905,7 @@ QList<KoShape *> KoShapeManager::shapesAt(const QRectF &rect, bool omitHiddenSha
 
 void KoShapeManager::update(QRectF &rect, const KoShape *shape, bool selectionHandles)
 {
+    d->invalidateTiles(rect, shape);
     d->canvas->updateCanvas(rect);
     if (selectionHandles && d->selection->isSelected(shape)) {
         if (d->canvas->toolProxy())
@@ -509,14 +916,24 @@ void KoShapeManager::update(QRectF &rect, const KoShape *shape, bool selectionHa
 void KoShapeManager::notifyShapeChanged(KoShape *shape)
 {
     Q_ASSERT(shape);
+    if (d->shapeSet.contains(shape)) {
+        // its z-index or parent might have changed
+        d->paintOrderPending.insert(shape);
+        // which can move it to another layer, so drop the tiles of all layers
+        d->invalidateTiles(shape->boundingRect(), 0);
+    }
+    KoShapeContainer *container = dynamic_cast<KoShapeContainer*>(shape);
     if (d->aggregate4update.contains(shape) || d->additionalShapes.contains(shape)) {
+        // the children are stacked with the container, so they move along even if it is queued already
+        if (container) {
+            d->markChildrenPaintOrderPending(container);
+        }
         return;
     }
     const bool wasEmpty = d->aggregate4update.isEmpty();
     d->aggregate4update.insert(shape);
     d->shapeIndexesBeforeUpdate.insert(shape, shape->zIndex());
 
-    KoShapeContainer *container = dynamic_cast<KoShapeContainer*>(shape);
     if (container) {
         foreach(KoShape *child, container->shapes())
             notifyShapeChanged(child);
@@ -580,6 +997,54 @@ void KoShapeManager::setPaintingStrategy(KoShapeManagerPaintingStrategy *strateg
 {
     delete d->strategy;
     d->strategy = strategy;
+    d->tiles.clear();
+}
+
+void KoShapeManager::setTiledPainting(bool enabled)
+{
+    d->tiledPainting = enabled;
+    if (!enabled)
+        d->tiles.clear();
+}
+
+bool KoShapeManager::tiledPainting() const
+{
+    return d->tiledPainting;
+}
+
+void KoShapeManager::beginInteraction()
+{
+    d->interacting = true;
+    d->refinementTimer.start();
+}
+
+void KoShapeManager::endInteraction()
+{
+    d->refinementTimer.stop();
+    if (!d->interacting)
+        return;
+    d->interacting = false;
+
+    // paint what was painted as a draft again at full detail
+    const QRectF rect = d->draftRect;
+    d->draftRect = QRectF();
+    if (!rect.isEmpty() && d->canvas)
+        d->canvas->updateCanvas(rect);
+}
+
+bool KoShapeManager::interactionInProgress() const
+{
+    return d->interacting;
+}
+
+void KoShapeManager::setRefinementDelay(int msec)
+{
+    d->refinementTimer.setInterval(msec);
+}
+
+int KoShapeManager::refinementDelay() const
+{
+    return d->refinementTimer.interval();
 }
 
 KoCanvasBase *KoShapeManager::canvas()
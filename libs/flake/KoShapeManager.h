@@ -120,6 +120,26 @@ public Q_SLOTS:
      */
     void removeAdditional(KoShape *shape);
 
+    /**
+     * Tell the shape manager that the user is zooming or panning the view.
+     *
+     * While the interaction is in progress paint() paints a draft: the shapes
+     * get KoShapePaintingContext::DraftDetail, shadows are left out, filter
+     * effects show the last result they rendered instead of rendering a new
+     * one, and pixmaps are drawn without smoothing. Tiles painted then are
+     * not kept.
+     *
+     * The interaction ends with endInteraction(), or when beginInteraction()
+     * was not called again for refinementDelay() milliseconds.
+     */
+    void beginInteraction();
+
+    /**
+     * End the interaction started with beginInteraction(); the area that
+     * was painted as a draft is then painted again at full detail.
+     */
+    void endInteraction();
+
 public:
     /// return the selection shapes for this shapeManager
     KoSelection *selection() const;
@@ -143,7 +163,8 @@ public:
     KoShape *shapeAt(const QPointF &position, KoFlake::ShapeSelection selection = KoFlake::ShapeOnTop, bool omitHiddenShapes = true);
 
     /**
-     * Returns the shapes which intersects the specific rect in the document.
+     * Returns the shapes which intersects the specific rect in the document,
+     * in the order they were added to the shape manager.
      * @param rect the rectangle in the document coordinate system.
      * @param omitHiddenShapes if true, only visible shapes are considered
      */
@@ -199,6 +220,38 @@ public:
      */
     void setPaintingStrategy(KoShapeManagerPaintingStrategy *strategy);
 
+    /**
+     * Enable or disable tiled painting, it is disabled by default.
+     *
+     * When painting tiled, paint() splits the area to paint into tiles and
+     * paints the shapes of each tile, found with the shape tree, into an
+     * image; the tiles are then drawn in paint order. Each layer gets tiles
+     * of its own, which are kept for the next paint until a shape of that
+     * layer changes, so a layer that is not edited is not painted again when
+     * scrolling back or when another layer changes.
+     *
+     * Printing and painters that are scaled or rotated are always painted
+     * without tiles. The tiles are painted one after the other in the gui
+     * thread, so a shape that covers several tiles is painted once for each
+     * of them; measure before enabling it for an application.
+     */
+    void setTiledPainting(bool enabled);
+
+    /// @return true if the shapes are painted tiled, see setTiledPainting()
+    bool tiledPainting() const;
+
+    /// @return true between beginInteraction() and the end of the interaction
+    bool interactionInProgress() const;
+
+    /**
+     * Set the time in milliseconds after the last beginInteraction() call
+     * at which the interaction ends by itself; the default is 250.
+     */
+    void setRefinementDelay(int msec);
+
+    /// @return the time after which an interaction ends by itself, see setRefinementDelay()
+    int refinementDelay() const;
+
 Q_SIGNALS:
     /// emitted when the selection is changed
     void selectionChanged();
@@ -220,6 +273,7 @@ private:
     class Private;
     Private * const d;
     Q_PRIVATE_SLOT(d, void updateTree())
+    Q_PRIVATE_SLOT(d, void filterResultReady(qint64, const QImage &))
 };
 
 #endif
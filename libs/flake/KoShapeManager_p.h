@@ -42,11 +42,102 @@
 #include <KoRTree.h>
 #include "KoClipPath.h"
 #include "KoShapePaintingContext.h"
+#include "KoViewConverter.h"
 
+#include <QCache>
 #include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QTimer>
 #include <FlakeDebug.h>
 
+/// Identifies a tile of the tiled painting of the shape manager
+struct KoShapeManagerTileKey
+{
+    KoShapeManagerTileKey(qreal zoomX, qreal zoomY, uint paintFlags, int column, int row, int run)
+        : zoomX(zoomX), zoomY(zoomY), paintFlags(paintFlags), column(column), row(row), run(run) {}
+
+    bool operator==(const KoShapeManagerTileKey &other) const {
+        return zoomX == other.zoomX && zoomY == other.zoomY && paintFlags == other.paintFlags
+            && column == other.column && row == other.row && run == other.run;
+    }
+
+    qreal zoomX;
+    qreal zoomY;
+    uint paintFlags; // the show flags of the painting context the tile was painted with
+    int column;
+    int row;
+    int run; // index of the group of shapes of one layer within the tile, in paint order
+};
+
+inline uint qHash(const KoShapeManagerTileKey &key, uint seed = 0)
+{
+    return qHash(key.zoomX, seed) ^ qHash(key.zoomY, seed) ^ key.paintFlags
+        ^ qHash((key.column << 16) ^ key.row, seed) ^ uint(key.run);
+}
+
+/// The shapes of one layer painted into a tile, kept to be reused by the next paint
+struct KoShapeManagerTile
+{
+    KoShapeManagerTile(const QList<KoShape *> &shapes, const KoShapeLayer *layer, const QRectF &documentRect, const QImage &image)
+        : shapes(shapes), layer(layer), documentRect(documentRect), image(image) {}
+
+    QList<KoShape *> shapes; // the shapes painted into the tile, in paint order
+    const KoShapeLayer *layer;
+    QRectF documentRect;
+    QImage image;
+};
+
+/**
+ * Applies the filter effects of a shape in a worker thread and hands the
+ * result to KoFilterEffectJobNotifier, which passes it on in the gui thread.
+ */
+class KoFilterEffectJob : public QRunnable
+{
+public:
+    /**
+     * @param stack a copy of the filter effects, owned by the job
+     * @param inputs the standard inputs, see KoFilterEffectStack::applyFilterEffects()
+     * @param key the key to put the result into KoImageCache with
+     */
+    KoFilterEffectJob(KoFilterEffectStack *stack, const QHash<QString, QImage> &inputs,
+                      const QRectF &shapeBound, qreal zoom, qint64 key);
+    virtual ~KoFilterEffectJob();
+    virtual void run();
+
+private:
+    KoFilterEffectStack *m_stack;
+    QHash<QString, QImage> m_inputs;
+    QRectF m_shapeBound;
+    KoViewConverter m_converter;
+    qint64 m_key;
+};
+
+/**
+ * Lives in the gui thread and passes the results of the KoFilterEffectJobs
+ * to the shape manager that started them, if it still exists.
+ */
+class KoFilterEffectJobNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    KoFilterEffectJobNotifier();
+
+    static KoFilterEffectJobNotifier *instance();
+
+    /// @p manager started the job that renders the result of @p key
+    void addJob(qint64 key, KoShapeManager *manager);
+    /// forget the jobs of @p manager, called when it gets deleted
+    static void removeManager(KoShapeManager *manager);
+
+public Q_SLOTS:
+    /// called queued by the job when it is done
+    void jobFinished(qint64 key, const QImage &result);
+
+private:
+    QHash<qint64, KoShapeManager *> m_jobs;
+};
+
 class Q_DECL_HIDDEN KoShapeManager::Private
 {
 public:
@@ -54,9 +145,16 @@ public:
         : selection(new KoSelection()),
           canvas(c),
           tree(4, 2),
+          paintOrderIndexValid(false),
+          settingShapes(false),
+          tiledPainting(false),
+          interacting(false),
           strategy(new KoShapeManagerPaintingStrategy(shapeManager)),
           q(shapeManager)
     {
+        tiles.setMaxCost(64 * 1024); // 64 MB of tiles
+        refinementTimer.setSingleShot(true);
+        refinementTimer.setInterval(250);
     }
 
     ~Private() {
@@ -77,6 +175,83 @@ public:
      */
     void paintGroup(KoShapeGroup *group, QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext);
 
+    /**
+     * Paint a shape that has filter effects as if it had none, for drafts
+     * when there is no result of the effects to show yet.
+     */
+    void paintWithoutFilterEffects(KoShape *shape, QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext);
+
+    /**
+     * Bring paintOrder up to date with the shapes in paintOrderPending.
+     *
+     * Pending shapes are taken out of the list and inserted again at their
+     * new position, which only costs a binary search each. When a big part
+     * of the shapes changed the whole list is sorted again instead.
+     */
+    void updatePaintOrder();
+
+    /// Put all descendants of @p container into paintOrderPending.
+    void markChildrenPaintOrderPending(KoShapeContainer *container);
+
+    /**
+     * Sort the shapes in the order they have to be painted, which is the
+     * order of KoShape::compareShapeZIndex.  All shapes have to be part of
+     * this shape manager.
+     */
+    void sortByPaintOrder(QList<KoShape *> &shapes);
+
+    /**
+     * Filter the shapes that have to be painted out of @p shapes and sort
+     * them in paint order. Hidden shapes are dropped, and shapes that have a
+     * parent with filter effects are replaced by that parent.
+     */
+    QList<KoShape *> paintableShapes(const QList<KoShape *> &shapes);
+
+    /**
+     * Paint the given shapes, which have to be in paint order, with their
+     * clipping applied.
+     */
+    void paintShapes(const QList<KoShape *> &shapes, QPainter &painter, const KoViewConverter &converter, bool forPrint,
+                     KoShapePaintingContext::LevelOfDetail levelOfDetail);
+
+    /**
+     * Paint the shapes in the clip region of @p painter tile by tile, using
+     * the cached tiles where possible. Tiles painted as a draft are not cached.
+     * @return false if the painter does not allow tiled painting, nothing is painted then
+     */
+    bool paintTiled(QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext::LevelOfDetail levelOfDetail);
+
+    /**
+     * Drop the cached tiles that overlap @p rect (in pt). If @p shape is given
+     * only the tiles of its layer are dropped.
+     */
+    void invalidateTiles(const QRectF &rect, const KoShape *shape);
+
+    /// @return the top level layer @p shape is in, or 0
+    static const KoShapeLayer *layerOf(const KoShape *shape);
+
+    /**
+     * Paint the standard inputs the filter effects of @p shape require.
+     * @param zoomedClipRegion the clipping rect of the filter effects in view coordinates
+     */
+    QHash<QString, QImage> filterInputs(KoShape *shape, const QRectF &zoomedClipRegion, QPainter &painter,
+                                        const KoViewConverter &converter, KoShapePaintingContext &paintContext);
+
+    /// @return the key in KoImageCache of the filter effect result of @p shape at the zoom of @p converter
+    static qint64 filterResultKey(const KoShape *shape, const KoViewConverter &converter, bool antialiasing);
+
+    /**
+     * Called when a KoFilterEffectJob finished. The @p result is only put into
+     * the cache when the shape it was rendered for is still in this manager.
+     */
+    void filterResultReady(qint64 key, const QImage &result);
+
+    /// a filter effect result rendered by a KoFilterEffectJob
+    struct PendingFilterResult {
+        KoShape *shape;
+        QSize size;
+    };
+
     class DetectCollision
     {
     public:
@@ -110,12 +285,33 @@ public:
     };
 
     QList<KoShape *> shapes;
+    QSet<KoShape *> shapeSet; // same as shapes, for fast lookups
     QList<KoShape *> additionalShapes; // these are shapes that are only handled for updates
     KoSelection *selection;
     KoCanvasBase *canvas;
     KoRTree<KoShape *> tree;
     QSet<KoShape *> aggregate4update;
     QHash<KoShape*, int> shapeIndexesBeforeUpdate;
+    // all shapes sorted with KoShape::compareShapeZIndex
+    QVector<KoShape *> paintOrder;
+    // the position of each shape in paintOrder, only valid if paintOrderIndexValid is set
+    QHash<KoShape *, int> paintOrderIndex;
+    // shapes added, removed or changed since paintOrder was last updated
+    QSet<KoShape *> paintOrderPending;
+    bool paintOrderIndexValid;
+    // set while setShapes() adds the shapes, the tree is then built in one go
+    bool settingShapes;
+    bool tiledPainting;
+    // tiles painted by paintTiled(), the cost is in kilobytes
+    QCache<KoShapeManagerTileKey, KoShapeManagerTile> tiles;
+    // the filter effect jobs started by this shape manager, to repaint their shapes when they are done
+    QHash<qint64, PendingFilterResult> filterJobs;
+    // set between beginInteraction() and the end of the interaction, paint() then paints drafts
+    bool interacting;
+    // the area painted as a draft during the interaction, in document coordinates
+    QRectF draftRect;
+    // ends the interaction when beginInteraction() was not called for a while
+    QTimer refinementTimer;
     KoShapeManagerPaintingStrategy *strategy;
     KoShapeManager *q;
 };
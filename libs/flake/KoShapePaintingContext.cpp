@@ -31,10 +31,12 @@ KoShapePaintingContext::KoShapePaintingContext()
     , showSelections(true)
     , showInlineObjectVisualization(false)
     , showAnnotations(false)
+    , levelOfDetail(FullDetail)
 {
 }
 
 KoShapePaintingContext::KoShapePaintingContext(KoCanvasBase *canvas, bool forPrint)
+    : levelOfDetail(FullDetail)
 {
     KoCanvasResourceManager *rm = canvas->resourceManager();
 
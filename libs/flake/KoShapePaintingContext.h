@@ -39,6 +39,18 @@ public:
 
     ~KoShapePaintingContext();
 
+    /// How much detail the shapes paint
+    enum LevelOfDetail {
+        FullDetail, ///< paint at full quality
+        /**
+         * The user is zooming or panning the view, see KoShapeManager::beginInteraction().
+         * Shapes that can do it paint a cheaper approximation, like a cached
+         * bitmap, a simplified path or greeked text; they are painted again at
+         * full detail when the interaction is over.
+         */
+        DraftDetail
+    };
+
     bool showFormattingCharacters;
     bool showTextShapeOutlines;
     bool showTableBorders;
@@ -47,6 +59,7 @@ public:
     bool showSelections;
     bool showInlineObjectVisualization;
     bool showAnnotations;
+    LevelOfDetail levelOfDetail;
 };
 
 #endif /* KOSHAPEPAINTINGCONTEXT_H */
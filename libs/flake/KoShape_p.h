@@ -24,6 +24,7 @@
 
 #include <QPoint>
 #include <QPaintDevice>
+#include <QSize>
 #include <QTransform>
 
 #include <KoCanvasBase.h>
@@ -59,6 +60,12 @@ public:
     /// calls update on the shape where the stroke is.
     void updateStroke();
 
+    /**
+     * Called whenever what the shape paints might have changed. Also marks
+     * the parents as changed as they paint their children.
+     */
+    void contentChanged() const;
+
     // Members
 
     KoShape *q_ptr;             // Points the shape that owns this class.
@@ -107,6 +114,12 @@ public:
     KoShapeAnchor *anchor;
     qreal minimumHeight;
 
+    const int cacheId; ///< identifies the shape in process wide caches, unlike its address it is never reused
+    mutable uint contentVersion; ///< changes with each contentChanged()
+    qint64 filterResultKey; ///< key in KoImageCache of the last filter effect result rendered
+    QSize filterResultSize; ///< size of that result
+    qint64 filterJobKey; ///< key of the filter effect result applied in the background, 0 if none
+
     /// Convert connection point position from shape coordinates, taking alignment into account
     void convertFromShapeCoordinates(KoConnectionPoint &point, const QSizeF &shapeSize) const;
 
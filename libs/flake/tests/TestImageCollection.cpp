@@ -21,14 +21,19 @@
 
 #include <KoImageData.h>
 #include <KoImageCollection.h>
+#include <KoImageCache.h>
 #include <KoStore.h>
 
 #include <QImage>
 #include <QPixmap>
 #include <QBuffer>
+#include <QImageReader>
 #include <QUrl>
 #include <FlakeDebug.h>
 
+#include <QRunnable>
+#include <QSignalSpy>
+#include <QThreadPool>
 #include <QTest>
 
 void TestImageCollection::testGetImageImage()
@@ -106,6 +111,61 @@ void TestImageCollection::testInvalidImageData()
     delete data;
 }
 
+void TestImageCollection::testSaveEncodedData()
+{
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(Qt::darkCyan);
+
+    // png data is saved as it was given
+    QByteArray pngData;
+    QBuffer pngBuffer(&pngData);
+    pngBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&pngBuffer, "PNG"));
+
+    KoImageData pngImage;
+    pngImage.setImage(pngData);
+    QCOMPARE(pngImage.suffix(), QString("png"));
+    QBuffer storedPng;
+    storedPng.open(QIODevice::WriteOnly);
+    QVERIFY(pngImage.saveData(storedPng));
+    QCOMPARE(storedPng.buffer(), pngData);
+
+    // after saving the data is kept on disk instead of in memory, saving again still copies it
+    QBuffer storedPngAgain;
+    storedPngAgain.open(QIODevice::WriteOnly);
+    QVERIFY(pngImage.saveData(storedPngAgain));
+    QCOMPARE(storedPngAgain.buffer(), pngData);
+    QCOMPARE(pngImage.image().size(), image.size());
+
+    // other formats are stored under the png suffix, so they have to be encoded as png
+    QByteArray jpegData;
+    QBuffer jpegBuffer(&jpegData);
+    jpegBuffer.open(QIODevice::WriteOnly);
+    if (!image.save(&jpegBuffer, "JPEG")) {
+        QSKIP("no jpeg support");
+    }
+
+    KoImageData jpegImage;
+    jpegImage.setImage(jpegData);
+    QVERIFY(jpegImage.isValid());
+    QCOMPARE(jpegImage.suffix(), QString("png"));
+    QBuffer storedJpeg;
+    storedJpeg.open(QIODevice::WriteOnly);
+    QVERIFY(jpegImage.saveData(storedJpeg));
+    storedJpeg.close();
+    storedJpeg.open(QIODevice::ReadOnly);
+    QCOMPARE(QImageReader::imageFormat(&storedJpeg), QByteArray("png"));
+    QImage reloaded;
+    QVERIFY(reloaded.loadFromData(storedJpeg.buffer(), "PNG"));
+    QCOMPARE(reloaded.size(), image.size());
+
+    // saving again gives the same file
+    QBuffer storedAgain;
+    storedAgain.open(QIODevice::WriteOnly);
+    QVERIFY(jpegImage.saveData(storedAgain));
+    QCOMPARE(storedAgain.buffer(), storedJpeg.buffer());
+}
+
 void TestImageCollection::testImageDataAsSharedData()
 {
     KoImageData data;
@@ -246,4 +306,235 @@ void TestImageCollection::testIsValid()
     QCOMPARE(data.isValid(), false);
 }
 
+void TestImageCollection::testScaledImage()
+{
+    KoImageCollection collection;
+    QImage image(800, 600, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    KoImageData *data = collection.createImageData(image);
+    QCOMPARE(data->pixelSize(), QSize(800, 600));
+
+    QSignalSpy spy(data, SIGNAL(scaledImageReady()));
+    data->scaledImage(QSize(100, 75));
+    QVERIFY(spy.count() > 0 || spy.wait());
+    QCOMPARE(data->scaledImage(QSize(100, 75)).size(), QSize(100, 75));
+
+    // a smaller size is served from the pyramid right away
+    QImage nearest = data->scaledImage(QSize(40, 30));
+    QCOMPARE(nearest.size(), QSize(100, 75));
+    QVERIFY(spy.count() > 1 || spy.wait());
+    QCOMPARE(data->scaledImage(QSize(40, 30)).size(), QSize(40, 30));
+    QCOMPARE(data->scaledImage(QSize(40, 30)).pixel(20, 15), QColor(Qt::red).rgb());
+
+    // the pixmap is scaled from the pyramid as well
+    QCOMPARE(data->pixmap(QSize(100, 75)).size(), QSize(100, 75));
+
+    delete data;
+}
+
+void TestImageCollection::testScaledImageNotifiesOwnKey()
+{
+    KoImageCollection collection;
+    QImage image1(400, 300, QImage::Format_RGB32);
+    image1.fill(Qt::red);
+    QImage image2(400, 300, QImage::Format_RGB32);
+    image2.fill(Qt::green);
+    KoImageData *data1 = collection.createImageData(image1);
+    KoImageData *data2 = collection.createImageData(image2);
+    QVERIFY(data1->key() != data2->key());
+
+    // both wait for scaled images, only the one whose pyramid changed is told
+    QSignalSpy spy1(data1, SIGNAL(scaledImageReady()));
+    QSignalSpy spy2(data2, SIGNAL(scaledImageReady()));
+    data2->scaledImage(QSize(100, 75));
+    QVERIFY(spy2.count() > 0 || spy2.wait());
+    spy2.clear();
+
+    data1->scaledImage(QSize(100, 75));
+    QVERIFY(spy1.count() > 0 || spy1.wait());
+    QCOMPARE(spy2.count(), 0);
+
+    delete data1;
+    delete data2;
+}
+
+void TestImageCollection::testCacheKeepsOriginalImage()
+{
+    // an indexed image is cached as RGB32, but the image data keeps the original
+    QImage image(64, 48, QImage::Format_Indexed8);
+    image.setColorCount(2);
+    image.setColor(0, qRgb(255, 0, 0));
+    image.setColor(1, qRgb(0, 0, 255));
+    image.fill(1);
+
+    KoImageData data;
+    data.setImage(image);
+    QCOMPARE(data.pixmap(QSize(32, 24)).size(), QSize(32, 24));
+    QVERIFY(KoImageCache::instance()->contains(data.key(), QSize(64, 48), QImage::Format_RGB32));
+    QCOMPARE(data.image().format(), QImage::Format_Indexed8);
+    QCOMPARE(data.image(), image);
+}
+
+void TestImageCollection::testMemoryLimit()
+{
+    const qint64 oldLimit = KoImageCollection::memoryLimit();
+    KoImageCache *cache = KoImageCache::instance();
+    cache->clear();
+
+    KoImageCollection collection;
+    QImage image1(400, 400, QImage::Format_RGB32);
+    image1.fill(Qt::red);
+    QImage image2(400, 400, QImage::Format_RGB32);
+    image2.fill(Qt::blue);
+    KoImageData *data1 = collection.createImageData(image1);
+    KoImageData *data2 = collection.createImageData(image2);
+    QVERIFY(data1->key() != data2->key());
+
+    // room for the levels of one image
+    const qint64 limit = 900000;
+    KoImageCollection::setMemoryLimit(limit);
+    QCOMPARE(cache->memoryLimit(), limit);
+
+    QSignalSpy spy1(data1, SIGNAL(scaledImageReady()));
+    data1->scaledImage(QSize(100, 100));
+    QVERIFY(spy1.count() > 0 || spy1.wait());
+    QCOMPARE(data1->scaledImage(QSize(100, 100)).size(), QSize(100, 100));
+    QVERIFY(cache->contains(data1->key(), QSize(400, 400), QImage::Format_RGB32));
+
+    cache->resetStatistics();
+    QSignalSpy spy2(data2, SIGNAL(scaledImageReady()));
+    data2->scaledImage(QSize(100, 100));
+    QVERIFY(spy2.count() > 0 || spy2.wait());
+    QCOMPARE(data2->scaledImage(QSize(100, 100)).size(), QSize(100, 100));
+
+    // the full image of the first one was used least recently
+    QVERIFY(!cache->contains(data1->key(), QSize(400, 400), QImage::Format_RGB32));
+    QVERIFY(cache->contains(data2->key(), QSize(400, 400), QImage::Format_RGB32));
+    const KoImageCache::Statistics statistics = cache->statistics();
+    QVERIFY(statistics.evictions > 0);
+    QVERIFY(statistics.memoryUsage <= limit);
+
+    KoImageCollection::setMemoryLimit(oldLimit);
+    delete data1;
+    delete data2;
+}
+
+void TestImageCollection::testImageCache()
+{
+    KoImageCache cache;
+    cache.setMemoryLimit(3 * 100 * 100 * 4);
+
+    QImage image(100, 100, QImage::Format_RGB32);
+    image.fill(Qt::green);
+    QImage small(50, 50, QImage::Format_RGB32);
+    small.fill(Qt::green);
+    cache.insert(1, image);
+    cache.insert(1, small);
+    cache.insert(2, image);
+
+    QCOMPARE(cache.find(1, QSize(100, 100), QImage::Format_RGB32), image);
+    QCOMPARE(cache.find(1, QSize(50, 50), QImage::Format_RGB32), small);
+    QVERIFY(cache.find(1, QSize(100, 100), QImage::Format_ARGB32).isNull());
+    QVERIFY(cache.find(3, QSize(100, 100), QImage::Format_RGB32).isNull());
+
+    KoImageCache::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits, qint64(2));
+    QCOMPARE(statistics.misses, qint64(2));
+    QCOMPARE(statistics.insertions, qint64(3));
+    QCOMPARE(statistics.count, 3);
+    QCOMPARE(statistics.memoryUsage, qint64(2 * 100 * 100 * 4 + 50 * 50 * 4));
+
+    // 2 was used least recently, so it goes first
+    cache.insert(3, image);
+    QVERIFY(!cache.contains(2, QSize(100, 100), QImage::Format_RGB32));
+    QVERIFY(cache.contains(1, QSize(100, 100), QImage::Format_RGB32));
+    QVERIFY(cache.contains(3, QSize(100, 100), QImage::Format_RGB32));
+    QCOMPARE(cache.statistics().evictions, qint64(1));
+
+    cache.remove(1);
+    QCOMPARE(cache.statistics().count, 1);
+    QCOMPARE(cache.statistics().memoryUsage, qint64(100 * 100 * 4));
+
+    // images that do not fit at all are not kept
+    cache.insert(4, QImage(1000, 1000, QImage::Format_RGB32));
+    QVERIFY(!cache.contains(4, QSize(1000, 1000), QImage::Format_RGB32));
+
+    cache.setMemoryLimit(0);
+    QCOMPARE(cache.statistics().count, 0);
+    QCOMPARE(cache.statistics().memoryUsage, qint64(0));
+}
+
+namespace {
+    class CacheStressJob : public QRunnable
+    {
+    public:
+        CacheStressJob(KoImageCache *cache, int seed, QAtomicInt *lookups)
+            : m_cache(cache), m_seed(seed), m_lookups(lookups) {}
+
+        virtual void run()
+        {
+            qsrand(m_seed);
+            for (int i = 0; i < 2000; ++i) {
+                const qint64 key = qrand() % 50;
+                const QSize size(8 << (qrand() % 4), 8 << (qrand() % 4));
+                if (qrand() % 3 == 0) {
+                    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+                    image.fill(Qt::transparent);
+                    m_cache->insert(key, image);
+                } else {
+                    const QImage image = m_cache->find(key, size, QImage::Format_ARGB32_Premultiplied);
+                    if (!image.isNull() && image.size() != size)
+                        qFatal("wrong image size from the cache");
+                    m_lookups->ref();
+                }
+                if (i % 500 == 0)
+                    m_cache->remove(key);
+            }
+        }
+
+    private:
+        KoImageCache *m_cache;
+        int m_seed;
+        QAtomicInt *m_lookups;
+    };
+}
+
+void TestImageCollection::testImageCacheStress()
+{
+    KoImageCache cache;
+    const qint64 limit = 256 * 1024;
+    cache.setMemoryLimit(limit);
+
+    QAtomicInt lookups;
+    QThreadPool pool;
+    pool.setMaxThreadCount(8);
+    for (int i = 0; i < 16; ++i)
+        pool.start(new CacheStressJob(&cache, i + 1, &lookups));
+    pool.waitForDone();
+
+    const KoImageCache::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits + statistics.misses, qint64(lookups.load()));
+    QVERIFY(statistics.hits > 0);
+    QVERIFY(statistics.evictions > 0);
+    QVERIFY(statistics.memoryUsage <= limit);
+    QVERIFY(statistics.count <= 50 * 16);
+
+    // the accounting has to match what is left in the cache
+    qint64 usage = 0;
+    int count = 0;
+    for (qint64 key = 0; key < 50; ++key) {
+        for (int w = 0; w < 4; ++w) {
+            for (int h = 0; h < 4; ++h) {
+                const QSize size(8 << w, 8 << h);
+                if (cache.contains(key, size, QImage::Format_ARGB32_Premultiplied)) {
+                    usage += size.width() * size.height() * 4;
+                    ++count;
+                }
+            }
+        }
+    }
+    QCOMPARE(usage, statistics.memoryUsage);
+    QCOMPARE(count, statistics.count);
+}
+
 QTEST_MAIN(TestImageCollection)
@@ -30,6 +30,7 @@ private Q_SLOTS:
     void testGetImageImage();
     void testGetImageStore();
     void testInvalidImageData();
+    void testSaveEncodedData();
 
     // imageData tests
     void testImageDataAsSharedData();
@@ -37,6 +38,12 @@ private Q_SLOTS:
     void testPreload3();
     void testSameKey();
     void testIsValid();
+    void testScaledImage();
+    void testCacheKeepsOriginalImage();
+    void testScaledImageNotifiesOwnKey();
+    void testMemoryLimit();
+    void testImageCache();
+    void testImageCacheStress();
 };
 
 #endif /* TESTIMAGECOLLECTION_H */
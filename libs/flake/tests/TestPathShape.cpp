@@ -23,7 +23,9 @@
 #include "KoPathPoint.h"
 #include "KoPathPointData.h"
 #include "KoPathSegment.h"
+#include "KoShapeStroke.h"
 
+#include <QPen>
 #include <QTest>
 
 void TestPathShape::close()
@@ -782,4 +784,102 @@ void TestPathShape::closeMerge()
     QVERIFY(path.outline() == ppath);
 }
 
+void TestPathShape::cachedOutline()
+{
+    KoPathShape path;
+    path.moveTo(QPointF(0, 0));
+    KoPathPoint *p2 = path.lineTo(QPointF(100, 0));
+    path.lineTo(QPointF(100, 100));
+
+    QPainterPath before = path.outline();
+    QCOMPARE(path.outline(), before);
+    QVERIFY(path.hitTest(QPointF(90, 10)));
+
+    // changing a point through its setter has to invalidate the cache
+    p2->setPoint(QPointF(0, 100));
+    QPainterPath ppath(QPointF(0, 0));
+    ppath.lineTo(0, 100);
+    ppath.lineTo(100, 100);
+    QCOMPARE(path.outline(), ppath);
+    QVERIFY(!path.hitTest(QPointF(90, 10)));
+    QVERIFY(path.hitTest(QPointF(10, 90)));
+
+    p2->setProperty(KoPathPoint::StopSubpath);
+    p2->setProperty(KoPathPoint::CloseSubpath);
+    QVERIFY(path.outline() != ppath);
+}
+
+void TestPathShape::cachedOutlineAfterStructureChange()
+{
+    KoPathShape path;
+    path.moveTo(QPointF(0, 0));
+    path.lineTo(QPointF(10, 0));
+    path.lineTo(QPointF(10, 10));
+    QPainterPath before = path.outline();
+
+    KoPathPoint *point = new KoPathPoint(&path, QPointF(5, 5), KoPathPoint::Normal);
+    QVERIFY(path.insertPoint(point, KoPathPointIndex(0, 2)));
+    QPainterPath ppath(QPointF(0, 0));
+    ppath.lineTo(10, 0);
+    ppath.lineTo(5, 5);
+    ppath.lineTo(10, 10);
+    QCOMPARE(path.outline(), ppath);
+
+    delete path.removePoint(KoPathPointIndex(0, 2));
+    QCOMPARE(path.outline(), before);
+
+    path.closeSubpath(KoPathPointIndex(0, 0));
+    ppath = before;
+    ppath.closeSubpath();
+    QCOMPARE(path.outline(), ppath);
+
+    path.clear();
+    QVERIFY(path.outline().isEmpty());
+}
+
+void TestPathShape::cachedStroke()
+{
+    KoPathShape path;
+    path.moveTo(QPointF(0, 0));
+    KoPathPoint *p2 = path.lineTo(QPointF(100, 0));
+    path.setStroke(new KoShapeStroke(2.0));
+
+    QPen pen;
+    pen.setWidthF(2.0);
+    QPainterPath stroke = path.pathStroke(pen);
+    QCOMPARE(path.pathStroke(pen), stroke);
+    QRectF bb = path.boundingRect();
+
+    pen.setWidthF(10.0);
+    QVERIFY(path.pathStroke(pen).boundingRect().height() > stroke.boundingRect().height());
+    pen.setWidthF(2.0);
+
+    p2->setPoint(QPointF(200, 0));
+    QVERIFY(path.pathStroke(pen) != stroke);
+    QVERIFY(path.boundingRect().width() > bb.width());
+
+    // the bounding rect has to follow the shape's transformation as well
+    bb = path.boundingRect();
+    path.setPosition(QPointF(50, 50));
+    QCOMPARE(path.boundingRect().size(), bb.size());
+    QVERIFY(path.boundingRect().topLeft() != bb.topLeft());
+}
+
+void TestPathShape::benchmarkGeometry()
+{
+    KoPathShape path;
+    path.moveTo(QPointF(0, 0));
+    for (int i = 1; i < 2000; ++i) {
+        path.curveTo(QPointF(i * 10 - 5, (i % 2) ? 20 : -20), QPointF(i * 10 - 2, 0), QPointF(i * 10, 0));
+    }
+    path.close();
+    path.setStroke(new KoShapeStroke(1.0));
+
+    QBENCHMARK {
+        path.outline();
+        path.boundingRect();
+        path.hitTest(QPointF(10000, 0));
+    }
+}
+
 QTEST_MAIN(TestPathShape)
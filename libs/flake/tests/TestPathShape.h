@@ -50,6 +50,12 @@ private Q_SLOTS:
     void closeMerge();
 
     void koPathPointDataLess();
+
+    void cachedOutline();
+    void cachedOutlineAfterStructureChange();
+    void cachedStroke();
+
+    void benchmarkGeometry();
 };
 
 #endif // TESTPATHSHAPE_H
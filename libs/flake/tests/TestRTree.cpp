@@ -0,0 +1,191 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestRTree.h"
+
+#include <KoRTree.h>
+
+#include <QTest>
+
+typedef QPair<QRectF, int> Item;
+
+static QList<Item> randomItems(int count)
+{
+    qsrand(42);
+    QList<Item> items;
+    for (int i = 0; i < count; ++i) {
+        QRectF rect(qrand() % 1000, qrand() % 1000, 1 + qrand() % 50, 1 + qrand() % 50);
+        items.append(qMakePair(rect, i));
+    }
+    return items;
+}
+
+static QList<Item> gridItems()
+{
+    QList<Item> items;
+    for (int y = 1; y <= 1000; ++y) {
+        for (int x = 1; x <= 100; ++x) {
+            items.append(qMakePair(QRectF(x, y, 1, 1), items.count()));
+        }
+    }
+    return items;
+}
+
+static QList<int> sorted(QList<int> list)
+{
+    qSort(list);
+    return list;
+}
+
+void TestRTree::testBulkLoad_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("empty") << 0;
+    QTest::newRow("one") << 1;
+    QTest::newRow("one node") << 4;
+    QTest::newRow("two nodes") << 5;
+    QTest::newRow("two levels") << 17;
+    QTest::newRow("many") << 5000;
+}
+
+void TestRTree::testBulkLoad()
+{
+    QFETCH(int, count);
+
+    const QList<Item> items = randomItems(count);
+    KoRTree<int> inserted(4, 2);
+    foreach (const Item &item, items) {
+        inserted.insert(item.first, item.second);
+    }
+    KoRTree<int> loaded(4, 2);
+    loaded.bulkLoad(items);
+
+    QCOMPARE(sorted(loaded.values()), sorted(inserted.values()));
+
+    // the results come in the order the items were given in
+    for (int i = 0; i < 100; ++i) {
+        const QRectF rect(qrand() % 1000, qrand() % 1000, qrand() % 200, qrand() % 200);
+        QCOMPARE(loaded.intersects(rect), inserted.intersects(rect));
+        const QPointF point(qrand() % 1000, qrand() % 1000);
+        QCOMPARE(loaded.contains(point), inserted.contains(point));
+    }
+}
+
+void TestRTree::testBulkLoadThenModify()
+{
+    const QList<Item> items = randomItems(1000);
+    KoRTree<int> tree(4, 2);
+    tree.bulkLoad(items);
+
+    // remove every other item
+    for (int i = 0; i < items.count(); i += 2) {
+        tree.remove(items[i].second);
+    }
+    tree.insert(QRectF(2000, 2000, 10, 10), 1000);
+
+    QList<int> expected;
+    for (int i = 1; i < items.count(); i += 2) {
+        expected.append(i);
+    }
+    expected.append(1000);
+    QCOMPARE(sorted(tree.values()), expected);
+    QCOMPARE(tree.intersects(QRectF(1990, 1990, 20, 20)), QList<int>() << 1000);
+
+    const QRectF rect(100, 100, 300, 300);
+    QList<int> found;
+    for (int i = 1; i < items.count(); i += 2) {
+        if (items[i].first.intersects(rect)) {
+            found.append(i);
+        }
+    }
+    QCOMPARE(tree.intersects(rect), found);
+}
+
+void TestRTree::testVisitors()
+{
+    const QList<Item> items = randomItems(2000);
+    KoRTree<int> tree(4, 2);
+    tree.bulkLoad(items);
+
+    for (int i = 0; i < 100; ++i) {
+        const QRectF rect(qrand() % 1000, qrand() % 1000, qrand() % 200, qrand() % 200);
+        QList<int> visited;
+        tree.visitIntersecting(rect, [&visited](int data) {
+            visited.append(data);
+        });
+        QCOMPARE(sorted(visited), tree.intersects(rect));
+
+        const QPointF point(qrand() % 1000, qrand() % 1000);
+        visited.clear();
+        tree.visitContaining(point, [&visited](int data) {
+            visited.append(data);
+        });
+        QCOMPARE(sorted(visited), tree.contains(point));
+    }
+}
+
+void TestRTree::benchmarkInsert()
+{
+    const QList<Item> items = gridItems();
+    QBENCHMARK {
+        KoRTree<int> tree(4, 2);
+        foreach (const Item &item, items) {
+            tree.insert(item.first, item.second);
+        }
+    }
+}
+
+void TestRTree::benchmarkBulkLoad()
+{
+    const QList<Item> items = gridItems();
+    QBENCHMARK {
+        KoRTree<int> tree(4, 2);
+        tree.bulkLoad(items);
+    }
+}
+
+void TestRTree::benchmarkIntersects()
+{
+    KoRTree<int> tree(4, 2);
+    tree.bulkLoad(gridItems());
+    int found = 0;
+    QBENCHMARK {
+        for (int y = 1; y <= 1000; y += 10) {
+            found += tree.intersects(QRectF(1, y, 20, 20)).count();
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void TestRTree::benchmarkVisitIntersecting()
+{
+    KoRTree<int> tree(4, 2);
+    tree.bulkLoad(gridItems());
+    int found = 0;
+    QBENCHMARK {
+        for (int y = 1; y <= 1000; y += 10) {
+            tree.visitIntersecting(QRectF(1, y, 20, 20), [&found](int) {
+                ++found;
+            });
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+QTEST_GUILESS_MAIN(TestRTree)
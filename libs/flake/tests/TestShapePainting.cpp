@@ -23,10 +23,20 @@
 #include "KoShapeContainer.h"
 #include "KoShapeManager.h"
 #include "KoShapePaintingContext.h"
+#include "KoFilterEffect.h"
+#include "KoFilterEffectStack.h"
+#include "KoFilterEffectFactoryBase.h"
+#include "KoFilterEffectRegistry.h"
+#include "KoImageCache.h"
+#include <KoXmlReader.h>
+#include <KoXmlWriter.h>
 
 #include <MockShapes.h>
 
+#include <QAtomicInt>
+#include <QCoreApplication>
 #include <QTest>
+#include <QThreadPool>
 
 void TestShapePainting::testPaintShape()
 {
@@ -251,4 +261,514 @@ void TestShapePainting::testPaintOrder()
     delete root;
 }
 
+namespace {
+class OrderedMockShape : public MockShape {
+public:
+    OrderedMockShape(QList<MockShape*> &list) : order(list) {}
+    void paint(QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintcontext) {
+        order.append(this);
+        MockShape::paint(painter, converter, paintcontext);
+    }
+    QList<MockShape*> &order;
+};
+}
+
+void TestShapePainting::testPaintOrderAfterChange()
+{
+    // the shape manager keeps the stacking order between paints, make sure
+    // changes of the z-index, the run through and the parent are picked up
+    QList<MockShape*> order;
+
+    MockContainer *top = new MockContainer();
+    top->setZIndex(2);
+    OrderedMockShape *shape1 = new OrderedMockShape(order);
+    shape1->setZIndex(1);
+    OrderedMockShape *shape2 = new OrderedMockShape(order);
+    shape2->setZIndex(2);
+    top->addShape(shape1);
+    top->addShape(shape2);
+
+    MockContainer *bottom = new MockContainer();
+    bottom->setZIndex(1);
+    OrderedMockShape *shape3 = new OrderedMockShape(order);
+    shape3->setZIndex(1);
+    bottom->addShape(shape3);
+
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    manager.addShape(top);
+    manager.addShape(bottom);
+
+    QImage image(100, 100,  QImage::Format_Mono);
+    QPainter painter(&image);
+    painter.setClipRect(0, 0, 100, 100);
+    KoViewConverter vc;
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape3);
+    QVERIFY(order[1] == shape1);
+    QVERIFY(order[2] == shape2);
+
+    // raise shape1 above shape2
+    order.clear();
+    shape1->setZIndex(3);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape3);
+    QVERIFY(order[1] == shape2);
+    QVERIFY(order[2] == shape1);
+
+    // moving the container moves all its children
+    order.clear();
+    bottom->setZIndex(3);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape2);
+    QVERIFY(order[1] == shape1);
+    QVERIFY(order[2] == shape3);
+
+    // the run through comes before the z-index
+    order.clear();
+    shape3->setRunThrough(-1);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape3);
+    QVERIFY(order[1] == shape2);
+    QVERIFY(order[2] == shape1);
+
+    // removed shapes are not painted, added ones are in place
+    order.clear();
+    manager.remove(shape2);
+    shape2->setParent(0);
+    OrderedMockShape *shape4 = new OrderedMockShape(order);
+    shape4->setZIndex(2);
+    top->addShape(shape4);
+    manager.addShape(shape4);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape3);
+    QVERIFY(order[1] == shape4);
+    QVERIFY(order[2] == shape1);
+
+    delete shape2;
+    delete top;
+    delete bottom;
+}
+
+void TestShapePainting::testPaintOrderGroupChangedTwice()
+{
+    // the second change of a container that is queued for the tree update
+    // already has to move its children along too
+    QList<MockShape*> order;
+
+    MockContainer *group = new MockContainer();
+    group->setZIndex(1);
+    MockContainer *inner = new MockContainer();
+    inner->setZIndex(1);
+    OrderedMockShape *shape1 = new OrderedMockShape(order);
+    shape1->setZIndex(1);
+    OrderedMockShape *shape2 = new OrderedMockShape(order);
+    shape2->setZIndex(2);
+    group->addShape(inner);
+    inner->addShape(shape1);
+    group->addShape(shape2);
+
+    OrderedMockShape *shape3 = new OrderedMockShape(order);
+    shape3->setZIndex(2);
+
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    manager.addShape(group);
+    manager.addShape(shape3);
+
+    QImage image(100, 100,  QImage::Format_Mono);
+    QPainter painter(&image);
+    painter.setClipRect(0, 0, 100, 100);
+    KoViewConverter vc;
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape1);
+    QVERIFY(order[1] == shape2);
+    QVERIFY(order[2] == shape3);
+
+    // raise the group above shape3 and then even higher, without a paint in between
+    order.clear();
+    group->setZIndex(3);
+    group->setZIndex(4);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape3);
+    QVERIFY(order[1] == shape1);
+    QVERIFY(order[2] == shape2);
+
+    // and back below it
+    order.clear();
+    group->setZIndex(3);
+    group->setZIndex(0);
+    manager.paint(painter, vc, false);
+    QCOMPARE(order.count(), 3);
+    QVERIFY(order[0] == shape1);
+    QVERIFY(order[1] == shape2);
+    QVERIFY(order[2] == shape3);
+
+    delete group;
+    delete shape3;
+}
+
+namespace {
+class ColoredMockShape : public KoShape {
+public:
+    ColoredMockShape(const QColor &color) : color(color), paintedCount(0) {}
+    void paint(QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &) {
+        painter.fillRect(converter.documentToView(QRectF(QPointF(0, 0), size())), color);
+        ++paintedCount;
+    }
+    virtual void saveOdf(KoShapeSavingContext &) const {}
+    virtual bool loadOdf(const KoXmlElement &, KoShapeLoadingContext &) {
+        return true;
+    }
+    QColor color;
+    int paintedCount;
+};
+}
+
+void TestShapePainting::testTiledPainting()
+{
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    QList<ColoredMockShape*> shapes;
+    for (int i = 0; i < 20; ++i) {
+        ColoredMockShape *shape = new ColoredMockShape(QColor::fromHsv(i * 18, 255, 255));
+        shape->setPosition(QPointF(i * 27.5, i * 13.25));
+        shape->setSize(QSizeF(120, 80));
+        shape->setZIndex(i);
+        manager.addShape(shape);
+        shapes.append(shape);
+    }
+    KoViewConverter vc;
+
+    QImage expected(700, 400, QImage::Format_ARGB32_Premultiplied);
+    expected.fill(Qt::white);
+    QPainter painter(&expected);
+    painter.setClipRect(expected.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+
+    // the tiles have to give the same pixels as painting the shapes directly
+    manager.setTiledPainting(true);
+    QImage tiled(expected.size(), QImage::Format_ARGB32_Premultiplied);
+    tiled.fill(Qt::white);
+    painter.begin(&tiled);
+    painter.setClipRect(tiled.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+    QCOMPARE(tiled, expected);
+
+    // nothing changed, so painting again uses the cached tiles
+    QList<int> paintedCounts;
+    foreach (ColoredMockShape *shape, shapes)
+        paintedCounts.append(shape->paintedCount);
+    tiled.fill(Qt::white);
+    painter.begin(&tiled);
+    painter.setClipRect(tiled.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+    QCOMPARE(tiled, expected);
+    for (int i = 0; i < shapes.count(); ++i)
+        QCOMPARE(shapes[i]->paintedCount, paintedCounts[i]);
+
+    // a changed shape drops the tiles it is in
+    shapes[3]->color = Qt::black;
+    shapes[3]->update();
+    tiled.fill(Qt::white);
+    painter.begin(&tiled);
+    painter.setClipRect(tiled.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+    QVERIFY(shapes[3]->paintedCount > paintedCounts[3]);
+
+    // a removed shape is not painted from a cached tile anymore
+    manager.remove(shapes[10]);
+    tiled.fill(Qt::white);
+    painter.begin(&tiled);
+    painter.setClipRect(tiled.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+
+    manager.setTiledPainting(false);
+    expected.fill(Qt::white);
+    painter.begin(&expected);
+    painter.setClipRect(expected.rect());
+    manager.paint(painter, vc, false);
+    painter.end();
+    QCOMPARE(tiled, expected);
+
+    qDeleteAll(shapes);
+}
+
+namespace {
+// counts the images processed by all copies of the effect
+QAtomicInt processedCount;
+
+class CountingFilterEffect : public KoFilterEffect {
+public:
+    CountingFilterEffect() : KoFilterEffect("counting", "Counting") {}
+    QImage processImage(const QImage &image, const KoFilterEffectRenderContext &) const {
+        processedCount.ref();
+        return image;
+    }
+    bool load(const KoXmlElement &element, const KoFilterEffectLoadingContext &) {
+        return element.tagName() == id();
+    }
+    void save(KoXmlWriter &writer) {
+        writer.startElement("counting");
+        saveCommonAttributes(writer);
+        writer.endElement();
+    }
+};
+
+class CountingFilterEffectFactory : public KoFilterEffectFactoryBase {
+public:
+    CountingFilterEffectFactory() : KoFilterEffectFactoryBase("counting", "Counting") {}
+    KoFilterEffect *createFilterEffect() const {
+        return new CountingFilterEffect();
+    }
+    KoFilterEffectConfigWidgetBase *createConfigWidget() const {
+        return 0;
+    }
+};
+
+// the effects are copied through the registry when they are applied in the background
+void registerCountingFilterEffect()
+{
+    KoFilterEffectRegistry *registry = KoFilterEffectRegistry::instance();
+    if (!registry->contains("counting"))
+        registry->add(new CountingFilterEffectFactory());
+}
+}
+
+void TestShapePainting::testFilterEffectCache()
+{
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    ColoredMockShape *shape = new ColoredMockShape(Qt::red);
+    shape->setSize(QSizeF(50, 50));
+    registerCountingFilterEffect();
+    processedCount.store(0);
+    CountingFilterEffect *effect = new CountingFilterEffect();
+    KoFilterEffectStack *stack = new KoFilterEffectStack();
+    stack->appendFilterEffect(effect);
+    shape->setFilterEffectStack(stack);
+    manager.addShape(shape);
+
+    // the background jobs work on a copy of the effects
+    KoFilterEffectStack *copy = stack->clone();
+    QVERIFY(copy);
+    QCOMPARE(copy->filterEffects().count(), 1);
+    QVERIFY(copy->filterEffects().first() != effect);
+    QCOMPARE(copy->filterEffects().first()->id(), effect->id());
+    QCOMPARE(copy->filterEffects().first()->output(), effect->output());
+    QCOMPARE(copy->filterEffects().first()->filterRect(), effect->filterRect());
+    delete copy;
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.setClipRect(image.rect());
+    KoViewConverter vc;
+    manager.paint(painter, vc, false);
+    QCOMPARE(processedCount.load(), 1);
+
+    // nothing changed, so the cached result is painted
+    manager.paint(painter, vc, false);
+    QCOMPARE(processedCount.load(), 1);
+
+    // after a change the effects are applied in the background while the older result is shown
+    shape->update();
+    manager.paint(painter, vc, false);
+    QThreadPool::globalInstance()->waitForDone();
+    QCOMPARE(processedCount.load(), 2);
+    QCoreApplication::processEvents();
+    manager.paint(painter, vc, false);
+    QCOMPARE(processedCount.load(), 2);
+
+    // and again for another zoom level
+    vc.setZoom(2.0);
+    manager.paint(painter, vc, false);
+    QThreadPool::globalInstance()->waitForDone();
+    QCOMPARE(processedCount.load(), 3);
+    QCoreApplication::processEvents();
+
+    // editing a parameter of an effect applies the effects again
+    const uint version = stack->version();
+    effect->setFilterRect(QRectF(-0.1, -0.1, 1.2, 1.2));
+    QVERIFY(stack->version() != version);
+    manager.paint(painter, vc, false);
+    QThreadPool::globalInstance()->waitForDone();
+    QCOMPARE(processedCount.load(), 4);
+
+    // the result of a job for a shape that got deleted is dropped
+    KoImageCache *cache = KoImageCache::instance();
+    cache->resetStatistics();
+    delete shape;
+    QCoreApplication::processEvents();
+    QCOMPARE(cache->statistics().insertions, qint64(0));
+
+    painter.end();
+}
+
+namespace {
+class DetailMockShape : public MockShape
+{
+public:
+    DetailMockShape() : levelOfDetail(KoShapePaintingContext::FullDetail) {}
+    void paint(QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext) {
+        MockShape::paint(painter, converter, paintContext);
+        levelOfDetail = paintContext.levelOfDetail;
+    }
+    KoShapePaintingContext::LevelOfDetail levelOfDetail;
+};
+}
+
+void TestShapePainting::testLevelOfDetail()
+{
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    DetailMockShape *shape = new DetailMockShape();
+    shape->setSize(QSizeF(50, 50));
+    manager.addShape(shape);
+    DetailMockShape *filtered = new DetailMockShape();
+    filtered->setSize(QSizeF(50, 50));
+    registerCountingFilterEffect();
+    processedCount.store(0);
+    CountingFilterEffect *effect = new CountingFilterEffect();
+    KoFilterEffectStack *stack = new KoFilterEffectStack();
+    stack->appendFilterEffect(effect);
+    filtered->setFilterEffectStack(stack);
+    manager.addShape(filtered);
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.setClipRect(image.rect());
+    KoViewConverter vc;
+
+    // while interacting drafts are painted and no filter effects are applied
+    manager.beginInteraction();
+    QVERIFY(manager.interactionInProgress());
+    manager.paint(painter, vc, false);
+    QCOMPARE(shape->levelOfDetail, KoShapePaintingContext::DraftDetail);
+    QCOMPARE(filtered->levelOfDetail, KoShapePaintingContext::DraftDetail);
+    QCOMPARE(filtered->paintedCount, 1);
+    QCOMPARE(processedCount.load(), 0);
+
+    // printing is always done at full detail
+    manager.paint(painter, vc, true);
+    QCOMPARE(shape->levelOfDetail, KoShapePaintingContext::FullDetail);
+    QCOMPARE(processedCount.load(), 1);
+
+    manager.endInteraction();
+    QVERIFY(!manager.interactionInProgress());
+    manager.paint(painter, vc, false);
+    QCOMPARE(shape->levelOfDetail, KoShapePaintingContext::FullDetail);
+    QCOMPARE(filtered->levelOfDetail, KoShapePaintingContext::FullDetail);
+
+    // the interaction ends by itself when nothing happens for a while
+    manager.setRefinementDelay(10);
+    QCOMPARE(manager.refinementDelay(), 10);
+    manager.beginInteraction();
+    QVERIFY(manager.interactionInProgress());
+    QTest::qWait(100);
+    QVERIFY(!manager.interactionInProgress());
+
+    painter.end();
+    QThreadPool::globalInstance()->waitForDone();
+    delete filtered;
+    delete shape;
+}
+
+namespace {
+class UpdateRecordingCanvas : public MockCanvas
+{
+public:
+    void updateCanvas(const QRectF &rc) {
+        updates.append(rc);
+    }
+    QList<QRectF> updates;
+};
+}
+
+void TestShapePainting::testEndInteractionUpdatesDrafts()
+{
+    UpdateRecordingCanvas canvas;
+    KoShapeManager manager(&canvas);
+    MockShape *shown = new MockShape();
+    shown->setSize(QSizeF(50, 50));
+    manager.addShape(shown);
+    MockShape *elsewhere = new MockShape();
+    elsewhere->setSize(QSizeF(50, 50));
+    elsewhere->setPosition(QPointF(500, 500));
+    manager.addShape(elsewhere);
+
+    QImage image(100, 100, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.setClipRect(image.rect());
+    KoViewConverter vc;
+
+    // nothing was painted as a draft, so nothing needs to be painted again
+    manager.beginInteraction();
+    canvas.updates.clear();
+    manager.endInteraction();
+    QVERIFY(canvas.updates.isEmpty());
+
+    // only the area painted as a draft is painted again
+    manager.beginInteraction();
+    manager.paint(painter, vc, false);
+    canvas.updates.clear();
+    manager.endInteraction();
+    QCOMPARE(canvas.updates.count(), 1);
+    QVERIFY(canvas.updates.first().contains(shown->boundingRect()));
+    QVERIFY(!canvas.updates.first().intersects(elsewhere->boundingRect()));
+
+    // and only once
+    canvas.updates.clear();
+    manager.beginInteraction();
+    manager.endInteraction();
+    QVERIFY(canvas.updates.isEmpty());
+
+    painter.end();
+    delete elsewhere;
+    delete shown;
+}
+
+void TestShapePainting::benchmarkPaint()
+{
+    // many overlapping shapes in a few layers, as on a crowded drawing
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    QList<KoShape*> containers;
+    for (int c = 0; c < 10; ++c) {
+        MockContainer *container = new MockContainer();
+        container->setZIndex(10 - c);
+        container->setSize(QSizeF(100, 100));
+        for (int i = 0; i < 2000; ++i) {
+            MockShape *shape = new MockShape();
+            shape->setZIndex((i * 7919) % 2000);
+            shape->setPosition(QPointF(i % 90, (i / 90) % 90));
+            shape->setSize(QSizeF(10, 10));
+            container->addShape(shape);
+        }
+        manager.addShape(container);
+        containers.append(container);
+    }
+
+    QImage image(100, 100,  QImage::Format_Mono);
+    QPainter painter(&image);
+    painter.setClipRect(0, 0, 100, 100);
+    KoViewConverter vc;
+    QBENCHMARK {
+        manager.paint(painter, vc, false);
+    }
+
+    qDeleteAll(containers);
+}
+
 QTEST_MAIN(TestShapePainting)
@@ -30,6 +30,13 @@ private Q_SLOTS:
     void testPaintShape();
     void testPaintHiddenShape();
     void testPaintOrder();
+    void testPaintOrderAfterChange();
+    void testPaintOrderGroupChangedTwice();
+    void testTiledPainting();
+    void testFilterEffectCache();
+    void testLevelOfDetail();
+    void testEndInteractionUpdatesDrafts();
+    void benchmarkPaint();
 };
 
 #endif
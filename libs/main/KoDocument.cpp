@@ -192,6 +192,8 @@ public:
 
     KoDocumentInfo *docInfo;
     KoDocumentRdfBase *docRdf;
+    // meta.xml as already parsed by loadOasisFromStore()
+    KoXmlDocument odfMetaDoc;
 
     KoProgressUpdater *progressUpdater;
     KoProgressProxy *progressProxy;
@@ -1859,9 +1861,10 @@ bool KoDocument::loadNativeFormatFromStoreInternal(KoStore *store)
     }
 
     if (oasis && store->hasFile("meta.xml")) {
-        KoXmlDocument metaDoc;
+        KoXmlDocument metaDoc = d->odfMetaDoc;
+        d->odfMetaDoc = KoXmlDocument();
         KoOdfReadStore oasisStore(store);
-        if (oasisStore.loadAndParse("meta.xml", metaDoc, d->lastErrorMessage)) {
+        if (!metaDoc.documentElement().isNull() || oasisStore.loadAndParse("meta.xml", metaDoc, d->lastErrorMessage)) {
             d->docInfo->loadOasis(metaDoc);
         }
     } else if (!oasis && store->hasFile("documentinfo.xml")) {
@@ -1944,6 +1947,7 @@ bool KoDocument::loadOasisFromStore(KoStore *store)
     if (! odfStore.loadAndParse(d->lastErrorMessage)) {
         return false;
     }
+    d->odfMetaDoc = odfStore.metaDoc();
     return loadOdf(odfStore);
 }
 
@@ -36,6 +36,7 @@
 
 #include <KoText.h>
 #include <KoTextDocument.h>
+#include <KoTextSearchIndex.h>
 #include <KoShape.h>
 #include <KoShapeContainer.h>
 #include <KoTextShapeData.h>
@@ -90,15 +91,20 @@ void KoFindText::findImplementation(const QString &pattern, QList<KoFindMatch> &
     bool before = opts->option("fromCursor")->value().toBool() && !d->currentCursor.isNull();
     QList<KoFindMatch> matchBefore;
     foreach(QTextDocument* document, d->documents) {
-        QTextCursor cursor = document->find(pattern, start, flags);
-        cursor.setKeepPositionOnInsert(true);
+        const QVector<int> positions = KoTextSearchIndex::index(document)->findAll(pattern, flags, start);
 
         QVector<QAbstractTextDocumentLayout::Selection> selections;
-        while(!cursor.isNull()) {
-            if(findInSelection && d->selectionEnd <= cursor.position()) {
+        selections.reserve(positions.count());
+        foreach(int position, positions) {
+            if(findInSelection && d->selectionEnd <= position + pattern.length()) {
                 break;
             }
 
+            QTextCursor cursor(document);
+            cursor.setPosition(position);
+            cursor.setPosition(position + pattern.length(), QTextCursor::KeepAnchor);
+            cursor.setKeepPositionOnInsert(true);
+
             if (before && document == d->currentCursor.document() && d->currentCursor < cursor) {
                 before = false;
             }
@@ -117,9 +123,6 @@ void KoFindText::findImplementation(const QString &pattern, QList<KoFindMatch> &
             else {
                 matchList.append(match);
             }
-
-            cursor = document->find(pattern, cursor, flags);
-            cursor.setKeepPositionOnInsert(true);
         }
         if (before && document == d->currentCursor.document()) {
             before = false;
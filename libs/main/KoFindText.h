@@ -37,7 +37,7 @@ class KoShape;
  *
  * This class provides a link between KoFindBase and QTextDocument for searching.
  * It uses a list of QTextDocument instances and searches through them using
- * QTextDocument::find().
+ * the KoTextSearchIndex of each document.
  *
  * The following options are defined:
  * <ul>
@@ -245,7 +245,17 @@ bool KoEmbeddedDocumentSaver::saveEmbeddedDocuments(KoDocumentBase::SavingContex
         const QString fileName = path.right(path.size() - index - 1);
         store->enterDirectory(dirPath);
 
-        if (!store->open(fileName)) {
+        // no need to deflate e.g. video or png files again
+        const bool storeOnly = KoStore::isCompressedMimeType(QString::fromLatin1(entry->mimeType));
+        const bool compressionEnabled = store->isCompressionEnabled();
+        if (storeOnly) {
+            store->setCompressionEnabled(false);
+        }
+        const bool opened = store->open(fileName);
+        if (storeOnly) {
+            store->setCompressionEnabled(compressionEnabled);
+        }
+        if (!opened) {
             return false;
         }
         store->write(entry->contents);
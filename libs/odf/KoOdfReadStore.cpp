@@ -28,8 +28,95 @@
 
 #include "KoOdfStylesReader.h"
 
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThreadPool>
 #include <QXmlStreamReader>
 
+namespace {
+
+/**
+ * Parses one xml file of the package from memory.
+ *
+ * The task is queued on the global thread pool, but whoever waits for it
+ * runs it directly if no pool thread has picked it up yet, so waiting can
+ * never starve on a busy pool.
+ */
+class ParseTask
+{
+public:
+    ParseTask(const QString &fileName, const QByteArray &data, KoOdfStylesReader *stylesReader)
+        : fileName(fileName)
+        , data(data)
+        , stylesReader(stylesReader)
+        , ok(false)
+    {
+    }
+
+    void run()
+    {
+        if (!claimed.testAndSetOrdered(0, 1)) {
+            return;
+        }
+        QBuffer buffer(&data);
+        ok = KoOdfReadStore::loadAndParse(&buffer, doc, errorMessage, fileName);
+        data.clear();
+        if (ok && stylesReader) {
+            stylesReader->createStyleMap(doc, true);
+        }
+        finished.release();
+    }
+
+    void waitForFinished()
+    {
+        run();
+        finished.acquire();
+        finished.release();
+    }
+
+    /// hands the parsed document over, so it is not released by whichever thread drops the task last
+    KoXmlDocument takeDocument()
+    {
+        KoXmlDocument result = doc;
+        doc = KoXmlDocument();
+        return result;
+    }
+
+    QString fileName;
+    QByteArray data;
+    KoOdfStylesReader *stylesReader;
+
+    KoXmlDocument doc;
+    bool ok;
+    QString errorMessage;
+
+private:
+    QAtomicInt claimed;
+    QSemaphore finished;
+};
+
+class ParseJob : public QRunnable
+{
+public:
+    explicit ParseJob(const QSharedPointer<ParseTask> &task)
+        : m_task(task)
+    {
+    }
+
+    void run() override
+    {
+        m_task->run();
+    }
+
+private:
+    QSharedPointer<ParseTask> m_task;
+};
+
+}
+
 class Q_DECL_HIDDEN KoOdfReadStore::Private
 {
 public:
@@ -38,14 +125,33 @@ public:
     {
     }
 
+    /// reads @p fileName from the store and queues parsing it, returns a null task if there is no such file
+    QSharedPointer<ParseTask> startParsing(const QString &fileName, KoOdfStylesReader *reader = 0);
+
     KoStore * store;
     KoOdfStylesReader stylesReader;
     // it is needed to keep the stylesDoc around so that you can access the styles
     KoXmlDocument stylesDoc;
     KoXmlDocument contentDoc;
     KoXmlDocument settingsDoc;
+    KoXmlDocument metaDoc;
 };
 
+QSharedPointer<ParseTask> KoOdfReadStore::Private::startParsing(const QString &fileName, KoOdfStylesReader *reader)
+{
+    QByteArray data;
+    if (!store->hasFile(fileName)) {
+        return QSharedPointer<ParseTask>();
+    }
+    if (!store->extractFile(fileName, data)) {
+        // leave it to the parser to report the missing content
+        debugOdf << "Entry " << fileName << " could not be read";
+    }
+    QSharedPointer<ParseTask> task(new ParseTask(fileName, data, reader));
+    QThreadPool::globalInstance()->start(new ParseJob(task));
+    return task;
+}
+
 KoOdfReadStore::KoOdfReadStore(KoStore *store)
         : d(new Private(store))
 {
@@ -76,24 +182,61 @@ KoXmlDocument KoOdfReadStore::settingsDoc() const
     return d->settingsDoc;
 }
 
+KoXmlDocument KoOdfReadStore::metaDoc() const
+{
+    return d->metaDoc;
+}
+
 bool KoOdfReadStore::loadAndParse(QString &errorMessage)
 {
-    if (!loadAndParse("content.xml", d->contentDoc, errorMessage)) {
+    if (!d->store) {
+        errorMessage = i18n("No store backend");
         return false;
     }
 
-    if (d->store->hasFile("styles.xml")) {
-        if (!loadAndParse("styles.xml", d->stylesDoc, errorMessage)) {
+    // The store can only have one file open at a time, so the files are
+    // read one after the other and parsed in the background while
+    // content.xml, usually by far the biggest one, is parsed here.
+    // The style map of styles.xml is built on the thread that parsed it.
+    QSharedPointer<ParseTask> stylesTask = d->startParsing("styles.xml", &d->stylesReader);
+    QSharedPointer<ParseTask> settingsTask = d->startParsing("settings.xml");
+    QSharedPointer<ParseTask> metaTask = d->startParsing("meta.xml");
+
+    const bool contentOk = loadAndParse("content.xml", d->contentDoc, errorMessage);
+
+    if (metaTask) {
+        metaTask->waitForFinished();
+        if (metaTask->ok) {
+            d->metaDoc = metaTask->takeDocument();
+        }
+    }
+    if (settingsTask) {
+        settingsTask->waitForFinished();
+    }
+    if (stylesTask) {
+        stylesTask->waitForFinished();
+    }
+    if (!contentOk) {
+        return false;
+    }
+
+    if (stylesTask) {
+        if (!stylesTask->ok) {
+            errorMessage = stylesTask->errorMessage;
             return false;
         }
+        d->stylesDoc = stylesTask->takeDocument();
+    } else {
+        d->stylesReader.createStyleMap(d->stylesDoc, true);
     }
-    // Load styles from style.xml
-    d->stylesReader.createStyleMap(d->stylesDoc, true);
     // Also load styles from content.xml
     d->stylesReader.createStyleMap(d->contentDoc, false);
 
-    if (d->store->hasFile("settings.xml")) {
-        loadAndParse("settings.xml", d->settingsDoc, errorMessage);
+    if (settingsTask) {
+        d->settingsDoc = settingsTask->takeDocument();
+        if (!settingsTask->ok) {
+            errorMessage = settingsTask->errorMessage;
+        }
     }
     return true;
 }
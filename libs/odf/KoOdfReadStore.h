@@ -75,16 +75,31 @@ public:
      */
     KoXmlDocument settingsDoc() const;
 
+    /**
+     * Get the meta document
+     *
+     * To get a usable result loadAndParse( QString ) has to be called first.
+     *
+     * This gives you the content of the meta.xml file, or a null document
+     * if there is none or it could not be parsed.
+     */
+    KoXmlDocument metaDoc() const;
+
     /**
      * Load and parse
      *
-     * This function loads and parses the content.xml, styles.xml and the settings.xml
-     * file in the store. The sytles are already parsed.
+     * This function loads and parses the content.xml, styles.xml, settings.xml and
+     * meta.xml files in the store. The sytles are already parsed.
+     *
+     * The files are read one after the other, but styles.xml, settings.xml and
+     * meta.xml are parsed on the global thread pool while content.xml is parsed
+     * on the calling thread.
      *
      * After this function is called you can access the data via
      * styles()
      * contentDoc()
      * settingsDoc()
+     * metaDoc()
      *
      * @param errorMessage The errorMessage is set in case an error is encounted.
      * @return true if loading and parsing was successful, false otherwise. In case of an error
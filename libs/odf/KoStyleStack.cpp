@@ -24,20 +24,137 @@
 
 #include <OdfDebug.h>
 
+#include <QHash>
+#include <QVector>
+
 //#define DEBUG_STYLESTACK
 
+namespace {
+
+/**
+ * Identifies a style element on the stack. Elements are compared by
+ * identity, the style name is only used to spread them over the buckets.
+ */
+struct StyleElementKey
+{
+    StyleElementKey(const KoXmlElement &e, const QString &styleNSURI)
+        : element(e), hash(qHash(e.attributeNS(styleNSURI, "name", QString()))) {}
+    bool operator==(const StyleElementKey &other) const {
+        return element == other.element;
+    }
+    KoXmlElement element;
+    uint hash;
+};
+
+inline uint qHash(const StyleElementKey &key, uint /*seed*/ = 0)
+{
+    return key.hash;
+}
+
+/**
+ * A style element together with all the elements below it on the stack.
+ *
+ * Nodes form a tree: the same chain of parent styles pushed again and
+ * again ends up in the same node, so the lookups done for the chain the
+ * first time are served from values afterwards.
+ */
+class ResolvedStyle
+{
+public:
+    ResolvedStyle()
+        : parent(0) {}
+
+    ResolvedStyle(ResolvedStyle *p, const KoXmlElement &style,
+                  const QList<QString> &propertiesTagNames, const QString &styleNSURI)
+        : parent(p)
+    {
+        foreach (const QString &propertiesTagName, propertiesTagNames) {
+            properties.append(KoXml::namedItemNS(style, styleNSURI, propertiesTagName));
+        }
+    }
+
+    ~ResolvedStyle() {
+        qDeleteAll(children);
+    }
+
+    ResolvedStyle *child(const KoXmlElement &style,
+                         const QList<QString> &propertiesTagNames, const QString &styleNSURI)
+    {
+        const StyleElementKey key(style, styleNSURI);
+        ResolvedStyle *node = children.value(key);
+        if (!node) {
+            node = new ResolvedStyle(this, style, propertiesTagNames, styleNSURI);
+            children.insert(key, node);
+        }
+        return node;
+    }
+
+    ResolvedStyle *parent;
+    /// the properties elements of this style, one per properties tag name
+    QList<KoXmlElement> properties;
+    QHash<StyleElementKey, ResolvedStyle*> children;
+    /// flattened lookups for the chain ending in this node
+    QHash<QString, QString> values;
+    QHash<QString, bool> hasValues;
+};
+
+}
+
 class KoStyleStack::KoStyleStackPrivate
 {
+public:
+    KoStyleStackPrivate()
+        : root(0) {}
+
+    ~KoStyleStackPrivate() {
+        qDeleteAll(roots);
+    }
+
+    /// Return the resolved node for the top of the stack of @p q, or 0 if it is empty
+    ResolvedStyle *top(const KoStyleStack *q);
+
+    /// Drop the resolved nodes for stack entries at index @p count and above
+    void truncate(int count) {
+        if (path.count() > count) {
+            path.resize(count);
+        }
+    }
+
+    /// the resolved node tree, one per set of properties tag names
+    QHash<QString, ResolvedStyle*> roots;
+    ResolvedStyle *root;
+    /// resolved node for each stack entry; may be shorter than the stack
+    QVector<ResolvedStyle*> path;
 };
 
+ResolvedStyle *KoStyleStack::KoStyleStackPrivate::top(const KoStyleStack *q)
+{
+    if (q->m_stack.isEmpty()) {
+        return 0;
+    }
+    if (!root) {
+        const QString key = QStringList(q->m_propertiesTagNames).join(QChar(','));
+        root = roots.value(key);
+        if (!root) {
+            root = new ResolvedStyle;
+            roots.insert(key, root);
+        }
+    }
+    for (int index = path.count(); index < q->m_stack.count(); ++index) {
+        ResolvedStyle *parent = index > 0 ? path.at(index - 1) : root;
+        path.append(parent->child(q->m_stack.at(index), q->m_propertiesTagNames, q->m_styleNSURI));
+    }
+    return path.last();
+}
+
 KoStyleStack::KoStyleStack()
-        : m_styleNSURI(KoXmlNS::style), m_foNSURI(KoXmlNS::fo), d(0)
+        : m_styleNSURI(KoXmlNS::style), m_foNSURI(KoXmlNS::fo), d(new KoStyleStackPrivate)
 {
     clear();
 }
 
 KoStyleStack::KoStyleStack(const char* styleNSURI, const char* foNSURI)
-        : m_styleNSURI(styleNSURI), m_foNSURI(foNSURI), d(0)
+        : m_styleNSURI(styleNSURI), m_foNSURI(foNSURI), d(new KoStyleStackPrivate)
 {
     m_propertiesTagNames.append("properties");
     clear();
@@ -51,6 +168,7 @@ KoStyleStack::~KoStyleStack()
 void KoStyleStack::clear()
 {
     m_stack.clear();
+    d->truncate(0);
 #ifdef DEBUG_STYLESTACK
     debugOdf << "clear!";
 #endif
@@ -75,12 +193,14 @@ void KoStyleStack::restore()
     Q_ASSERT(toIndex <= (int)m_stack.count());   // If equal, nothing to remove. If greater, bug.
     for (int index = (int)m_stack.count() - 1; index >= toIndex; --index)
         m_stack.pop_back();
+    d->truncate(m_stack.count());
 }
 
 void KoStyleStack::pop()
 {
     Q_ASSERT(!m_stack.isEmpty());
     m_stack.pop_back();
+    d->truncate(m_stack.count());
 #ifdef DEBUG_STYLESTACK
     debugOdf << "pop -> count=" << m_stack.count();
 #endif
@@ -103,30 +223,51 @@ QString KoStyleStack::property(const QString &nsURI, const QString &name, const
     return property(nsURI, name, &detail);
 }
 
+static inline QString cacheKey(const QString &nsURI, const QString &name, const QString *detail)
+{
+    QString key(nsURI);
+    key += QChar(' ');
+    key += name;
+    if (detail) {
+        key += QChar(' ');
+        key += *detail;
+    }
+    return key;
+}
+
 inline QString KoStyleStack::property(const QString &nsURI, const QString &name, const QString *detail) const
 {
+    ResolvedStyle *top = d->top(this);
+    if (!top) {
+        return QString();
+    }
+    const QString key = cacheKey(nsURI, name, detail);
+    QHash<QString, QString>::ConstIterator cached = top->values.constFind(key);
+    if (cached != top->values.constEnd()) {
+        return cached.value();
+    }
+
     QString fullName(name);
     if (detail) {
         fullName += '-' + *detail;
     }
-    QList<KoXmlElement>::ConstIterator it = m_stack.end();
-    while (it != m_stack.begin()) {
-        --it;
-        foreach (const QString &propertyTagName, m_propertiesTagNames) {
-            KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertyTagName);
+    QString result;
+    for (ResolvedStyle *node = top; node->parent && result.isEmpty(); node = node->parent) {
+        foreach (const KoXmlElement &properties, node->properties) {
             if (detail) {
-                QString attribute(properties.attributeNS(nsURI, fullName));
-                if (!attribute.isEmpty()) {
-                    return attribute;
+                result = properties.attributeNS(nsURI, fullName);
+                if (!result.isEmpty()) {
+                    break;
                 }
             }
-            QString attribute(properties.attributeNS(nsURI, name));
-            if (!attribute.isEmpty()) {
-                return attribute;
+            result = properties.attributeNS(nsURI, name);
+            if (!result.isEmpty()) {
+                break;
             }
         }
     }
-    return QString();
+    top->values.insert(key, result);
+    return result;
 }
 
 bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name) const
@@ -141,21 +282,32 @@ bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name, const
 
 inline bool KoStyleStack::hasProperty(const QString &nsURI, const QString &name, const QString *detail) const
 {
+    ResolvedStyle *top = d->top(this);
+    if (!top) {
+        return false;
+    }
+    const QString key = cacheKey(nsURI, name, detail);
+    QHash<QString, bool>::ConstIterator cached = top->hasValues.constFind(key);
+    if (cached != top->hasValues.constEnd()) {
+        return cached.value();
+    }
+
     QString fullName(name);
     if (detail) {
         fullName += '-' + *detail;
     }
-    QList<KoXmlElement>::ConstIterator it = m_stack.end();
-    while (it != m_stack.begin()) {
-        --it;
-        foreach (const QString &propertiesTagName, m_propertiesTagNames) {
-            const KoXmlElement properties = KoXml::namedItemNS(*it, m_styleNSURI, propertiesTagName);
+    bool result = false;
+    for (ResolvedStyle *node = top; node->parent && !result; node = node->parent) {
+        foreach (const KoXmlElement &properties, node->properties) {
             if (properties.hasAttributeNS(nsURI, name) ||
-                    (detail && properties.hasAttributeNS(nsURI, fullName)))
-                return true;
+                    (detail && properties.hasAttributeNS(nsURI, fullName))) {
+                result = true;
+                break;
+            }
         }
     }
-    return false;
+    top->hasValues.insert(key, result);
+    return result;
 }
 
 // Font size is a bit special. "115%" applies to "the fontsize of the parent style".
@@ -260,12 +412,16 @@ QString KoStyleStack::userStyleDisplayName(const QString& family) const
 
 void KoStyleStack::setTypeProperties(const char* typeProperties)
 {
+    d->root = 0;
+    d->truncate(0);
     m_propertiesTagNames.clear();
     m_propertiesTagNames.append(typeProperties == 0 || qstrlen(typeProperties) == 0 ? QString("properties") : (QString(typeProperties) + "-properties"));
 }
 
 void KoStyleStack::setTypeProperties(const QList<QString> &typeProperties)
 {
+    d->root = 0;
+    d->truncate(0);
     m_propertiesTagNames.clear();
     foreach (const QString &typeProperty, typeProperties) {
         if (!typeProperty.isEmpty()) {
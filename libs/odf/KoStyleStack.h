@@ -54,6 +54,11 @@
  *  In general though, you wouldn't use push/pop directly, but KoOdfLoadingContext::fillStyleStack
  *  or KoOdfLoadingContext::addStyles to automatically push a style and all its
  *  parent styles onto the stack.
+ *
+ *  Lookups are cached per chain of pushed style elements, so pushing the same
+ *  styles again (e.g. for every paragraph using them) answers property() and
+ *  hasProperty() without walking the elements again. The cache lives as long
+ *  as the stack and assumes the pushed elements are not modified.
  */
 class KOODF_EXPORT KoStyleStack
 {
@@ -0,0 +1,162 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "TestKoStyleStack.h"
+
+#include <KoStyleStack.h>
+#include <KoXmlReader.h>
+#include <KoXmlNS.h>
+
+#include <QTest>
+#include <QLoggingCategory>
+
+static const char stylesXml[] =
+    "<office:styles xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+    " xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\""
+    " xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0\">"
+    "<style:style style:name=\"Standard\" style:family=\"paragraph\">"
+    "<style:paragraph-properties fo:margin=\"1cm\" fo:margin-left=\"2cm\"/>"
+    "<style:text-properties fo:color=\"#000000\" fo:font-size=\"12pt\"/>"
+    "</style:style>"
+    "<style:style style:name=\"P1\" style:family=\"paragraph\" style:parent-style-name=\"Standard\">"
+    "<style:paragraph-properties fo:margin=\"3cm\"/>"
+    "<style:text-properties fo:color=\"#ff0000\"/>"
+    "</style:style>"
+    "<style:style style:name=\"P2\" style:family=\"paragraph\" style:parent-style-name=\"Standard\">"
+    "<style:text-properties fo:color=\"\"/>"
+    "</style:style>"
+    "</office:styles>";
+
+static KoXmlElement styleElement(const KoXmlDocument &doc, const QString &name)
+{
+    KoXmlElement e;
+    forEachElement(e, doc.documentElement()) {
+        if (e.attributeNS(KoXmlNS::style, "name") == name)
+            return e;
+    }
+    return KoXmlElement();
+}
+
+void TestKoStyleStack::initTestCase()
+{
+    QLoggingCategory::setFilterRules("*.debug=false\n"
+        "calligra.lib.odf=true");
+}
+
+void TestKoStyleStack::testProperty()
+{
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(QByteArray(stylesXml), true));
+
+    KoStyleStack stack;
+    stack.setTypeProperties("paragraph");
+    stack.push(styleElement(doc, "Standard"));
+    stack.push(styleElement(doc, "P1"));
+
+    // twice, the second time is served from the cache
+    for (int i = 0; i < 2; ++i) {
+        QVERIFY(stack.hasProperty(KoXmlNS::fo, "margin"));
+        QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString("3cm"));
+        // P1 sets margin, which wins over margin-left of the parent
+        QCOMPARE(stack.property(KoXmlNS::fo, "margin", "left"), QString("3cm"));
+        QVERIFY(!stack.hasProperty(KoXmlNS::fo, "color"));
+        QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString());
+    }
+
+    stack.pop();
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString("1cm"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin", "left"), QString("2cm"));
+
+    stack.clear();
+    QVERIFY(!stack.hasProperty(KoXmlNS::fo, "margin"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString());
+}
+
+void TestKoStyleStack::testSaveRestore()
+{
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(QByteArray(stylesXml), true));
+
+    KoStyleStack stack;
+    stack.setTypeProperties("text");
+    stack.push(styleElement(doc, "Standard"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString("#000000"));
+
+    stack.save();
+    stack.push(styleElement(doc, "P1"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString("#ff0000"));
+    stack.restore();
+    QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString("#000000"));
+
+    // same depth, different style: must not reuse the lookups done for P1
+    stack.save();
+    stack.push(styleElement(doc, "P2"));
+    QVERIFY(stack.hasProperty(KoXmlNS::fo, "color"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString("#000000"));
+    stack.restore();
+
+    stack.save();
+    stack.push(styleElement(doc, "P1"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "color"), QString("#ff0000"));
+    stack.restore();
+}
+
+void TestKoStyleStack::testTypeProperties()
+{
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(QByteArray(stylesXml), true));
+
+    KoStyleStack stack;
+    stack.push(styleElement(doc, "Standard"));
+    stack.push(styleElement(doc, "P1"));
+
+    stack.setTypeProperties("paragraph");
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString("3cm"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "font-size"), QString());
+
+    stack.setTypeProperties("text");
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString());
+    QCOMPARE(stack.property(KoXmlNS::fo, "font-size"), QString("12pt"));
+
+    QList<QString> types;
+    types << "paragraph" << "text";
+    stack.setTypeProperties(types);
+    QCOMPARE(stack.property(KoXmlNS::fo, "margin"), QString("3cm"));
+    QCOMPARE(stack.property(KoXmlNS::fo, "font-size"), QString("12pt"));
+}
+
+void TestKoStyleStack::benchmarkProperty()
+{
+    KoXmlDocument doc;
+    QVERIFY(doc.setContent(QByteArray(stylesXml), true));
+    const KoXmlElement standard = styleElement(doc, "Standard");
+    const KoXmlElement p1 = styleElement(doc, "P1");
+
+    KoStyleStack stack;
+    stack.setTypeProperties("paragraph");
+    QBENCHMARK {
+        stack.save();
+        stack.push(standard);
+        stack.push(p1);
+        stack.property(KoXmlNS::fo, "margin", "left");
+        stack.property(KoXmlNS::fo, "margin", "right");
+        stack.hasProperty(KoXmlNS::fo, "text-indent");
+        stack.restore();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestKoStyleStack)
@@ -41,8 +41,12 @@ private Q_SLOTS:
     void testEscapingLongString();
     void testEscalingLongString2();
     void testConfig();
+    void testNumberAttributes();
+    void testUtf8Escaping();
+    void testBufferedOutput();
 
     void speedTest();
+    void benchmarkWriting();
 
 private:
     void setup(const char *publicId = 0, const char *systemId = 0);
@@ -228,6 +232,53 @@ void TestXmlWriter::testConfig()
             " <config:config-item config:name=\"TestConfigDouble\" config:type=\"double\">5</config:config-item>"));
 }
 
+void TestXmlWriter::testNumberAttributes()
+{
+    setup();
+    writer->startElement("test");
+    writer->addAttribute("a", 0.0);
+    writer->addAttribute("b", -2.5);
+    writer->addAttribute("c", 0.1);
+    writer->addAttribute("d", 1e20);
+    writer->addAttribute("e", 2.5f);
+    writer->addAttributePt("f", -0.75f);
+    writer->addAttribute("g", uint(4000000000u));
+    writer->addAttribute("h", int(-2147483647 - 1));
+    writer->endElement();
+    QCOMPARE(content(), QString("<test a=\"0.00000000000\" b=\"-2.50000000000\" c=\"0.10000000000\""
+                " d=\"%1\" e=\"2.500000\" f=\"-0.750000pt\" g=\"4000000000\" h=\"-2147483648\"/>")
+             .arg(QString::fromLatin1(QByteArray::number(1e20, 'f', 11))));
+}
+
+void TestXmlWriter::testUtf8Escaping()
+{
+    setup();
+    writer->startElement("test", false);
+    // euro sign, a surrogate pair, a lone surrogate and a control code which is dropped
+    QString text = QString::fromUtf8("<€ \xF0\x9D\x84\x9E&") + QChar(0xd800) + QChar(0x1) + QLatin1String("\"");
+    writer->addAttribute("a", text);
+    writer->addTextNode(text);
+    writer->endElement();
+    const QString expected = QString::fromUtf8("&lt;€ \xF0\x9D\x84\x9E&amp;?&quot;");
+    QCOMPARE(content(), QString("<test a=\"%1\">%1</test>").arg(expected));
+}
+
+void TestXmlWriter::testBufferedOutput()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    KoXmlWriter xmlWriter(&buffer);
+    xmlWriter.startElement("a");
+    xmlWriter.startElement("b");
+    xmlWriter.addAttribute("c", "d");
+    // device() hands out a device with everything written so far
+    QCOMPARE(xmlWriter.device()->size(), qint64(13));
+    xmlWriter.endElement();
+    xmlWriter.endElement();
+    // closing the outermost element flushes as well
+    QCOMPARE(QString::fromUtf8(buffer.data()), QString("<a>\n <b c=\"d\"/>\n</a>"));
+}
+
 static const int NumParagraphs = 30000;
 
 void TestXmlWriter::speedTest()
@@ -257,6 +308,30 @@ void TestXmlWriter::speedTest()
     // TODO we might want to convert this into a QBenchmark test
 }
 
+void TestXmlWriter::benchmarkWriting()
+{
+    const QString paragText = QString::fromUtf8("This is the text of the paragraph. I'm including a euro sign to test encoding issues: €");
+    const QString styleName = "Heading 1";
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        KoXmlWriter writer(&buffer);
+        writer.startDocument("rootelem");
+        writer.startElement("rootelem");
+        for (int i = 0 ; i < NumParagraphs ; ++i) {
+            writer.startElement("paragraph");
+            writer.addAttribute("text:style-name", styleName);
+            writer.addAttributePt("svg:x", i * 0.35);
+            writer.addAttribute("text:level", i % 10);
+            writer.addTextNode(paragText);
+            writer.endElement();
+        }
+        writer.endElement();
+        writer.endDocument();
+    }
+}
+
 QTEST_GUILESS_MAIN(TestXmlWriter)
 #include <TestXmlWriter.moc>
 
@@ -577,6 +577,23 @@ void KoStore::setCompressionEnabled(bool /*e*/)
 {
 }
 
+bool KoStore::isCompressionEnabled() const
+{
+    return false;
+}
+
+bool KoStore::isCompressedMimeType(const QString &mimeType)
+{
+    if (mimeType.startsWith(QLatin1String("video/")) || mimeType.startsWith(QLatin1String("audio/"))) {
+        return true;
+    }
+    return mimeType == QLatin1String("image/png")
+        || mimeType == QLatin1String("image/jpeg")
+        || mimeType == QLatin1String("image/gif")
+        || mimeType == QLatin1String("image/webp")
+        || mimeType == QLatin1String("application/zip");
+}
+
 bool KoStore::isEncrypted()
 {
     return false;
@@ -313,6 +313,18 @@ public:
      */
     virtual void setCompressionEnabled(bool e);
 
+    /**
+     * Returns whether files opened for writing are compressed, see setCompressionEnabled().
+     */
+    virtual bool isCompressionEnabled() const;
+
+    /**
+     * Returns whether data of the given mime type is compressed already, like
+     * PNG or JPEG images or audio and video, so that it can be written with
+     * compression disabled: deflating it again costs time and gains nothing.
+     */
+    static bool isCompressedMimeType(const QString &mimeType);
+
 protected:
     KoStore(Mode mode, bool writeMimetype = true);
 
@@ -304,10 +304,23 @@ public:
 #ifdef KOXML_COMPACT
     // map given depth to the list of items
     QHash<int, KoXmlPackedGroup> groups;
+#ifdef KOXML_COMPRESS
+    // applied to every group, depends on the size of the document
+    KoXmlVectorPolicy groupPolicy;
+#endif
 #else
     QVector<KoXmlPackedItem> items;
 #endif
 
+    /// tells the expected size of the xml in bytes, -1 if it is unknown
+#ifdef KOXML_COMPRESS
+    void setSizeHint(qint64 size) {
+        groupPolicy = KoXmlVectorPolicy::forDocumentSize(size);
+    }
+#else
+    void setSizeHint(qint64) {}
+#endif
+
     QList<KoQName> qnameList;
     QString docType;
 
@@ -377,6 +390,8 @@ public:
         KoXmlPackedGroup& group = groups[depth];
 
 #ifdef KOXML_COMPRESS
+        if (group.isEmpty())
+            group.setPolicy(groupPolicy);
         KoXmlPackedItem& item = group.newItem();
 #else
         // reserve up front
@@ -469,6 +484,9 @@ public:
 
 public:
     KoXmlPackedDocument(): processNamespace(false), currentDepth(0) {
+#ifdef KOXML_COMPRESS
+        groupPolicy = KoXmlVectorPolicy::forDocumentSize(-1);
+#endif
         clear();
     }
 
@@ -765,11 +783,15 @@ public:
     QString prefix;
     QString localName;
 
+    // The shared null node is never deleted and is referenced by documents
+    // that may be parsed on different threads, so it is not counted.
     void ref() {
-        ++refCount;
+        if (this != &null) {
+            ++refCount;
+        }
     }
     void unref() {
-        if (!--refCount) {
+        if (this != &null && !--refCount) {
             delete this;
         }
     }
@@ -1498,6 +1520,7 @@ bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg,
 
     packedDoc = new KoXmlPackedDocument;
     packedDoc->processNamespace = reader->namespaceProcessing();
+    packedDoc->setSizeHint(reader->device() ? reader->device()->size() : -1);
 
     ParseError error = parseDocument(*reader, *packedDoc, stripSpaces);
     if (error.error) {
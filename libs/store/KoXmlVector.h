@@ -28,10 +28,76 @@
 #endif
 
 #include <QVector>
+#include <QList>
 #include <QByteArray>
 #include <QDataStream>
 #include <QBuffer>
 
+#include <algorithm>
+
+/**
+ * Runtime settings for KoXmlVector: how many items are compressed together
+ * and how many decompressed blocks are kept around for reading.
+ */
+struct KoXmlVectorPolicy
+{
+    /// false keeps all items uncompressed in one plain vector
+    bool compressed;
+    /// number of items compressed together in one block
+    int blockSize;
+    /// number of decompressed blocks kept for reading, least recently used are dropped
+    int cachedBlocks;
+
+    /**
+     * Policy for a document of @p size bytes, pass -1 if unknown.
+     * Small documents are not compressed at all, the time is better spent
+     * elsewhere; huge ones use bigger blocks, which compress better.
+     */
+    static KoXmlVectorPolicy forDocumentSize(qint64 size) {
+        KoXmlVectorPolicy policy;
+        policy.compressed = true;
+        policy.blockSize = 256;
+        policy.cachedBlocks = 2;
+        if (size < 0) {
+            return policy;
+        }
+        if (size < 512 * 1024) {
+            policy.compressed = false;
+        } else if (size < 16 * 1024 * 1024) {
+            policy.cachedBlocks = 4;
+        } else {
+            policy.blockSize = 1024;
+            policy.cachedBlocks = 4;
+        }
+        return policy;
+    }
+};
+
+/**
+ * Numbers about the memory used by a KoXmlVector and how well its cache of
+ * decompressed blocks works.
+ */
+struct KoXmlVectorStatistics
+{
+    int itemSize;            ///< sizeof() of one item
+    int blockCount;          ///< number of compressed blocks
+    qint64 compressedBytes;  ///< size of all compressed blocks
+    int uncompressedItems;   ///< items held uncompressed, not counting the cache
+    int cachedItems;         ///< items in the decompressed block cache
+    int cacheHits;
+    int cacheMisses;
+
+    /// rough estimate of the memory used, in bytes
+    qint64 memoryUsage() const {
+        return compressedBytes + qint64(uncompressedItems + cachedItems) * itemSize;
+    }
+
+    qreal hitRate() const {
+        const int lookups = cacheHits + cacheMisses;
+        return lookups ? qreal(cacheHits) / lookups : 0.0;
+    }
+};
+
 /**
  * KoXmlVector
  *
@@ -40,66 +106,81 @@
  *
  * Needs to be used like this, otherwise will crash:
  * <ul>
+ * <li>optionally choose a policy with setPolicy()</li>
  * <li>add content with newItem()</li>
  * <li>finish adding content with squeeze()</li>
  * <li>just read content with operator[]</li>
  * </ul>
  *
- * @param uncompressedItemCount when number of buffered items reach this,
- *      compression will start small value will give better memory usage at the
- *      cost of speed bigger value will be better in term of speed, but use
- *      more memory
+ * @param uncompressedItemCount default block size: when number of buffered
+ *      items reach this, compression will start small value will give better
+ *      memory usage at the cost of speed bigger value will be better in term
+ *      of speed, but use more memory
  */
 template <typename T, int uncompressedItemCount = 256, int reservedBufferSize = 1024*1024>
 class KoXmlVector
 {
 private:
+    struct CachedBlock {
+        int block;
+        QVector<T> items;
+    };
+
     unsigned m_totalItems;
+    KoXmlVectorPolicy m_policy;
     QVector<unsigned> m_startIndex;
     QVector<QByteArray> m_blocks;
 
-    mutable unsigned m_bufferStartIndex;
-    mutable QVector<T> m_bufferItems;
+    // items which are not compressed (yet), starting at m_bufferStartIndex
+    unsigned m_bufferStartIndex;
+    QVector<T> m_bufferItems;
+
+    mutable QList<CachedBlock> m_cache; // most recently used first
     mutable QByteArray m_bufferData;
+    mutable int m_cacheHits;
+    mutable int m_cacheMisses;
 
 protected:
     /**
-     * fetch given item index to the buffer
-     * will INVALIDATE all references to the buffer
+     * return the decompressed items of the given block
+     * will INVALIDATE all references to other blocks
      */
-    void fetchItem(unsigned index) const {
-        // already in the buffer ?
-        if (index >= m_bufferStartIndex)
-            if (index - m_bufferStartIndex < (unsigned)m_bufferItems.count())
-                return;
-
-        // search in the stored blocks
-        // TODO: binary search to speed up
-        int loc = m_startIndex.count() - 1;
-        for (int c = 0; c < m_startIndex.count() - 1; ++c)
-            if (index >= m_startIndex[c])
-                if (index < m_startIndex[c+1]) {
-                    loc = c;
-                    break;
-                }
-
-        m_bufferStartIndex = m_startIndex[loc];
+    const QVector<T> &fetchBlock(int block) const {
+        for (int i = 0; i < m_cache.count(); ++i) {
+            if (m_cache[i].block == block) {
+                ++m_cacheHits;
+                if (i > 0)
+                    m_cache.move(i, 0);
+                return m_cache.first().items;
+            }
+        }
+
+        ++m_cacheMisses;
+        while (!m_cache.isEmpty() && m_cache.count() >= qMax(1, m_policy.cachedBlocks))
+            m_cache.removeLast();
+
+        m_cache.prepend(CachedBlock());
+        CachedBlock &cached = m_cache.first();
+        cached.block = block;
 #ifdef KOXMLVECTOR_USE_LZF
-        KoLZF::decompress(m_blocks[loc], m_bufferData);
+        KoLZF::decompress(m_blocks[block], m_bufferData);
 #else
-        m_bufferData = m_blocks[loc];
+        m_bufferData = m_blocks[block];
 #endif
         QBuffer buffer(&m_bufferData);
         buffer.open(QIODevice::ReadOnly);
         QDataStream in(&buffer);
-        m_bufferItems.clear();
-        in >> m_bufferItems;
+        in >> cached.items;
+        return cached.items;
     }
 
     /**
      * store data in the buffer to main m_blocks
      */
     void storeBuffer() {
+        if (m_bufferItems.isEmpty())
+            return;
+
         QBuffer buffer;
         buffer.open(QIODevice::WriteOnly);
         QDataStream out(&buffer);
@@ -117,7 +198,11 @@ protected:
     }
 
 public:
-    inline KoXmlVector(): m_totalItems(0), m_bufferStartIndex(0) {};
+    inline KoXmlVector(): m_totalItems(0), m_bufferStartIndex(0), m_cacheHits(0), m_cacheMisses(0) {
+        m_policy.compressed = true;
+        m_policy.blockSize = uncompressedItemCount;
+        m_policy.cachedBlocks = 1;
+    }
 
     void clear() {
         m_totalItems = 0;
@@ -126,7 +211,40 @@ public:
 
         m_bufferStartIndex = 0;
         m_bufferItems.clear();
-        m_bufferData.reserve(reservedBufferSize);
+        m_cache.clear();
+        m_cacheHits = 0;
+        m_cacheMisses = 0;
+        if (m_policy.compressed)
+            m_bufferData.reserve(reservedBufferSize);
+    }
+
+    /**
+     * Set how items are stored, only possible while the vector is empty.
+     */
+    void setPolicy(const KoXmlVectorPolicy &policy) {
+        Q_ASSERT(isEmpty());
+        m_policy = policy;
+        m_policy.blockSize = qMax(1, m_policy.blockSize);
+    }
+
+    inline const KoXmlVectorPolicy &policy() const {
+        return m_policy;
+    }
+
+    KoXmlVectorStatistics statistics() const {
+        KoXmlVectorStatistics stats;
+        stats.itemSize = sizeof(T);
+        stats.blockCount = m_blocks.count();
+        stats.compressedBytes = 0;
+        foreach (const QByteArray &block, m_blocks)
+            stats.compressedBytes += block.size();
+        stats.uncompressedItems = m_bufferItems.count();
+        stats.cachedItems = 0;
+        foreach (const CachedBlock &cached, m_cache)
+            stats.cachedItems += cached.items.count();
+        stats.cacheHits = m_cacheHits;
+        stats.cacheMisses = m_cacheMisses;
+        return stats;
     }
 
     inline int count() const {
@@ -146,7 +264,7 @@ public:
      */
     T& newItem() {
         // buffer full?
-        if (m_bufferItems.count() >= uncompressedItemCount - 1)
+        if (m_policy.compressed && m_bufferItems.count() >= m_policy.blockSize)
             storeBuffer();
 
         ++m_totalItems;
@@ -159,8 +277,13 @@ public:
      * it may be invalid if another function is invoked
      */
     const T &operator[](int i) const {
-        fetchItem((unsigned)i);
-        return m_bufferItems[i - m_bufferStartIndex];
+        const unsigned index = i;
+        if (index >= m_bufferStartIndex)
+            return m_bufferItems[index - m_bufferStartIndex];
+
+        const int block = std::upper_bound(m_startIndex.constBegin(), m_startIndex.constEnd(), index)
+                          - m_startIndex.constBegin() - 1;
+        return fetchBlock(block)[index - m_startIndex[block]];
     }
 
     /**
@@ -168,7 +291,10 @@ public:
      * will INVALIDATE all references to the buffer
      */
     void squeeze() {
-        storeBuffer();
+        if (m_policy.compressed)
+            storeBuffer();
+        else
+            m_bufferItems.squeeze();
     }
 
 };
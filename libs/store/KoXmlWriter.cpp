@@ -24,17 +24,18 @@
 #include <QByteArray>
 #include <QStack>
 #include <float.h>
+#include <cmath>
 
 static const int s_indentBufferLength = 100;
-static const int s_escapeBufferLen = 10000;
+static const int s_outputBufferLength = 16 * 1024;
 
 class Q_DECL_HIDDEN KoXmlWriter::Private
 {
 public:
-    Private(QIODevice* dev_, int indentLevel = 0) : dev(dev_), baseIndentLevel(indentLevel) {}
+    Private(QIODevice* dev_, int indentLevel = 0) : dev(dev_), baseIndentLevel(indentLevel), outputLength(0) {}
     ~Private() {
         delete[] indentBuffer;
-        delete[] escapeBuffer;
+        delete[] outputBuffer;
         //TODO: look at if we must delete "dev". For me we must delete it otherwise we will leak it
     }
 
@@ -44,9 +45,67 @@ public:
 
     char* indentBuffer; // maybe make it static, but then it needs a K_GLOBAL_STATIC
     // and would eat 1K all the time... Maybe refcount it :)
-    char* escapeBuffer; // can't really be static if we want to be thread-safe
+    char* outputBuffer; // everything is written here first, and to dev in one go
+    int outputLength;
 };
 
+// Formats @p value like QByteArray::setNum(value, 'f', precision) does, but
+// without allocating. Returns the length written to @p buffer, or -1 if the
+// value is out of the range handled here and Qt has to do the job.
+static int formatDecimal(char* buffer, double value, int precision)
+{
+    static const double scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11 };
+    // !(x < y) also catches nan
+    if (precision < 0 || precision > 11 || !(qAbs(value) < 1e15))
+        return -1;
+    if (value == 0 && std::signbit(value))
+        return -1;
+
+    const bool negative = value < 0;
+    if (negative)
+        value = -value;
+    double intPart = std::floor(value);
+    // value - intPart is exact, the multiplication is off by at most one ulp
+    // (< 2e-5 in this range), so only trust the rounding away from the halfway point
+    const double scaled = (value - intPart) * scales[precision];
+    double fracPart = std::floor(scaled);
+    const double rest = scaled - fracPart;
+    if (qAbs(rest - 0.5) < 1e-4)
+        return -1;
+    if (rest > 0.5)
+        fracPart += 1;
+    if (fracPart >= scales[precision]) {
+        fracPart -= scales[precision];
+        intPart += 1;
+    }
+    quint64 integer = quint64(intPart);
+    quint64 fraction = quint64(fracPart);
+    if (negative && integer == 0 && fraction == 0)
+        return -1; // "-0.000", leave that one to Qt as well
+
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = '0' + integer % 10;
+        integer /= 10;
+    } while (integer);
+
+    char* out = buffer;
+    if (negative)
+        *out++ = '-';
+    while (count)
+        *out++ = digits[--count];
+    if (precision > 0) {
+        *out++ = '.';
+        for (int i = precision - 1; i >= 0; --i) {
+            out[i] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        out += precision;
+    }
+    return out - buffer;
+}
+
 KoXmlWriter::KoXmlWriter(QIODevice* dev, int indentLevel)
         : d(new Private(dev, indentLevel))
 {
@@ -59,16 +118,56 @@ void KoXmlWriter::init()
     memset(d->indentBuffer, ' ', s_indentBufferLength);
     *d->indentBuffer = '\n'; // write newline before indentation, in one go
 
-    d->escapeBuffer = new char[s_escapeBufferLen];
+    d->outputBuffer = new char[s_outputBufferLength];
     if (!d->dev->isOpen())
         d->dev->open(QIODevice::WriteOnly);
 }
 
 KoXmlWriter::~KoXmlWriter()
 {
+    flush();
     delete d;
 }
 
+void KoXmlWriter::flush()
+{
+    if (d->outputLength > 0) {
+        d->dev->write(d->outputBuffer, d->outputLength);
+        d->outputLength = 0;
+    }
+}
+
+inline void KoXmlWriter::flushIfTopLevel()
+{
+    if (d->tags.isEmpty())
+        flush();
+}
+
+void KoXmlWriter::writeData(const char* data, int length)
+{
+    if (d->outputLength + length > s_outputBufferLength) {
+        flush();
+        if (length >= s_outputBufferLength) {
+            d->dev->write(data, length);
+            return;
+        }
+    }
+    memcpy(d->outputBuffer + d->outputLength, data, length);
+    d->outputLength += length;
+}
+
+void KoXmlWriter::writeCString(const char* cstr)
+{
+    writeData(cstr, qstrlen(cstr));
+}
+
+void KoXmlWriter::writeChar(char c)
+{
+    if (d->outputLength == s_outputBufferLength)
+        flush();
+    d->outputBuffer[d->outputLength++] = c;
+}
+
 void KoXmlWriter::startDocument(const char* rootElemName, const char* publicId, const char* systemId)
 {
     Q_ASSERT(d->tags.isEmpty());
@@ -85,6 +184,7 @@ void KoXmlWriter::startDocument(const char* rootElemName, const char* publicId,
         writeCString("\"");
         writeCString(">\n");
     }
+    flushIfTopLevel();
 }
 
 void KoXmlWriter::endDocument()
@@ -92,6 +192,7 @@ void KoXmlWriter::endDocument()
     // just to do exactly like QDom does (newline at end of file).
     writeChar('\n');
     Q_ASSERT(d->tags.isEmpty());
+    flushIfTopLevel();
 }
 
 // returns the value of indentInside of the parent
@@ -133,7 +234,7 @@ void KoXmlWriter::startElement(const char* tagName, bool indentInside)
 
     d->tags.push(Tag(tagName, parentIndent && indentInside));
     writeChar('<');
-    writeCString(tagName);
+    writeData(tagName, d->tags.top().tagNameLength);
     //kDebug(s_area) << tagName;
 }
 
@@ -141,6 +242,7 @@ void KoXmlWriter::addCompleteElement(const char* cstr)
 {
     prepareForChild();
     writeCString(cstr);
+    flushIfTopLevel();
 }
 
 
@@ -164,12 +266,13 @@ void KoXmlWriter::addCompleteElement(QIODevice* indev)
         qint64 len = indev->read(buffer.data(), buffer.size());
         if (len <= 0)   // e.g. on error
             break;
-        d->dev->write(buffer.data(), len);
+        writeData(buffer.data(), len);
     }
     if (!wasOpen) {
         // Restore initial state
         indev->close();
     }
+    flushIfTopLevel();
 }
 
 void KoXmlWriter::endElement()
@@ -189,28 +292,32 @@ void KoXmlWriter::endElement()
         }
         writeCString("</");
         Q_ASSERT(tag.tagName != 0);
-        writeCString(tag.tagName);
+        writeData(tag.tagName, tag.tagNameLength);
         writeChar('>');
     }
+    flushIfTopLevel();
+}
+
+void KoXmlWriter::addTextNode(const QString& str)
+{
+    prepareForTextNode();
+    writeEscaped(str);
+    flushIfTopLevel();
 }
 
 void KoXmlWriter::addTextNode(const QByteArray& cstr)
 {
     // Same as the const char* version below, but here we know the size
     prepareForTextNode();
-    char* escaped = escapeForXML(cstr.constData(), cstr.size());
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(cstr.constData(), cstr.size());
+    flushIfTopLevel();
 }
 
 void KoXmlWriter::addTextNode(const char* cstr)
 {
     prepareForTextNode();
-    char* escaped = escapeForXML(cstr, -1);
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(cstr, -1);
+    flushIfTopLevel();
 }
 
 void KoXmlWriter::addProcessingInstruction(const char* cstr)
@@ -219,6 +326,16 @@ void KoXmlWriter::addProcessingInstruction(const char* cstr)
     writeCString("<?");
     addTextNode(cstr);
     writeCString("?>");
+    flushIfTopLevel();
+}
+
+void KoXmlWriter::addAttribute(const char* attrName, const QString& value)
+{
+    writeChar(' ');
+    writeCString(attrName);
+    writeCString("=\"");
+    writeEscaped(value);
+    writeChar('"');
 }
 
 void KoXmlWriter::addAttribute(const char* attrName, const QByteArray& value)
@@ -227,10 +344,7 @@ void KoXmlWriter::addAttribute(const char* attrName, const QByteArray& value)
     writeChar(' ');
     writeCString(attrName);
     writeCString("=\"");
-    char* escaped = escapeForXML(value.constData(), value.size());
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(value.constData(), value.size());
     writeChar('"');
 }
 
@@ -239,82 +353,104 @@ void KoXmlWriter::addAttribute(const char* attrName, const char* value)
     writeChar(' ');
     writeCString(attrName);
     writeCString("=\"");
-    char* escaped = escapeForXML(value, -1);
-    writeCString(escaped);
-    if (escaped != d->escapeBuffer)
-        delete[] escaped;
+    writeEscaped(value, -1);
     writeChar('"');
 }
 
+void KoXmlWriter::addAttribute(const char* attrName, int value)
+{
+    writeNumberAttribute(attrName, value);
+}
+
+void KoXmlWriter::addAttribute(const char* attrName, uint value)
+{
+    writeNumberAttribute(attrName, value);
+}
+
 void KoXmlWriter::addAttribute(const char* attrName, double value)
 {
-    QByteArray str;
-    str.setNum(value, 'f', 11);
-    addAttribute(attrName, str.data());
+    writeNumberAttribute(attrName, value, 11, 0);
 }
 
 void KoXmlWriter::addAttribute(const char* attrName, float value)
 {
-    QByteArray str;
-    str.setNum(value, 'f', FLT_DIG);
-    addAttribute(attrName, str.data());
+    writeNumberAttribute(attrName, value, FLT_DIG, 0);
 }
 
 void KoXmlWriter::addAttributePt(const char* attrName, double value)
 {
-    QByteArray str;
-    str.setNum(value, 'f', 11);
-    str += "pt";
-    addAttribute(attrName, str.data());
+    writeNumberAttribute(attrName, value, 11, "pt");
 }
 
 void KoXmlWriter::addAttributePt(const char* attrName, float value)
 {
-    QByteArray str;
-    str.setNum(value, 'f', FLT_DIG);
-    str += "pt";
-    addAttribute(attrName, str.data());
+    writeNumberAttribute(attrName, value, FLT_DIG, "pt");
+}
+
+void KoXmlWriter::writeNumberAttribute(const char* attrName, double value, int precision, const char* suffix)
+{
+    writeChar(' ');
+    writeCString(attrName);
+    writeCString("=\"");
+    char buffer[64];
+    const int length = formatDecimal(buffer, value, precision);
+    if (length >= 0) {
+        writeData(buffer, length);
+    } else {
+        const QByteArray str = QByteArray::number(value, 'f', precision);
+        writeData(str.constData(), str.size());
+    }
+    if (suffix)
+        writeCString(suffix);
+    writeChar('"');
+}
+
+void KoXmlWriter::writeNumberAttribute(const char* attrName, qlonglong value)
+{
+    writeChar(' ');
+    writeCString(attrName);
+    writeCString("=\"");
+    char digits[24];
+    int count = 0;
+    quint64 absolute = value < 0 ? quint64(-(value + 1)) + 1 : quint64(value);
+    do {
+        digits[count++] = '0' + absolute % 10;
+        absolute /= 10;
+    } while (absolute);
+    if (value < 0)
+        writeChar('-');
+    while (count)
+        writeChar(digits[--count]);
+    writeChar('"');
 }
 
 void KoXmlWriter::writeIndent()
 {
     // +1 because of the leading '\n'
-    d->dev->write(d->indentBuffer, qMin(indentLevel() + 1,
-                                        s_indentBufferLength));
+    writeData(d->indentBuffer, qMin(indentLevel() + 1,
+                                    s_indentBufferLength));
 }
 
 void KoXmlWriter::writeString(const QString& str)
 {
     // cachegrind says .utf8() is where most of the time is spent
     const QByteArray cstr = str.toUtf8();
-    d->dev->write(cstr);
+    writeData(cstr.constData(), cstr.size());
 }
 
-// In case of a reallocation (ret value != d->buffer), the caller owns the return value,
-// it must delete it (with [])
-char* KoXmlWriter::escapeForXML(const char* source, int length = -1) const
+// Escapes into the output buffer, flushing it when it gets full.
+// We're pessimistic on char length; so there is always room left for
+// the longest thing one char can become: 6 (&quot;)
+void KoXmlWriter::writeEscaped(const char* source, int length)
 {
-    // we're going to be pessimistic on char length; so lets make the outputLength less
-    // the amount one char can take: 6
-    char* destBoundary = d->escapeBuffer + s_escapeBufferLen - 6;
-    char* destination = d->escapeBuffer;
-    char* output = d->escapeBuffer;
-    const char* src = source; // src moves, source remains
-    for (;;) {
+    char* destination = d->outputBuffer + d->outputLength;
+    char* const destBoundary = d->outputBuffer + s_outputBufferLength - 6;
+    const char* const end = length < 0 ? 0 : source + length;
+    for (const char* src = source; src != end && *src; ++src) {
         if (destination >= destBoundary) {
-            // When we come to realize that our escaped string is going to
-            // be bigger than the escape buffer (this shouldn't happen very often...),
-            // we drop the idea of using it, and we allocate a bigger buffer.
-            // Note that this if() can only be hit once per call to the method.
-            if (length == -1)
-                length = qstrlen(source);   // expensive...
-            uint newLength = length * 6 + 1; // worst case. 6 is due to &quot; and &apos;
-            char* buffer = new char[ newLength ];
-            destBoundary = buffer + newLength;
-            uint amountOfCharsAlreadyCopied = destination - d->escapeBuffer;
-            memcpy(buffer, d->escapeBuffer, amountOfCharsAlreadyCopied);
-            output = buffer;
-            destination = buffer + amountOfCharsAlreadyCopied;
+            d->outputLength = destination - d->outputBuffer;
+            flush();
+            destination = d->outputBuffer;
         }
         switch (*src) {
         case 60: // <
@@ -339,28 +475,91 @@ char* KoXmlWriter::escapeForXML(const char* source, int length = -1) const
             memcpy(destination, "&amp;", 5);
             destination += 5;
             break;
-        case 0:
-            *destination = '\0';
-            return output;
         // Control codes accepted in XML 1.0 documents.
         case 9:
         case 10:
         case 13:
-            *destination++ = *src++;
-            continue;
+            *destination++ = *src;
+            break;
         default:
             // Don't add control codes not accepted in XML 1.0 documents.
-            if (*src > 0 && *src < 32) {
-                ++src;
+            if (*src < 0 || *src >= 32) {
+                *destination++ = *src;
+            }
+            break;
+        }
+    }
+    d->outputLength = destination - d->outputBuffer;
+}
+
+// Same as above, but converts to utf8 on the fly, like QString::toUtf8()
+// does (lone surrogates become '?'), which saves the temporary QByteArray.
+void KoXmlWriter::writeEscaped(const QString& str)
+{
+    char* destination = d->outputBuffer + d->outputLength;
+    char* const destBoundary = d->outputBuffer + s_outputBufferLength - 6;
+    const QChar* src = str.constData();
+    const QChar* const end = src + str.length();
+    for (; src != end; ++src) {
+        if (destination >= destBoundary) {
+            d->outputLength = destination - d->outputBuffer;
+            flush();
+            destination = d->outputBuffer;
+        }
+        const ushort unicode = src->unicode();
+        if (unicode < 0x80) {
+            switch (unicode) {
+            case 60: // <
+                memcpy(destination, "&lt;", 4);
+                destination += 4;
+                break;
+            case 62: // >
+                memcpy(destination, "&gt;", 4);
+                destination += 4;
+                break;
+            case 34: // "
+                memcpy(destination, "&quot;", 6);
+                destination += 6;
+                break;
+            case 38: // &
+                memcpy(destination, "&amp;", 5);
+                destination += 5;
+                break;
+            case 0:
+                // the char* version stops there as well
+                d->outputLength = destination - d->outputBuffer;
+                return;
+            case 9:
+            case 10:
+            case 13:
+                *destination++ = unicode;
+                break;
+            default:
+                if (unicode >= 32) {
+                    *destination++ = unicode;
+                }
+                break;
+            }
+        } else if (unicode < 0x800) {
+            *destination++ = 0xc0 | (unicode >> 6);
+            *destination++ = 0x80 | (unicode & 0x3f);
+        } else if (QChar::isSurrogate(unicode)) {
+            if (QChar::isHighSurrogate(unicode) && src + 1 != end && (src + 1)->isLowSurrogate()) {
+                const uint ucs4 = QChar::surrogateToUcs4(unicode, (++src)->unicode());
+                *destination++ = 0xf0 | (ucs4 >> 18);
+                *destination++ = 0x80 | ((ucs4 >> 12) & 0x3f);
+                *destination++ = 0x80 | ((ucs4 >> 6) & 0x3f);
+                *destination++ = 0x80 | (ucs4 & 0x3f);
             } else {
-                *destination++ = *src++;
+                *destination++ = '?';
             }
-            continue;
+        } else {
+            *destination++ = 0xe0 | (unicode >> 12);
+            *destination++ = 0x80 | ((unicode >> 6) & 0x3f);
+            *destination++ = 0x80 | (unicode & 0x3f);
         }
-        ++src;
     }
-    // NOTREACHED (see case 0)
-    return output;
+    d->outputLength = destination - d->outputBuffer;
 }
 
 void KoXmlWriter::addManifestEntry(const QString& fullPath, const QString& mediaType)
@@ -528,6 +727,7 @@ void KoXmlWriter::addTextSpan(const QString& text, const QMap<int, int>& tabCach
 
 QIODevice *KoXmlWriter::device() const
 {
+    const_cast<KoXmlWriter*>(this)->flush();
     return d->dev;
 }
 
@@ -547,6 +747,7 @@ QList<const char*> KoXmlWriter::tagHierarchy() const
 
 QString KoXmlWriter::toString() const
 {
+    const_cast<KoXmlWriter*>(this)->flush();
     Q_ASSERT(!d->dev->isSequential());
     if (d->dev->isSequential())
         return QString();
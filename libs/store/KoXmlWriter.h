@@ -31,6 +31,11 @@
  * The XML is being written out along the way, which avoids requiring the entire
  * document in memory (like QDom does), and avoids using QTextStream at all
  * (which in Qt3 has major performance issues when converting to utf8).
+ *
+ * Output is collected in an internal buffer and handed to the device in
+ * large chunks. The buffer is flushed whenever the outermost element is
+ * closed, when device() or toString() is called, and on destruction, so the
+ * device is complete whenever no element is open.
  */
 class KOSTORE_EXPORT KoXmlWriter
 {
@@ -44,8 +49,17 @@ public:
     /// Destructor
     ~KoXmlWriter();
 
+    /**
+     * @return the device the XML is written to. Pending output is flushed
+     * first, so the device can be used directly afterwards.
+     */
     QIODevice *device() const;
 
+    /**
+     * Write out everything buffered so far to the device.
+     */
+    void flush();
+
     /**
      * Start the XML document.
      * This writes out the \<?xml?\> tag with utf8 encoding, and the DOCTYPE.
@@ -70,23 +84,17 @@ public:
 
     /**
      * Overloaded version of addAttribute( const char*, const char* ),
-     * which is a bit slower because it needs to convert @p value to utf8 first.
+     * @p value is converted to utf8 while being written out.
      */
-    inline void addAttribute(const char* attrName, const QString& value) {
-        addAttribute(attrName, value.toUtf8());
-    }
+    void addAttribute(const char* attrName, const QString& value);
     /**
      * Add an attribute whose value is an integer
      */
-    inline void addAttribute(const char* attrName, int value) {
-        addAttribute(attrName, QByteArray::number(value));
-    }
+    void addAttribute(const char* attrName, int value);
     /**
      * Add an attribute whose value is an unsigned integer
      */
-    inline void addAttribute(const char* attrName, uint value) {
-        addAttribute(attrName, QByteArray::number(value));
-    }
+    void addAttribute(const char* attrName, uint value);
     /**
      * Add an attribute whose value is an bool
      * It is written as "true" or "false" based on value
@@ -135,11 +143,9 @@ public:
     void endElement();
     /**
      * Overloaded version of addTextNode( const char* ),
-     * which is a bit slower because it needs to convert @p str to utf8 first.
+     * @p str is converted to utf8 while being written out.
      */
-    inline void addTextNode(const QString& str) {
-        addTextNode(str.toUtf8());
-    }
+    void addTextNode(const QString& str);
     /// Overloaded version of the one taking a const char* argument
     void addTextNode(const QByteArray& cstr);
     /**
@@ -247,17 +253,20 @@ public:
 private:
     struct Tag {
         Tag(const char* t = 0, bool ind = true)
-                : tagName(t), hasChildren(false), lastChildIsText(false),
+                : tagName(t), tagNameLength(t ? qstrlen(t) : 0),
+                hasChildren(false), lastChildIsText(false),
                 openingTagClosed(false), indentInside(ind) {}
         Tag(const Tag &original)
         {
             tagName = original.tagName;
+            tagNameLength = original.tagNameLength;
             hasChildren = original.hasChildren;
             lastChildIsText = original.lastChildIsText;
             openingTagClosed = original.openingTagClosed;
             indentInside = original.indentInside;
         }
         const char* tagName;
+        uint tagNameLength; ///< computed once, used for both the start and the end tag
         bool hasChildren : 1; ///< element or text children
         bool lastChildIsText : 1; ///< last child is a text node
         bool openingTagClosed : 1; ///< true once the '\>' in \<tag a="b"\> is written out
@@ -271,20 +280,24 @@ private:
     // Try to use it as much as possible, especially with constants.
     void writeString(const QString& str);
 
-    // TODO check return value!!!
-    inline void writeCString(const char* cstr) {
-        device()->write(cstr, qstrlen(cstr));
-    }
-    inline void writeChar(char c) {
-        device()->putChar(c);
-    }
+    // All output goes through these, into the buffer
+    void writeData(const char* data, int length);
+    void writeCString(const char* cstr);
+    void writeChar(char c);
     inline void closeStartElement(Tag& tag) {
         if (!tag.openingTagClosed) {
             tag.openingTagClosed = true;
             writeChar('>');
         }
     }
-    char* escapeForXML(const char* source, int length) const;
+    /// Escape @p source for XML right into the output buffer, stops at the first '\0'
+    void writeEscaped(const char* source, int length);
+    /// Convert @p str to utf8 and escape it for XML right into the output buffer
+    void writeEscaped(const QString& str);
+    void writeNumberAttribute(const char* attrName, double value, int precision, const char* suffix);
+    void writeNumberAttribute(const char* attrName, qlonglong value);
+    /// The device is complete whenever no element is open
+    void flushIfTopLevel();
     bool prepareForChild();
     void prepareForTextNode();
     void init();
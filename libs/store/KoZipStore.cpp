@@ -134,6 +134,11 @@ void KoZipStore::setCompressionEnabled(bool e)
     }
 }
 
+bool KoZipStore::isCompressionEnabled() const
+{
+    return m_pZip->compression() == KZip::DeflateCompression;
+}
+
 bool KoZipStore::doFinalize()
 {
     return m_pZip->close();
@@ -42,6 +42,7 @@ public:
     ~KoZipStore();
 
     virtual void setCompressionEnabled(bool e);
+    virtual bool isCompressionEnabled() const;
     virtual qint64 write(const char* _data, qint64 _len);
 
     virtual QStringList directoryList() const;
@@ -157,6 +157,112 @@ void TestKoXmlVector::writeAndRead()
     }
 }
 
+void TestKoXmlVector::writeAndReadWithPolicy_data()
+{
+    QTest::addColumn<bool>("compressed");
+    QTest::addColumn<int>("blockSize");
+    QTest::addColumn<int>("cachedBlocks");
+    QTest::addColumn<int>("itemCount");
+
+    QTest::newRow("uncompressed") << false << 4 << 1 << 50;
+    QTest::newRow("uncompressed, empty") << false << 4 << 1 << 0;
+    QTest::newRow("one item blocks") << true << 1 << 1 << 7;
+    QTest::newRow("partial last block") << true << 4 << 2 << 18;
+    QTest::newRow("more cache than blocks") << true << 5 << 10 << 20;
+}
+
+void TestKoXmlVector::writeAndReadWithPolicy()
+{
+    QFETCH(bool, compressed);
+    QFETCH(int, blockSize);
+    QFETCH(int, cachedBlocks);
+    QFETCH(int, itemCount);
+
+    KoXmlVectorPolicy policy;
+    policy.compressed = compressed;
+    policy.blockSize = blockSize;
+    policy.cachedBlocks = cachedBlocks;
+
+    KoXmlVector<TestStruct> vector;
+    vector.setPolicy(policy);
+
+    for (int i = 0; i < itemCount; ++i) {
+        TestStruct &item = vector.newItem();
+        item.attr = (i % 2) == 0;
+        item.type = (TestEnum)(i % 5);
+        item.number = i;
+        item.string = QString::number(i);
+    }
+    vector.squeeze();
+    QCOMPARE(vector.count(), itemCount);
+
+    const KoXmlVectorStatistics stats = vector.statistics();
+    if (compressed) {
+        QCOMPARE(stats.blockCount, (itemCount + blockSize - 1) / blockSize);
+        QCOMPARE(stats.uncompressedItems, 0);
+    } else {
+        QCOMPARE(stats.blockCount, 0);
+        QCOMPARE(stats.uncompressedItems, itemCount);
+    }
+
+    // forwards, then jumping around
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int n = 0; n < itemCount; ++n) {
+            const int i = pass == 0 ? n : (n * 7) % itemCount;
+            const TestStruct &readItem = vector[i];
+            QCOMPARE(readItem.attr, (i % 2) == 0);
+            QCOMPARE(readItem.type, (TestEnum)(i % 5));
+            QCOMPARE(readItem.number, (unsigned int)i);
+            QCOMPARE(readItem.string, QString::number(i));
+        }
+    }
+    QVERIFY(vector.statistics().cachedItems <= cachedBlocks * blockSize);
+}
+
+void TestKoXmlVector::blockCache()
+{
+    KoXmlVectorPolicy policy;
+    policy.compressed = true;
+    policy.blockSize = 4;
+    policy.cachedBlocks = 2;
 
+    KoXmlVector<TestStruct> vector;
+    vector.setPolicy(policy);
+    for (int i = 0; i < 20; ++i) {
+        vector.newItem().number = i;
+    }
+    vector.squeeze();
+
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(vector[i].number, (unsigned int)i); // first one misses
+    }
+    QCOMPARE(vector[4].number, 4u);  // miss
+    QCOMPARE(vector[0].number, 0u);  // hit, still cached
+    QCOMPARE(vector[8].number, 8u);  // miss, drops block of item 4
+    QCOMPARE(vector[4].number, 4u);  // miss again
+
+    const KoXmlVectorStatistics stats = vector.statistics();
+    QCOMPARE(stats.blockCount, 5);
+    QCOMPARE(stats.cacheMisses, 4);
+    QCOMPARE(stats.cacheHits, 4);
+    QCOMPARE(stats.hitRate(), 0.5);
+    QCOMPARE(stats.cachedItems, 8);
+    QVERIFY(stats.compressedBytes > 0);
+    QVERIFY(stats.memoryUsage() >= stats.compressedBytes + 8 * qint64(sizeof(TestStruct)));
+}
+
+void TestKoXmlVector::documentSizePolicy()
+{
+    QVERIFY(KoXmlVectorPolicy::forDocumentSize(-1).compressed);
+    QVERIFY(!KoXmlVectorPolicy::forDocumentSize(0).compressed);
+    QVERIFY(!KoXmlVectorPolicy::forDocumentSize(10 * 1024).compressed);
+
+    const KoXmlVectorPolicy medium = KoXmlVectorPolicy::forDocumentSize(2 * 1024 * 1024);
+    const KoXmlVectorPolicy huge = KoXmlVectorPolicy::forDocumentSize(200 * 1024 * 1024);
+    QVERIFY(medium.compressed);
+    QVERIFY(huge.compressed);
+    QVERIFY(huge.blockSize > medium.blockSize);
+    QVERIFY(medium.cachedBlocks > 1);
+}
 
 QTEST_GUILESS_MAIN(TestKoXmlVector)
@@ -31,6 +31,10 @@ private Q_SLOTS:
     void simpleConstructor();
     void writeAndRead_data();
     void writeAndRead();
+    void writeAndReadWithPolicy_data();
+    void writeAndReadWithPolicy();
+    void blockCache();
+    void documentSizePolicy();
 };
 
 #endif
@@ -226,6 +226,31 @@ void KoFindPrivate::parseSettingsAndFind()
         regExp = QRegExp(pattern);
     }
 
+    if (strategy == &replaceStrategy && findDirection == &findForward) {
+        // replace the matches up to the end of the document, or up to where we started, in one go
+        const bool lastPart = ((document == startDocument) && restarted) || selectedText;
+        int end = -1;
+        if (selectedText) {
+            end = provider->intResource(KoText::SelectedTextAnchor);
+        } else if (lastPart) {
+            end = endPosition.position();
+        }
+        if (replaceStrategy.replaceAll(document, lastKnownPosition.position(), end, flags)) {
+            if (lastPart) {
+                restarted = false;
+                strategy->displayFinalDialog();
+                lastKnownPosition = startPosition;
+            } else {
+                restarted = true;
+                findDirection->nextDocument(document, this);
+                lastKnownPosition = QTextCursor(document);
+                findDirection->positionCursor(lastKnownPosition);
+                parseSettingsAndFind();
+            }
+            return;
+        }
+    }
+
     QTextCursor cursor;
     if (!regExp.isEmpty() && regExp.isValid()) {
         cursor = document->find(regExp, lastKnownPosition, flags);
@@ -26,6 +26,7 @@
 #include <klocalizedstring.h>
 
 #include "FindDirection_p.h"
+#include "KoTextSearchIndex.h"
 
 KoReplaceStrategy::KoReplaceStrategy(QWidget * parent)
         : m_dialog(new KReplaceDialog(parent))
@@ -82,3 +83,13 @@ bool KoReplaceStrategy::foundMatch(QTextCursor &cursor, FindDirection *findDirec
 
     return true;
 }
+
+bool KoReplaceStrategy::replaceAll(QTextDocument *document, int from, int to, QTextDocument::FindFlags flags)
+{
+    if ((m_dialog->options() & (KReplaceDialog::PromptOnReplace | KFind::RegularExpression)) != 0) {
+        return false;
+    }
+
+    m_replaced += KoTextSearchIndex::index(document)->replaceAll(m_dialog->pattern(), m_dialog->replacement(), flags, from, to);
+    return true;
+}
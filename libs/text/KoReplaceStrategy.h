@@ -22,6 +22,8 @@
 
 #include "KoFindStrategyBase.h"
 
+#include <QTextDocument>
+
 class QWidget;
 class KReplaceDialog;
 
@@ -46,6 +48,16 @@ public:
     /// reimplmented
     virtual bool foundMatch(QTextCursor &cursor, FindDirection *findDirection);
 
+    /**
+     * Replace all matches in @p document between @p from and @p to at once.
+     * This is not done when each replacement has to be confirmed or the pattern
+     * is a regular expression; then foundMatch() has to be used for each match.
+     *
+     * @param to the last position a match may end at, or -1 for the end of the document
+     * @return true if the matches were replaced
+     */
+    bool replaceAll(QTextDocument *document, int from, int to, QTextDocument::FindFlags flags);
+
 private:
     KReplaceDialog *m_dialog;
     int m_replaced;
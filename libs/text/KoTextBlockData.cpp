@@ -37,6 +37,8 @@ public:
     {
         layoutedMarkupRanges[KoTextBlockData::Misspell] = false;
         layoutedMarkupRanges[KoTextBlockData::Grammar] = false;
+        markupsRevision[KoTextBlockData::Misspell] = -2;
+        markupsRevision[KoTextBlockData::Grammar] = -2;
     }
 
     ~Private() {
@@ -58,6 +60,7 @@ public:
     KoTextBlockPaintStrategyBase *paintStrategy;
     QMap<KoTextBlockData::MarkupType, QVector<MarkupRange> > markupRangesMap;
     QMap<KoTextBlockData::MarkupType, bool> layoutedMarkupRanges;
+    QMap<KoTextBlockData::MarkupType, int> markupsRevision;
 };
 
 KoTextBlockData::KoTextBlockData(QTextBlock &block)
@@ -149,6 +152,16 @@ bool KoTextBlockData::isMarkupsLayoutValid(MarkupType type) const
     return d->layoutedMarkupRanges[type];
 }
 
+void KoTextBlockData::setMarkupsRevision(MarkupType type, int revision)
+{
+    d->markupsRevision[type] = revision;
+}
+
+int KoTextBlockData::markupsRevision(MarkupType type) const
+{
+    return d->markupsRevision.value(type, -2);
+}
+
 QVector<KoTextBlockData::MarkupRange>::Iterator KoTextBlockData::markupsBegin(MarkupType type)
 {
     return d->markupRangesMap[type].begin();
@@ -104,6 +104,15 @@ public:
     void setMarkupsLayoutValidity(MarkupType type, bool valid);
     bool isMarkupsLayoutValid(MarkupType type) const;
 
+    /**
+     * Set the revision of the block, see QTextBlock::revision(), the markups of
+     * a type were last checked against. Use -1 to mark them as outdated; a block
+     * whose markups were never checked has -2.
+     */
+    void setMarkupsRevision(MarkupType type, int revision);
+    /// return the revision the markups were last checked against, -1 if they are outdated or -2 if never checked
+    int markupsRevision(MarkupType type) const;
+
     QVector<MarkupRange>::Iterator markupsBegin(MarkupType type);
     QVector<MarkupRange>::Iterator markupsEnd(MarkupType type);
 
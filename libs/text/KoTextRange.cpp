@@ -99,7 +99,13 @@ bool KoTextRange::positionOnlyMode() const
 void KoTextRange::setPositionOnlyMode(bool b)
 {
     Q_D(KoTextRange);
+    if (d->manager) {
+        d->manager->unindex(this);
+    }
     d->positionOnlyMode = b;
+    if (d->manager) {
+        d->manager->index(this);
+    }
 }
 
 bool KoTextRange::hasRange() const
@@ -123,16 +129,28 @@ int KoTextRange::rangeEnd() const
 void KoTextRange::setRangeStart(int position)
 {
     Q_D(KoTextRange);
+    if (d->manager) {
+        d->manager->unindex(this);
+    }
     d->positionOnlyMode = true;
     d->cursor.setPosition(position);
+    if (d->manager) {
+        d->manager->index(this);
+    }
 }
 
 void KoTextRange::setRangeEnd(int position)
 {
     Q_D(KoTextRange);
+    if (d->manager) {
+        d->manager->unindex(this);
+    }
     d->positionOnlyMode = false;
     d->cursor.setPosition(d->cursor.selectionStart());
     d->cursor.setPosition(position, QTextCursor::KeepAnchor);
+    if (d->manager) {
+        d->manager->index(this);
+    }
 }
 
 QString KoTextRange::text() const
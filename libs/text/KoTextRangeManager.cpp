@@ -24,6 +24,73 @@
 
 #include "TextDebug.h"
 
+#include <QTextDocument>
+
+#include <algorithm>
+
+namespace {
+    inline int startOf(const KoTextRange *range) { return range->rangeStart(); }
+    inline int endOf(const KoTextRange *range) { return range->rangeEnd(); }
+
+    /// @return the index of the first of the sorted @p ranges whose @p key is not less than @p position
+    int lowerBound(const QVector<KoTextRange *> &ranges, int position, int (*key)(const KoTextRange *))
+    {
+        int first = 0;
+        int last = ranges.count();
+        while (first < last) {
+            const int middle = (first + last) / 2;
+            if (key(ranges.at(middle)) < position) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        return first;
+    }
+
+    void insertSorted(QVector<KoTextRange *> &ranges, KoTextRange *range, int (*key)(const KoTextRange *))
+    {
+        const int position = key(range);
+        // text ranges are mostly added in the order of the document, so look at the end first
+        if (ranges.isEmpty() || key(ranges.last()) <= position) {
+            ranges.append(range);
+        } else {
+            ranges.insert(lowerBound(ranges, position + 1, key), range);
+        }
+    }
+
+    void removeSorted(QVector<KoTextRange *> &ranges, KoTextRange *range, int (*key)(const KoTextRange *))
+    {
+        const int position = key(range);
+        for (int i = lowerBound(ranges, position, key); i < ranges.count() && key(ranges.at(i)) == position; ++i) {
+            if (ranges.at(i) == range) {
+                ranges.remove(i);
+                return;
+            }
+        }
+        // not where it should be, so the order got lost somehow
+        warnText << "text range not found in the index at" << position;
+        ranges.removeOne(range);
+    }
+
+    /**
+     * Sort the @p ranges again whose @p key is between @p first and @p last. They are
+     * the only ones that can be out of order, and they are next to each other.
+     */
+    void resort(QVector<KoTextRange *> &ranges, int first, int last, int (*key)(const KoTextRange *))
+    {
+        const int begin = lowerBound(ranges, first, key);
+        int end = begin;
+        while (end < ranges.count() && key(ranges.at(end)) <= last) {
+            ++end;
+        }
+        if (end - begin > 1) {
+            std::stable_sort(ranges.begin() + begin, ranges.begin() + end,
+                             [key](const KoTextRange *a, const KoTextRange *b) { return key(a) < key(b); });
+        }
+    }
+}
+
 KoTextRangeManager::KoTextRangeManager(QObject *parent)
     : QObject(parent)
 {
@@ -62,6 +129,7 @@ void KoTextRangeManager::insert(KoTextRange *textRange)
         }
     }
     m_textRanges.insert(textRange);
+    index(textRange);
 }
 
 void KoTextRangeManager::remove(KoTextRange *textRange)
@@ -81,6 +149,7 @@ void KoTextRangeManager::remove(KoTextRange *textRange)
         }
     }
 
+    unindex(textRange);
     m_textRanges.remove(textRange);
     m_deletedTextRanges.insert(textRange);
     textRange->snapshot();
@@ -102,40 +171,115 @@ QList<KoTextRange *> KoTextRangeManager::textRanges() const
 }
 
 
+void KoTextRangeManager::index(KoTextRange *range)
+{
+    if (!m_textRanges.contains(range)) {
+        return;
+    }
+    QTextDocument *document = range->document();
+    if (document && !m_documentIndex.contains(document)) {
+        connect(document, SIGNAL(contentsChange(int,int,int)),
+                this, SLOT(documentContentsChange(int,int,int)), Qt::UniqueConnection);
+    }
+    DocumentIndex &documentIndex = m_documentIndex[document];
+    insertSorted(documentIndex.byStart, range, startOf);
+    insertSorted(documentIndex.byEnd, range, endOf);
+}
+
+void KoTextRangeManager::unindex(KoTextRange *range)
+{
+    if (!m_textRanges.contains(range)) {
+        return;
+    }
+    QHash<const QTextDocument *, DocumentIndex>::iterator it = m_documentIndex.find(range->document());
+    if (it == m_documentIndex.end()) {
+        return;
+    }
+    removeSorted(it->byStart, range, startOf);
+    removeSorted(it->byEnd, range, endOf);
+    if (it->byStart.isEmpty()) {
+        if (range->document()) {
+            disconnect(range->document(), SIGNAL(contentsChange(int,int,int)),
+                       this, SLOT(documentContentsChange(int,int,int)));
+        }
+        m_documentIndex.erase(it);
+    }
+}
+
+void KoTextRangeManager::documentContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (charsAdded == 0) {
+        return; // removing text moves all cursors the same way
+    }
+    QHash<const QTextDocument *, DocumentIndex>::iterator it = m_documentIndex.find(qobject_cast<QTextDocument *>(sender()));
+    if (it == m_documentIndex.end()) {
+        return;
+    }
+    resort(it->byStart, position, position + charsAdded, startOf);
+    resort(it->byEnd, position, position + charsAdded, endOf);
+}
+
 QHash<int, KoTextRange *> KoTextRangeManager::textRangesChangingWithin(const QTextDocument *doc, int first, int last, int matchFirst, int matchLast) const
 {
     QHash<int, KoTextRange *> ranges;
-    foreach (KoTextRange *range, m_textRanges) {
-        if (range->document() != doc) {
-            continue;
+    foreach (const RangePoint &point, orderedTextRangesChangingWithin(doc, first, last, matchFirst, matchLast)) {
+        ranges.insertMulti(point.position, point.range);
+    }
+    return ranges;
+}
+
+QVector<KoTextRangeManager::RangePoint> KoTextRangeManager::orderedTextRangesChangingWithin(const QTextDocument *doc, int first, int last, int matchFirst, int matchLast) const
+{
+    QVector<RangePoint> starts;
+    QVector<RangePoint> ends;
+    QHash<const QTextDocument *, DocumentIndex>::const_iterator it = m_documentIndex.constFind(doc);
+    if (it == m_documentIndex.constEnd()) {
+        return starts;
+    }
+
+    const QVector<KoTextRange *> &byStart = it->byStart;
+    for (int i = lowerBound(byStart, first, startOf); i < byStart.count(); ++i) {
+        KoTextRange *range = byStart.at(i);
+        const int start = range->rangeStart();
+        if (start > last) {
+            break;
         }
-        if (!range->hasRange()) {
-            if (range->rangeStart() >= first && range->rangeStart() <= last) {
-                ranges.insertMulti(range->rangeStart(), range);
-            }
+        if (!range->hasRange() || range->rangeEnd() >= matchFirst) {
+            const RangePoint point = { start, range };
+            starts.append(point);
+        }
+    }
+
+    const QVector<KoTextRange *> &byEnd = it->byEnd;
+    for (int i = lowerBound(byEnd, first, endOf); i < byEnd.count(); ++i) {
+        KoTextRange *range = byEnd.at(i);
+        const int end = range->rangeEnd();
+        if (end > last) {
+            break;
+        }
+        if (range->hasRange() && range->rangeStart() >= matchFirst
+                && (matchLast == -1 || range->rangeStart() <= matchLast)) {
+            const RangePoint point = { end, range };
+            ends.append(point);
+        }
+    }
+
+    if (ends.isEmpty()) {
+        return starts;
+    }
+
+    // merge both, a text range ending at a position comes before one starting there
+    QVector<RangePoint> points;
+    points.reserve(starts.count() + ends.count());
+    int s = 0;
+    int e = 0;
+    while (s < starts.count() || e < ends.count()) {
+        if (e < ends.count() && (s == starts.count() || ends.at(e).position <= starts.at(s).position)) {
+            points.append(ends.at(e++));
         } else {
-            if (range->rangeStart() >= first && range->rangeStart() <= last) {
-                if (matchLast == -1 || range->rangeEnd() <= matchLast) {
-                    if (range->rangeEnd() >= matchFirst) {
-                        ranges.insertMulti(range->rangeStart(), range);
-                    }
-                }
-            }
-            if (range->rangeEnd() >= first && range->rangeEnd() <= last) {
-                if (matchLast == -1 || range->rangeStart() <= matchLast) {
-                    if (range->rangeStart() >= matchFirst) {
-                        ranges.insertMulti(range->rangeEnd(), range);
-                    }
-                }
-            }
-            if (range->rangeStart() >= first && range->rangeStart() <= last) {
-                if (matchLast == -1 || range->rangeEnd() >= matchLast) {
-                    if (range->rangeEnd() >= matchFirst) {
-                        ranges.insert(range->rangeStart(), range);
-                    }
-                }
-            }
+            points.append(starts.at(s++));
         }
     }
-    return ranges;
+    return points;
 }
@@ -29,6 +29,7 @@
 #include <QMetaType>
 #include <QHash>
 #include <QSet>
+#include <QVector>
 
 
 /**
@@ -74,9 +75,45 @@ public:
      */
     QHash<int, KoTextRange *> textRangesChangingWithin(const QTextDocument *, int first, int last, int matchFirst, int matchLast) const;
 
+    /// A position at which a text range starts or ends
+    struct RangePoint {
+        int position;
+        KoTextRange *range;
+    };
+
+    /**
+     * Return the same text ranges as textRangesChangingWithin(), sorted by the position they
+     * start or end at. Text ranges that start and end within are returned twice.
+     */
+    QVector<RangePoint> orderedTextRangesChangingWithin(const QTextDocument *, int first, int last, int matchFirst, int matchLast) const;
+
+private Q_SLOTS:
+    /// sort the text ranges again that got out of order by the change
+    void documentContentsChange(int position, int charsRemoved, int charsAdded);
+
 private:
+    friend class KoTextRange;
+
+    /// add a text range to the index of its document
+    void index(KoTextRange *range);
+    /// remove a text range from the index of its document, before it is moved or removed
+    void unindex(KoTextRange *range);
+
+    /**
+     * The text ranges of one document, sorted by where they start and where they end.
+     * When a text range is moved itself it is indexed again. Editing the text keeps
+     * the order except where text is inserted right at a shared position: the start of
+     * a selection moves behind the inserted text, while a position only text range
+     * stays in front of it. Those are sorted again when the document reports the change.
+     */
+    struct DocumentIndex {
+        QVector<KoTextRange *> byStart;
+        QVector<KoTextRange *> byEnd;
+    };
+
     QSet<KoTextRange *> m_textRanges;
     QSet<KoTextRange *> m_deletedTextRanges; // kept around for undo purposes
+    QHash<const QTextDocument *, DocumentIndex> m_documentIndex;
 
     KoBookmarkManager m_bookmarkManager;
     KoAnnotationManager m_annotationManager;
@@ -0,0 +1,167 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "KoTextSearchIndex.h"
+
+#include <QStringMatcher>
+#include <QTextBlock>
+#include <QTextCursor>
+
+namespace {
+    struct Paragraph {
+        Paragraph() : valid(false) {}
+
+        QString text;
+        bool valid;
+    };
+}
+
+class Q_DECL_HIDDEN KoTextSearchIndex::Private
+{
+public:
+    explicit Private(QTextDocument *document)
+        : document(document)
+    {
+    }
+
+    /// @return the text of @p block, which is the paragraph with @p number
+    const QString &text(const QTextBlock &block, int number)
+    {
+        Paragraph &paragraph = paragraphs[number];
+        if (!paragraph.valid) {
+            // like QTextDocument::find(), which matches a space on a non breaking space
+            paragraph.text = block.text();
+            paragraph.text.replace(QChar::Nbsp, QLatin1Char(' '));
+            paragraph.valid = true;
+        }
+        return paragraph.text;
+    }
+
+    QTextDocument *document;
+    QVector<Paragraph> paragraphs; // by block number, empty when not in use yet
+};
+
+KoTextSearchIndex *KoTextSearchIndex::index(QTextDocument *document)
+{
+    KoTextSearchIndex *index = document->findChild<KoTextSearchIndex *>(QString(), Qt::FindDirectChildren);
+    if (!index)
+        index = new KoTextSearchIndex(document);
+    return index;
+}
+
+KoTextSearchIndex::KoTextSearchIndex(QTextDocument *document)
+    : QObject(document)
+    , d(new Private(document))
+{
+    connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+}
+
+KoTextSearchIndex::~KoTextSearchIndex()
+{
+    delete d;
+}
+
+QVector<int> KoTextSearchIndex::findAll(const QString &pattern, QTextDocument::FindFlags flags, int from, int to) const
+{
+    QVector<int> positions;
+    if (pattern.isEmpty())
+        return positions;
+
+    if (d->paragraphs.count() != d->document->blockCount())
+        d->paragraphs = QVector<Paragraph>(d->document->blockCount());
+
+    const QStringMatcher matcher(pattern,
+            (flags & QTextDocument::FindCaseSensitively) ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    const bool wholeWords = flags & QTextDocument::FindWholeWords;
+    if (to < 0)
+        to = d->document->characterCount();
+
+    QTextBlock block = d->document->findBlock(qMax(0, from));
+    int number = block.blockNumber();
+    for (; block.isValid() && block.position() <= to; block = block.next(), ++number) {
+        const QString &text = d->text(block, number);
+        int offset = qMax(0, from - block.position());
+        while (offset <= text.length()) {
+            const int start = matcher.indexIn(text, offset);
+            if (start < 0)
+                break;
+            const int end = start + pattern.length();
+            if (wholeWords && ((start > 0 && text.at(start - 1).isLetterOrNumber())
+                    || (end < text.length() && text.at(end).isLetterOrNumber()))) {
+                // QTextDocument::find() goes on after the character following it
+                offset = end + 1;
+                continue;
+            }
+            if (block.position() + end > to)
+                return positions;
+            positions.append(block.position() + start);
+            offset = end;
+        }
+    }
+    return positions;
+}
+
+int KoTextSearchIndex::count(const QString &pattern, QTextDocument::FindFlags flags, int from, int to) const
+{
+    return findAll(pattern, flags, from, to).count();
+}
+
+int KoTextSearchIndex::replaceAll(const QString &pattern, const QString &replacement, QTextDocument::FindFlags flags, int from, int to)
+{
+    const QVector<int> positions = findAll(pattern, flags, from, to);
+    if (positions.isEmpty())
+        return 0;
+
+    QTextCursor cursor(d->document);
+    cursor.beginEditBlock();
+    // from the last match back, so the positions of the other matches stay the same
+    for (int i = positions.count() - 1; i >= 0; --i) {
+        cursor.setPosition(positions[i]);
+        cursor.setPosition(positions[i] + pattern.length(), QTextCursor::KeepAnchor);
+        cursor.insertText(replacement);
+    }
+    cursor.endEditBlock();
+    return positions.count();
+}
+
+void KoTextSearchIndex::documentChanged(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (d->paragraphs.isEmpty())
+        return;
+
+    const QTextBlock first = d->document->findBlock(position);
+    QTextBlock last = d->document->findBlock(position + charsAdded);
+    if (!last.isValid())
+        last = d->document->lastBlock();
+    if (!first.isValid()) {
+        d->paragraphs.clear();
+        return;
+    }
+
+    // the changed paragraphs replace the ones that were there before the change
+    const int firstNumber = first.blockNumber();
+    const int lastNumber = last.blockNumber();
+    const int oldLastNumber = lastNumber - (d->document->blockCount() - d->paragraphs.count());
+    if (oldLastNumber < firstNumber || oldLastNumber >= d->paragraphs.count()) {
+        d->paragraphs.clear();
+        return;
+    }
+    d->paragraphs.remove(firstNumber, oldLastNumber - firstNumber + 1);
+    d->paragraphs.insert(firstNumber, lastNumber - firstNumber + 1, Paragraph());
+}
@@ -0,0 +1,79 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef KOTEXTSEARCHINDEX_H
+#define KOTEXTSEARCHINDEX_H
+
+#include "kotext_export.h"
+
+#include <QObject>
+#include <QTextDocument>
+#include <QVector>
+
+/**
+ * A search index of the text of a QTextDocument.
+ *
+ * The index keeps the text of each paragraph of the document, so searching
+ * does not have to put it together from the fragments of the document again
+ * for every search. It follows the edits of the document: only the text of
+ * changed paragraphs is taken again, the next time it is searched.
+ *
+ * The matches are the ones QTextDocument::find() gives when it is called
+ * again and again from the end of the previous match, so find next, the
+ * highlighting of all matches and replace all agree on what matches.
+ *
+ * An index is created for a document the first time it is asked for with
+ * index() and lives as long as the document.
+ */
+class KOTEXT_EXPORT KoTextSearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    /// @return the index of @p document, created if there is none yet
+    static KoTextSearchIndex *index(QTextDocument *document);
+
+    explicit KoTextSearchIndex(QTextDocument *document);
+    virtual ~KoTextSearchIndex();
+
+    /**
+     * Find all matches of @p pattern that lie within @p from and @p to.
+     * Of the flags, FindCaseSensitively and FindWholeWords are used.
+     * @param to the last position a match may end at, or -1 for the end of the document
+     * @return the start positions of the matches in increasing order
+     */
+    QVector<int> findAll(const QString &pattern, QTextDocument::FindFlags flags = 0, int from = 0, int to = -1) const;
+
+    /// @return the number of matches findAll() would return
+    int count(const QString &pattern, QTextDocument::FindFlags flags = 0, int from = 0, int to = -1) const;
+
+    /**
+     * Replace all matches findAll() would return by @p replacement.
+     * All replacements are done in one edit block, so they are undone at once
+     * and the document is laid out only once afterwards.
+     * @return the number of replacements
+     */
+    int replaceAll(const QString &pattern, const QString &replacement, QTextDocument::FindFlags flags = 0, int from = 0, int to = -1);
+
+private Q_SLOTS:
+    void documentChanged(int position, int charsRemoved, int charsAdded);
+
+private:
+    class Private;
+    Private * const d;
+};
+
+#endif // KOTEXTSEARCHINDEX_H
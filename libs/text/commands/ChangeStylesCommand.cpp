@@ -30,6 +30,7 @@
 #include <QTextDocument>
 #include <QTextCursor>
 #include <QTextBlock>
+#include <QBitArray>
 
 ChangeStylesCommand::ChangeStylesCommand(QTextDocument *qDoc
         , const QList<KoCharacterStyle *> &origCharacterStyles
@@ -43,10 +44,17 @@ ChangeStylesCommand::ChangeStylesCommand(QTextDocument *qDoc
     , m_document(qDoc)
     , m_first(true)
 {
-    // TODO optimization strategy;  store the formatid of the formats we checked into
-    // a qset for 'hits' and 'ignores' and avoid the copying of the format
-    // (fragment.charFormat() / block.blockFormat()) when the formatId is
-    // already checked previously
+    // The formats of the document serve as the index of where the styles are used:
+    // mark the formats that refer to a changed style, then only the blocks and fragments
+    // using one of those formats need to be looked at, without copying any format.
+    const QVector<QTextFormat> formats = m_document->allFormats();
+    QBitArray changedFormats(formats.count());
+    for (int i = 0; i < formats.count(); ++i) {
+        const int id = formats.at(i).intProperty(KoCharacterStyle::StyleId);
+        if (id > 0 && changedStyles.contains(id)) {
+            changedFormats.setBit(i);
+        }
+    }
 
     KoStyleManager *sm = KoTextDocument(m_document).styleManager();
     QTextCursor cursor(m_document);
@@ -54,6 +62,11 @@ ChangeStylesCommand::ChangeStylesCommand(QTextDocument *qDoc
     Memento *memento = new Memento;
 
     while (block.isValid()) {
+        if (!usesFormat(block, changedFormats)) {
+            block = block.next();
+            continue;
+        }
+
         memento->blockPosition = block.position();
         memento->blockParentCharFormat = block.charFormat();
         memento->blockParentFormat = KoTextDocument(m_document).frameBlockFormat();
@@ -194,6 +207,21 @@ void ChangeStylesCommand::undo()
 }
 
 
+bool ChangeStylesCommand::usesFormat(const QTextBlock &block, const QBitArray &formats)
+{
+    const int blockFormatIndex = block.blockFormatIndex();
+    if (blockFormatIndex >= 0 && blockFormatIndex < formats.count() && formats.testBit(blockFormatIndex)) {
+        return true;
+    }
+    for (QTextBlock::iterator iter = block.begin(); !iter.atEnd(); ++iter) {
+        const int charFormatIndex = iter.fragment().charFormatIndex();
+        if (charFormatIndex >= 0 && charFormatIndex < formats.count() && formats.testBit(charFormatIndex)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void ChangeStylesCommand::clearCommonProperties(QTextFormat *firstFormat, const QTextFormat &secondFormat)
 {
     Q_ASSERT(firstFormat);
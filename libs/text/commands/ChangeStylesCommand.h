@@ -30,6 +30,8 @@
 class KoCharacterStyle;
 class KoParagraphStyle;
 class QTextDocument;
+class QTextBlock;
+class QBitArray;
 
 class ChangeStylesCommand : public KUndo2Command
 {
@@ -53,6 +55,13 @@ private:
      */
     void clearCommonProperties(QTextFormat *firstFormat, const QTextFormat &secondFormat);
 
+    /**
+     * Helper function for finding the blocks to change.
+     *
+     * @return true if the block or one of its fragments has one of the set @a formats
+     */
+    static bool usesFormat(const QTextBlock &block, const QBitArray &formats);
+
 private:
     struct Memento // documents all change to the textdocument by a single style change
     {
@@ -98,6 +98,9 @@
 #include <QTextList>
 #include <QTextTable>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QPair>
 #include <QString>
 #include <QTextInlineObject>
 #include <QTextStream>
@@ -150,6 +153,21 @@ public:
 
     QStringList rdfIdList;
 
+    /// how deep loadBody() of this loader is nested, the outermost call is 1
+    int rootCallChecker;
+    int loadTimeSlice;
+    QElapsedTimer chunkTime;
+
+    /**
+     * The formats resulting from applying a character style to the format of the cursor.
+     * A document uses few combinations of the two, and sharing the result saves resolving
+     * the style and its parents for every span, and QTextDocument comparing the formats.
+     */
+    QHash<KoCharacterStyle *, QVector<QPair<QTextCharFormat, QTextCharFormat> > > resolvedCharFormats;
+
+    /// apply the @p characterStyle to the char format of the @p cursor
+    void applyCharacterStyle(KoCharacterStyle *characterStyle, QTextCursor &cursor);
+
     /// level is between 1 and 10
     void setCurrentList(KoList *currentList, int level);
     /// level is between 1 and 10
@@ -175,6 +193,8 @@ public:
           loadSpanLevel(0),
           loadSpanInitialPos(0)
         , m_previousList(10)
+        , rootCallChecker(0)
+        , loadTimeSlice(0)
     {
         progressTime.start();
     }
@@ -186,6 +206,30 @@ public:
     KoList *list(const QTextDocument *document, KoListStyle *listStyle, bool mergeSimilarStyledList);
 };
 
+void KoTextLoader::Private::applyCharacterStyle(KoCharacterStyle *characterStyle, QTextCursor &cursor)
+{
+    // the number of formats a style is remembered with, mostly one per paragraph style it is used in
+    const int maxResolvedFormats = 16;
+
+    const QTextCharFormat format = cursor.charFormat();
+    QVector<QPair<QTextCharFormat, QTextCharFormat> > &resolved = resolvedCharFormats[characterStyle];
+    for (int i = 0; i < resolved.count(); ++i) {
+        if (resolved.at(i).first == format) {
+            cursor.setCharFormat(resolved.at(i).second);
+            return;
+        }
+    }
+
+    QTextCharFormat cf = format;
+    characterStyle->applyStyle(cf);
+    characterStyle->ensureMinimalProperties(cf);
+    if (resolved.count() == maxResolvedFormats) {
+        resolved.remove(0);
+    }
+    resolved.append(qMakePair(format, cf));
+    cursor.setCharFormat(cf);
+}
+
 KoList *KoTextLoader::Private::list(const QTextDocument *document, KoListStyle *listStyle, bool mergeSimilarStyledList)
 {
     //TODO: Remove mergeSimilarStyledList parameter by finding a way to put the numbered-paragraphs of same level
@@ -289,12 +333,25 @@ KoTextLoader::~KoTextLoader()
     delete d;
 }
 
+void KoTextLoader::setLoadTimeSlice(int milliseconds)
+{
+    d->loadTimeSlice = qMax(0, milliseconds);
+}
+
+int KoTextLoader::loadTimeSlice() const
+{
+    return d->loadTimeSlice;
+}
+
 void KoTextLoader::loadBody(const KoXmlElement &bodyElem, QTextCursor &cursor, LoadBodyMode mode)
 {
     const QTextDocument *document = cursor.block().document();
 
-    static int rootCallChecker = 0;
-    if (rootCallChecker == 0) {
+    // the body of a note is loaded by a loader of its own while the loader of the
+    // document is still loading, so that one stays the root
+    const bool rootCall = d->rootCallChecker == 0
+        && cursor.currentFrame()->format().intProperty(KoText::SubFrameType) != KoText::NoteFrameType;
+    if (rootCall) {
         if (document->resource(KoTextDocument::FrameCharFormat, KoTextDocument::FrameCharFormatUrl).isValid()) {
             d->defaultBlockFormat = KoTextDocument(document).frameBlockFormat();
             d->defaultCharFormat = KoTextDocument(document).frameCharFormat();
@@ -308,7 +365,7 @@ void KoTextLoader::loadBody(const KoXmlElement &bodyElem, QTextCursor &cursor, L
             KoTextDocument(document).setFrameBlockFormat(cursor.blockFormat());
         }
     }
-    rootCallChecker++;
+    d->rootCallChecker++;
 
     cursor.beginEditBlock();
 
@@ -357,6 +414,12 @@ void KoTextLoader::loadBody(const KoXmlElement &bodyElem, QTextCursor &cursor, L
     else {
         startBody(KoXml::childNodesCount(bodyElem));
 
+        // only the outermost body is loaded in chunks, the elements in it are loaded in one go
+        const bool loadInChunks = mode == LoadMode && d->rootCallChecker == 1 && d->loadTimeSlice > 0;
+        if (loadInChunks) {
+            d->chunkTime.start();
+        }
+
         KoXmlElement tag;
         for (KoXmlNode _node = bodyElem.firstChild(); !_node.isNull(); _node = _node.nextSibling() ) {
             if (!(tag = _node.toElement()).isNull()) {
@@ -408,12 +471,20 @@ void KoTextLoader::loadBody(const KoXmlElement &bodyElem, QTextCursor &cursor, L
                     }
                 }
                 processBody();
+
+                if (loadInChunks && d->chunkTime.elapsed() >= d->loadTimeSlice) {
+                    // let the content loaded so far be layouted and painted
+                    cursor.endEditBlock();
+                    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+                    cursor.beginEditBlock();
+                    d->chunkTime.restart();
+                }
             }
         }
         endBody();
     }
 
-    rootCallChecker--;
+    d->rootCallChecker--;
 
     // Here we put old endings after text insertion.
     if (mode == PasteMode) {
@@ -432,7 +503,7 @@ void KoTextLoader::loadBody(const KoXmlElement &bodyElem, QTextCursor &cursor, L
         //debugText << range->id();
     //}
 
-    if (!rootCallChecker) {
+    if (rootCall) {
         // Allow to move end bounds of sections with inserting text
         KoTextDocument(cursor.block().document()).sectionModel()->allowMovingEndBound();
     }
@@ -951,7 +1022,7 @@ void KoTextLoader::loadSpan(const KoXmlElement &element, QTextCursor &cursor, bo
 
             KoCharacterStyle *characterStyle = d->textSharedData->characterStyle(styleName, d->stylesDotXml);
             if (characterStyle) {
-                characterStyle->applyStyle(&cursor);
+                d->applyCharacterStyle(characterStyle, cursor);
                 if (ts.firstChild().isNull()) {
                     // empty span so let's save the characterStyle for possible use at end of par
                     d->endCharStyle = characterStyle;
@@ -984,7 +1055,7 @@ void KoTextLoader::loadSpan(const KoXmlElement &element, QTextCursor &cursor, bo
             if (!styleName.isEmpty()) {
                 KoCharacterStyle *characterStyle = d->textSharedData->characterStyle(styleName, d->stylesDotXml);
                 if (characterStyle) {
-                    characterStyle->applyStyle(&cursor);
+                    d->applyCharacterStyle(characterStyle, cursor);
                 } else {
                     warnText << "character style " << styleName << " not found";
                 }
@@ -101,6 +101,19 @@ public:
     */
     void loadBody(const KoXmlElement &element, QTextCursor &cursor, LoadBodyMode pasteMode = LoadMode);
 
+    /**
+    * Set the time in milliseconds the loader inserts the content of the body before it
+    * lets the event loop run, so the start of a long document can already be layouted
+    * and shown while the rest is loaded. User input is not processed in between.
+    *
+    * This only applies to the LoadMode, and the document should not record undo then.
+    * The default of 0 loads the body in one go.
+    */
+    void setLoadTimeSlice(int milliseconds);
+
+    /// @return the time the loader inserts content before it lets the event loop run
+    int loadTimeSlice() const;
+
 Q_SIGNALS:
 
     /**
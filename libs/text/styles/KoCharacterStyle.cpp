@@ -148,6 +148,17 @@ public:
     KoCharacterStyle *parentStyle;
     KoCharacterStyle *defaultStyle;
     bool m_inUse;
+
+    /// the biggest version of the properties of this style and its parents
+    int chainVersion() const {
+        int version = stylesPrivate.version();
+        for (const KoCharacterStyle *style = parentStyle; style; style = style->d->parentStyle) {
+            version = qMax(version, style->d->stylesPrivate.version());
+        }
+        return version;
+    }
+
+    ResolvedFormatCache<QTextCharFormat> resolvedFormats;
 };
 
 KoCharacterStyle::Private::Private()
@@ -382,6 +393,7 @@ void KoCharacterStyle::setDefaultStyle(KoCharacterStyle *defaultStyle)
 void KoCharacterStyle::setParentStyle(KoCharacterStyle *parent)
 {
     d->parentStyle = parent;
+    d->stylesPrivate.markChanged();
 }
 
 KoCharacterStyle *KoCharacterStyle::parentStyle() const
@@ -429,6 +441,16 @@ void KoCharacterStyle::clearForeground()
 
 void KoCharacterStyle::applyStyle(QTextCharFormat &format, bool emitSignal) const
 {
+    // the result only depends on the format and the properties of this style and its parents
+    if (d->resolvedFormats.find(d->chainVersion(), format)) {
+        if (emitSignal) {
+            emit styleApplied(this);
+            d->m_inUse = true;
+        }
+        return;
+    }
+    const QTextCharFormat unresolvedFormat = format;
+
     if (d->parentStyle) {
         d->parentStyle->applyStyle(format);
     }
@@ -491,6 +513,8 @@ void KoCharacterStyle::applyStyle(QTextCharFormat &format, bool emitSignal) cons
         debugText << "clearProperty" << property;
         format.clearProperty(property);
     }
+    d->resolvedFormats.insert(unresolvedFormat, format);
+
     if (emitSignal) {
         emit styleApplied(this);
         d->m_inUse = true;
@@ -85,12 +85,28 @@ public:
         }
     }
 
+    /// the biggest version of the properties of this style, its parents and the default style
+    int chainVersion() const {
+        const Private *style = this;
+        int version = stylesPrivate.version();
+        while (style->parentStyle) {
+            style = style->parentStyle->d;
+            version = qMax(version, style->stylesPrivate.version());
+        }
+        // values not set by any parent come from the default style
+        if (style->defaultStyle) {
+            version = qMax(version, style->defaultStyle->d->stylesPrivate.version());
+        }
+        return version;
+    }
+
     QString name;
     KoParagraphStyle *parentStyle;
     KoParagraphStyle *defaultStyle;
     KoList *list;
     StylePrivate stylesPrivate;
     bool m_inUse;
+    ResolvedFormatCache<QTextBlockFormat> resolvedFormats;
 };
 
 KoParagraphStyle::KoParagraphStyle(QObject *parent)
@@ -137,12 +153,14 @@ KoCharacterStyle::Type KoParagraphStyle::styleType() const
 void KoParagraphStyle::setDefaultStyle(KoParagraphStyle *defaultStyle)
 {
     d->defaultStyle = defaultStyle;
+    d->stylesPrivate.markChanged();
     KoCharacterStyle::setDefaultStyle(defaultStyle);
 }
 
 void KoParagraphStyle::setParentStyle(KoParagraphStyle *parent)
 {
     d->parentStyle = parent;
+    d->stylesPrivate.markChanged();
     KoCharacterStyle::setParentStyle(parent);
 }
 
@@ -234,6 +252,14 @@ QColor KoParagraphStyle::propertyColor(int key) const
 
 void KoParagraphStyle::applyStyle(QTextBlockFormat &format) const
 {
+    // the result only depends on the format and the properties of this style and its parents
+    if (d->resolvedFormats.find(d->chainVersion(), format)) {
+        emit styleApplied(this);
+        d->m_inUse = true;
+        return;
+    }
+    const QTextBlockFormat unresolvedFormat = format;
+
     if (d->parentStyle) {
         d->parentStyle->applyStyle(format);
     }
@@ -255,6 +281,8 @@ void KoParagraphStyle::applyStyle(QTextBlockFormat &format) const
     if ((hasProperty(DefaultOutlineLevel)) && (!format.hasProperty(OutlineLevel))) {
        format.setProperty(OutlineLevel, defaultOutlineLevel());
     }
+    d->resolvedFormats.insert(unresolvedFormat, format);
+
     emit styleApplied(this);
     d->m_inUse = true;
 }
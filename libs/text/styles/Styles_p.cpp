@@ -22,13 +22,19 @@
 
 #include "TextDebug.h"
 
+#include <QAtomicInt>
+
+static QAtomicInt s_lastVersion;
+
 StylePrivate::StylePrivate()
 {
+    markChanged();
 }
 
 StylePrivate::StylePrivate(const StylePrivate &other)
         : m_properties(other.m_properties)
 {
+    markChanged();
 }
 
 StylePrivate::~StylePrivate()
@@ -38,16 +44,32 @@ StylePrivate::~StylePrivate()
 StylePrivate::StylePrivate(const QMap<int, QVariant> &other)
         : m_properties(other)
 {
+    markChanged();
+}
+
+StylePrivate &StylePrivate::operator=(const StylePrivate &other)
+{
+    m_properties = other.m_properties;
+    markChanged();
+    return *this;
+}
+
+void StylePrivate::markChanged()
+{
+    m_version = s_lastVersion.fetchAndAddRelaxed(1) + 1;
 }
 
 void StylePrivate::add(int key, const QVariant &value)
 {
     m_properties.insert(key, value);
+    markChanged();
 }
 
 void StylePrivate::remove(int key)
 {
-    m_properties.remove(key);
+    if (m_properties.remove(key)) {
+        markChanged();
+    }
 }
 
 const QVariant StylePrivate::value(int key) const
@@ -76,6 +98,7 @@ void StylePrivate::copyMissing(const QMap<int, QVariant> &other)
         if (!m_properties.contains(it.key()))
             m_properties.insert(it.key(), it.value());
     }
+    markChanged();
 }
 
 void StylePrivate::removeDuplicates(const StylePrivate &other)
@@ -85,6 +108,7 @@ void StylePrivate::removeDuplicates(const StylePrivate &other)
             m_properties.remove(key);
         }
     }
+    markChanged();
 }
 
 void StylePrivate::removeDuplicates(const QMap<int, QVariant> &other)
@@ -93,6 +117,7 @@ void StylePrivate::removeDuplicates(const QMap<int, QVariant> &other)
         if (m_properties.value(key) == other.value(key))
             m_properties.remove(key);
     }
+    markChanged();
 }
 
 QList<int> StylePrivate::keys() const
@@ -23,6 +23,8 @@
 
 #include <QVariant>
 #include <QMap>
+#include <QPair>
+#include <QVector>
 
 class StylePrivate
 {
@@ -32,6 +34,8 @@ public:
     StylePrivate(const QMap<int, QVariant> &other);
     ~StylePrivate();
 
+    StylePrivate &operator=(const StylePrivate &other);
+
     void add(int key, const QVariant &value);
     void remove(int key);
     const QVariant value(int key) const;
@@ -42,6 +46,7 @@ public:
     void removeDuplicates(const QMap<int, QVariant> &other);
     void clearAll() {
         m_properties.clear();
+        markChanged();
     }
     QList<int> keys() const;
     bool operator==(const StylePrivate &other) const;
@@ -51,8 +56,67 @@ public:
         return m_properties;
     }
 
+    /**
+     * @return the version of the properties. Each change of the properties of any style
+     * gives a version bigger than all versions before, so the biggest version of a style
+     * and its parents tells whether any of them changed.
+     */
+    int version() const {
+        return m_version;
+    }
+
+    /// give a new version, also used when the parent of a style changes
+    void markChanged();
+
 private:
     QMap<int, QVariant> m_properties;
+    int m_version;
+};
+
+/**
+ * The formats resulting from applying a style to other formats, kept as long as the
+ * style and its parents do not change.
+ */
+template<typename Format>
+class ResolvedFormatCache
+{
+public:
+    ResolvedFormatCache() : m_version(0) {}
+
+    /**
+     * Look up what applying the style at @p version to @p format gave before.
+     * @return true if it was found, then @p format is set to the result
+     */
+    bool find(int version, Format &format)
+    {
+        if (version != m_version) {
+            m_formats.clear();
+            m_version = version;
+            return false;
+        }
+        for (int i = 0; i < m_formats.count(); ++i) {
+            if (m_formats.at(i).first == format) {
+                format = m_formats.at(i).second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// remember that applying the style to @p format gave @p result
+    void insert(const Format &format, const Format &result)
+    {
+        // a style is mostly applied to as many formats as there are parent styles it is used with
+        if (m_formats.count() == MaxFormats) {
+            m_formats.remove(0);
+        }
+        m_formats.append(qMakePair(format, result));
+    }
+
+private:
+    enum { MaxFormats = 16 };
+    int m_version;
+    QVector<QPair<Format, Format> > m_formats;
 };
 
 #endif
@@ -397,4 +397,68 @@ void TestStyles::testUnapplyStyle()
     QCOMPARE(cf.hasProperty(QTextFormat::FontItalic), false);
 }
 
+void TestStyles::testReapplyChangedStyle()
+{
+    KoParagraphStyle base;
+    base.setLeftMargin(QTextLength(QTextLength::FixedLength, 10.0));
+    KoParagraphStyle heading;
+    heading.setParentStyle(&base);
+    heading.setTopMargin(QTextLength(QTextLength::FixedLength, 5.0));
+    KoCharacterStyle emphasis;
+    emphasis.setFontItalic(true);
+    KoCharacterStyle strong;
+    strong.setParentStyle(&emphasis);
+    strong.setFontWeight(QFont::Bold);
+
+    // applying the same styles to the same formats again gives the same results
+    QTextBlockFormat bf;
+    heading.applyStyle(bf);
+    QCOMPARE(bf.leftMargin(), 10.0);
+    QCOMPARE(bf.topMargin(), 5.0);
+    QTextBlockFormat bf2;
+    heading.applyStyle(bf2);
+    QCOMPARE(bf2, bf);
+
+    QTextCharFormat cf;
+    strong.applyStyle(cf);
+    QCOMPARE(cf.fontItalic(), true);
+    QCOMPARE(cf.fontWeight(), int(QFont::Bold));
+
+    // a change of a parent is seen by its children
+    base.setLeftMargin(QTextLength(QTextLength::FixedLength, 20.0));
+    bf2 = QTextBlockFormat();
+    heading.applyStyle(bf2);
+    QCOMPARE(bf2.leftMargin(), 20.0);
+    QCOMPARE(bf2.topMargin(), 5.0);
+
+    emphasis.setFontItalic(false);
+    QTextCharFormat cf2;
+    strong.applyStyle(cf2);
+    QCOMPARE(cf2.fontItalic(), false);
+    QCOMPARE(cf2.fontWeight(), int(QFont::Bold));
+
+    // and so is a change of the parent itself
+    heading.setParentStyle(0);
+    bf2 = QTextBlockFormat();
+    heading.applyStyle(bf2);
+    QCOMPARE(bf2.hasProperty(QTextFormat::BlockLeftMargin), false);
+
+    strong.setParentStyle(0);
+    cf2 = QTextCharFormat();
+    strong.applyStyle(cf2);
+    QCOMPARE(cf2.hasProperty(QTextFormat::FontItalic), false);
+
+    // the format the style is applied to is taken into account
+    KoCharacterStyle bigger;
+    bigger.setPercentageFontSize(200);
+    QTextCharFormat small;
+    small.setFontPointSize(5.0);
+    bigger.applyStyle(small);
+    QCOMPARE(small.fontPointSize(), 10.0);
+    QTextCharFormat large;
+    large.setFontPointSize(20.0);
+    bigger.applyStyle(large);
+    QCOMPARE(large.fontPointSize(), 40.0);
+}
+
 QTEST_MAIN(TestStyles)
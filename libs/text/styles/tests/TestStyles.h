@@ -34,6 +34,7 @@ private Q_SLOTS: // tests
     void testApplyParagraphStyleWithParent();
     void testCopyParagraphStyle();
     void testUnapplyStyle();
+    void testReapplyChangedStyle();
 };
 
 #endif
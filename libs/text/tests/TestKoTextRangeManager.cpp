@@ -0,0 +1,271 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "TestKoTextRangeManager.h"
+
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+
+#include <KoTextRangeManager.h>
+#include <KoBookmark.h>
+
+#include <algorithm>
+
+typedef QPair<int, KoTextRange *> Point;
+
+// what textRangesChangingWithin is documented to return, found by looking at all ranges
+static QList<Point> expectedPoints(const QList<KoBookmark *> &ranges, int first, int last, int matchFirst, int matchLast)
+{
+    QList<Point> points;
+    foreach (KoBookmark *range, ranges) {
+        const int start = range->rangeStart();
+        const int end = range->rangeEnd();
+        if (start >= first && start <= last && (!range->hasRange() || end >= matchFirst)) {
+            points.append(Point(start, range));
+        }
+        if (range->hasRange() && end >= first && end <= last
+                && start >= matchFirst && (matchLast == -1 || start <= matchLast)) {
+            points.append(Point(end, range));
+        }
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+}
+
+static void compare(const KoTextRangeManager &manager, const QTextDocument &doc, const QList<KoBookmark *> &ranges)
+{
+    const int length = doc.characterCount();
+    for (int first = 0; first < length; first += 7) {
+        for (int last = first; last < length; last += 11) {
+            const int matches[][2] = { {first, last}, {0, -1}, {first, -1}, {0, last} };
+            for (int m = 0; m < 4; ++m) {
+                const int matchFirst = matches[m][0];
+                const int matchLast = matches[m][1];
+                const QList<Point> expected = expectedPoints(ranges, first, last, matchFirst, matchLast);
+
+                const QVector<KoTextRangeManager::RangePoint> ordered = manager.orderedTextRangesChangingWithin(&doc, first, last, matchFirst, matchLast);
+                QList<Point> points;
+                for (int i = 0; i < ordered.count(); ++i) {
+                    if (i > 0) {
+                        QVERIFY(ordered.at(i - 1).position <= ordered.at(i).position);
+                    }
+                    points.append(Point(ordered.at(i).position, ordered.at(i).range));
+                }
+                std::sort(points.begin(), points.end());
+                QCOMPARE(points, expected);
+
+                const QHash<int, KoTextRange *> hash = manager.textRangesChangingWithin(&doc, first, last, matchFirst, matchLast);
+                points.clear();
+                for (QHash<int, KoTextRange *>::const_iterator it = hash.constBegin(); it != hash.constEnd(); ++it) {
+                    points.append(Point(it.key(), it.value()));
+                }
+                std::sort(points.begin(), points.end());
+                QCOMPARE(points, expected);
+            }
+        }
+    }
+}
+
+static QList<KoBookmark *> createRanges(KoTextRangeManager &manager, QTextDocument &doc, int count)
+{
+    QList<KoBookmark *> ranges;
+    const int length = doc.characterCount() - 1;
+    for (int i = 0; i < count; ++i) {
+        QTextCursor cursor(&doc);
+        // spread over the document and not in order, some of them being positions only
+        const int start = (i * 37) % length;
+        cursor.setPosition(start);
+        if (i % 3) {
+            cursor.setPosition(qMin(length, start + (i * 13) % 40), QTextCursor::KeepAnchor);
+        }
+        KoBookmark *range = new KoBookmark(cursor);
+        range->setName(QString("bookmark%1").arg(i));
+        manager.insert(range);
+        ranges.append(range);
+    }
+    return ranges;
+}
+
+void TestKoTextRangeManager::testOrder()
+{
+    QTextDocument doc;
+    doc.setPlainText(QString(200, 'x'));
+    KoTextRangeManager manager;
+    QList<KoBookmark *> ranges = createRanges(manager, doc, 60);
+
+    compare(manager, doc, ranges);
+
+    // ranges ending at a position come before ranges starting there
+    foreach (KoBookmark *range, ranges) {
+        if (!range->hasRange()) {
+            continue;
+        }
+        const int end = range->rangeEnd();
+        const QVector<KoTextRangeManager::RangePoint> points = manager.orderedTextRangesChangingWithin(&doc, end, end, 0, -1);
+        bool startSeen = false;
+        foreach (const KoTextRangeManager::RangePoint &point, points) {
+            const bool isEnd = point.range->hasRange() && point.range->rangeEnd() == end;
+            QVERIFY(!(isEnd && startSeen));
+            startSeen = startSeen || !isEnd;
+        }
+    }
+
+    qDeleteAll(ranges);
+}
+
+void TestKoTextRangeManager::testEditing()
+{
+    QTextDocument doc;
+    doc.setPlainText(QString(200, 'x'));
+    KoTextRangeManager manager;
+    QList<KoBookmark *> ranges = createRanges(manager, doc, 60);
+
+    QTextCursor cursor(&doc);
+    cursor.setPosition(50);
+    cursor.insertText(QString(15, 'y'));
+    compare(manager, doc, ranges);
+
+    cursor.setPosition(30);
+    cursor.setPosition(80, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    compare(manager, doc, ranges);
+
+    cursor.setPosition(0);
+    cursor.insertText("abc");
+    compare(manager, doc, ranges);
+
+    qDeleteAll(ranges);
+}
+
+void TestKoTextRangeManager::testInsertAtSharedStart()
+{
+    QTextDocument doc;
+    doc.setPlainText(QString(200, 'x'));
+    // the document reports its changes to the manager when it has a layout, as the ones of the text shapes
+    doc.documentLayout();
+    KoTextRangeManager manager;
+    QList<KoBookmark *> ranges;
+
+    // selections and positions starting at the same places, in both orders
+    for (int i = 0; i < 4; ++i) {
+        const int start = 20 + 40 * i;
+        QTextCursor cursor(&doc);
+        cursor.setPosition(start);
+        KoBookmark *position = new KoBookmark(cursor);
+        position->setName(QString("position%1").arg(i));
+        cursor.setPosition(start + 10, QTextCursor::KeepAnchor);
+        KoBookmark *selection = new KoBookmark(cursor);
+        selection->setName(QString("selection%1").arg(i));
+        if (i % 2) {
+            manager.insert(position);
+            manager.insert(selection);
+        } else {
+            manager.insert(selection);
+            manager.insert(position);
+        }
+        ranges << position << selection;
+    }
+    compare(manager, doc, ranges);
+
+    // inserting at the shared start moves the start of the selection but not the position
+    QTextCursor cursor(&doc);
+    for (int i = 3; i >= 0; --i) {
+        const int start = 20 + 40 * i;
+        cursor.setPosition(start);
+        cursor.insertText(QString(5, 'y'));
+        QCOMPARE(ranges.at(2 * i)->rangeStart(), start);
+        QCOMPARE(ranges.at(2 * i + 1)->rangeStart(), start + 5);
+    }
+    compare(manager, doc, ranges);
+
+    // and again within one edit block, at two shared starts
+    ranges.at(0)->setRangeStart(ranges.at(1)->rangeStart());
+    ranges.at(2)->setRangeStart(ranges.at(3)->rangeStart());
+    compare(manager, doc, ranges);
+    cursor.beginEditBlock();
+    cursor.setPosition(ranges.at(2)->rangeStart());
+    cursor.insertText("z");
+    cursor.setPosition(ranges.at(0)->rangeStart());
+    cursor.insertText("z");
+    cursor.endEditBlock();
+    QCOMPARE(ranges.at(1)->rangeStart(), ranges.at(0)->rangeStart() + 1);
+    QCOMPARE(ranges.at(3)->rangeStart(), ranges.at(2)->rangeStart() + 1);
+    compare(manager, doc, ranges);
+
+    qDeleteAll(ranges);
+}
+
+void TestKoTextRangeManager::testMovingRanges()
+{
+    QTextDocument doc;
+    doc.setPlainText(QString(200, 'x'));
+    KoTextRangeManager manager;
+    QList<KoBookmark *> ranges = createRanges(manager, doc, 60);
+
+    for (int i = 0; i < ranges.count(); i += 4) {
+        KoBookmark *range = ranges.at(i);
+        range->setRangeEnd(qMin(doc.characterCount() - 1, range->rangeStart() + 25));
+    }
+    compare(manager, doc, ranges);
+
+    for (int i = 1; i < ranges.count(); i += 5) {
+        ranges.at(i)->setRangeStart(190 - i);
+    }
+    compare(manager, doc, ranges);
+
+    for (int i = 2; i < ranges.count(); i += 6) {
+        ranges.at(i)->setPositionOnlyMode(true);
+    }
+    compare(manager, doc, ranges);
+
+    qDeleteAll(ranges);
+}
+
+void TestKoTextRangeManager::testRemove()
+{
+    QTextDocument doc;
+    doc.setPlainText(QString(200, 'x'));
+    KoTextRangeManager manager;
+    QList<KoBookmark *> ranges = createRanges(manager, doc, 60);
+
+    QList<KoBookmark *> removed;
+    for (int i = ranges.count() - 1; i >= 0; i -= 3) {
+        manager.remove(ranges.at(i));
+        removed.append(ranges.takeAt(i));
+    }
+    compare(manager, doc, ranges);
+
+    // ranges inserted again are found again
+    KoBookmark *range = removed.takeFirst();
+    manager.insert(range);
+    ranges.append(range);
+    compare(manager, doc, ranges);
+
+    // a range of another document is not returned
+    QTextDocument otherDoc;
+    otherDoc.setPlainText(QString(200, 'x'));
+    QList<KoBookmark *> otherRanges = createRanges(manager, otherDoc, 10);
+    compare(manager, doc, ranges);
+    compare(manager, otherDoc, otherRanges);
+
+    qDeleteAll(otherRanges);
+    qDeleteAll(removed);
+    qDeleteAll(ranges);
+}
+
+QTEST_MAIN(TestKoTextRangeManager)
@@ -0,0 +1,138 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "TestKoTextSearchIndex.h"
+
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+
+#include <KoTextSearchIndex.h>
+
+// the matches found by calling QTextDocument::find() again and again
+static QVector<int> expectedMatches(const QTextDocument &doc, const QString &pattern, QTextDocument::FindFlags flags)
+{
+    QVector<int> positions;
+    QTextCursor cursor = doc.find(pattern, 0, flags);
+    while (!cursor.isNull()) {
+        positions.append(cursor.selectionStart());
+        cursor = doc.find(pattern, cursor, flags);
+    }
+    return positions;
+}
+
+static void compare(QTextDocument &doc)
+{
+    KoTextSearchIndex *index = KoTextSearchIndex::index(&doc);
+    const char *patterns[] = { "a", "the", "The", "aa", "be", "to be", "x" };
+    const QTextDocument::FindFlags flags[] = {
+        0,
+        QTextDocument::FindCaseSensitively,
+        QTextDocument::FindWholeWords,
+        QTextDocument::FindCaseSensitively | QTextDocument::FindWholeWords
+    };
+    for (uint p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+        for (uint f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f) {
+            const QString pattern = QString::fromLatin1(patterns[p]);
+            const QVector<int> expected = expectedMatches(doc, pattern, flags[f]);
+            QCOMPARE(index->findAll(pattern, flags[f]), expected);
+            QCOMPARE(index->count(pattern, flags[f]), expected.count());
+        }
+    }
+}
+
+void TestKoTextSearchIndex::testFindAll()
+{
+    QTextDocument doc;
+    doc.setPlainText("To be, or not to be, that is the question:\n"
+                     "Whether 'tis nobler in the mind to suffer\n"
+                     "\n"
+                     "The slings and arrows of outrageous fortune,\n"
+                     "aaaa aa a theThe");
+    compare(doc);
+
+    QVERIFY(KoTextSearchIndex::index(&doc)->findAll(QString()).isEmpty());
+    QCOMPARE(KoTextSearchIndex::index(&doc), KoTextSearchIndex::index(&doc));
+}
+
+void TestKoTextSearchIndex::testEditing()
+{
+    QTextDocument doc;
+    doc.setPlainText("to be\nor not to be\nthe end");
+    compare(doc);
+
+    QTextCursor cursor(&doc);
+    cursor.setPosition(3);
+    cursor.insertText("the aa");
+    compare(doc);
+
+    // split and join paragraphs
+    cursor.insertBlock();
+    cursor.insertText("be\nbe the\n");
+    compare(doc);
+    cursor.setPosition(2);
+    cursor.setPosition(20, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    compare(doc);
+
+    // several changes in one edit block
+    cursor.beginEditBlock();
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("\nto be");
+    cursor.setPosition(0);
+    cursor.insertText("The\n");
+    cursor.endEditBlock();
+    compare(doc);
+
+    doc.undo();
+    compare(doc);
+    doc.setPlainText("a whole new text to be searched");
+    compare(doc);
+}
+
+void TestKoTextSearchIndex::testRange()
+{
+    QTextDocument doc;
+    doc.setPlainText("be be\nbe be");
+    KoTextSearchIndex *index = KoTextSearchIndex::index(&doc);
+
+    QCOMPARE(index->findAll("be", 0, 1), QVector<int>() << 3 << 6 << 9);
+    // a match has to end before the end of the range
+    QCOMPARE(index->findAll("be", 0, 0, 8), QVector<int>() << 0 << 3 << 6);
+    QCOMPARE(index->findAll("be", 0, 3, 8), QVector<int>() << 3 << 6);
+    QCOMPARE(index->count("be", 0, 0, 7), 2);
+}
+
+void TestKoTextSearchIndex::testReplaceAll()
+{
+    QTextDocument doc;
+    doc.setPlainText("to be, or not to Be\nthat is the question to be");
+    KoTextSearchIndex *index = KoTextSearchIndex::index(&doc);
+
+    QCOMPARE(index->replaceAll("be", "exist", QTextDocument::FindWholeWords, 4), 2);
+    QCOMPARE(doc.toPlainText(), QString("to be, or not to exist\nthat is the question to exist"));
+    QCOMPARE(index->count("exist"), 2);
+
+    // all replacements are undone at once
+    doc.undo();
+    QCOMPARE(doc.toPlainText(), QString("to be, or not to Be\nthat is the question to be"));
+    compare(doc);
+
+    QCOMPARE(index->replaceAll("nothing", "something"), 0);
+}
+
+QTEST_MAIN(TestKoTextSearchIndex)
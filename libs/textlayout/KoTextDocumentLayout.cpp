@@ -53,6 +53,7 @@
 #include <QTextBlock>
 #include <QTextTable>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QList>
 
 extern int qt_defaultDpiY();
@@ -92,8 +93,64 @@ public:
        , restartLayout(false)
        , wordprocessingMode(false)
        , showInlineObjectVisualization(false)
+       , pendingAreaNumber(INT_MAX)
+       , layoutTimeSlice(0)
+       , slicedLayout(false)
     {
     }
+
+    /// @return the index of the first root-area from @p from on that needs to be layouted
+    int firstDirtyRootArea(int from) const
+    {
+        for (int i = from; i < rootAreaList.count(); ++i) {
+            if (rootAreaList.at(i)->isDirty())
+                return i;
+        }
+        return rootAreaList.count();
+    }
+
+    /// forgets the root-areas from @p index on
+    void removeRootAreasFrom(int index)
+    {
+        while (rootAreaList.count() > index) {
+            rootAreaIndex.remove(rootAreaList.takeLast());
+            checkpoints.removeLast();
+        }
+    }
+
+    /// @return the index of @p rootArea in rootAreaList, or -1
+    int indexOfRootArea(KoTextLayoutRootArea *rootArea) const
+    {
+        return rootAreaIndex.value(rootArea, -1);
+    }
+
+    /**
+     * @return the index of the first root-area whose bounding-rect does not end above @p y.
+     * The root-areas are placed one below the other, so their bounding-rects are sorted.
+     */
+    int firstRootAreaEndingBelow(qreal y) const
+    {
+        int first = 0;
+        int last = rootAreaList.count();
+        while (first < last) {
+            const int middle = (first + last) / 2;
+            if (rootAreaList.at(middle)->boundingRect().bottom() < y) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        return first;
+    }
+
+    /// The state the layout was in when it started a root-area
+    struct Checkpoint {
+        qreal y;
+        int footNoteAutoCount;
+        bool footNoteCursor; // foot notes continued from the previous root-area
+        KoInlineNote *continuedNote;
+    };
+
     KoStyleManager *styleManager;
 
     KoChangeTracker *changeTracker;
@@ -138,6 +195,12 @@ public:
     bool restartLayout;
     bool wordprocessingMode;
     bool showInlineObjectVisualization;
+
+    QList<Checkpoint> checkpoints; // one for each of the rootAreaList
+    QHash<KoTextLayoutRootArea *, int> rootAreaIndex; // the index of each of the rootAreaList
+    int pendingAreaNumber; // the root-area an interrupted layout run did not get to
+    int layoutTimeSlice;
+    bool slicedLayout; // the current layout run may stop after layoutTimeSlice
 };
 
 
@@ -324,7 +387,7 @@ void KoTextDocumentLayout::documentChanged(int position, int charsRemoved, int c
         } else {
             fromArea = d->rootAreaList.at(0);
         }
-        int startIndex = fromArea ? qMax(0, d->rootAreaList.indexOf(fromArea)) : 0;
+        int startIndex = fromArea ? qMax(0, d->indexOfRootArea(fromArea)) : 0;
         int endIndex = startIndex;
         if (charsRemoved != 0 || charsAdded != 0) {
             // If any characters got removed or added make sure to also catch other root-areas that may be
@@ -335,7 +398,7 @@ void KoTextDocumentLayout::documentChanged(int position, int charsRemoved, int c
             KoTextLayoutRootArea *toArea = fromArea ? rootAreaForPosition(position + qMax(charsRemoved, charsAdded) + 1) : 0;
             if (toArea) {
                 if (toArea != fromArea) {
-                    endIndex = qMax(startIndex, d->rootAreaList.indexOf(toArea));
+                    endIndex = qMax(startIndex, d->indexOfRootArea(toArea));
                 } else {
                     endIndex = startIndex;
                 }
@@ -371,16 +434,21 @@ KoTextLayoutRootArea *KoTextDocumentLayout::rootAreaForPosition(int position) co
     if (!line.isValid())
         return 0;
 
-    foreach (KoTextLayoutRootArea *rootArea, d->rootAreaList) {
+    QPointF pos = line.position();
+    qreal x = pos.x();
+    qreal y = pos.y();
+
+    // only the root-areas that reach from above the line to below it are checked
+    for (int i = d->firstRootAreaEndingBelow(y); i < d->rootAreaList.count(); ++i) {
+        KoTextLayoutRootArea *rootArea = d->rootAreaList.at(i);
         QRectF rect = rootArea->boundingRect(); // should already be normalized()
+        //0.125 needed since Qt Scribe works with fixed point
+        if (y + line.height() + 0.125 < rect.y())
+            break;
         if (rect.width() <= 0.0 && rect.height() <= 0.0) // ignore the rootArea if it has a size of QSizeF(0,0)
             continue;
-        QPointF pos = line.position();
-        qreal x = pos.x();
-        qreal y = pos.y();
 
-        //0.125 needed since Qt Scribe works with fixed point
-        if (x + 0.125 >= rect.x() && x<= rect.right() && y + line.height() + 0.125 >= rect.y() && y <= rect.bottom()) {
+        if (x + 0.125 >= rect.x() && x<= rect.right()) {
             return rootArea;
         }
     }
@@ -389,7 +457,10 @@ KoTextLayoutRootArea *KoTextDocumentLayout::rootAreaForPosition(int position) co
 
 KoTextLayoutRootArea *KoTextDocumentLayout::rootAreaForPoint(const QPointF &point) const
 {
-    foreach(KoTextLayoutRootArea *rootArea, d->rootAreaList) {
+    for (int i = d->firstRootAreaEndingBelow(point.y()); i < d->rootAreaList.count(); ++i) {
+        KoTextLayoutRootArea *rootArea = d->rootAreaList.at(i);
+        if (rootArea->boundingRect().top() > point.y())
+            break;
         if (!rootArea->isDirty()) {
             if (rootArea->boundingRect().contains(point)) {
                 return rootArea;
@@ -568,9 +639,11 @@ void KoTextDocumentLayout::positionAnchorTextRanges(int pos, int length, const Q
     if (!textRangeManager()) {
         return;
     }
-    QHash<int, KoTextRange *> ranges = textRangeManager()->textRangesChangingWithin(effectiveDocument, pos, pos+length, pos, pos+length);
+    // in the order of the document, so anchors are collected in the order they are met
+    const QVector<KoTextRangeManager::RangePoint> points = textRangeManager()->orderedTextRangesChangingWithin(effectiveDocument, pos, pos+length, pos, pos+length);
 
-    foreach(KoTextRange *range, ranges) {
+    foreach(const KoTextRangeManager::RangePoint &point, points) {
+        KoTextRange *range = point.range;
         KoAnchorTextRange *anchorRange = dynamic_cast<KoAnchorTextRange *>(range);
         if (anchorRange) {
             // We need some special treatment for anchors as they need to position their object during
@@ -752,11 +825,38 @@ RootAreaConstraint constraintsForPosition(QTextFrame::iterator it, bool previous
     return constraints;
 }
 
-bool KoTextDocumentLayout::doLayout()
+bool KoTextDocumentLayout::resumeLayout(int areaNumber, FrameIterator **footNoteCursor, KoInlineNote **continuedNote, int *footNoteAutoCount)
 {
     delete d->layoutPosition;
-    d->layoutPosition = new FrameIterator(document()->rootFrame());
-    d->y = 0;
+    if (areaNumber == 0) {
+        d->layoutPosition = new FrameIterator(document()->rootFrame());
+        d->y = 0;
+        *footNoteCursor = 0;
+        *continuedNote = 0;
+        *footNoteAutoCount = 0;
+        return true;
+    }
+
+    // The root-areas before are still valid, so continue where the previous one ends
+    KoTextLayoutRootArea *previousArea = d->rootAreaList.at(areaNumber - 1);
+    d->layoutPosition = new FrameIterator(previousArea->nextStartOfArea());
+    d->y = previousArea->bottom() + qreal(50);
+    *footNoteCursor = previousArea->footNoteCursorToNext();
+    *continuedNote = previousArea->continuedNoteToNext();
+    *footNoteAutoCount = d->checkpoints.at(areaNumber - 1).footNoteAutoCount + previousArea->footNoteAutoCount();
+
+    if (d->layoutPosition->it == document()->rootFrame()->end() && !*footNoteCursor) {
+        d->provider->releaseAllAfter(previousArea);
+        d->removeRootAreasFrom(areaNumber);
+        return false;
+    }
+    return true;
+}
+
+bool KoTextDocumentLayout::doLayout()
+{
+    QElapsedTimer layoutTime;
+    layoutTime.start();
     d->layoutScheduled = false;
     d->restartLayout = false;
     FrameIterator *transferedFootNoteCursor = 0;
@@ -764,12 +864,35 @@ bool KoTextDocumentLayout::doLayout()
     int footNoteAutoCount = 0;
     KoTextLayoutRootArea *rootArea = 0;
 
-    d->rootAreaList.clear();
+    // Only the root-areas from the first dirty one on need to be layouted again
+    int currentAreaNumber = qMin(d->firstDirtyRootArea(0), d->pendingAreaNumber);
+    d->pendingAreaNumber = INT_MAX;
+    if (!resumeLayout(currentAreaNumber, &transferedFootNoteCursor, &transferedContinuedNote, &footNoteAutoCount)) {
+        return true; // Nothing changed
+    }
 
-    int currentAreaNumber = 0;
     do {
         if (d->restartLayout) {
-            return false; // Abort layouting to restart from the beginning.
+            d->pendingAreaNumber = currentAreaNumber;
+            return false; // Abort layouting to restart from the first dirty root-area.
+        }
+
+        if (currentAreaNumber < d->rootAreaList.count()) {
+            // If the root-area starts as it did the last time then the layout converged, and the
+            // following root-areas are valid up to the next dirty one.
+            KoTextLayoutRootArea *previousLayout = d->rootAreaList.at(currentAreaNumber);
+            const Private::Checkpoint &checkpoint = d->checkpoints.at(currentAreaNumber);
+            if (!previousLayout->isDirty() && previousLayout->top() == d->y
+                    && previousLayout->isStartingAt(d->layoutPosition)
+                    && !transferedFootNoteCursor && !checkpoint.footNoteCursor
+                    && transferedContinuedNote == checkpoint.continuedNote
+                    && footNoteAutoCount == checkpoint.footNoteAutoCount) {
+                currentAreaNumber = d->firstDirtyRootArea(currentAreaNumber + 1);
+                if (!resumeLayout(currentAreaNumber, &transferedFootNoteCursor, &transferedContinuedNote, &footNoteAutoCount)) {
+                    return true; // Finished layouting
+                }
+                continue;
+            }
         }
 
         // Build our request for our rootArea provider
@@ -780,10 +903,21 @@ bool KoTextDocumentLayout::doLayout()
         rootArea = d->provider->provide(this, constraints, currentAreaNumber, &newRootArea);
         if (!rootArea) {
             // Out of space ? Nothing more to do
+            d->removeRootAreasFrom(currentAreaNumber);
             break;
         }
 
-        d->rootAreaList.append(rootArea);
+        if (currentAreaNumber < d->rootAreaList.count() && d->rootAreaList.at(currentAreaNumber) != rootArea) {
+            d->removeRootAreasFrom(currentAreaNumber);
+        }
+        const Private::Checkpoint checkpoint = { d->y, footNoteAutoCount, transferedFootNoteCursor != 0, transferedContinuedNote };
+        if (currentAreaNumber == d->rootAreaList.count()) {
+            d->rootAreaIndex.insert(rootArea, d->rootAreaList.count());
+            d->rootAreaList.append(rootArea);
+            d->checkpoints.append(checkpoint);
+        } else {
+            d->checkpoints[currentAreaNumber] = checkpoint;
+        }
         bool shouldLayout = false;
 
         if (rootArea->top() != d->y) {
@@ -845,20 +979,25 @@ bool KoTextDocumentLayout::doLayout()
             if (finished && !rootArea->footNoteCursorToNext()) {
                 d->provider->releaseAllAfter(rootArea);
                 // We must also delete them from our own list too
-                int newsize = d->rootAreaList.indexOf(rootArea) + 1;
-                while (d->rootAreaList.size() > newsize) {
-                    d->rootAreaList.removeLast();
-                }
+                d->removeRootAreasFrom(currentAreaNumber + 1);
                 return true; // Finished layouting
             }
 
             if (d->layoutPosition->it == document()->rootFrame()->end()) {
+                d->removeRootAreasFrom(currentAreaNumber + 1);
                 return true; // Finished layouting
             }
 
             if (!continuousLayout()) {
+                d->pendingAreaNumber = currentAreaNumber + 1;
                 return false; // Let's take a break. We are not finished layouting yet.
             }
+
+            if (d->slicedLayout && d->layoutTimeSlice > 0 && layoutTime.elapsed() >= d->layoutTimeSlice) {
+                d->pendingAreaNumber = currentAreaNumber + 1;
+                scheduleLayout(); // continue after the waiting events are handled
+                return false;
+            }
         } else {
             // Drop following rootAreas
             delete d->layoutPosition;
@@ -866,10 +1005,7 @@ bool KoTextDocumentLayout::doLayout()
             if (d->layoutPosition->it == document()->rootFrame()->end() && !rootArea->footNoteCursorToNext()) {
                 d->provider->releaseAllAfter(rootArea);
                 // We must also delete them from our own list too
-                int newsize = d->rootAreaList.indexOf(rootArea) + 1;
-                while (d->rootAreaList.size() > newsize) {
-                    d->rootAreaList.removeLast();
-                }
+                d->removeRootAreasFrom(currentAreaNumber + 1);
                 return true; // Finished layouting
             }
         }
@@ -907,7 +1043,9 @@ void KoTextDocumentLayout::executeScheduledLayout()
         // root-areas that got dirty and are before the currently processed root-area.
         d->restartLayout = true;
     } else {
+        d->slicedLayout = true;
         layout();
+        d->slicedLayout = false;
     }
 }
 
@@ -921,6 +1059,16 @@ void KoTextDocumentLayout::setContinuousLayout(bool continuous)
     d->continuousLayout = continuous;
 }
 
+void KoTextDocumentLayout::setLayoutTimeSlice(int msec)
+{
+    d->layoutTimeSlice = msec;
+}
+
+int KoTextDocumentLayout::layoutTimeSlice() const
+{
+    return d->layoutTimeSlice;
+}
+
 void KoTextDocumentLayout::setBlockLayout(bool block)
 {
     d->layoutBlocked = block;
@@ -1000,9 +1148,8 @@ QList<KoTextLayoutRootArea *> KoTextDocumentLayout::rootAreas() const
 
 void KoTextDocumentLayout::removeRootArea(KoTextLayoutRootArea *rootArea)
 {
-    int indexOf = rootArea ? qMax(0, d->rootAreaList.indexOf(rootArea)) : 0;
-    for(int i = d->rootAreaList.count() - 1; i >= indexOf; --i)
-        d->rootAreaList.removeAt(i);
+    int indexOf = rootArea ? qMax(0, d->indexOfRootArea(rootArea)) : 0;
+    d->removeRootAreasFrom(indexOf);
 }
 
 QList<KoShape*> KoTextDocumentLayout::shapes() const
@@ -39,6 +39,8 @@ class KoShapeAnchor;
 class KoTextLayoutRootArea;
 class KoTextLayoutRootAreaProvider;
 class KoTextLayoutObstruction;
+class KoInlineNote;
+class FrameIterator;
 
 class QRectF;
 class QSizeF;
@@ -239,6 +241,16 @@ public:
     /// Set should layout be continued when done with current root area
     void setContinuousLayout(bool continuous);
 
+    /**
+     * Set how many milliseconds a scheduled layout run may take. A run that takes longer
+     * stops after the current root-area and continues once the events that came in
+     * meanwhile are handled, so the root-areas done so far can already be used.
+     * 0, the default, layouts all in one run. Direct calls of \a layout() always run
+     * till the layout is finished.
+     */
+    void setLayoutTimeSlice(int msec);
+    int layoutTimeSlice() const;
+
     /// Set \a layout() to be blocked (no layouting will happen)
     void setBlockLayout(bool block);
     bool layoutBlocked() const;
@@ -323,6 +335,12 @@ private:
     Private * const d;
 
     bool doLayout();
+    /**
+     * Prepares the layout to continue with the root-area @p areaNumber, taking the
+     * state from the root-areas before it.
+     * @return false if the root-areas before it already hold the whole document
+     */
+    bool resumeLayout(int areaNumber, FrameIterator **footNoteCursor, KoInlineNote **continuedNote, int *footNoteAutoCount);
     void updateProgress(const QTextFrame::iterator &it);
 };
 
@@ -72,10 +72,11 @@ void ToCGenerator::setBlock(const QTextBlock &block)
 
 QString ToCGenerator::fetchBookmarkRef(const QTextBlock &block, KoTextRangeManager *textRangeManager)
 {
-    QHash<int, KoTextRange *> ranges = textRangeManager->textRangesChangingWithin(block.document(), block.position(), block.position() + block.length(), block.position(), block.position() + block.length());
+    const QVector<KoTextRangeManager::RangePoint> points = textRangeManager->orderedTextRangesChangingWithin(block.document(), block.position(), block.position() + block.length(), block.position(), block.position() + block.length());
 
-    foreach (KoTextRange *range, ranges) {
-        KoBookmark *bookmark = dynamic_cast<KoBookmark *>(range);
+    // the first bookmark of the block
+    foreach (const KoTextRangeManager::RangePoint &point, points) {
+        KoBookmark *bookmark = dynamic_cast<KoBookmark *>(point.range);
         if (bookmark) {
             return bookmark->name();
         }
@@ -0,0 +1,105 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "KoTextDocumentLayoutBenchmark.h"
+#include "MockRootAreaProvider.h"
+
+#include <KoTextDocument.h>
+#include <KoStyleManager.h>
+#include <KoParagraphStyle.h>
+#include <KoInlineTextObjectManager.h>
+#include <KoTextDocumentLayout.h>
+#include <KoTextLayoutRootArea.h>
+
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+
+/// the number of paragraphs, four to five of them fit into a root-area
+#define PARAGRAPH_COUNT 6000
+
+void KoTextDocumentLayoutBenchmark::initTestCase()
+{
+    m_doc = new QTextDocument;
+    KoTextDocument(m_doc).setInlineTextObjectManager(new KoInlineTextObjectManager);
+    m_doc->setDefaultFont(QFont("Sans Serif", 12, QFont::Normal, false));
+    m_styleManager = new KoStyleManager(0);
+    KoTextDocument(m_doc).setStyleManager(m_styleManager);
+
+    MockRootAreaProvider *provider = new MockRootAreaProvider();
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+    m_layout = new KoTextDocumentLayout(m_doc, provider);
+    m_doc->setDocumentLayout(m_layout);
+
+    QStringList paragraphs;
+    for (int i = 0; i < PARAGRAPH_COUNT; ++i) {
+        paragraphs << QString("Paragraph %1").arg(i);
+    }
+    QTextCursor cursor(m_doc);
+    cursor.insertText(paragraphs.join(QChar(QChar::ParagraphSeparator)));
+    KoParagraphStyle style;
+    style.setStyleId(101);
+    for (QTextBlock block = m_doc->begin(); block.isValid(); block = block.next()) {
+        style.applyStyle(block);
+    }
+
+    m_layout->layout();
+    QVERIFY(m_layout->rootAreas().count() > 1000);
+}
+
+void KoTextDocumentLayoutBenchmark::cleanupTestCase()
+{
+    delete m_doc;
+    delete m_styleManager;
+}
+
+void KoTextDocumentLayoutBenchmark::benchmarkRootAreaForPosition()
+{
+    const int step = m_doc->characterCount() / 1000;
+    QBENCHMARK {
+        for (int position = 0; position < m_doc->characterCount() - 1; position += step) {
+            QVERIFY(m_layout->rootAreaForPosition(position));
+        }
+    }
+}
+
+void KoTextDocumentLayoutBenchmark::benchmarkRootAreaForPoint()
+{
+    QList<QPointF> points;
+    foreach (KoTextLayoutRootArea *rootArea, m_layout->rootAreas()) {
+        points.append(rootArea->boundingRect().center());
+    }
+    QBENCHMARK {
+        foreach (const QPointF &point, points) {
+            QVERIFY(m_layout->rootAreaForPoint(point));
+        }
+    }
+}
+
+void KoTextDocumentLayoutBenchmark::benchmarkTypingAtEnd()
+{
+    QTextCursor cursor(m_doc);
+    cursor.movePosition(QTextCursor::End);
+    QBENCHMARK {
+        cursor.insertText("x");
+        m_layout->layout();
+    }
+}
+
+QTEST_MAIN(KoTextDocumentLayoutBenchmark)
@@ -0,0 +1,49 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOTEXTDOCUMENTLAYOUTBENCHMARK_H
+#define KOTEXTDOCUMENTLAYOUTBENCHMARK_H
+
+#include <QObject>
+
+class QTextDocument;
+class KoTextDocumentLayout;
+class KoStyleManager;
+
+/**
+ * Benchmarks the lookups of KoTextDocumentLayout on a document of some thousand
+ * root-areas, which is about the size of a long book.
+ */
+class KoTextDocumentLayoutBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkRootAreaForPosition();
+    void benchmarkRootAreaForPoint();
+    void benchmarkTypingAtEnd();
+
+private:
+    QTextDocument *m_doc;
+    KoStyleManager *m_styleManager;
+    KoTextDocumentLayout *m_layout;
+};
+
+#endif // KOTEXTDOCUMENTLAYOUTBENCHMARK_H
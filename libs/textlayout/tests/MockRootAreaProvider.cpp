@@ -47,8 +47,8 @@ KoTextLayoutRootArea *MockRootAreaProvider::provide(KoTextDocumentLayout *docume
 
 void MockRootAreaProvider::doPostLayout(KoTextLayoutRootArea *rootArea, bool isNewRootArea)
 {
-    Q_UNUSED(rootArea);
     Q_UNUSED(isNewRootArea);
+    m_layoutedAreas.append(rootArea);
 }
 
 void MockRootAreaProvider::updateAll()
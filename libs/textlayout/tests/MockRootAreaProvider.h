@@ -24,6 +24,7 @@
 
 #include <QRectF>
 #include <QMap>
+#include <QList>
 
 class MockRootAreaProvider : public KoTextLayoutRootAreaProvider
 {
@@ -46,6 +47,7 @@ public:
     QMap<int, KoTextLayoutRootArea*> m_areas;
     QRectF m_suggestedRect;
     bool m_askedForMoreThenOneArea;
+    QList<KoTextLayoutRootArea *> m_layoutedAreas; // in the order doPostLayout was called for them
 };
 
 #endif
@@ -21,6 +21,9 @@
 #include "TestDocumentLayout.h"
 #include "MockRootAreaProvider.h"
 #include <QTest>
+#include <QSignalSpy>
+#include <QTextBlock>
+#include <QTextLayout>
 
 #include <TextLayoutDebug.h>
 
@@ -191,4 +194,129 @@ void TestDocumentLayout::testRootAreaZeroWidthAndHeight()
     QCOMPARE(provider->area()->referenceRect(), QRectF(10.,10.,0.,0.));
 }
 
+void TestDocumentLayout::testIncrementalLayout()
+{
+    QStringList paragraphs;
+    for (int i = 0; i < 40; ++i) {
+        paragraphs << QString("Paragraph %1").arg(i);
+    }
+    setupTest(paragraphs.join(QChar(QChar::ParagraphSeparator)));
+
+    MockRootAreaProvider *provider = dynamic_cast<MockRootAreaProvider*>(m_layout->provider());
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+
+    m_layout->layout();
+    QList<KoTextLayoutRootArea *> rootAreas = m_layout->rootAreas();
+    QVERIFY(rootAreas.count() > 3);
+    QCOMPARE(provider->m_layoutedAreas, rootAreas);
+
+    // a change that does not move the following text only layouts the root-areas marked dirty
+    provider->m_layoutedAreas.clear();
+    QTextCursor cursor(m_doc);
+    cursor.insertText("x");
+    m_layout->layout();
+    QCOMPARE(m_layout->rootAreas(), rootAreas);
+    QCOMPARE(provider->m_layoutedAreas.count(), 2);
+    QCOMPARE(provider->m_layoutedAreas.at(0), rootAreas.at(0));
+    QCOMPARE(provider->m_layoutedAreas.at(1), rootAreas.at(1));
+
+    // the root-areas before a change are left alone
+    provider->m_layoutedAreas.clear();
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("x");
+    m_layout->layout();
+    QCOMPARE(m_layout->rootAreas(), rootAreas);
+    QVERIFY(!provider->m_layoutedAreas.isEmpty());
+    QVERIFY(!provider->m_layoutedAreas.contains(rootAreas.at(0)));
+    QVERIFY(provider->m_layoutedAreas.contains(rootAreas.last()));
+
+    // text that moves to the following root-areas layouts them too
+    provider->m_layoutedAreas.clear();
+    cursor.setPosition(0);
+    for (int i = 0; i < 10; ++i) {
+        cursor.insertText(QString(QChar::ParagraphSeparator));
+    }
+    m_layout->layout();
+    QVERIFY(m_layout->rootAreas().count() > rootAreas.count());
+    QVERIFY(provider->m_layoutedAreas.count() > rootAreas.count());
+    foreach (KoTextLayoutRootArea *rootArea, m_layout->rootAreas()) {
+        QVERIFY(!rootArea->isDirty());
+    }
+}
+
+void TestDocumentLayout::testRootAreaLookup()
+{
+    QStringList paragraphs;
+    for (int i = 0; i < 100; ++i) {
+        paragraphs << QString("Paragraph %1").arg(i);
+    }
+    setupTest(paragraphs.join(QChar(QChar::ParagraphSeparator)));
+
+    MockRootAreaProvider *provider = dynamic_cast<MockRootAreaProvider*>(m_layout->provider());
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+    m_layout->layout();
+    QList<KoTextLayoutRootArea *> rootAreas = m_layout->rootAreas();
+    QVERIFY(rootAreas.count() > 10);
+
+    for (QTextBlock block = m_doc->begin(); block.isValid(); block = block.next()) {
+        const QTextLine line = block.layout()->lineAt(0);
+        KoTextLayoutRootArea *expected = 0;
+        foreach (KoTextLayoutRootArea *rootArea, rootAreas) {
+            if (rootArea->boundingRect().contains(line.position())) {
+                expected = rootArea;
+                break;
+            }
+        }
+        QVERIFY(expected);
+        QCOMPARE(m_layout->rootAreaForPosition(block.position()), expected);
+    }
+
+    foreach (KoTextLayoutRootArea *rootArea, rootAreas) {
+        QCOMPARE(m_layout->rootAreaForPoint(rootArea->boundingRect().center()), rootArea);
+        QCOMPARE(m_layout->rootAreaForPoint(rootArea->boundingRect().topLeft()), rootArea);
+    }
+    // there is nothing between the root-areas and below the last one
+    QVERIFY(!m_layout->rootAreaForPoint(QPointF(100., rootAreas.at(0)->boundingRect().bottom() + 25.)));
+    QVERIFY(!m_layout->rootAreaForPoint(QPointF(100., rootAreas.last()->boundingRect().bottom() + 25.)));
+}
+
+void TestDocumentLayout::testLayoutTimeSlice()
+{
+    QStringList paragraphs;
+    for (int i = 0; i < 400; ++i) {
+        paragraphs << QString("Paragraph %1 with some more text to make it a bit longer than one line").arg(i);
+    }
+    const QString text = paragraphs.join(QChar(QChar::ParagraphSeparator));
+
+    setupTest(text);
+    MockRootAreaProvider *provider = dynamic_cast<MockRootAreaProvider*>(m_layout->provider());
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+    m_layout->layout();
+    const int rootAreaCount = m_layout->rootAreas().count();
+    QVERIFY(rootAreaCount > 10);
+
+    // a direct layout call is never sliced
+    setupTest(text);
+    provider = dynamic_cast<MockRootAreaProvider*>(m_layout->provider());
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+    m_layout->setLayoutTimeSlice(1);
+    QCOMPARE(m_layout->layoutTimeSlice(), 1);
+    m_layout->layout();
+    QCOMPARE(m_layout->rootAreas().count(), rootAreaCount);
+
+    // a scheduled one continues till it is finished
+    setupTest(text);
+    provider = dynamic_cast<MockRootAreaProvider*>(m_layout->provider());
+    provider->setSuggestedRect(QRectF(0., 0., 200., 100.));
+    m_layout->setLayoutTimeSlice(1);
+    QSignalSpy finishedSpy(m_layout, SIGNAL(finishedLayout()));
+    m_layout->scheduleLayout();
+    QVERIFY(finishedSpy.wait(30000));
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(m_layout->rootAreas().count(), rootAreaCount);
+    foreach (KoTextLayoutRootArea *rootArea, m_layout->rootAreas()) {
+        QVERIFY(!rootArea->isDirty());
+    }
+}
+
 QTEST_MAIN(TestDocumentLayout)
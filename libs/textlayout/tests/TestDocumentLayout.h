@@ -57,6 +57,21 @@ private Q_SLOTS:
      */
     void testRootAreaZeroWidthAndHeight();
 
+    /**
+     * Test that only the root-areas that changed are layouted again.
+     */
+    void testIncrementalLayout();
+
+    /**
+     * Test the lookup of root-areas by position and by point.
+     */
+    void testRootAreaLookup();
+
+    /**
+     * Test that a layout in time slices gives the same root-areas.
+     */
+    void testLayoutTimeSlice();
+
 private:
     void setupTest(const QString &initText = QString());
 
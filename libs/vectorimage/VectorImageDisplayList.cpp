@@ -0,0 +1,118 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "VectorImageDisplayList.h"
+
+#include "VectorImageDebug.h"
+#include "EmfParser.h"
+#include "EmfOutputPainterStrategy.h"
+#include "SvmParser.h"
+#include "SvmPainterBackend.h"
+#include "WmfPainterBackend.h"
+
+#include <QPainter>
+#include <QPicture>
+
+VectorImageDisplayList::VectorImageDisplayList()
+{
+}
+
+VectorImageDisplayList::VectorImageDisplayList(const QPicture &picture, const QSizeF &size)
+    : m_data(picture.data(), picture.size()),
+    m_size(size)
+{
+}
+
+VectorImageDisplayList VectorImageDisplayList::record(Format format, const QByteArray &contents, const QSizeF &size)
+{
+    QPicture picture;
+    QPainter painter;
+    if (!painter.begin(&picture)) {
+        warnVectorImage << "Failed to record the display list";
+        return VectorImageDisplayList();
+    }
+
+    // the parsers set absolute transformations, combined with the one the
+    // painter has when they start; a QPicture plays them back the same way,
+    // relative to the transformation of the painter it is replayed on
+    bool ok = false;
+    switch (format) {
+    case Wmf: {
+        Libwmf::WmfPainterBackend wmfPainter(&painter, size);
+        ok = wmfPainter.load(contents);
+        if (ok) {
+            painter.save();
+            wmfPainter.play();
+            painter.restore();
+        }
+        break;
+    }
+    case Emf: {
+        // FIXME: Make emfOutput use QSizeF
+        QSize sizeInt(size.width(), size.height());
+        Libemf::Parser emfParser;
+        // Last param = true means keep aspect ratio.
+        Libemf::OutputPainterStrategy emfPaintOutput(painter, sizeInt, true);
+        emfParser.setOutput(&emfPaintOutput);
+        ok = emfParser.load(contents);
+        break;
+    }
+    case Svm: {
+        QSize sizeInt(size.width(), size.height());
+        Libsvm::SvmParser svmParser;
+        Libsvm::SvmPainterBackend svmPaintOutput(&painter, sizeInt);
+        svmParser.setBackend(&svmPaintOutput);
+        ok = svmParser.parse(contents);
+        break;
+    }
+    }
+    painter.end();
+
+    if (!ok)
+        return VectorImageDisplayList();
+    return VectorImageDisplayList(picture, size);
+}
+
+bool VectorImageDisplayList::isNull() const
+{
+    return m_data.isEmpty();
+}
+
+QSizeF VectorImageDisplayList::size() const
+{
+    return m_size;
+}
+
+int VectorImageDisplayList::byteCount() const
+{
+    return m_data.size();
+}
+
+void VectorImageDisplayList::replay(QPainter &painter) const
+{
+    if (m_data.isEmpty())
+        return;
+
+    // QPicture is not safe to play from several threads, so every replay
+    // works on its own copy of the commands
+    QPicture picture;
+    picture.setData(m_data.constData(), m_data.size());
+    painter.save();
+    painter.drawPicture(0, 0, picture);
+    painter.restore();
+}
@@ -0,0 +1,86 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VECTORIMAGEDISPLAYLIST_H
+#define VECTORIMAGEDISPLAYLIST_H
+
+#include "kovectorimage_export.h"
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QSizeF>
+
+class QPainter;
+class QPicture;
+
+/**
+ * The drawing commands of a vector image, recorded once.
+ *
+ * Parsing a WMF, EMF or SVM file is a lot more work than drawing it. A display
+ * list is made by parsing the file a single time; after that it can be painted
+ * any number of times, at any scale, without going through the parser again.
+ *
+ * Display lists are immutable and implicitly shared, so they are cheap to copy
+ * and can be replayed from several threads at the same time.
+ */
+class KOVECTORIMAGE_EXPORT VectorImageDisplayList
+{
+public:
+    enum Format {
+        Wmf,
+        Emf,
+        Svm
+    };
+
+    /// creates a null display list
+    VectorImageDisplayList();
+
+    /**
+     * Creates a display list from the commands recorded in @p picture.
+     * @param size the size the commands were drawn for
+     */
+    VectorImageDisplayList(const QPicture &picture, const QSizeF &size);
+
+    /**
+     * Parses @p contents and records what the parser draws when it fills
+     * @p size. Returns a null display list if the contents cannot be parsed.
+     */
+    static VectorImageDisplayList record(Format format, const QByteArray &contents, const QSizeF &size);
+
+    bool isNull() const;
+
+    /// the size the image was recorded for
+    QSizeF size() const;
+
+    /// the number of bytes the recorded commands take
+    int byteCount() const;
+
+    /**
+     * Paints the image into the rectangle (0, 0, size()) of the current
+     * coordinate system of @p painter. The painter state is not changed.
+     */
+    void replay(QPainter &painter) const;
+
+private:
+    QByteArray m_data;
+    QSizeF m_size;
+};
+
+Q_DECLARE_METATYPE(VectorImageDisplayList)
+
+#endif // VECTORIMAGEDISPLAYLIST_H
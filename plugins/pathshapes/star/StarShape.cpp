@@ -229,6 +229,7 @@ void StarShape::createPoints(int requiredPointCount)
             m_subpaths[0]->append(new KoPathPoint(this, QPointF()));
         }
     }
+    notifyPointsChanged();
 }
 
 void StarShape::setSize(const QSizeF &newSize)
@@ -54,7 +54,6 @@
 #include <QPainter>
 #include <QTimer>
 #include <QPixmapCache>
-#include <QThreadPool>
 #include <QImage>
 #include <QColor>
 
@@ -65,33 +64,8 @@ QString generate_key(qint64 key, const QSize & size)
 
 // ----------------------------------------------------------------- //
 
-_Private::PixmapScaler::PixmapScaler(PictureShape *pictureShape, const QSize &pixmapSize):
-    m_size(pixmapSize)
+void _Private::PictureShapeProxy::scaledImageReady()
 {
-    m_image = pictureShape->imageData()->image();
-    m_imageKey = pictureShape->imageData()->key();
-    connect(this, SIGNAL(finished(QString,QImage)), &pictureShape->m_proxy, SLOT(setImage(QString,QImage)));
-}
-
-void _Private::PixmapScaler::run()
-{
-    QString key = generate_key(m_imageKey, m_size);
-
-    m_image = m_image.scaled(
-        m_size.width(),
-        m_size.height(),
-        Qt::IgnoreAspectRatio,
-        Qt::SmoothTransformation
-    );
-
-    emit finished(key, m_image);
-}
-
-// ----------------------------------------------------------------- //
-
-void _Private::PictureShapeProxy::setImage(const QString &key, const QImage &image)
-{
-    QPixmapCache::insert(key, QPixmap::fromImage(image));
     m_pictureShape->update();
 }
 
@@ -272,8 +246,6 @@ QPainterPath PictureShape::shadowOutline() const
 void PictureShape::paint(QPainter &painter, const KoViewConverter &converter,
                          KoShapePaintingContext &paintContext)
 {
-    Q_UNUSED(paintContext);
-
     QRectF viewRect = converter.documentToView(QRectF(QPointF(0,0), size()));
     if (imageData() == 0) {
         painter.fillRect(viewRect, QColor(Qt::gray));
@@ -285,7 +257,7 @@ void PictureShape::paint(QPainter &painter, const KoViewConverter &converter,
     paintBorder(painter, converter);
     painter.restore();
 
-    QSize pixmapSize = calcOptimalPixmapSize(viewRect.size(), imageData()->image().size());
+    QSize pixmapSize = calcOptimalPixmapSize(viewRect.size(), imageData()->pixelSize());
 
     // Normalize the clipping rect if it isn't already done.
     m_clippingRect.normalize(imageData()->imageSize());
@@ -344,14 +316,44 @@ void PictureShape::paint(QPainter &painter, const KoViewConverter &converter,
         QPixmap pixmap;
         QString key(generate_key(imageData()->key(), pixmapSize));
 
-        // If the required pixmap is not in the cache
-        // launch a task in a background thread that scales
-        // the source image to the required size
+        // While the canvas is zoomed the pixmap painted last is stretched
+        // instead of scaling the image again for every step of the zoom
+        if (paintContext.levelOfDetail == KoShapePaintingContext::DraftDetail && !m_paintedPixmapSize.isEmpty()
+                && !QPixmapCache::find(key, &pixmap)
+                && QPixmapCache::find(generate_key(imageData()->key(), m_paintedPixmapSize), &pixmap)) {
+            QRectF cropRect(
+                pixmap.width()  * m_clippingRect.left,
+                pixmap.height() * m_clippingRect.top,
+                pixmap.width()  * m_clippingRect.width(),
+                pixmap.height() * m_clippingRect.height()
+            );
+            painter.drawPixmap(viewRect, pixmap, cropRect);
+            return;
+        }
+
+        // If the required pixmap is not in the cache ask the image data for it,
+        // which scales the source image to the required size in a background
+        // thread and meanwhile gives us the closest size it already has
         if (!QPixmapCache::find(key, &pixmap)) {
-            QThreadPool::globalInstance()->start(new _Private::PixmapScaler(this, pixmapSize));
-            painter.fillRect(viewRect, QColor(Qt::gray)); // just paint a gray rect as long as we don't have the required pixmap
+            QObject::connect(imageData(), SIGNAL(scaledImageReady()), &m_proxy, SLOT(scaledImageReady()), Qt::UniqueConnection);
+            QImage image = imageData()->scaledImage(pixmapSize);
+            if (image.size() == pixmapSize) {
+                pixmap = QPixmap::fromImage(image);
+                QPixmapCache::insert(key, pixmap);
+            } else if (!image.isNull()) {
+                QSizeF imageSize = image.size();
+                QRectF cropRect(
+                    imageSize.width()  * m_clippingRect.left,
+                    imageSize.height() * m_clippingRect.top,
+                    imageSize.width()  * m_clippingRect.width(),
+                    imageSize.height() * m_clippingRect.height()
+                );
+                painter.drawImage(viewRect, image, cropRect);
+            } else {
+                painter.fillRect(viewRect, QColor(Qt::gray)); // just paint a gray rect as long as we don't have the required pixmap
+            }
         }
-        else {
+        if (!pixmap.isNull()) {
             QRectF cropRect(
                 pixmapSize.width()  * m_clippingRect.left,
                 pixmapSize.height() * m_clippingRect.top,
@@ -360,6 +362,7 @@ void PictureShape::paint(QPainter &painter, const KoViewConverter &converter,
             );
 
             painter.drawPixmap(viewRect, pixmap, cropRect);
+            m_paintedPixmapSize = pixmapSize;
         }
     }
 }
@@ -385,7 +388,7 @@ void PictureShape::waitUntilReady(const KoViewConverter &converter, bool asynchr
         m_printQualityImage = image.scaled(pixels, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
     }
     else {
-        QSize pixmapSize = calcOptimalPixmapSize(converter.documentToView(QRectF(QPointF(0,0), size())).size(), imageData->image().size());
+        QSize pixmapSize = calcOptimalPixmapSize(converter.documentToView(QRectF(QPointF(0,0), size())).size(), imageData->pixelSize());
         QString key(generate_key(imageData->key(), pixmapSize));
         if (QPixmapCache::find(key) == 0) {
             QPixmap pixmap = imageData->pixmap(pixmapSize);
@@ -25,7 +25,6 @@
 #include <QPainterPath>
 #include <QPixmap>
 #include <QImage>
-#include <QRunnable>
 
 #include <KoTosContainer.h>
 #include <KoFrameShape.h>
@@ -55,33 +54,13 @@ namespace _Private
             m_pictureShape(p) { }
 
     public Q_SLOTS:
-        void setImage(const QString& key, const QImage& image);
+        /// repaints the shape once its image has been scaled in the background
+        void scaledImageReady();
 
     private:
         PictureShape *m_pictureShape;
     };
 
-    /**
-     * This class will scale an image to a given size.
-     * Instances of this class can be executed in a thread pool
-     * therefore the scaling process can be done in the background
-     */
-    class PixmapScaler: public QObject, public QRunnable
-    {
-        Q_OBJECT
-    public:
-        PixmapScaler(PictureShape *pictureShape, const QSize &pixmapSize);
-        virtual void run();
-
-    Q_SIGNALS:
-        void finished(const QString &, const QImage &);
-
-    private:
-        QSize m_size;
-        QImage m_image;
-        quint64 m_imageKey;
-    };
-
     /**
      * This method will create an outline path out of the image
      */
@@ -91,7 +70,6 @@ namespace _Private
 
 class PictureShape : public KoTosContainer, public KoFrameShape, public SvgShape
 {
-    friend class _Private::PixmapScaler;
     friend class _Private::PictureShapeProxy;
 
 public:
@@ -163,6 +141,7 @@ private:
     KoImageCollection *m_imageCollection;
     mutable QImage m_printQualityImage;
     mutable QSizeF m_printQualityRequestedSize;
+    QSize m_paintedPixmapSize; ///< the size of the cached pixmap painted last
 
     QFlags<MirrorMode> m_mirrorMode;
     ColorMode m_colorMode;
@@ -55,6 +55,7 @@ void ColoringFilterEffect::setColoring(qreal red, qreal green, qreal blue, qreal
     m_blue = blue;
     m_contrast = contrast;
     m_luminance = luminance;
+    parametersChanged();
 }
 
 qreal ColoringFilterEffect::red() const
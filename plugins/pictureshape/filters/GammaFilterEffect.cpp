@@ -48,6 +48,7 @@ bool GammaFilterEffect::load(const KoXmlElement& /*element*/, const KoFilterEffe
 void GammaFilterEffect::setGamma(qreal gamma)
 {
     m_gamma =gamma;
+    parametersChanged();
 }
 
 qreal GammaFilterEffect::gamma() const
@@ -43,6 +43,7 @@ BlendEffect::BlendMode BlendEffect::blendMode() const
 void BlendEffect::setBlendMode(BlendMode blendMode)
 {
     m_blendMode = blendMode;
+    parametersChanged();
 }
 
 QImage BlendEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
@@ -18,7 +18,7 @@
  */
 
 #include "ColorMatrixEffect.h"
-#include "ColorChannelConversion.h"
+#include "FilterEffectKernels.h"
 #include <KoFilterEffectRenderContext.h>
 #include <KoXmlWriter.h>
 #include <KoXmlReader.h>
@@ -47,6 +47,7 @@ void ColorMatrixEffect::setIdentity()
             m_matrix[r*MatrixCols+c] = r == c ? 1.0 : 0.0;
         }
     }
+    parametersChanged();
 }
 
 ColorMatrixEffect::Type ColorMatrixEffect::type() const
@@ -79,6 +80,7 @@ void ColorMatrixEffect::setColorMatrix(const QVector<qreal> &colorMatrix)
     if (colorMatrix.count() == MatrixSize)
         m_matrix = colorMatrix;
     m_type = Matrix;
+    parametersChanged();
 }
 
 void ColorMatrixEffect::setSaturate(qreal value)
@@ -99,6 +101,7 @@ void ColorMatrixEffect::setSaturate(qreal value)
     m_matrix[10] = 0.213 - 0.213 * value;
     m_matrix[11] = 0.715 - 0.715 * value;
     m_matrix[12] = 0.072 + 0.928 * value;
+    parametersChanged();
 }
 
 qreal ColorMatrixEffect::saturate() const
@@ -131,6 +134,7 @@ void ColorMatrixEffect::setHueRotate(qreal value)
     m_matrix[10] = 0.213 - 0.213 * c - 0.787 * s;
     m_matrix[11] = 0.715 - 0.715 * c + 0.715 * s;
     m_matrix[12] = 0.072 + 0.928 * c + 0.072 * s;
+    parametersChanged();
 }
 
 qreal ColorMatrixEffect::hueRotate() const
@@ -151,52 +155,18 @@ void ColorMatrixEffect::setLuminanceAlpha()
     m_matrix[16] = 0.7154;
     m_matrix[17] = 0.0721;
     m_matrix[18] = 0.0;
+    parametersChanged();
 }
 
 QImage ColorMatrixEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
 {
     QImage result = image;
 
-    const QRgb *src = (const QRgb*)image.constBits();
-    QRgb *dst = (QRgb*)result.bits();
-    int w = result.width();
-
-    const qreal * m = m_matrix.data();
-    qreal sa, sr, sg, sb;
-    qreal da, dr, dg, db;
-
-    QRect roi = context.filterRegion().toRect();
-    for (int row = roi.top(); row < roi.bottom(); ++row) {
-        for (int col = roi.left(); col < roi.right(); ++col) {
-            const QRgb &s = src[row*w+col];
-            sa = fromIntColor[qAlpha(s)];
-            sr = fromIntColor[qRed(s)];
-            sg = fromIntColor[qGreen(s)];
-            sb = fromIntColor[qBlue(s)];
-            // the matrix is applied to non-premultiplied color values
-            // so we have to convert colors by dividing by alpha value
-            if (sa > 0.0 && sa < 1.0) {
-                sr /= sa;
-                sb /= sa;
-                sg /= sa;
-            }
-
-            // apply matrix to color values
-            dr = m[ 0] * sr + m[ 1] * sg + m[ 2] * sb + m[ 3] * sa + m[ 4];
-            dg = m[ 5] * sr + m[ 6] * sg + m[ 7] * sb + m[ 8] * sa + m[ 9];
-            db = m[10] * sr + m[11] * sg + m[12] * sb + m[13] * sa + m[14];
-            da = m[15] * sr + m[16] * sg + m[17] * sb + m[18] * sa + m[19];
-
-            // the new alpha value
-            da *= 255.0;
-
-            // set pre-multiplied color values on destination image
-            dst[row*w+col] = qRgba(static_cast<quint8>(qBound(qreal(0.0), dr * da, qreal(255.0))),
-                                   static_cast<quint8>(qBound(qreal(0.0), dg * da, qreal(255.0))),
-                                   static_cast<quint8>(qBound(qreal(0.0), db * da, qreal(255.0))),
-                                   static_cast<quint8>(qBound(qreal(0.0), da, qreal(255.0))));
-        }
-    }
+    const QRect roi = context.filterRegion().toRect();
+    FilterEffectKernels::instance()->colorMatrix(reinterpret_cast<const quint32*>(image.constBits()),
+                                                 reinterpret_cast<quint32*>(result.bits()), result.width(),
+                                                 roi.left(), roi.right(), roi.top(), roi.bottom(),
+                                                 m_matrix.data());
 
     return result;
 }
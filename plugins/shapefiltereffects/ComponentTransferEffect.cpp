@@ -18,14 +18,14 @@
  */
 
 #include "ComponentTransferEffect.h"
-#include "ColorChannelConversion.h"
+#include "FilterEffectKernels.h"
 #include <KoFilterEffectRenderContext.h>
 #include <KoXmlWriter.h>
 #include <KoXmlReader.h>
 #include <klocalizedstring.h>
 #include <QRect>
 #include <QImage>
-#include <math.h>
+#include <QVector>
 
 ComponentTransferEffect::ComponentTransferEffect()
         : KoFilterEffect(ComponentTransferEffectId, i18n("Component transfer"))
@@ -40,6 +40,7 @@ ComponentTransferEffect::Function ComponentTransferEffect::function(Channel chan
 void ComponentTransferEffect::setFunction(Channel channel, Function function)
 {
     m_data[channel].function = function;
+    parametersChanged();
 }
 
 QList<qreal> ComponentTransferEffect::tableValues(Channel channel) const
@@ -50,11 +51,13 @@ QList<qreal> ComponentTransferEffect::tableValues(Channel channel) const
 void ComponentTransferEffect::setTableValues(Channel channel, QList<qreal> tableValues)
 {
     m_data[channel].tableValues = tableValues;
+    parametersChanged();
 }
 
 void ComponentTransferEffect::setSlope(Channel channel, qreal slope)
 {
     m_data[channel].slope = slope;
+    parametersChanged();
 }
 
 qreal ComponentTransferEffect::slope(Channel channel) const
@@ -65,6 +68,7 @@ qreal ComponentTransferEffect::slope(Channel channel) const
 void ComponentTransferEffect::setIntercept(Channel channel, qreal intercept)
 {
     m_data[channel].intercept = intercept;
+    parametersChanged();
 }
 
 qreal ComponentTransferEffect::intercept(Channel channel) const
@@ -75,6 +79,7 @@ qreal ComponentTransferEffect::intercept(Channel channel) const
 void ComponentTransferEffect::setAmplitude(Channel channel, qreal amplitude)
 {
     m_data[channel].amplitude = amplitude;
+    parametersChanged();
 }
 
 qreal ComponentTransferEffect::amplitude(Channel channel) const
@@ -85,6 +90,7 @@ qreal ComponentTransferEffect::amplitude(Channel channel) const
 void ComponentTransferEffect::setExponent(Channel channel, qreal exponent)
 {
     m_data[channel].exponent = exponent;
+    parametersChanged();
 }
 
 qreal ComponentTransferEffect::exponent(Channel channel) const
@@ -95,6 +101,7 @@ qreal ComponentTransferEffect::exponent(Channel channel) const
 void ComponentTransferEffect::setOffset(Channel channel, qreal offset)
 {
     m_data[channel].offset = offset;
+    parametersChanged();
 }
 
 qreal ComponentTransferEffect::offset(Channel channel) const
@@ -106,85 +113,45 @@ QImage ComponentTransferEffect::processImage(const QImage &image, const KoFilter
 {
     QImage result = image;
 
-    const QRgb *src = (const QRgb*)image.constBits();
-    QRgb *dst = (QRgb*)result.bits();
-    int w = result.width();
-
-    qreal sa, sr, sg, sb;
-    qreal da, dr, dg, db;
-    int pixel;
-
-    const QRect roi = context.filterRegion().toRect();
-    const int minRow = roi.top();
-    const int maxRow = roi.bottom();
-    const int minCol = roi.left();
-    const int maxCol = roi.right();
-
-    for (int row = minRow; row <= maxRow; ++row) {
-        for (int col = minCol; col <= maxCol; ++col) {
-            pixel = row * w + col;
-            const QRgb &s = src[pixel];
-
-            sa = fromIntColor[qAlpha(s)];
-            sr = fromIntColor[qRed(s)];
-            sg = fromIntColor[qGreen(s)];
-            sb = fromIntColor[qBlue(s)];
-            // the matrix is applied to non-premultiplied color values
-            // so we have to convert colors by dividing by alpha value
-            if (sa > 0.0 && sa < 1.0) {
-                sr /= sa;
-                sb /= sa;
-                sg /= sa;
-            }
-
-            dr = transferChannel(ChannelR, sr);
-            dg = transferChannel(ChannelG, sg);
-            db = transferChannel(ChannelB, sb);
-            da = transferChannel(ChannelA, sa);
-
-            da *= 255.0;
-
-            // set pre-multiplied color values on destination image
-            dst[pixel] = qRgba(static_cast<quint8>(qBound(qreal(0.0), dr * da, qreal(255.0))),
-                               static_cast<quint8>(qBound(qreal(0.0), dg * da, qreal(255.0))),
-                               static_cast<quint8>(qBound(qreal(0.0), db * da, qreal(255.0))),
-                               static_cast<quint8>(qBound(qreal(0.0), da, qreal(255.0))));
+    FilterEffectKernels::TransferFunction functions[4];
+    QVector<qreal> tables[4];
+    for (int channel = ChannelR; channel <= ChannelA; ++channel) {
+        const Data &d = m_data[channel];
+        FilterEffectKernels::TransferFunction &function = functions[channel];
+        switch (d.function) {
+        case Identity:
+            function.type = FilterEffectKernels::TransferFunction::Identity;
+            break;
+        case Table:
+            function.type = FilterEffectKernels::TransferFunction::Table;
+            break;
+        case Discrete:
+            function.type = FilterEffectKernels::TransferFunction::Discrete;
+            break;
+        case Linear:
+            function.type = FilterEffectKernels::TransferFunction::Linear;
+            break;
+        case Gamma:
+            function.type = FilterEffectKernels::TransferFunction::Gamma;
+            break;
         }
+        tables[channel] = d.tableValues.toVector();
+        function.table = tables[channel].constData();
+        function.tableSize = tables[channel].count();
+        function.slope = d.slope;
+        function.intercept = d.intercept;
+        function.amplitude = d.amplitude;
+        function.exponent = d.exponent;
+        function.offset = d.offset;
     }
 
-    return result;
-}
-
-qreal ComponentTransferEffect::transferChannel(Channel channel, qreal value) const
-{
-    const Data &d = m_data[channel];
-
-    switch (d.function) {
-    case Identity:
-        return value;
-    case Table: {
-        qreal valueCount = d.tableValues.count() - 1;
-        if (valueCount < 0.0)
-            return value;
-        qreal k1 = static_cast<int>(value * valueCount);
-        qreal k2 = qMin(k1 + 1, valueCount);
-        qreal vk1 = d.tableValues[k1];
-        qreal vk2 = d.tableValues[k2];
-        return vk1 + (value - static_cast<qreal>(k1) / valueCount)*valueCount *(vk2 - vk1);
-    }
-    case Discrete: {
-        qreal valueCount = d.tableValues.count() - 1;
-        if (valueCount < 0.0)
-            return value;
-        return d.tableValues[static_cast<int>(value*valueCount)];
-    }
-    case Linear:
-        return d.slope * value + d.intercept;
-    case Gamma:
-        return d.amplitude * pow(value, d.exponent) + d.offset;
-    }
+    const QRect roi = context.filterRegion().toRect();
+    FilterEffectKernels::instance()->componentTransfer(reinterpret_cast<const quint32*>(image.constBits()),
+                                                       reinterpret_cast<quint32*>(result.bits()), result.width(),
+                                                       roi.left(), roi.right() + 1, roi.top(), roi.bottom() + 1,
+                                                       functions);
 
-    return value;
+    return result;
 }
 
 bool ComponentTransferEffect::load(const KoXmlElement &element, const KoFilterEffectLoadingContext &)
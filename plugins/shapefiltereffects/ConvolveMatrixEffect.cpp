@@ -18,6 +18,7 @@
  */
 
 #include "ConvolveMatrixEffect.h"
+#include "FilterEffectKernels.h"
 #include "KoFilterEffectRenderContext.h"
 #include "KoFilterEffectLoadingContext.h"
 #include "KoViewConverter.h"
@@ -50,6 +51,7 @@ void ConvolveMatrixEffect::setDefaults()
         m_kernel[i] = 0.0;
     }
     m_kernelUnitLength = QPointF(1,1);
+    parametersChanged();
 }
 
 QPoint ConvolveMatrixEffect::order() const
@@ -60,6 +62,7 @@ QPoint ConvolveMatrixEffect::order() const
 void ConvolveMatrixEffect::setOrder(const QPoint &order)
 {
     m_order = QPoint(qMax(1, order.x()), qMax(1, order.y()));
+    parametersChanged();
 }
 
 QVector<qreal> ConvolveMatrixEffect::kernel() const
@@ -72,6 +75,7 @@ void ConvolveMatrixEffect::setKernel(const QVector<qreal> &kernel)
     if (m_order.x()*m_order.y() != kernel.count())
         return;
     m_kernel = kernel;
+    parametersChanged();
 }
 
 qreal ConvolveMatrixEffect::divisor() const
@@ -82,6 +86,7 @@ qreal ConvolveMatrixEffect::divisor() const
 void ConvolveMatrixEffect::setDivisor(qreal divisor)
 {
     m_divisor = divisor;
+    parametersChanged();
 }
 
 qreal ConvolveMatrixEffect::bias() const
@@ -92,6 +97,7 @@ qreal ConvolveMatrixEffect::bias() const
 void ConvolveMatrixEffect::setBias(qreal bias)
 {
     m_bias = bias;
+    parametersChanged();
 }
 
 QPoint ConvolveMatrixEffect::target() const
@@ -102,6 +108,7 @@ QPoint ConvolveMatrixEffect::target() const
 void ConvolveMatrixEffect::setTarget(const QPoint &target)
 {
     m_target = target;
+    parametersChanged();
 }
 
 ConvolveMatrixEffect::EdgeMode ConvolveMatrixEffect::edgeMode() const
@@ -112,6 +119,7 @@ ConvolveMatrixEffect::EdgeMode ConvolveMatrixEffect::edgeMode() const
 void ConvolveMatrixEffect::setEdgeMode(EdgeMode edgeMode)
 {
     m_edgeMode = edgeMode;
+    parametersChanged();
 }
 
 bool ConvolveMatrixEffect::isPreserveAlphaEnabled() const
@@ -141,11 +149,13 @@ QImage ConvolveMatrixEffect::processImage(const QImage &image, const KoFilterEff
 
     // setup mask
     const int maskSize = rx*ry;
-    QVector<QPoint> offset(maskSize);
+    QVector<int> offsetX(maskSize);
+    QVector<int> offsetY(maskSize);
     int index = 0;
     for (int y = 0; y < ry; ++y) {
         for (int x = 0; x < rx; ++x) {
-            offset[index] = QPoint(x-tx, y-ty);
+            offsetX[index] = x-tx;
+            offsetY[index] = y-ty;
             index++;
         }
     }
@@ -161,77 +171,26 @@ QImage ConvolveMatrixEffect::processImage(const QImage &image, const KoFilterEff
             divisor = 1.0;
     }
 
-    int dstPixel, srcPixel;
-    qreal sumA, sumR, sumG, sumB;
-    const QRgb * src = (const QRgb*)image.constBits();
-    QRgb * dst = (QRgb*)result.bits();
+    FilterEffectKernels::EdgeMode edgeMode = FilterEffectKernels::EdgeDuplicate;
+    switch (m_edgeMode) {
+    case Duplicate:
+        edgeMode = FilterEffectKernels::EdgeDuplicate;
+        break;
+    case Wrap:
+        edgeMode = FilterEffectKernels::EdgeWrap;
+        break;
+    case None:
+        edgeMode = FilterEffectKernels::EdgeNone;
+        break;
+    }
 
     const QRect roi = context.filterRegion().toRect();
-    const int minX = roi.left();
-    const int maxX = roi.right();
-    const int minY = roi.top();
-    const int maxY = roi.bottom();
-
-    int srcRow, srcCol;
-    for (int row = minY; row <= maxY; ++row) {
-        for (int col = minX; col <= maxX; ++col) {
-            dstPixel = row * w + col;
-            sumA = sumR = sumG = sumB = 0;
-            for (int i = 0; i < maskSize; ++i) {
-                srcRow = row + offset[i].y();
-                srcCol = col + offset[i].x();
-                // handle top and bottom edge
-                if (srcRow < 0 || srcRow >= h ) {
-                    switch(m_edgeMode) {
-                        case Duplicate:
-                            srcRow = srcRow >= h ? h-1 : 0;
-                            break;
-                        case Wrap:
-                            srcRow = (srcRow+h)%h;
-                            break;
-                        case None:
-                            // zero for all color channels
-                            continue;
-                            break;
-                    }
-                }
-                // handle left and right edge
-                if (srcCol < 0 || srcCol >= w) {
-                    switch(m_edgeMode) {
-                        case Duplicate:
-                            srcCol = srcCol >= w ? w-1 : 0;
-                            break;
-                        case Wrap:
-                            srcCol = (srcCol+w)%w;
-                            break;
-                        case None:
-                            // zero for all color channels
-                            continue;
-                            break;
-                    }
-                }
-                srcPixel = srcRow * w + srcCol;
-                const QRgb &s = src[srcPixel];
-                const qreal &k = m_kernel[i];
-                if (!m_preserveAlpha)
-                    sumA += qAlpha(s) * k;
-                sumR += qRed(s) * k;
-                sumG += qGreen(s) * k;
-                sumB += qBlue(s) * k;
-            }
-            if (m_preserveAlpha) {
-                dst[dstPixel] = qRgba( qBound(0, static_cast<int>(sumR / divisor + m_bias), 255),
-                                       qBound(0, static_cast<int>(sumG / divisor + m_bias), 255),
-                                       qBound(0, static_cast<int>(sumB / divisor + m_bias), 255),
-                                       qAlpha(dst[dstPixel]));
-            } else {
-                dst[dstPixel] = qRgba( qBound(0, static_cast<int>(sumR / divisor + m_bias), 255),
-                                       qBound(0, static_cast<int>(sumG / divisor + m_bias), 255),
-                                       qBound(0, static_cast<int>(sumB / divisor + m_bias), 255),
-                                       qBound(0, static_cast<int>(sumA / divisor + m_bias), 255));
-            }
-        }
-    }
+    FilterEffectKernels::instance()->convolve(reinterpret_cast<const quint32*>(image.constBits()),
+                                              reinterpret_cast<quint32*>(result.bits()),
+                                              w, h, roi.left(), roi.right() + 1, roi.top(), roi.bottom() + 1,
+                                              offsetX.constData(), offsetY.constData(), m_kernel.constData(),
+                                              qMin(maskSize, m_kernel.count()),
+                                              divisor, m_bias, edgeMode, m_preserveAlpha);
 
     return result;
 }
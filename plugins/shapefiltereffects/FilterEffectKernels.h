@@ -0,0 +1,131 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef FILTEREFFECTKERNELS_H
+#define FILTEREFFECTKERNELS_H
+
+#include <QtGlobal>
+
+/**
+ * The pixel loops of the filter effects.
+ *
+ * The loops work on ARGB32 premultiplied pixels and are written so the
+ * compiler can vectorize them. In a packagers build they are compiled once
+ * for each instruction set Vc supports, and instance() picks the best one
+ * the CPU runs; otherwise they are compiled for the architecture of the
+ * build. All implementations give exactly the same pixels as the scalar
+ * code of the effects did.
+ *
+ * Regions are given as half open ranges of columns [x0, x1) and rows
+ * [y0, y1), which have to lie inside the image.
+ */
+class FilterEffectKernels
+{
+public:
+    /// How pixels outside of the image are read by convolve()
+    enum EdgeMode {
+        EdgeDuplicate, ///< the nearest pixel of the image is used
+        EdgeWrap,      ///< the pixel from the opposite side of the image is used
+        EdgeNone       ///< the pixel is left out
+    };
+
+    /// A transfer function of componentTransfer()
+    struct TransferFunction {
+        enum Type {
+            Identity,
+            Table,
+            Discrete,
+            Linear,
+            Gamma
+        };
+
+        TransferFunction()
+            : type(Identity), table(0), tableSize(0), slope(1), intercept(0),
+              amplitude(1), exponent(1), offset(0) {}
+
+        Type type;
+        const qreal *table; ///< the values of Table and Discrete
+        int tableSize;
+        qreal slope;
+        qreal intercept;
+        qreal amplitude;
+        qreal exponent;
+        qreal offset;
+    };
+
+    virtual ~FilterEffectKernels() {}
+
+    /// @return the kernels for the CPU the program runs on
+    static const FilterEffectKernels *instance();
+
+    /// @return the name of the instruction set the kernels of instance() were compiled for
+    virtual const char *implementationName() const = 0;
+
+    /**
+     * Blurs all pixels of an image in place with a stack blur of @p radius,
+     * which approximates a gaussian blur with a standard deviation of about
+     * @p radius / 2.
+     */
+    virtual void stackBlur(quint32 *pixels, int width, int height, int radius) const = 0;
+
+    /**
+     * Erodes (takes the minimum) or dilates (takes the maximum) each channel
+     * over a rectangle of (2 * @p radiusX + 1) x (2 * @p radiusY + 1) pixels.
+     * The rectangles around the pixels of the region have to lie inside the
+     * image; @p dst is not touched outside the region.
+     */
+    virtual void morphology(const quint32 *src, quint32 *dst, int width,
+                            int x0, int x1, int y0, int y1,
+                            int radiusX, int radiusY, bool erode) const = 0;
+
+    /**
+     * Applies the 5x4 color @p matrix, in row order, to the non-premultiplied
+     * colors of the pixels of the region.
+     */
+    virtual void colorMatrix(const quint32 *src, quint32 *dst, int width,
+                             int x0, int x1, int y0, int y1, const qreal *matrix) const = 0;
+
+    /**
+     * Composites @p src onto @p dst in the region with the arithmetic operator
+     * k1 * s * d + k2 * d + k3 * s + k4, where @p k holds k1 to k4.
+     */
+    virtual void arithmeticComposite(const quint32 *src, quint32 *dst, int width,
+                                     int x0, int x1, int y0, int y1, const qreal *k) const = 0;
+
+    /**
+     * Convolves the pixels of the region with a kernel of @p count values.
+     * Each value is applied to the pixel at the offset (@p offsetX[i], @p offsetY[i]).
+     * The sums are divided by @p divisor and @p bias is added to them; with
+     * @p preserveAlpha the alpha channel of @p dst is kept.
+     */
+    virtual void convolve(const quint32 *src, quint32 *dst, int width, int height,
+                          int x0, int x1, int y0, int y1,
+                          const int *offsetX, const int *offsetY, const qreal *kernel, int count,
+                          qreal divisor, qreal bias, EdgeMode edgeMode, bool preserveAlpha) const = 0;
+
+    /**
+     * Applies a transfer function to each channel of the non-premultiplied
+     * colors of the pixels of the region.
+     * @param functions the functions for red, green, blue and alpha
+     */
+    virtual void componentTransfer(const quint32 *src, quint32 *dst, int width,
+                                   int x0, int x1, int y0, int y1,
+                                   const TransferFunction *functions) const = 0;
+};
+
+#endif // FILTEREFFECTKERNELS_H
@@ -0,0 +1,535 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#if !defined _MSC_VER
+#pragma GCC diagnostic ignored "-Wundef"
+#endif
+
+#include "FilterEffectKernelsPerArch.h"
+#include "FilterEffectKernels.h"
+#include "ColorChannelConversion.h"
+
+#include <QVector>
+#include <QColor>
+
+#include <string.h>
+#include <math.h>
+
+/*
+ * This file is compiled once for every instruction set, so everything but the
+ * factory method lives in an anonymous namespace or in a class templated on
+ * the implementation.
+ *
+ * The loops are written for the auto-vectorizer: they walk over plain arrays
+ * without branches or calls in the inner loop, and they do the same integer
+ * and floating point operations in the same order as the scalar code of the
+ * effects did, so every implementation gives the same pixels.
+ */
+
+namespace {
+
+/**
+ * Divides the non-negative @p sums by @p divisor, rounding down like the
+ * integer division does. As long as the sums are below 2^24 the division is
+ * done with a float multiplication, which is at most one off, and then fixed.
+ */
+void divide(const int *sums, int *quotients, int count, int divisor)
+{
+    if (divisor > (1 << 24) / 256) {
+        for (int i = 0; i < count; ++i)
+            quotients[i] = sums[i] / divisor;
+        return;
+    }
+
+    const float inverse = 1.0f / divisor;
+    for (int i = 0; i < count; ++i) {
+        int quotient = static_cast<int>(static_cast<float>(sums[i]) * inverse);
+        quotient -= quotient * divisor > sums[i];
+        quotient += (quotient + 1) * divisor <= sums[i];
+        quotients[i] = quotient;
+    }
+}
+
+/**
+ * One pass of the stack blur. Each of the @p columns of @p src, which has
+ * @p rows rows, is blurred along the rows into @p dst. All columns move along
+ * together, so the inner loops run over the columns.
+ */
+void stackBlurColumns(const int *src, int *dst, int rows, int columns, int radius)
+{
+    const int div = 2 * radius + 1;
+    const int r1 = radius + 1;
+    const int divisor = r1 * r1;
+    const int lastRow = rows - 1;
+
+    // the stack of the last div rows, followed by the running sums
+    QVector<int> buffer((div + 3) * columns, 0);
+    int *stack = buffer.data();
+    int *sum = stack + div * columns;
+    int *inSum = sum + columns;
+    int *outSum = inSum + columns;
+
+    for (int i = -radius; i <= radius; ++i) {
+        const int *row = src + qBound(0, i, lastRow) * columns;
+        int *slot = stack + (i + radius) * columns;
+        int *side = i > 0 ? inSum : outSum;
+        const int weight = r1 - qAbs(i);
+        for (int x = 0; x < columns; ++x) {
+            slot[x] = row[x];
+            sum[x] += row[x] * weight;
+            side[x] += row[x];
+        }
+    }
+
+    int stackPointer = radius;
+    for (int y = 0; y < rows; ++y) {
+        divide(sum, dst + y * columns, columns, divisor);
+
+        const int *incoming = src + qMin(y + r1, lastRow) * columns;
+        int *oldest = stack + ((stackPointer + r1) % div) * columns;
+        stackPointer = (stackPointer + 1) % div;
+        const int *next = stack + stackPointer * columns;
+        for (int x = 0; x < columns; ++x) {
+            sum[x] -= outSum[x];
+            outSum[x] -= oldest[x];
+            oldest[x] = incoming[x];
+            inSum[x] += incoming[x];
+            sum[x] += inSum[x];
+            outSum[x] += next[x];
+            inSum[x] -= next[x];
+        }
+    }
+}
+
+template<bool erode>
+inline uchar extreme(uchar a, uchar b)
+{
+    return erode ? qMin(a, b) : qMax(a, b);
+}
+
+/**
+ * Morphology as two separable passes: the extremes over the rows go to a
+ * buffer, the extremes over the columns of that buffer to @p dst. The
+ * channels are handled as independent bytes.
+ */
+template<bool erode>
+void morphologyPasses(const uchar *src, uchar *dst, int width,
+                      int x0, int x1, int y0, int y1, int radiusX, int radiusY)
+{
+    const int stride = 4 * width;
+    const int span = 4 * (x1 - x0);
+    const int rows = y1 - y0 + 2 * radiusY;
+
+    QVector<uchar> horizontal(rows * span);
+    for (int row = 0; row < rows; ++row) {
+        const uchar *line = src + (y0 - radiusY + row) * stride + 4 * x0;
+        uchar *h = horizontal.data() + row * span;
+        memcpy(h, line - 4 * radiusX, span);
+        for (int dx = -radiusX + 1; dx <= radiusX; ++dx) {
+            const uchar *shifted = line + 4 * dx;
+            for (int i = 0; i < span; ++i)
+                h[i] = extreme<erode>(h[i], shifted[i]);
+        }
+    }
+
+    for (int row = y0; row < y1; ++row) {
+        uchar *d = dst + row * stride + 4 * x0;
+        const uchar *h = horizontal.constData() + (row - y0) * span;
+        memcpy(d, h, span);
+        for (int dy = 1; dy <= 2 * radiusY; ++dy) {
+            const uchar *shifted = h + dy * span;
+            for (int i = 0; i < span; ++i)
+                d[i] = extreme<erode>(d[i], shifted[i]);
+        }
+    }
+}
+
+/// @return the pixel of non-premultiplied colors and of @p alpha in [0..255]
+inline quint32 premultipliedPixel(qreal red, qreal green, qreal blue, qreal alpha)
+{
+    return qRgba(static_cast<quint8>(qBound(qreal(0.0), red * alpha, qreal(255.0))),
+                 static_cast<quint8>(qBound(qreal(0.0), green * alpha, qreal(255.0))),
+                 static_cast<quint8>(qBound(qreal(0.0), blue * alpha, qreal(255.0))),
+                 static_cast<quint8>(qBound(qreal(0.0), alpha, qreal(255.0))));
+}
+
+inline int convolvedChannel(qreal sum, qreal divisor, qreal bias)
+{
+    return qBound(0, static_cast<int>(sum / divisor + bias), 255);
+}
+
+/// the table index of @p value, kept inside the table for colors that were not premultiplied correctly
+inline int tableIndex(qreal value, int tableSize)
+{
+    return qBound(0, static_cast<int>(value), tableSize - 1);
+}
+
+void transfer(const FilterEffectKernels::TransferFunction &function,
+              const qreal *values, qreal *results, int count)
+{
+    typedef FilterEffectKernels::TransferFunction TransferFunction;
+
+    const int tableSize = function.tableSize;
+    const qreal valueCount = tableSize - 1;
+    const qreal *table = function.table;
+
+    switch (function.type) {
+    case TransferFunction::Table:
+        if (valueCount < 0.0)
+            break;
+        for (int i = 0; i < count; ++i) {
+            const qreal value = values[i];
+            const qreal k1 = static_cast<int>(value * valueCount);
+            const qreal k2 = qMin(k1 + 1, valueCount);
+            const qreal vk1 = table[tableIndex(k1, tableSize)];
+            const qreal vk2 = table[tableIndex(k2, tableSize)];
+            results[i] = vk1 + (value - static_cast<qreal>(k1) / valueCount) * valueCount * (vk2 - vk1);
+        }
+        return;
+    case TransferFunction::Discrete:
+        if (valueCount < 0.0)
+            break;
+        for (int i = 0; i < count; ++i)
+            results[i] = table[tableIndex(values[i] * valueCount, tableSize)];
+        return;
+    case TransferFunction::Linear:
+        for (int i = 0; i < count; ++i)
+            results[i] = function.slope * values[i] + function.intercept;
+        return;
+    case TransferFunction::Gamma:
+        for (int i = 0; i < count; ++i)
+            results[i] = function.amplitude * pow(values[i], function.exponent) + function.offset;
+        return;
+    case TransferFunction::Identity:
+        break;
+    }
+
+    memcpy(results, values, count * sizeof(qreal));
+}
+
+template<Vc::Implementation _impl>
+class FilterEffectKernelsImpl : public FilterEffectKernels
+{
+public:
+    virtual const char *implementationName() const;
+
+    virtual void stackBlur(quint32 *pixels, int width, int height, int radius) const;
+
+    virtual void morphology(const quint32 *src, quint32 *dst, int width,
+                            int x0, int x1, int y0, int y1,
+                            int radiusX, int radiusY, bool erode) const;
+
+    virtual void colorMatrix(const quint32 *src, quint32 *dst, int width,
+                             int x0, int x1, int y0, int y1, const qreal *matrix) const;
+
+    virtual void arithmeticComposite(const quint32 *src, quint32 *dst, int width,
+                                     int x0, int x1, int y0, int y1, const qreal *k) const;
+
+    virtual void convolve(const quint32 *src, quint32 *dst, int width, int height,
+                          int x0, int x1, int y0, int y1,
+                          const int *offsetX, const int *offsetY, const qreal *kernel, int count,
+                          qreal divisor, qreal bias, EdgeMode edgeMode, bool preserveAlpha) const;
+
+    virtual void componentTransfer(const quint32 *src, quint32 *dst, int width,
+                                   int x0, int x1, int y0, int y1,
+                                   const TransferFunction *functions) const;
+};
+
+template<Vc::Implementation _impl>
+const char *FilterEffectKernelsImpl<_impl>::implementationName() const
+{
+#ifdef HAVE_VC
+    switch (_impl) {
+    case Vc::SSE2Impl:
+        return "SSE2";
+    case Vc::SSE3Impl:
+        return "SSE3";
+    case Vc::SSSE3Impl:
+        return "SSSE3";
+    case Vc::SSE41Impl:
+        return "SSE4.1";
+    case Vc::SSE42Impl:
+        return "SSE4.2";
+    case Vc::AVXImpl:
+        return "AVX";
+    case Vc::AVX2Impl:
+        return "AVX2";
+    default:
+        break;
+    }
+#endif
+    return "Scalar";
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::stackBlur(quint32 *pixels, int width, int height, int radius) const
+{
+    if (radius < 1 || width < 1 || height < 1)
+        return;
+
+    const int count = width * height;
+    QVector<int> channel(count);
+    QVector<int> blurred(count);
+
+    // the channels are blurred one after the other; each is first blurred
+    // horizontally in a transposed copy and then vertically
+    for (int shift = 0; shift < 32; shift += 8) {
+        int *transposed = channel.data();
+        for (int y = 0; y < height; ++y) {
+            const quint32 *line = pixels + y * width;
+            for (int x = 0; x < width; ++x)
+                transposed[x * height + y] = (line[x] >> shift) & 0xff;
+        }
+        stackBlurColumns(transposed, blurred.data(), width, height, radius);
+
+        int *plane = channel.data();
+        const int *blurredTransposed = blurred.constData();
+        for (int y = 0; y < height; ++y) {
+            int *line = plane + y * width;
+            for (int x = 0; x < width; ++x)
+                line[x] = blurredTransposed[x * height + y];
+        }
+        stackBlurColumns(plane, blurred.data(), height, width, radius);
+
+        const quint32 mask = ~(0xffu << shift);
+        const int *values = blurred.constData();
+        for (int i = 0; i < count; ++i)
+            pixels[i] = (pixels[i] & mask) | (quint32(values[i]) << shift);
+    }
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::morphology(const quint32 *src, quint32 *dst, int width,
+                                                int x0, int x1, int y0, int y1,
+                                                int radiusX, int radiusY, bool erode) const
+{
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const uchar *srcBytes = reinterpret_cast<const uchar*>(src);
+    uchar *dstBytes = reinterpret_cast<uchar*>(dst);
+    if (erode)
+        morphologyPasses<true>(srcBytes, dstBytes, width, x0, x1, y0, y1, radiusX, radiusY);
+    else
+        morphologyPasses<false>(srcBytes, dstBytes, width, x0, x1, y0, y1, radiusX, radiusY);
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::colorMatrix(const quint32 *src, quint32 *dst, int width,
+                                                 int x0, int x1, int y0, int y1, const qreal *m) const
+{
+    for (int row = y0; row < y1; ++row) {
+        const quint32 *s = src + row * width;
+        quint32 *d = dst + row * width;
+        for (int col = x0; col < x1; ++col) {
+            const quint32 pixel = s[col];
+            const qreal sa = fromIntColor[qAlpha(pixel)];
+            // the matrix is applied to non-premultiplied color values; dividing
+            // by one instead of branching leaves the other colors unchanged
+            const qreal divisor = sa > 0.0 && sa < 1.0 ? sa : qreal(1.0);
+            const qreal sr = fromIntColor[qRed(pixel)] / divisor;
+            const qreal sg = fromIntColor[qGreen(pixel)] / divisor;
+            const qreal sb = fromIntColor[qBlue(pixel)] / divisor;
+
+            const qreal dr = m[ 0] * sr + m[ 1] * sg + m[ 2] * sb + m[ 3] * sa + m[ 4];
+            const qreal dg = m[ 5] * sr + m[ 6] * sg + m[ 7] * sb + m[ 8] * sa + m[ 9];
+            const qreal db = m[10] * sr + m[11] * sg + m[12] * sb + m[13] * sa + m[14];
+            const qreal da = m[15] * sr + m[16] * sg + m[17] * sb + m[18] * sa + m[19];
+
+            d[col] = premultipliedPixel(dr, dg, db, da * 255.0);
+        }
+    }
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::arithmeticComposite(const quint32 *src, quint32 *dst, int width,
+                                                         int x0, int x1, int y0, int y1, const qreal *k) const
+{
+    for (int row = y0; row < y1; ++row) {
+        const quint32 *s = src + row * width;
+        quint32 *d = dst + row * width;
+        for (int col = x0; col < x1; ++col) {
+            const quint32 source = s[col];
+            const quint32 destination = d[col];
+
+            const qreal sa = fromIntColor[qAlpha(source)];
+            const qreal sr = fromIntColor[qRed(source)];
+            const qreal sg = fromIntColor[qGreen(source)];
+            const qreal sb = fromIntColor[qBlue(source)];
+
+            qreal da = fromIntColor[qAlpha(destination)];
+            qreal dr = fromIntColor[qRed(destination)];
+            qreal dg = fromIntColor[qGreen(destination)];
+            qreal db = fromIntColor[qBlue(destination)];
+
+            da = k[0] * sa * da + k[1] * da + k[2] * sa + k[3];
+            dr = k[0] * sr * dr + k[1] * dr + k[2] * sr + k[3];
+            dg = k[0] * sg * dg + k[1] * dg + k[2] * sg + k[3];
+            db = k[0] * sb * db + k[1] * db + k[2] * sb + k[3];
+
+            d[col] = premultipliedPixel(dr, dg, db, da * 255.0);
+        }
+    }
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::convolve(const quint32 *src, quint32 *dst, int width, int height,
+                                              int x0, int x1, int y0, int y1,
+                                              const int *offsetX, const int *offsetY, const qreal *kernel, int count,
+                                              qreal divisor, qreal bias, EdgeMode edgeMode, bool preserveAlpha) const
+{
+    if (x0 >= x1 || y0 >= y1 || count < 1)
+        return;
+
+    int minOffsetX = offsetX[0], maxOffsetX = offsetX[0];
+    int minOffsetY = offsetY[0], maxOffsetY = offsetY[0];
+    for (int i = 1; i < count; ++i) {
+        minOffsetX = qMin(minOffsetX, offsetX[i]);
+        maxOffsetX = qMax(maxOffsetX, offsetX[i]);
+        minOffsetY = qMin(minOffsetY, offsetY[i]);
+        maxOffsetY = qMax(maxOffsetY, offsetY[i]);
+    }
+
+    // the columns whose kernel lies inside the image in all rows
+    const int innerX0 = qBound(x0, -minOffsetX, x1);
+    const int innerX1 = qBound(innerX0, width - maxOffsetX, x1);
+
+    const int span = x1 - x0;
+    QVector<qreal> sums(4 * span);
+    qreal *sumR = sums.data();
+    qreal *sumG = sumR + span;
+    qreal *sumB = sumG + span;
+    qreal *sumA = sumB + span;
+
+    for (int row = y0; row < y1; ++row) {
+        quint32 *d = dst + row * width;
+        const bool innerRow = row + minOffsetY >= 0 && row + maxOffsetY < height;
+        const int scalarX1 = innerRow ? innerX0 : x1;
+        const int scalarX0 = innerRow ? innerX1 : x1;
+
+        if (innerRow && innerX0 < innerX1) {
+            // the taps go in the outer loop, so each sum is accumulated in
+            // the same order as in the scalar code below
+            sums.fill(0.0);
+            for (int i = 0; i < count; ++i) {
+                const quint32 *line = src + (row + offsetY[i]) * width;
+                const int shift = offsetX[i];
+                const qreal k = kernel[i];
+                for (int col = innerX0; col < innerX1; ++col) {
+                    const quint32 s = line[col + shift];
+                    const int index = col - x0;
+                    sumA[index] += qAlpha(s) * k;
+                    sumR[index] += qRed(s) * k;
+                    sumG[index] += qGreen(s) * k;
+                    sumB[index] += qBlue(s) * k;
+                }
+            }
+            for (int col = innerX0; col < innerX1; ++col) {
+                const int index = col - x0;
+                const int alpha = preserveAlpha ? qAlpha(d[col]) : convolvedChannel(sumA[index], divisor, bias);
+                d[col] = qRgba(convolvedChannel(sumR[index], divisor, bias),
+                               convolvedChannel(sumG[index], divisor, bias),
+                               convolvedChannel(sumB[index], divisor, bias),
+                               alpha);
+            }
+        }
+
+        // the pixels near the edges, one at a time
+        for (int col = x0; col < x1; ++col) {
+            if (col == scalarX1)
+                col = scalarX0;
+            if (col >= x1)
+                break;
+
+            qreal a = 0, r = 0, g = 0, b = 0;
+            for (int i = 0; i < count; ++i) {
+                int srcRow = row + offsetY[i];
+                int srcCol = col + offsetX[i];
+                if (srcRow < 0 || srcRow >= height) {
+                    if (edgeMode == EdgeNone)
+                        continue;
+                    srcRow = edgeMode == EdgeWrap ? (srcRow + height) % height : (srcRow >= height ? height - 1 : 0);
+                }
+                if (srcCol < 0 || srcCol >= width) {
+                    if (edgeMode == EdgeNone)
+                        continue;
+                    srcCol = edgeMode == EdgeWrap ? (srcCol + width) % width : (srcCol >= width ? width - 1 : 0);
+                }
+                const quint32 s = src[srcRow * width + srcCol];
+                const qreal k = kernel[i];
+                a += qAlpha(s) * k;
+                r += qRed(s) * k;
+                g += qGreen(s) * k;
+                b += qBlue(s) * k;
+            }
+            const int alpha = preserveAlpha ? qAlpha(d[col]) : convolvedChannel(a, divisor, bias);
+            d[col] = qRgba(convolvedChannel(r, divisor, bias),
+                           convolvedChannel(g, divisor, bias),
+                           convolvedChannel(b, divisor, bias),
+                           alpha);
+        }
+    }
+}
+
+template<Vc::Implementation _impl>
+void FilterEffectKernelsImpl<_impl>::componentTransfer(const quint32 *src, quint32 *dst, int width,
+                                                       int x0, int x1, int y0, int y1,
+                                                       const TransferFunction *functions) const
+{
+    if (x0 >= x1)
+        return;
+
+    // one row of each channel, first the source values then the results
+    const int span = x1 - x0;
+    QVector<qreal> buffer(8 * span);
+    qreal *values = buffer.data();
+    qreal *results = values + 4 * span;
+
+    for (int row = y0; row < y1; ++row) {
+        const quint32 *s = src + row * width + x0;
+        quint32 *d = dst + row * width + x0;
+
+        for (int i = 0; i < span; ++i) {
+            const quint32 pixel = s[i];
+            const qreal sa = fromIntColor[qAlpha(pixel)];
+            // the functions work on non-premultiplied color values
+            const qreal divisor = sa > 0.0 && sa < 1.0 ? sa : qreal(1.0);
+            values[i] = fromIntColor[qRed(pixel)] / divisor;
+            values[span + i] = fromIntColor[qGreen(pixel)] / divisor;
+            values[2 * span + i] = fromIntColor[qBlue(pixel)] / divisor;
+            values[3 * span + i] = sa;
+        }
+
+        for (int channel = 0; channel < 4; ++channel)
+            transfer(functions[channel], values + channel * span, results + channel * span, span);
+
+        for (int i = 0; i < span; ++i) {
+            d[i] = premultipliedPixel(results[i], results[span + i], results[2 * span + i],
+                                      results[3 * span + i] * 255.0);
+        }
+    }
+}
+
+}
+
+template<>
+FilterEffectKernelsFactory::ReturnType
+FilterEffectKernelsFactory::create<Vc::CurrentImplementation::current()>(ParamType)
+{
+    return new FilterEffectKernelsImpl<Vc::CurrentImplementation::current()>();
+}
@@ -39,6 +39,7 @@ QColor FloodEffect::floodColor() const
 void FloodEffect::setFloodColor(const QColor &color)
 {
     m_color = color;
+    parametersChanged();
 }
 
 QImage FloodEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
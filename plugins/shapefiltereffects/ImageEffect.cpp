@@ -49,6 +49,7 @@ QImage ImageEffect::image() const
 void ImageEffect::setImage(const QImage &image)
 {
     m_image = image;
+    parametersChanged();
 }
 
 QImage ImageEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
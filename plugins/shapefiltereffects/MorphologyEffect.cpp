@@ -18,6 +18,7 @@
  */
 
 #include "MorphologyEffect.h"
+#include "FilterEffectKernels.h"
 #include "KoFilterEffectRenderContext.h"
 #include "KoFilterEffectLoadingContext.h"
 #include "KoViewConverter.h"
@@ -42,6 +43,7 @@ QPointF MorphologyEffect::morphologyRadius() const
 void MorphologyEffect::setMorphologyRadius(const QPointF &radius)
 {
     m_radius = radius;
+    parametersChanged();
 }
 
 MorphologyEffect::Operator MorphologyEffect::morphologyOperator() const
@@ -52,6 +54,7 @@ MorphologyEffect::Operator MorphologyEffect::morphologyOperator() const
 void MorphologyEffect::setMorphologyOperator(Operator op)
 {
     m_operator = op;
+    parametersChanged();
 }
 
 QImage MorphologyEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
@@ -66,59 +69,15 @@ QImage MorphologyEffect::processImage(const QImage &image, const KoFilterEffectR
     const int w = result.width();
     const int h = result.height();
 
-    // setup mask
-    const int maskSize = (1+2*rx)*(1+2*ry);
-    int * mask = new int[maskSize];
-    int index = 0;
-    for (int y = -ry; y <= ry; ++y) {
-        for (int x = -rx; x <= rx; ++x) {
-            mask[index] = y*w+x;
-            index++;
-        }
-    }
-
-    int dstPixel, srcPixel;
-    uchar s0, s1, s2, s3;
-    const uchar * src = image.constBits();
-    uchar * dst = result.bits();
-
     const QRect roi = context.filterRegion().toRect();
     const int minX = qMax(rx, roi.left());
     const int maxX = qMin(w-rx, roi.right());
     const int minY = qMax(ry, roi.top());
     const int maxY = qMin(h-ry, roi.bottom());
-    const int defValue = m_operator == Erode ? 255 : 0;
-
-    uchar * d = 0;
-
-    for (int row = minY; row < maxY; ++row) {
-        for (int col = minX; col < maxX; ++col) {
-            dstPixel = row * w + col;
-            s0 = s1 = s2 = s3 = defValue;
-            for (int i = 0; i < maskSize; ++i) {
-                srcPixel = dstPixel+mask[i];
-                const uchar *s = &src[4*srcPixel];
-                if (m_operator == Erode ) {
-                    s0 = qMin(s0, s[0]);
-                    s1 = qMin(s1, s[1]);
-                    s2 = qMin(s2, s[2]);
-                    s3 = qMin(s3, s[3]);
-                } else {
-                    s0 = qMax(s0, s[0]);
-                    s1 = qMax(s1, s[1]);
-                    s2 = qMax(s2, s[2]);
-                    s3 = qMax(s3, s[3]);
-                }
-            }
-            d = &dst[4*dstPixel];
-            d[0] = s0;
-            d[1] = s1;
-            d[2] = s2;
-            d[3] = s3;
-        }
-    }
 
-    delete [] mask;
+    FilterEffectKernels::instance()->morphology(reinterpret_cast<const quint32*>(image.constBits()),
+                                                reinterpret_cast<quint32*>(result.bits()), w,
+                                                minX, maxX, minY, maxY, rx, ry, m_operator == Erode);
 
     return result;
 }
@@ -40,6 +40,7 @@ QPointF OffsetEffect::offset() const
 void OffsetEffect::setOffset(const QPointF &offset)
 {
     m_offset = offset;
+    parametersChanged();
 }
 
 QImage OffsetEffect::processImage(const QImage &image, const KoFilterEffectRenderContext &context) const
@@ -0,0 +1,116 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "FilterEffectKernelsBenchmark.h"
+
+#include "FilterEffectKernels.h"
+
+#include <QColor>
+#include <QDebug>
+#include <QTest>
+
+const int IMG_WIDTH = 1024;
+const int IMG_HEIGHT = 1024;
+
+void FilterEffectKernelsBenchmark::initTestCase()
+{
+    qDebug() << "Kernels compiled for" << FilterEffectKernels::instance()->implementationName();
+
+    m_src.resize(IMG_WIDTH * IMG_HEIGHT);
+    uint state = 42;
+    for (int i = 0; i < m_src.count(); ++i) {
+        state = state * 1103515245u + 12345u;
+        const int alpha = (state >> 8) & 0xff;
+        m_src[i] = qRgba((state >> 16) % (alpha + 1), (state >> 20) % (alpha + 1), (state >> 4) % (alpha + 1), alpha);
+    }
+    m_dst = m_src;
+}
+
+void FilterEffectKernelsBenchmark::benchmarkStackBlur()
+{
+    QBENCHMARK {
+        FilterEffectKernels::instance()->stackBlur(m_dst.data(), IMG_WIDTH, IMG_HEIGHT, 10);
+    }
+}
+
+void FilterEffectKernelsBenchmark::benchmarkMorphology()
+{
+    QBENCHMARK {
+        FilterEffectKernels::instance()->morphology(m_src.constData(), m_dst.data(), IMG_WIDTH,
+                                                    5, IMG_WIDTH - 5, 5, IMG_HEIGHT - 5, 5, 5, true);
+    }
+}
+
+void FilterEffectKernelsBenchmark::benchmarkColorMatrix()
+{
+    // a saturation of 0.5
+    const qreal matrix[20] = {
+        0.6063, 0.3576, 0.0361, 0, 0,
+        0.1063, 0.8576, 0.0361, 0, 0,
+        0.1063, 0.3576, 0.5361, 0, 0,
+        0,      0,      0,      1, 0
+    };
+    QBENCHMARK {
+        FilterEffectKernels::instance()->colorMatrix(m_src.constData(), m_dst.data(), IMG_WIDTH,
+                                                     0, IMG_WIDTH, 0, IMG_HEIGHT, matrix);
+    }
+}
+
+void FilterEffectKernelsBenchmark::benchmarkArithmeticComposite()
+{
+    const qreal k[4] = { 0.5, 0.25, 0.25, 0.0 };
+    QBENCHMARK {
+        FilterEffectKernels::instance()->arithmeticComposite(m_src.constData(), m_dst.data(), IMG_WIDTH,
+                                                             0, IMG_WIDTH, 0, IMG_HEIGHT, k);
+    }
+}
+
+void FilterEffectKernelsBenchmark::benchmarkConvolve()
+{
+    // a 3x3 sharpen kernel centered on the pixel
+    const int offsetX[9] = { -1, 0, 1, -1, 0, 1, -1, 0, 1 };
+    const int offsetY[9] = { -1, -1, -1, 0, 0, 0, 1, 1, 1 };
+    const qreal kernel[9] = { 0, -1, 0, -1, 5, -1, 0, -1, 0 };
+    QBENCHMARK {
+        FilterEffectKernels::instance()->convolve(m_src.constData(), m_dst.data(), IMG_WIDTH, IMG_HEIGHT,
+                                                  0, IMG_WIDTH, 0, IMG_HEIGHT,
+                                                  offsetX, offsetY, kernel, 9, 1.0, 0.0,
+                                                  FilterEffectKernels::EdgeDuplicate, false);
+    }
+}
+
+void FilterEffectKernelsBenchmark::benchmarkComponentTransfer()
+{
+    const qreal table[5] = { 0.0, 0.5, 0.6, 0.8, 1.0 };
+    FilterEffectKernels::TransferFunction functions[4];
+    functions[0].type = FilterEffectKernels::TransferFunction::Table;
+    functions[0].table = table;
+    functions[0].tableSize = 5;
+    functions[1].type = FilterEffectKernels::TransferFunction::Linear;
+    functions[1].slope = 0.8;
+    functions[1].intercept = 0.1;
+    functions[2].type = FilterEffectKernels::TransferFunction::Discrete;
+    functions[2].table = table;
+    functions[2].tableSize = 5;
+    QBENCHMARK {
+        FilterEffectKernels::instance()->componentTransfer(m_src.constData(), m_dst.data(), IMG_WIDTH,
+                                                           0, IMG_WIDTH, 0, IMG_HEIGHT, functions);
+    }
+}
+
+QTEST_GUILESS_MAIN(FilterEffectKernelsBenchmark)
@@ -0,0 +1,855 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestFilterEffectKernels.h"
+
+#include "FilterEffectKernels.h"
+#include "ColorChannelConversion.h"
+#include "ConvolveMatrixEffect.h"
+
+#include <KoFilterEffectRenderContext.h>
+#include <KoViewConverter.h>
+
+#include <QColor>
+#include <QImage>
+#include <QVector>
+#include <QTest>
+
+#include <math.h>
+#include <string.h>
+
+typedef FilterEffectKernels::TransferFunction TransferFunction;
+
+namespace {
+
+/// a small random generator, so the test images are the same on all platforms
+class Random
+{
+public:
+    explicit Random(uint seed) : m_state(seed) {}
+
+    int number(int max)
+    {
+        m_state = m_state * 1103515245u + 12345u;
+        return (m_state >> 8) % (max + 1);
+    }
+
+    qreal real(qreal min, qreal max)
+    {
+        return min + (max - min) * number(10000) / 10000.0;
+    }
+
+private:
+    uint m_state;
+};
+
+/// @return premultiplied pixels, with a good share of transparent and opaque ones
+QVector<quint32> randomPixels(int width, int height, uint seed)
+{
+    Random random(seed);
+    QVector<quint32> pixels(width * height);
+    for (int i = 0; i < pixels.count(); ++i) {
+        int alpha = random.number(255);
+        if (alpha < 32)
+            alpha = 0;
+        else if (alpha > 192)
+            alpha = 255;
+        pixels[i] = qRgba(random.number(alpha), random.number(alpha), random.number(alpha), alpha);
+    }
+    return pixels;
+}
+
+/// @return horizontal stripes of random colors, whose inner pixels give sums that divide without a rest
+QVector<quint32> stripedPixels(int width, int height, int stripeHeight, uint seed)
+{
+    const QVector<quint32> colors = randomPixels(1, height / stripeHeight + 1, seed);
+    QVector<quint32> pixels(width * height);
+    for (int i = 0; i < pixels.count(); ++i)
+        pixels[i] = colors[i / width / stripeHeight];
+    return pixels;
+}
+
+/*
+ * The loops of the effects before the kernels were added, as the reference.
+ */
+
+void referenceStackBlur(quint32 *pix, int w, int h, int radius)
+{
+    if (radius < 1) {
+        return;
+    }
+
+    int wm  = w - 1;
+    int hm  = h - 1;
+    int wh  = w * h;
+    int div = radius + radius + 1;
+
+    int *r = new int[wh];
+    int *g = new int[wh];
+    int *b = new int[wh];
+    int *a = new int[wh];
+    int rsum, gsum, bsum, asum, x, y, i, yp, yi, yw;
+    QRgb p;
+    int *vmin = new int[qMax(w, h)];
+
+    int divsum = (div + 1) >> 1;
+    divsum *= divsum;
+    int *dv = new int[256*divsum];
+    for (i = 0; i < 256*divsum; ++i) {
+        dv[i] = (i / divsum);
+    }
+
+    yw = yi = 0;
+
+    int **stack = new int*[div];
+    for (int i = 0; i < div; ++i) {
+        stack[i] = new int[4];
+    }
+
+    int stackpointer;
+    int stackstart;
+    int *sir;
+    int rbs;
+    int r1 = radius + 1;
+    int routsum, goutsum, boutsum, aoutsum;
+    int rinsum, ginsum, binsum, ainsum;
+
+    for (y = 0; y < h; ++y) {
+        rinsum = ginsum = binsum = ainsum = routsum = goutsum = boutsum = aoutsum = rsum = gsum = bsum = asum = 0;
+        for (i = - radius; i <= radius; ++i) {
+            p = pix[yi+qMin(wm, qMax(i, 0))];
+            sir = stack[i+radius];
+            sir[0] = qRed(p);
+            sir[1] = qGreen(p);
+            sir[2] = qBlue(p);
+            sir[3] = qAlpha(p);
+
+            rbs = r1 - abs(i);
+            rsum += sir[0] * rbs;
+            gsum += sir[1] * rbs;
+            bsum += sir[2] * rbs;
+            asum += sir[3] * rbs;
+
+            if (i > 0) {
+                rinsum += sir[0];
+                ginsum += sir[1];
+                binsum += sir[2];
+                ainsum += sir[3];
+            } else {
+                routsum += sir[0];
+                goutsum += sir[1];
+                boutsum += sir[2];
+                aoutsum += sir[3];
+            }
+        }
+        stackpointer = radius;
+
+        for (x = 0; x < w; ++x) {
+            r[yi] = dv[rsum];
+            g[yi] = dv[gsum];
+            b[yi] = dv[bsum];
+            a[yi] = dv[asum];
+
+            rsum -= routsum;
+            gsum -= goutsum;
+            bsum -= boutsum;
+            asum -= aoutsum;
+
+            stackstart = stackpointer - radius + div;
+            sir = stack[stackstart%div];
+
+            routsum -= sir[0];
+            goutsum -= sir[1];
+            boutsum -= sir[2];
+            aoutsum -= sir[3];
+
+            if (y == 0) {
+                vmin[x] = qMin(x + radius + 1, wm);
+            }
+            p = pix[yw+vmin[x]];
+
+            sir[0] = qRed(p);
+            sir[1] = qGreen(p);
+            sir[2] = qBlue(p);
+            sir[3] = qAlpha(p);
+
+            rinsum += sir[0];
+            ginsum += sir[1];
+            binsum += sir[2];
+            ainsum += sir[3];
+
+            rsum += rinsum;
+            gsum += ginsum;
+            bsum += binsum;
+            asum += ainsum;
+
+            stackpointer = (stackpointer + 1) % div;
+            sir = stack[(stackpointer)%div];
+
+            routsum += sir[0];
+            goutsum += sir[1];
+            boutsum += sir[2];
+            aoutsum += sir[3];
+
+            rinsum -= sir[0];
+            ginsum -= sir[1];
+            binsum -= sir[2];
+            ainsum -= sir[3];
+
+            ++yi;
+        }
+        yw += w;
+    }
+    for (x = 0; x < w; ++x) {
+        rinsum = ginsum = binsum = ainsum = routsum = goutsum = boutsum = aoutsum = rsum = gsum = bsum = asum = 0;
+
+        yp = - radius * w;
+
+        for (i = -radius; i <= radius; ++i) {
+            yi = qMax(0, yp) + x;
+
+            sir = stack[i+radius];
+
+            sir[0] = r[yi];
+            sir[1] = g[yi];
+            sir[2] = b[yi];
+            sir[3] = a[yi];
+
+            rbs = r1 - abs(i);
+
+            rsum += r[yi] * rbs;
+            gsum += g[yi] * rbs;
+            bsum += b[yi] * rbs;
+            asum += a[yi] * rbs;
+
+            if (i > 0) {
+                rinsum += sir[0];
+                ginsum += sir[1];
+                binsum += sir[2];
+                ainsum += sir[3];
+            } else {
+                routsum += sir[0];
+                goutsum += sir[1];
+                boutsum += sir[2];
+                aoutsum += sir[3];
+            }
+
+            if (i < hm) {
+                yp += w;
+            }
+        }
+
+        yi = x;
+        stackpointer = radius;
+
+        for (y = 0; y < h; ++y) {
+            pix[yi] = qRgba(dv[rsum], dv[gsum], dv[bsum], dv[asum]);
+
+            rsum -= routsum;
+            gsum -= goutsum;
+            bsum -= boutsum;
+            asum -= aoutsum;
+
+            stackstart = stackpointer - radius + div;
+            sir = stack[stackstart%div];
+
+            routsum -= sir[0];
+            goutsum -= sir[1];
+            boutsum -= sir[2];
+            aoutsum -= sir[3];
+
+            if (x == 0) {
+                vmin[y] = qMin(y + r1, hm) * w;
+            }
+            p = x + vmin[y];
+
+            sir[0] = r[p];
+            sir[1] = g[p];
+            sir[2] = b[p];
+            sir[3] = a[p];
+
+            rinsum += sir[0];
+            ginsum += sir[1];
+            binsum += sir[2];
+            ainsum += sir[3];
+
+            rsum += rinsum;
+            gsum += ginsum;
+            bsum += binsum;
+            asum += ainsum;
+
+            stackpointer = (stackpointer + 1) % div;
+            sir = stack[stackpointer];
+
+            routsum += sir[0];
+            goutsum += sir[1];
+            boutsum += sir[2];
+            aoutsum += sir[3];
+
+            rinsum -= sir[0];
+            ginsum -= sir[1];
+            binsum -= sir[2];
+            ainsum -= sir[3];
+
+            yi += w;
+        }
+    }
+    delete [] r;
+    delete [] g;
+    delete [] b;
+    delete [] a;
+    delete [] vmin;
+    delete [] dv;
+
+    for (int i = 0; i < div; ++i) {
+        delete [] stack[i];
+    }
+    delete [] stack;
+}
+
+void referenceMorphology(const quint32 *srcPixels, quint32 *dstPixels, int w,
+                         int minX, int maxX, int minY, int maxY, int rx, int ry, bool erode)
+{
+    const int maskSize = (1+2*rx)*(1+2*ry);
+    QVector<int> mask(maskSize);
+    int index = 0;
+    for (int y = -ry; y <= ry; ++y) {
+        for (int x = -rx; x <= rx; ++x) {
+            mask[index] = y*w+x;
+            index++;
+        }
+    }
+
+    const uchar *src = reinterpret_cast<const uchar*>(srcPixels);
+    uchar *dst = reinterpret_cast<uchar*>(dstPixels);
+    const uchar defValue = erode ? 255 : 0;
+    for (int row = minY; row < maxY; ++row) {
+        for (int col = minX; col < maxX; ++col) {
+            const int dstPixel = row * w + col;
+            uchar s0, s1, s2, s3;
+            s0 = s1 = s2 = s3 = defValue;
+            for (int i = 0; i < maskSize; ++i) {
+                const uchar *s = &src[4*(dstPixel+mask[i])];
+                if (erode) {
+                    s0 = qMin(s0, s[0]);
+                    s1 = qMin(s1, s[1]);
+                    s2 = qMin(s2, s[2]);
+                    s3 = qMin(s3, s[3]);
+                } else {
+                    s0 = qMax(s0, s[0]);
+                    s1 = qMax(s1, s[1]);
+                    s2 = qMax(s2, s[2]);
+                    s3 = qMax(s3, s[3]);
+                }
+            }
+            uchar *d = &dst[4*dstPixel];
+            d[0] = s0;
+            d[1] = s1;
+            d[2] = s2;
+            d[3] = s3;
+        }
+    }
+}
+
+void referenceColorMatrix(const quint32 *src, quint32 *dst, int w, const QRect &roi, const qreal *m)
+{
+    qreal sa, sr, sg, sb;
+    qreal da, dr, dg, db;
+
+    for (int row = roi.top(); row < roi.bottom(); ++row) {
+        for (int col = roi.left(); col < roi.right(); ++col) {
+            const QRgb &s = src[row*w+col];
+            sa = fromIntColor[qAlpha(s)];
+            sr = fromIntColor[qRed(s)];
+            sg = fromIntColor[qGreen(s)];
+            sb = fromIntColor[qBlue(s)];
+            if (sa > 0.0 && sa < 1.0) {
+                sr /= sa;
+                sb /= sa;
+                sg /= sa;
+            }
+
+            dr = m[ 0] * sr + m[ 1] * sg + m[ 2] * sb + m[ 3] * sa + m[ 4];
+            dg = m[ 5] * sr + m[ 6] * sg + m[ 7] * sb + m[ 8] * sa + m[ 9];
+            db = m[10] * sr + m[11] * sg + m[12] * sb + m[13] * sa + m[14];
+            da = m[15] * sr + m[16] * sg + m[17] * sb + m[18] * sa + m[19];
+
+            da *= 255.0;
+
+            dst[row*w+col] = qRgba(static_cast<quint8>(qBound(qreal(0.0), dr * da, qreal(255.0))),
+                                   static_cast<quint8>(qBound(qreal(0.0), dg * da, qreal(255.0))),
+                                   static_cast<quint8>(qBound(qreal(0.0), db * da, qreal(255.0))),
+                                   static_cast<quint8>(qBound(qreal(0.0), da, qreal(255.0))));
+        }
+    }
+}
+
+void referenceArithmeticComposite(const quint32 *src, quint32 *dst, int w, const QRect &roi, const qreal *k)
+{
+    qreal sa, sr, sg, sb;
+    qreal da, dr, dg, db;
+
+    for (int row = roi.top(); row < roi.bottom(); ++row) {
+        for (int col = roi.left(); col < roi.right(); ++col) {
+            const int pixel = row * w + col;
+            const QRgb &s = src[pixel];
+            QRgb &d = dst[pixel];
+
+            sa = fromIntColor[qAlpha(s)];
+            sr = fromIntColor[qRed(s)];
+            sg = fromIntColor[qGreen(s)];
+            sb = fromIntColor[qBlue(s)];
+
+            da = fromIntColor[qAlpha(d)];
+            dr = fromIntColor[qRed(d)];
+            dg = fromIntColor[qGreen(d)];
+            db = fromIntColor[qBlue(d)];
+
+            da = k[0] * sa * da + k[1] * da + k[2] * sa + k[3];
+            dr = k[0] * sr * dr + k[1] * dr + k[2] * sr + k[3];
+            dg = k[0] * sg * dg + k[1] * dg + k[2] * sg + k[3];
+            db = k[0] * sb * db + k[1] * db + k[2] * sb + k[3];
+
+            da *= 255.0;
+
+            d = qRgba(static_cast<quint8>(qBound(qreal(0.0), dr * da, qreal(255.0))),
+                      static_cast<quint8>(qBound(qreal(0.0), dg * da, qreal(255.0))),
+                      static_cast<quint8>(qBound(qreal(0.0), db * da, qreal(255.0))),
+                      static_cast<quint8>(qBound(qreal(0.0), da, qreal(255.0))));
+        }
+    }
+}
+
+void referenceConvolve(const quint32 *src, quint32 *dst, int w, int h, const QRect &roi,
+                       const int *offsetX, const int *offsetY, const qreal *kernel, int maskSize,
+                       qreal divisor, qreal bias, FilterEffectKernels::EdgeMode edgeMode, bool preserveAlpha)
+{
+    qreal sumA, sumR, sumG, sumB;
+    int srcRow, srcCol;
+    for (int row = roi.top(); row <= roi.bottom(); ++row) {
+        for (int col = roi.left(); col <= roi.right(); ++col) {
+            const int dstPixel = row * w + col;
+            sumA = sumR = sumG = sumB = 0;
+            for (int i = 0; i < maskSize; ++i) {
+                srcRow = row + offsetY[i];
+                srcCol = col + offsetX[i];
+                if (srcRow < 0 || srcRow >= h) {
+                    switch (edgeMode) {
+                    case FilterEffectKernels::EdgeDuplicate:
+                        srcRow = srcRow >= h ? h-1 : 0;
+                        break;
+                    case FilterEffectKernels::EdgeWrap:
+                        srcRow = (srcRow+h)%h;
+                        break;
+                    case FilterEffectKernels::EdgeNone:
+                        continue;
+                    }
+                }
+                if (srcCol < 0 || srcCol >= w) {
+                    switch (edgeMode) {
+                    case FilterEffectKernels::EdgeDuplicate:
+                        srcCol = srcCol >= w ? w-1 : 0;
+                        break;
+                    case FilterEffectKernels::EdgeWrap:
+                        srcCol = (srcCol+w)%w;
+                        break;
+                    case FilterEffectKernels::EdgeNone:
+                        continue;
+                    }
+                }
+                const QRgb &s = src[srcRow * w + srcCol];
+                const qreal &k = kernel[i];
+                if (!preserveAlpha)
+                    sumA += qAlpha(s) * k;
+                sumR += qRed(s) * k;
+                sumG += qGreen(s) * k;
+                sumB += qBlue(s) * k;
+            }
+            if (preserveAlpha) {
+                dst[dstPixel] = qRgba(qBound(0, static_cast<int>(sumR / divisor + bias), 255),
+                                      qBound(0, static_cast<int>(sumG / divisor + bias), 255),
+                                      qBound(0, static_cast<int>(sumB / divisor + bias), 255),
+                                      qAlpha(dst[dstPixel]));
+            } else {
+                dst[dstPixel] = qRgba(qBound(0, static_cast<int>(sumR / divisor + bias), 255),
+                                      qBound(0, static_cast<int>(sumG / divisor + bias), 255),
+                                      qBound(0, static_cast<int>(sumB / divisor + bias), 255),
+                                      qBound(0, static_cast<int>(sumA / divisor + bias), 255));
+            }
+        }
+    }
+}
+
+qreal referenceTransfer(const TransferFunction &f, qreal value)
+{
+    switch (f.type) {
+    case TransferFunction::Identity:
+        return value;
+    case TransferFunction::Table: {
+        qreal valueCount = f.tableSize - 1;
+        if (valueCount < 0.0)
+            return value;
+        qreal k1 = static_cast<int>(value * valueCount);
+        qreal k2 = qMin(k1 + 1, valueCount);
+        qreal vk1 = f.table[static_cast<int>(k1)];
+        qreal vk2 = f.table[static_cast<int>(k2)];
+        return vk1 + (value - static_cast<qreal>(k1) / valueCount)*valueCount *(vk2 - vk1);
+    }
+    case TransferFunction::Discrete: {
+        qreal valueCount = f.tableSize - 1;
+        if (valueCount < 0.0)
+            return value;
+        return f.table[static_cast<int>(value*valueCount)];
+    }
+    case TransferFunction::Linear:
+        return f.slope * value + f.intercept;
+    case TransferFunction::Gamma:
+        return f.amplitude * pow(value, f.exponent) + f.offset;
+    }
+
+    return value;
+}
+
+void referenceComponentTransfer(const quint32 *src, quint32 *dst, int w, const QRect &roi,
+                                const TransferFunction *functions)
+{
+    qreal sa, sr, sg, sb;
+    qreal da, dr, dg, db;
+
+    for (int row = roi.top(); row <= roi.bottom(); ++row) {
+        for (int col = roi.left(); col <= roi.right(); ++col) {
+            const int pixel = row * w + col;
+            const QRgb &s = src[pixel];
+
+            sa = fromIntColor[qAlpha(s)];
+            sr = fromIntColor[qRed(s)];
+            sg = fromIntColor[qGreen(s)];
+            sb = fromIntColor[qBlue(s)];
+            if (sa > 0.0 && sa < 1.0) {
+                sr /= sa;
+                sb /= sa;
+                sg /= sa;
+            }
+
+            dr = referenceTransfer(functions[0], sr);
+            dg = referenceTransfer(functions[1], sg);
+            db = referenceTransfer(functions[2], sb);
+            da = referenceTransfer(functions[3], sa);
+
+            da *= 255.0;
+
+            dst[pixel] = qRgba(static_cast<quint8>(qBound(qreal(0.0), dr * da, qreal(255.0))),
+                               static_cast<quint8>(qBound(qreal(0.0), dg * da, qreal(255.0))),
+                               static_cast<quint8>(qBound(qreal(0.0), db * da, qreal(255.0))),
+                               static_cast<quint8>(qBound(qreal(0.0), da, qreal(255.0))));
+        }
+    }
+}
+
+}
+
+void TestFilterEffectKernels::testStackBlur_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<int>("radius");
+    QTest::addColumn<bool>("striped");
+
+    QTest::newRow("no radius") << 16 << 16 << 0 << false;
+    QTest::newRow("single pixel") << 1 << 1 << 3 << false;
+    QTest::newRow("small") << 7 << 5 << 1 << false;
+    QTest::newRow("medium") << 64 << 48 << 3 << false;
+    QTest::newRow("radius beyond the image") << 33 << 17 << 20 << false;
+    QTest::newRow("narrow") << 3 << 120 << 8 << false;
+    QTest::newRow("wide radius") << 100 << 80 << 60 << false;
+    // the sums do not fit into a float any more
+    QTest::newRow("huge radius") << 40 << 6 << 256 << false;
+    QTest::newRow("flat areas") << 40 << 120 << 10 << true;
+    QTest::newRow("flat areas, wide radius") << 60 << 300 << 43 << true;
+}
+
+void TestFilterEffectKernels::testStackBlur()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, radius);
+    QFETCH(bool, striped);
+
+    QVector<quint32> expected = striped ? stripedPixels(width, height, 3 * radius, 1) : randomPixels(width, height, 1);
+    QVector<quint32> actual = expected;
+    referenceStackBlur(expected.data(), width, height, radius);
+    FilterEffectKernels::instance()->stackBlur(actual.data(), width, height, radius);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestFilterEffectKernels::testMorphology_data()
+{
+    QTest::addColumn<int>("radiusX");
+    QTest::addColumn<int>("radiusY");
+    QTest::addColumn<bool>("erode");
+
+    QTest::newRow("erode 0x0") << 0 << 0 << true;
+    QTest::newRow("erode 1x2") << 1 << 2 << true;
+    QTest::newRow("erode 3x0") << 3 << 0 << true;
+    QTest::newRow("dilate 0x3") << 0 << 3 << false;
+    QTest::newRow("dilate 4x4") << 4 << 4 << false;
+    QTest::newRow("dilate beyond the region") << 20 << 1 << false;
+}
+
+void TestFilterEffectKernels::testMorphology()
+{
+    QFETCH(int, radiusX);
+    QFETCH(int, radiusY);
+    QFETCH(bool, erode);
+
+    const int width = 40;
+    const int height = 30;
+    const QVector<quint32> src = randomPixels(width, height, 2);
+    QVector<quint32> expected = randomPixels(width, height, 3);
+    QVector<quint32> actual = expected;
+
+    // the region like MorphologyEffect clips it
+    const QRect roi(2, 3, 34, 25);
+    const int minX = qMax(radiusX, roi.left());
+    const int maxX = qMin(width - radiusX, roi.right());
+    const int minY = qMax(radiusY, roi.top());
+    const int maxY = qMin(height - radiusY, roi.bottom());
+
+    referenceMorphology(src.constData(), expected.data(), width, minX, maxX, minY, maxY, radiusX, radiusY, erode);
+    FilterEffectKernels::instance()->morphology(src.constData(), actual.data(), width,
+                                                minX, maxX, minY, maxY, radiusX, radiusY, erode);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestFilterEffectKernels::testColorMatrix()
+{
+    const int width = 37;
+    const int height = 23;
+    const QRect roi(1, 2, 35, 19);
+
+    for (uint seed = 0; seed < 8; ++seed) {
+        Random random(seed);
+        qreal matrix[20];
+        for (int i = 0; i < 20; ++i)
+            matrix[i] = random.real(-1.5, 1.5);
+
+        const QVector<quint32> src = randomPixels(width, height, seed);
+        QVector<quint32> expected = src;
+        QVector<quint32> actual = src;
+        referenceColorMatrix(src.constData(), expected.data(), width, roi, matrix);
+        FilterEffectKernels::instance()->colorMatrix(src.constData(), actual.data(), width,
+                                                     roi.left(), roi.right(), roi.top(), roi.bottom(), matrix);
+
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestFilterEffectKernels::testArithmeticComposite()
+{
+    const int width = 29;
+    const int height = 31;
+    const QRect roi(0, 3, 29, 20);
+
+    for (uint seed = 0; seed < 8; ++seed) {
+        Random random(seed);
+        qreal k[4];
+        for (int i = 0; i < 4; ++i)
+            k[i] = random.real(-1.0, 2.0);
+
+        const QVector<quint32> src = randomPixels(width, height, seed);
+        QVector<quint32> expected = randomPixels(width, height, seed + 100);
+        QVector<quint32> actual = expected;
+        referenceArithmeticComposite(src.constData(), expected.data(), width, roi, k);
+        FilterEffectKernels::instance()->arithmeticComposite(src.constData(), actual.data(), width,
+                                                             roi.left(), roi.right(), roi.top(), roi.bottom(), k);
+
+        QCOMPARE(actual, expected);
+    }
+}
+
+void TestFilterEffectKernels::testConvolve_data()
+{
+    QTest::addColumn<int>("orderX");
+    QTest::addColumn<int>("orderY");
+    QTest::addColumn<int>("targetX");
+    QTest::addColumn<int>("targetY");
+    QTest::addColumn<int>("edgeMode");
+    QTest::addColumn<bool>("preserveAlpha");
+    QTest::addColumn<qreal>("bias");
+
+    QTest::newRow("3x3 duplicate") << 3 << 3 << 1 << 1 << int(FilterEffectKernels::EdgeDuplicate) << false << 0.0;
+    QTest::newRow("3x3 wrap") << 3 << 3 << 1 << 1 << int(FilterEffectKernels::EdgeWrap) << false << 0.0;
+    QTest::newRow("3x3 none") << 3 << 3 << 1 << 1 << int(FilterEffectKernels::EdgeNone) << false << 0.0;
+    QTest::newRow("5x2 corner target") << 5 << 2 << 0 << 1 << int(FilterEffectKernels::EdgeDuplicate) << false << 0.0;
+    QTest::newRow("1x4 preserve alpha") << 1 << 4 << 0 << 3 << int(FilterEffectKernels::EdgeWrap) << true << 0.0;
+    QTest::newRow("4x4 bias") << 4 << 4 << 2 << 2 << int(FilterEffectKernels::EdgeNone) << true << 12.5;
+    QTest::newRow("kernel wider than the image") << 30 << 3 << 15 << 1 << int(FilterEffectKernels::EdgeDuplicate) << false << 0.0;
+}
+
+void TestFilterEffectKernels::testConvolve()
+{
+    QFETCH(int, orderX);
+    QFETCH(int, orderY);
+    QFETCH(int, targetX);
+    QFETCH(int, targetY);
+    QFETCH(int, edgeMode);
+    QFETCH(bool, preserveAlpha);
+    QFETCH(qreal, bias);
+
+    const int width = 24;
+    const int height = 19;
+    const QRect roi(0, 0, width, height);
+
+    const int count = orderX * orderY;
+    QVector<int> offsetX(count);
+    QVector<int> offsetY(count);
+    QVector<qreal> kernel(count);
+    Random random(count);
+    qreal divisor = 0.0;
+    for (int i = 0; i < count; ++i) {
+        offsetX[i] = i % orderX - targetX;
+        offsetY[i] = i / orderX - targetY;
+        kernel[i] = random.real(-1.0, 3.0);
+        divisor += kernel[i];
+    }
+    if (divisor == 0.0)
+        divisor = 1.0;
+
+    const QVector<quint32> src = randomPixels(width, height, count);
+    QVector<quint32> expected = src;
+    QVector<quint32> actual = src;
+    const FilterEffectKernels::EdgeMode mode = static_cast<FilterEffectKernels::EdgeMode>(edgeMode);
+    referenceConvolve(src.constData(), expected.data(), width, height, roi,
+                      offsetX.constData(), offsetY.constData(), kernel.constData(), count,
+                      divisor, bias, mode, preserveAlpha);
+    FilterEffectKernels::instance()->convolve(src.constData(), actual.data(), width, height,
+                                              roi.left(), roi.right() + 1, roi.top(), roi.bottom() + 1,
+                                              offsetX.constData(), offsetY.constData(), kernel.constData(), count,
+                                              divisor, bias, mode, preserveAlpha);
+
+    QCOMPARE(actual, expected);
+}
+
+void TestFilterEffectKernels::testConvolveMatrixEffect()
+{
+    const int width = 24;
+    const int height = 19;
+    // the effect only changes the pixels within the filter region
+    const QRect roi(3, 2, 15, 12);
+
+    QVector<qreal> kernel(9);
+    Random random(9);
+    qreal divisor = 0.0;
+    for (int i = 0; i < kernel.count(); ++i) {
+        kernel[i] = random.real(-1.0, 3.0);
+        divisor += kernel[i];
+    }
+    if (divisor == 0.0)
+        divisor = 1.0;
+
+    ConvolveMatrixEffect effect;
+    effect.setOrder(QPoint(3, 3));
+    effect.setKernel(kernel);
+    effect.setEdgeMode(ConvolveMatrixEffect::Wrap);
+
+    QVector<int> offsetX(kernel.count());
+    QVector<int> offsetY(kernel.count());
+    for (int i = 0; i < kernel.count(); ++i) {
+        offsetX[i] = i % 3 - 1;
+        offsetY[i] = i / 3 - 1;
+    }
+
+    const QVector<quint32> src = randomPixels(width, height, 9);
+    QVector<quint32> expected = src;
+    referenceConvolve(src.constData(), expected.data(), width, height, roi,
+                      offsetX.constData(), offsetY.constData(), kernel.constData(), kernel.count(),
+                      divisor, 0.0, FilterEffectKernels::EdgeWrap, false);
+
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int row = 0; row < height; ++row)
+        memcpy(image.scanLine(row), src.constData() + row * width, width * sizeof(quint32));
+
+    KoViewConverter converter;
+    KoFilterEffectRenderContext context(converter);
+    context.setFilterRegion(roi);
+    const QImage result = effect.processImage(image, context);
+
+    QCOMPARE(result.size(), image.size());
+    QVector<quint32> actual(width * height);
+    for (int row = 0; row < height; ++row)
+        memcpy(actual.data() + row * width, result.constScanLine(row), width * sizeof(quint32));
+
+    QCOMPARE(actual, expected);
+}
+
+void TestFilterEffectKernels::testComponentTransfer_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("tableSize");
+
+    QTest::newRow("identity") << int(TransferFunction::Identity) << 0;
+    QTest::newRow("empty table") << int(TransferFunction::Table) << 0;
+    QTest::newRow("table") << int(TransferFunction::Table) << 2;
+    QTest::newRow("long table") << int(TransferFunction::Table) << 9;
+    QTest::newRow("discrete") << int(TransferFunction::Discrete) << 1;
+    QTest::newRow("long discrete") << int(TransferFunction::Discrete) << 6;
+    QTest::newRow("linear") << int(TransferFunction::Linear) << 0;
+    QTest::newRow("gamma") << int(TransferFunction::Gamma) << 0;
+}
+
+void TestFilterEffectKernels::testComponentTransfer()
+{
+    QFETCH(int, type);
+    QFETCH(int, tableSize);
+
+    const int width = 31;
+    const int height = 17;
+    const QRect roi(3, 1, 26, 14);
+
+    Random random(type + tableSize);
+    QVector<qreal> tables[4];
+    TransferFunction functions[4];
+    for (int channel = 0; channel < 4; ++channel) {
+        for (int i = 0; i < tableSize; ++i)
+            tables[channel].append(random.real(0.0, 1.0));
+        TransferFunction &function = functions[channel];
+        // the alpha channel keeps the identity in every other run, so all colors show up
+        function.type = channel == 3 && tableSize % 2 ? TransferFunction::Identity : static_cast<TransferFunction::Type>(type);
+        function.table = tables[channel].constData();
+        function.tableSize = tableSize;
+        function.slope = random.real(-0.5, 1.5);
+        function.intercept = random.real(-0.2, 0.5);
+        function.amplitude = random.real(0.5, 1.5);
+        function.exponent = random.real(0.2, 3.0);
+        function.offset = random.real(-0.2, 0.2);
+    }
+
+    const QVector<quint32> src = randomPixels(width, height, type);
+    QVector<quint32> expected = src;
+    QVector<quint32> actual = src;
+    referenceComponentTransfer(src.constData(), expected.data(), width, roi, functions);
+    FilterEffectKernels::instance()->componentTransfer(src.constData(), actual.data(), width,
+                                                       roi.left(), roi.right() + 1, roi.top(), roi.bottom() + 1,
+                                                       functions);
+
+    QCOMPARE(actual, expected);
+}
+
+QTEST_GUILESS_MAIN(TestFilterEffectKernels)
@@ -0,0 +1,45 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef TESTFILTEREFFECTKERNELS_H
+#define TESTFILTEREFFECTKERNELS_H
+
+#include <QObject>
+
+/**
+ * Checks that the kernels of FilterEffectKernels::instance() give exactly the
+ * pixels of the scalar loops the effects had before.
+ */
+class TestFilterEffectKernels : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testStackBlur_data();
+    void testStackBlur();
+    void testMorphology_data();
+    void testMorphology();
+    void testColorMatrix();
+    void testArithmeticComposite();
+    void testConvolve_data();
+    void testConvolve();
+    void testConvolveMatrixEffect();
+    void testComponentTransfer_data();
+    void testComponentTransfer();
+};
+
+#endif // TESTFILTEREFFECTKERNELS_H
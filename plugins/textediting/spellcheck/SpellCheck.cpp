@@ -43,6 +43,11 @@
 #include <QTextCharFormat>
 #include <QAction>
 
+// the number of characters of outdated paragraphs checked together in one run
+#define MaxCharsPerCheck 5000
+// the time in ms new misspellings are collected before the layouts are updated
+#define UpdateInterval 100
+
 SpellCheck::SpellCheck()
     : m_document(0)
     , m_bgSpellCheck(0)
@@ -50,7 +55,9 @@ SpellCheck::SpellCheck()
     , m_documentIsLoading(false)
     , m_isChecking(false)
     , m_spellCheckMenu(0)
-    , m_activeSection(0, 0, 0)
+    , m_runFrom(0)
+    , m_runTo(0)
+    , m_runValid(true)
     , m_simpleEdit(false)
     , m_cursorPosition(0)
 {
@@ -76,6 +83,10 @@ SpellCheck::SpellCheck()
             this, SLOT(highlightMisspelled(QString,int,bool)));
     connect(m_bgSpellCheck, SIGNAL(done()), this, SLOT(finishedRun()));
     connect(spellCheck, SIGNAL(toggled(bool)), this, SLOT(setBackgroundSpellChecking(bool)));
+
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UpdateInterval);
+    connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateLayouts()));
 }
 
 void SpellCheck::finishedWord(QTextDocument *document, int cursorPosition)
@@ -112,19 +123,79 @@ void SpellCheck::checkSection(QTextDocument *document, int startPosition, int en
         return;
     }
 
-    foreach (const SpellSections &ss, m_documentsQueue) {
-        if (ss.from <= startPosition && ss.to >= endPosition) {
-            runQueue();
-            m_spellCheckMenu->setVisible(true);
-            return;
-        }
-        // TODO also check if we should replace an existing queued item with a longer span
+    QTextBlock block = document->findBlock(startPosition);
+    while (block.isValid() && block.position() <= endPosition) {
+        KoTextBlockData blockData(block);
+        blockData.setMarkupsRevision(KoTextBlockData::Misspell, -1);
+        block = block.next();
     }
+    scheduleCheck(document, startPosition);
+    m_spellCheckMenu->setVisible(true);
+}
 
-    SpellSections ss(document, startPosition, endPosition);
-    m_documentsQueue.enqueue(ss);
+void SpellCheck::scheduleCheck(QTextDocument *document, int position)
+{
+    bool queued = false;
+    for (int i = 0; i < m_dirtyDocuments.count(); ++i) {
+        if (m_dirtyDocuments[i].document == document) {
+            m_dirtyDocuments[i].position = position;
+            queued = true;
+            break;
+        }
+    }
+    if (!queued)
+        m_dirtyDocuments.append(DirtyDocument(document, position));
     runQueue();
-    m_spellCheckMenu->setVisible(true);
+}
+
+bool SpellCheck::needsCheck(const QTextBlock &block) const
+{
+    QTextBlock b(block);
+    KoTextBlockData blockData(b);
+    const int revision = blockData.markupsRevision(KoTextBlockData::Misspell);
+    if (revision == -1)
+        return true;
+    // with auto spell check off only the paragraphs asked for are checked,
+    // not the ones that were never checked (-2)
+    if (!m_enableSpellCheck || revision == block.revision())
+        return false;
+    // the paragraph the user types in is checked on finishedWord, not halfway a word
+    return block.document() != m_document || !block.contains(m_cursorPosition);
+}
+
+bool SpellCheck::findOutdatedRange(QTextDocument *document, int position, int *from, int *to) const
+{
+    QTextBlock start = document->findBlock(position);
+    if (!start.isValid())
+        start = document->begin();
+    if (!start.isValid())
+        return false;
+
+    // look from position to the end of the document, then from its start
+    QTextBlock first;
+    QTextBlock block = start;
+    do {
+        if (needsCheck(block)) {
+            first = block;
+            break;
+        }
+        block = block.next();
+        if (!block.isValid())
+            block = document->begin();
+    } while (block != start);
+    if (!first.isValid())
+        return false;
+
+    // the outdated paragraphs following it are checked in the same run
+    QTextBlock last = first;
+    for (block = first.next(); block.isValid() && needsCheck(block); block = block.next()) {
+        if (block.position() + block.length() - first.position() > MaxCharsPerCheck)
+            break;
+        last = block;
+    }
+    *from = first.position();
+    *to = last.position() + last.length() - 1;
+    return true;
 }
 
 void SpellCheck::setDocument(QTextDocument *document)
@@ -239,7 +310,11 @@ class MyThread : public QThread { public: static void mySleep(unsigned long msec
 static_cast<MyThread*>(QThread::currentThread())->mySleep(400);
 #endif
 
-    QTextBlock block = m_activeSection.document->findBlock(startPosition);
+    // positions the run reports after its text changed point to the wrong place
+    if (!m_runValid || m_activeDocument.isNull())
+        return;
+
+    QTextBlock block = m_activeDocument->findBlock(startPosition);
     KoTextBlockData blockData(block);
     blockData.appendMarkup(KoTextBlockData::Misspell, startPosition - block.position(), startPosition - block.position() + word.trimmed().length());
 }
@@ -264,6 +339,14 @@ void SpellCheck::documentChanged(int from, int charsRemoved, int charsAdded)
     if (!block.isValid())
         return;
 
+    if (m_isChecking && document == m_activeDocument && from <= m_runTo) {
+        // drop the results of the run, its paragraphs are checked again when it is done
+        m_runValid = false;
+        m_runFrom = qMin(m_runFrom, from);
+        m_runTo = qMax(m_runTo + charsAdded - charsRemoved, from + charsAdded);
+    }
+
+    bool outdated = false;
     do {
         KoTextBlockData blockData(block);
         if (m_enableSpellCheck) {
@@ -278,7 +361,8 @@ void SpellCheck::documentChanged(int from, int charsRemoved, int charsAdded)
                 }
             } else {
                 // handle not so simple edits (like cut/paste etc)
-                checkSection(document, block.position(), block.position() + block.length() - 1);
+                blockData.setMarkupsRevision(KoTextBlockData::Misspell, -1);
+                outdated = true;
             }
         } else {
             blockData.clearMarkups(KoTextBlockData::Misspell);
@@ -287,6 +371,8 @@ void SpellCheck::documentChanged(int from, int charsRemoved, int charsAdded)
     } while(block.isValid() && block.position() <= from + charsAdded);
 
     m_simpleEdit = false;
+    if (outdated)
+        scheduleCheck(document, from);
 }
 
 void SpellCheck::runQueue()
@@ -294,21 +380,40 @@ void SpellCheck::runQueue()
     Q_ASSERT(QThread::currentThread() == QApplication::instance()->thread());
     if (m_isChecking)
         return;
-    while (!m_documentsQueue.isEmpty()) {
-        m_activeSection = m_documentsQueue.dequeue();
-        if (m_activeSection.document.isNull())
-            continue;
-        QTextBlock block = m_activeSection.document->findBlock(m_activeSection.from);
-        if (!block.isValid())
+    while (!m_dirtyDocuments.isEmpty()) {
+        // the document the user works in goes first
+        int index = 0;
+        for (int i = 0; i < m_dirtyDocuments.count(); ++i) {
+            if (m_dirtyDocuments[i].document == m_document) {
+                index = i;
+                break;
+            }
+        }
+        DirtyDocument &dirty = m_dirtyDocuments[index];
+        int from, to;
+        if (dirty.document.isNull() || !findOutdatedRange(dirty.document, dirty.position, &from, &to)) {
+            m_dirtyDocuments.removeAt(index);
             continue;
+        }
+
+        m_activeDocument = dirty.document;
+        m_runFrom = from;
+        m_runTo = to;
+        m_runValid = true;
+        // the next run continues where this one ends
+        dirty.position = to + 1;
         m_isChecking = true;
+
+        QTextBlock block = m_activeDocument->findBlock(from);
         do {
             KoTextBlockData blockData(block);
             blockData.clearMarkups(KoTextBlockData::Misspell);
+            blockData.setMarkupsLayoutValidity(KoTextBlockData::Misspell, false);
+            blockData.setMarkupsRevision(KoTextBlockData::Misspell, block.revision());
             block = block.next();
-        } while(block.isValid() && block.position() < m_activeSection.to);
+        } while(block.isValid() && block.position() <= to);
 
-        m_bgSpellCheck->startRun(m_activeSection.document, m_activeSection.from, m_activeSection.to);
+        m_bgSpellCheck->startRun(m_activeDocument, from, to);
         break;
     }
 }
@@ -326,16 +431,49 @@ void SpellCheck::finishedRun()
     Q_ASSERT(QThread::currentThread() == QApplication::instance()->thread());
     m_isChecking = false;
 
-    KoTextDocumentLayout *lay = qobject_cast<KoTextDocumentLayout*>(m_activeSection.document->documentLayout());
-    lay->provider()->updateAll();
+    if (m_activeDocument) {
+        if (!m_runValid) {
+            QTextBlock block = m_activeDocument->findBlock(m_runFrom);
+            while (block.isValid() && block.position() <= m_runTo) {
+                KoTextBlockData blockData(block);
+                blockData.setMarkupsRevision(KoTextBlockData::Misspell, -1);
+                block = block.next();
+            }
+            scheduleCheck(m_activeDocument, m_runFrom);
+        }
+
+        // collect the documents of several runs, so their layouts are updated once
+        if (!m_updateDocuments.contains(m_activeDocument))
+            m_updateDocuments.append(m_activeDocument);
+        if (!m_updateTimer.isActive())
+            m_updateTimer.start();
+    }
 
     QTimer::singleShot(0, this, SLOT(runQueue()));
 }
 
+void SpellCheck::updateLayouts()
+{
+    foreach (const QPointer<QTextDocument> &document, m_updateDocuments) {
+        if (document.isNull())
+            continue;
+        KoTextDocumentLayout *lay = qobject_cast<KoTextDocumentLayout*>(document->documentLayout());
+        if (lay)
+            lay->provider()->updateAll();
+    }
+    m_updateDocuments.clear();
+}
+
 void SpellCheck::setCurrentCursorPosition(QTextDocument *document, int cursorPosition)
 {
     setDocument(document);
+    QTextBlock previousBlock = m_document->findBlock(m_cursorPosition);
+    m_cursorPosition = cursorPosition;
     if (m_enableSpellCheck) {
+        // the paragraph the cursor left may have been typed in
+        if (previousBlock.isValid() && !previousBlock.contains(cursorPosition) && needsCheck(previousBlock))
+            scheduleCheck(m_document, previousBlock.position());
+
         //check if word at cursor is misspelled
         QTextBlock block = m_document->findBlock(cursorPosition);
         if (block.isValid()) {
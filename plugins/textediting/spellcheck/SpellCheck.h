@@ -29,10 +29,12 @@
 #include <QTextCharFormat>
 #include <QTextDocument>
 #include <QPointer>
-#include <QQueue>
+#include <QList>
 #include <QTextLayout>
 #include <QTextStream>
+#include <QTimer>
 
+class QTextBlock;
 class QTextDocument;
 class QTextStream;
 class BgSpellCheck;
@@ -85,34 +87,45 @@ private Q_SLOTS:
     void finishedRun();
     void configureSpellCheck();
     void runQueue();
+    void updateLayouts();
     void setBackgroundSpellChecking(bool b);
     void documentChanged(int from, int charsRemoved, int charsAdded);
 
 private:
+    /// queue @p document to have its outdated paragraphs checked, starting at @p position
+    void scheduleCheck(QTextDocument *document, int position);
+    /// return true if the misspell markups of @p block have to be checked again
+    bool needsCheck(const QTextBlock &block) const;
+    /// find the next range of outdated paragraphs, looking from @p position on
+    bool findOutdatedRange(QTextDocument *document, int position, int *from, int *to) const;
+
     Sonnet::Speller m_speller;
     QPointer<QTextDocument> m_document;
     QString m_word;
     BgSpellCheck *m_bgSpellCheck;
-    struct SpellSections {
-        SpellSections(QTextDocument *doc, int start, int end)
+    struct DirtyDocument {
+        DirtyDocument(QTextDocument *doc, int pos)
             : document(doc)
+            , position(pos)
         {
-            from = start;
-            to = end;
         }
         QPointer<QTextDocument> document;
-        int from;
-        int to;
+        int position; // where to look for outdated paragraphs first
     };
-    QQueue<SpellSections> m_documentsQueue;
+    QList<DirtyDocument> m_dirtyDocuments; // documents that may have outdated paragraphs
     bool m_enableSpellCheck;
     bool m_documentIsLoading;
     bool m_isChecking;
     QTextStream stream;
     SpellCheckMenu *m_spellCheckMenu;
-    SpellSections m_activeSection; // the section we are currently doing a run on;
+    QPointer<QTextDocument> m_activeDocument; // the document we are currently doing a run on
+    int m_runFrom;
+    int m_runTo;
+    bool m_runValid; // false when the text of the run changed while it was checked
+    QList<QPointer<QTextDocument> > m_updateDocuments; // documents waiting for updateLayouts()
+    QTimer m_updateTimer;
     bool m_simpleEdit; //set when user is doing a simple edit, meaning we should not start spellchecking
-    int m_cursorPosition; // simple edit cursor position
+    int m_cursorPosition; // cursor position in m_document, also of a simple edit
 };
 
 #endif
@@ -1,13 +1,16 @@
 #include "TestSpellCheck.h"
 
 #include "../BgSpellCheck.h"
+#include "../SpellCheck.h"
 
 #include <KoCharacterStyle.h>
+#include <KoTextBlockData.h>
 
 #include <QTextDocument>
 #include <QTextBlock>
 #include <QTextCursor>
 #include <QTextCharFormat>
+#include <QStandardPaths>
 
 #include <QTest>
 
@@ -24,6 +27,12 @@ public:
     virtual void start() { }
 };
 
+void TestSpellCheck::initTestCase()
+{
+    // SpellCheck keeps the auto spell check setting in the config
+    QStandardPaths::setTestModeEnabled(true);
+}
+
 void TestSpellCheck::testFetchMoreText()
 {
     MySpellCheck checker;
@@ -94,4 +103,29 @@ void TestSpellCheck::testFetchMoreText2()
     QCOMPARE(checker.publicFetchMoreText(), QString("Mostly Empty Parags."));
 }
 
+void TestSpellCheck::testCheckSectionWithoutAutoSpellCheck()
+{
+    SpellCheck checker;
+    QMetaObject::invokeMethod(&checker, "setBackgroundSpellChecking", Q_ARG(bool, false));
+    QVERIFY(!checker.backgroundSpellChecking());
+
+    QTextDocument doc;
+    doc.setPlainText("first parag\nsecond parag\nthird parag");
+    QTextBlock first = doc.begin();
+    QTextBlock second = first.next();
+    QTextBlock third = second.next();
+    QVERIFY(third.isValid());
+
+    // checking a selection only checks the paragraphs in it
+    checker.checkSection(&doc, second.position(), second.position() + second.length() - 1);
+    QCOMPARE(KoTextBlockData(second).markupsRevision(KoTextBlockData::Misspell), second.revision());
+    QCOMPARE(KoTextBlockData(first).markupsRevision(KoTextBlockData::Misspell), -2);
+    QCOMPARE(KoTextBlockData(third).markupsRevision(KoTextBlockData::Misspell), -2);
+
+    // and does not go on with the paragraphs that were never checked when the run is done
+    QTest::qWait(500);
+    QCOMPARE(KoTextBlockData(first).markupsRevision(KoTextBlockData::Misspell), -2);
+    QCOMPARE(KoTextBlockData(third).markupsRevision(KoTextBlockData::Misspell), -2);
+}
+
 QTEST_MAIN(TestSpellCheck)
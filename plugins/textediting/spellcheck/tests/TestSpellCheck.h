@@ -10,8 +10,10 @@ public:
     TestSpellCheck() {}
 
 private Q_SLOTS:
+    void initTestCase();
     void testFetchMoreText();
     void testFetchMoreText2();
+    void testCheckSectionWithoutAutoSpellCheck();
 };
 
 #endif
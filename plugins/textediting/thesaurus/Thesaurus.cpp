@@ -44,6 +44,7 @@ NOT TODO:
 #include "Thesaurus.h"
 
 #include "ThesaurusDebug.h"
+#include "ThesaurusIndex.h"
 
 #include <KoIcon.h>
 #include <KoResourcePaths.h>
@@ -76,7 +77,7 @@ NOT TODO:
 Thesaurus::Thesaurus()
 {
     m_standAlone = false;
-    m_thesProc = new KProcess;
+    m_thesIndex = new ThesaurusIndex;
     m_wnProc = new KProcess;
 
     m_dialog = new KoDialog(0);
@@ -223,7 +224,7 @@ Thesaurus::~Thesaurus()
     // and a crash (when closing e.g. konqueror) when the thesaurus dialog
     // gets close while it was still working and showing the wait cursor
     // QApplication::restoreOverrideCursor();
-    delete m_thesProc;
+    delete m_thesIndex;
     delete m_wnProc;
     delete m_dialog;
 }
@@ -424,30 +425,18 @@ void Thesaurus::findTermThesaurus(const QString &searchTerm)
         return;
     }
 
-    // Find only whole words. Looks clumsy, but this way we don't have to rely on
-    // features that might only be in certain versions of grep:
-    QString searchTermTmp = ';' + searchTerm.trimmed() + ';';
-    m_thesProc->setOutputChannelMode(KProcess::SeparateChannels);
-    m_thesProc->clearProgram();
-    m_thesProc->setReadChannel(QProcess::StandardOutput);
-    *m_thesProc << "grep" << "-i" << searchTermTmp;
-    *m_thesProc << m_dataFile;
+    // the file is indexed once, then each lookup is a binary search
+    if (m_thesIndex->fileName() != m_dataFile && !m_thesIndex->load(m_dataFile)) {
+        KMessageBox::error(0, i18n("<b>Error:</b> Failed to read the thesaurus file '%1'.", m_dataFile));
+        return;
+    }
 
     QStringList syn;
     QStringList hyper;
     QStringList hypo;
 
-    m_thesProc->start();
-    if (!m_thesProc->waitForFinished()) {
-        KMessageBox::error(0, i18n("<b>Error:</b> Failed to execute grep."));
-        return;
-    }
-
-    if (!m_thesProc->waitForReadyRead()) {
-    }
-    QByteArray byteArray = m_thesProc->readAllStandardOutput();
-    QString stdoutString(byteArray);
-    const QStringList lines = stdoutString.split(QChar('\n'));
+    // the lines having the search term as a whole term
+    const QStringList lines = m_thesIndex->lines(searchTerm.trimmed());
 
     foreach(const QString& line, lines) {
         if (line.startsWith(QLatin1String("  "))) {  // ignore license (two spaces)
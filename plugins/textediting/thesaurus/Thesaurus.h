@@ -30,6 +30,7 @@ class QPushButton;
 class KHistoryComboBox;
 class KProcess;
 class KoDialog;
+class ThesaurusIndex;
 
 class QToolButton;
 class QTextDocument;
@@ -90,7 +91,7 @@ private:
     int m_startPosition;
     Mode m_mode;
 
-    KProcess *m_thesProc;
+    ThesaurusIndex *m_thesIndex;
     KProcess *m_wnProc;
     KoDialog *m_dialog;
     KHistoryComboBox *m_edit;
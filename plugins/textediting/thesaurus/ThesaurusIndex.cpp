@@ -0,0 +1,188 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "ThesaurusIndex.h"
+
+#include "ThesaurusDebug.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // the files are UTF-8 but their terms are mostly ASCII, so only that is folded
+    inline char foldCase(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    int compareTerms(const char *a, quint32 aLength, const char *b, quint32 bLength)
+    {
+        const quint32 length = qMin(aLength, bLength);
+        for (quint32 i = 0; i < length; ++i) {
+            const char ca = foldCase(a[i]);
+            const char cb = foldCase(b[i]);
+            if (ca != cb) {
+                return uchar(ca) < uchar(cb) ? -1 : 1;
+            }
+        }
+        return aLength == bLength ? 0 : (aLength < bLength ? -1 : 1);
+    }
+}
+
+class EntryLessThan
+{
+public:
+    explicit EntryLessThan(const char *data) : m_data(data) {}
+
+    bool operator()(const ThesaurusIndex::Entry &a, const ThesaurusIndex::Entry &b) const
+    {
+        const int c = compareTerms(m_data + a.term, a.length, m_data + b.term, b.length);
+        return c < 0 || (c == 0 && a.line < b.line);
+    }
+
+private:
+    const char *m_data;
+};
+
+ThesaurusIndex::ThesaurusIndex()
+    : m_data(0),
+    m_size(0)
+{
+}
+
+ThesaurusIndex::~ThesaurusIndex()
+{
+    clear();
+}
+
+void ThesaurusIndex::clear()
+{
+    m_entries.clear();
+    m_contents.clear();
+    if (m_file.isOpen()) {
+        m_file.close(); // also unmaps the file
+    }
+    m_file.setFileName(QString());
+    m_data = 0;
+    m_size = 0;
+}
+
+bool ThesaurusIndex::load(const QString &fileName)
+{
+    clear();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        warnThesaurus << "Could not open thesaurus file" << fileName;
+        m_file.setFileName(QString());
+        return false;
+    }
+    if (m_file.size() > 0xffffffffLL) {
+        warnThesaurus << "Thesaurus file too big" << fileName;
+        clear();
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data) {
+        m_contents = m_file.readAll();
+        m_data = m_contents.constData();
+    }
+
+    const char *data = m_data;
+    const char *end = data + m_size;
+    for (const char *line = data; line < end;) {
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char *next = lineEnd + 1;
+        if (lineEnd > line && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+
+        // skip the license, which is indented by two spaces
+        if (!(lineEnd - line >= 2 && line[0] == ' ' && line[1] == ' ')) {
+            const char *term = line;
+            for (const char *p = line; p <= lineEnd; ++p) {
+                if (p == lineEnd || *p == ';') {
+                    const quint32 length = p - term;
+                    if (length > 0 && !(length == 1 && *term == '#')) {
+                        const Entry entry = { quint32(term - data), length, quint32(line - data) };
+                        m_entries.append(entry);
+                    }
+                    term = p + 1;
+                }
+            }
+        }
+        line = next;
+    }
+    m_entries.squeeze();
+    std::sort(m_entries.begin(), m_entries.end(), EntryLessThan(data));
+
+    debugThesaurus << "Indexed" << m_entries.count() << "terms of" << fileName;
+    return true;
+}
+
+QString ThesaurusIndex::fileName() const
+{
+    return m_file.fileName();
+}
+
+QStringList ThesaurusIndex::lines(const QString &term) const
+{
+    QStringList lines;
+    const QByteArray key = term.toUtf8();
+
+    // find the first entry of the term
+    int first = 0;
+    int last = m_entries.count();
+    while (first < last) {
+        const int middle = (first + last) / 2;
+        const Entry &entry = m_entries.at(middle);
+        if (compareTerms(m_data + entry.term, entry.length, key.constData(), key.length()) < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    // the entries of a term are sorted by line, a line can have a term twice
+    quint32 previousLine = m_size;
+    for (int i = first; i < m_entries.count(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        if (compareTerms(m_data + entry.term, entry.length, key.constData(), key.length()) != 0) {
+            break;
+        }
+        if (entry.line == previousLine) {
+            continue;
+        }
+        previousLine = entry.line;
+
+        const char *line = m_data + entry.line;
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', m_size - entry.line));
+        if (!lineEnd) {
+            lineEnd = m_data + m_size;
+        }
+        if (lineEnd > line && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+        lines.append(QString::fromUtf8(line, lineEnd - line));
+    }
+    return lines;
+}
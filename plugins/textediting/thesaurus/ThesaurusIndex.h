@@ -0,0 +1,79 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef THESAURUSINDEX_H
+#define THESAURUSINDEX_H
+
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * An index of the terms of a thesaurus file.
+ *
+ * The file has one line per meaning, listing its terms separated by ';' with
+ * a '#' between the synonyms and the hypernyms, e.g. ";pure;unmixed;#;absolute;".
+ * Lines starting with two spaces hold the license.
+ *
+ * The file is memory mapped and the index is a table of all terms sorted
+ * case insensitively, pointing to their positions in the file, so finding the
+ * lines of a term is a binary search.
+ */
+class ThesaurusIndex
+{
+public:
+    ThesaurusIndex();
+    ~ThesaurusIndex();
+
+    /**
+     * Map the thesaurus file @p fileName and index its terms, replacing the
+     * file loaded before.
+     * @return false if the file could not be read
+     */
+    bool load(const QString &fileName);
+
+    /// @return the name of the loaded file, or an empty string if none is loaded
+    QString fileName() const;
+
+    /**
+     * @return the lines that have @p term as one of their terms, compared case
+     * insensitively, in the order of the file.
+     */
+    QStringList lines(const QString &term) const;
+
+private:
+    Q_DISABLE_COPY(ThesaurusIndex)
+
+    void clear();
+
+    /// a term in the file
+    struct Entry {
+        quint32 term;   ///< offset of the term
+        quint32 length; ///< length of the term
+        quint32 line;   ///< offset of the line
+    };
+    friend class EntryLessThan;
+
+    QFile m_file;
+    QByteArray m_contents; // used if the file cannot be mapped
+    const char *m_data;
+    quint32 m_size;
+    QVector<Entry> m_entries; // sorted by term, then by line
+};
+
+#endif // THESAURUSINDEX_H
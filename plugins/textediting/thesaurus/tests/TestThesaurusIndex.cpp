@@ -0,0 +1,91 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "TestThesaurusIndex.h"
+
+#include "../ThesaurusIndex.h"
+
+#include <QTemporaryFile>
+#include <QTest>
+
+static void writeThesaurus(QTemporaryFile &file, const QByteArray &contents)
+{
+    QVERIFY(file.open());
+    file.write(contents);
+    file.close();
+}
+
+void TestThesaurusIndex::testLookup()
+{
+    QTemporaryFile file;
+    writeThesaurus(file,
+        "  license text;absolute;\n"
+        ";absolute;#;implicit;unquestioning;\n"
+        ";direct;#;absolute;\n"
+        ";implicit;unquestioning;#;absolute;\n"
+        ";pure;unmixed;undiluted;#;absolute;\r\n"
+        ";Last;#;dying;\n"
+        ";absolutely;#;\n"
+        ";very good;#;good;");
+
+    ThesaurusIndex index;
+    QVERIFY(index.load(file.fileName()));
+    QCOMPARE(index.fileName(), file.fileName());
+
+    // all lines with the whole term, in file order and without the license
+    QStringList lines = index.lines("absolute");
+    QCOMPARE(lines.count(), 4);
+    QCOMPARE(lines.at(0), QString(";absolute;#;implicit;unquestioning;"));
+    QCOMPARE(lines.at(3), QString(";pure;unmixed;undiluted;#;absolute;"));
+
+    // case insensitive
+    QCOMPARE(index.lines("last"), QStringList() << ";Last;#;dying;");
+    QCOMPARE(index.lines("DYING"), QStringList() << ";Last;#;dying;");
+
+    // terms with spaces and the last line without a line end
+    QCOMPARE(index.lines("very good"), QStringList() << ";very good;#;good;");
+    QCOMPARE(index.lines("good"), QStringList() << ";very good;#;good;");
+
+    // no partial matches
+    QVERIFY(index.lines("absolut").isEmpty());
+    QVERIFY(index.lines("very").isEmpty());
+    QVERIFY(index.lines("#").isEmpty());
+    QVERIFY(index.lines(QString()).isEmpty());
+}
+
+void TestThesaurusIndex::testReload()
+{
+    QTemporaryFile first;
+    writeThesaurus(first, ";cut;shortened;#;abridged;\n");
+    QTemporaryFile second;
+    writeThesaurus(second, ";relative;#;comparative;\n");
+
+    ThesaurusIndex index;
+    QVERIFY(index.load(first.fileName()));
+    QCOMPARE(index.lines("cut").count(), 1);
+
+    QVERIFY(index.load(second.fileName()));
+    QVERIFY(index.lines("cut").isEmpty());
+    QCOMPARE(index.lines("comparative").count(), 1);
+
+    QVERIFY(!index.load(QString("/nonexistent/thesaurus.txt")));
+    QVERIFY(index.fileName().isEmpty());
+    QVERIFY(index.lines("relative").isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestThesaurusIndex)
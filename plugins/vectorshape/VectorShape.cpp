@@ -35,6 +35,8 @@
 #include <QMutexLocker>
 #include <QThreadPool>
 #include <QSvgRenderer>
+#include <QPicture>
+#include <QCryptographicHash>
 
 // Calligra
 #include "KoUnit.h"
@@ -47,17 +49,10 @@
 #include <KoOdfLoadingContext.h>
 #include <KoShapeSavingContext.h>
 #include <KoViewConverter.h>
-
-// Wmf support
-#include "WmfPainterBackend.h"
+#include <KoImageCache.h>
 
 // Vector shape
 #include "VectorDebug.h"
-#include "EmfParser.h"
-#include "EmfOutputPainterStrategy.h"
-#include "EmfOutputDebugStrategy.h"
-#include "SvmParser.h"
-#include "SvmPainterBackend.h"
 
 // Comment out to get uncached painting, which is good for debugging
 //#define VECTORSHAPE_PAINT_UNCACHED
@@ -65,15 +60,20 @@
 // Comment out to get unthreaded painting, which is good for debugging
 //#define VECTORSHAPE_PAINT_UNTHREADED
 
+/// the number of rendered zoom levels to remember per shape
+#define MAX_RENDERED_SIZES 8
+
 VectorShape::VectorShape()
     : KoFrameShape( KoXmlNS::draw, "image" )
     , m_type(VectorTypeNone)
     , m_isRendering(false)
+    , m_cacheKey(0)
+    , m_lastImageKey(0)
 {
     setShapeId(VectorShape_SHAPEID);
     // Default size of the shape.
     KoShape::setSize( QSizeF( CM_TO_POINT( 8 ), CM_TO_POINT( 5 ) ) );
-    m_cache.setMaxCost(3);
+    qRegisterMetaType<VectorImageDisplayList>();
 }
 
 VectorShape::~VectorShape()
@@ -101,18 +101,22 @@ void VectorShape::setCompressedContents(const QByteArray &newContents, VectorTyp
 
     m_contents = newContents;
     m_type = vectorType;
-    m_cache.clear();
+    m_displayList = VectorImageDisplayList();
+    m_cacheKeySize = QSizeF();
+    m_lastImage = QImage();
     update();
 }
 
 // ----------------------------------------------------------------
 //                             Painting
 
-RenderThread::RenderThread(const QByteArray &contents, VectorShape::VectorType type,
-                           const QSizeF &size, const QSize &boundingSize, qreal zoomX, qreal zoomY)
+RenderThread::RenderThread(const VectorImageDisplayList &displayList, const QByteArray &contents,
+                           VectorShape::VectorType type, const QSizeF &size, const QSize &boundingSize,
+                           qreal zoomX, qreal zoomY, qint64 cacheKey)
     : QObject(), QRunnable(),
       m_contents(contents), m_type(type),
-      m_size(size), m_boundingSize(boundingSize), m_zoomX(zoomX), m_zoomY(zoomY)
+      m_size(size), m_boundingSize(boundingSize), m_zoomX(zoomX), m_zoomY(zoomY),
+      m_cacheKey(cacheKey), m_displayList(displayList)
 {
     setAutoDelete(true);
 }
@@ -123,47 +127,65 @@ RenderThread::~RenderThread()
 
 void RenderThread::run()
 {
-    QImage *image = new QImage(m_boundingSize, QImage::Format_ARGB32);
-    image->fill(0);
+    // the contents are only parsed the first time, later zoom levels replay what was recorded
+    if (m_displayList.isNull() || m_displayList.size() != m_size) {
+        m_displayList = record();
+    }
+
+    QImage image(m_boundingSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
     QPainter painter;
-    if (!painter.begin(image)) {
+    if (!painter.begin(&image)) {
         warnVector << "Failed to create image-cache";
-        delete image;
-        image = 0;
     } else {
         painter.scale(m_zoomX, m_zoomY);
-        draw(painter);
+        m_displayList.replay(painter);
         painter.end();
+        m_image = image;
+        KoImageCache::instance()->insert(m_cacheKey, image);
     }
-    emit finished(m_boundingSize, image);
+    emit finished(m_cacheKey, m_image, m_displayList);
 }
 
-void RenderThread::draw(QPainter &painter)
+QImage RenderThread::image() const
 {
-    // If the data is uninitialized, e.g. because loading failed, draw the null shape.
-    if (m_contents.isEmpty()) {
-        drawNull(painter);
-        return;
-    }
+    return m_image;
+}
+
+VectorImageDisplayList RenderThread::record() const
+{
+    VectorImageDisplayList displayList;
 
-    // Actually draw the contents
+    // Actually parse the contents
     switch (m_type) {
     case VectorShape::VectorTypeWmf:
-        drawWmf(painter);
+        displayList = VectorImageDisplayList::record(VectorImageDisplayList::Wmf, m_contents, m_size);
         break;
     case VectorShape::VectorTypeEmf:
-        drawEmf(painter);
+        displayList = VectorImageDisplayList::record(VectorImageDisplayList::Emf, m_contents, m_size);
         break;
     case VectorShape::VectorTypeSvm:
-        drawSvm(painter);
+        displayList = VectorImageDisplayList::record(VectorImageDisplayList::Svm, m_contents, m_size);
         break;
     case VectorShape::VectorTypeSvg:
-        drawSvg(painter);
-        break;
     case VectorShape::VectorTypeNone:
     default:
+        break;
+    }
+    if (!displayList.isNull()) {
+        return displayList;
+    }
+
+    QPicture picture;
+    QPainter painter(&picture);
+    // If the data is uninitialized, e.g. because loading failed, draw the null shape.
+    if (m_type == VectorShape::VectorTypeSvg && !m_contents.isEmpty()) {
+        drawSvg(painter);
+    } else {
         drawNull(painter);
     }
+    painter.end();
+    return VectorImageDisplayList(picture, m_size);
 }
 
 void RenderThread::drawNull(QPainter &painter) const
@@ -180,53 +202,6 @@ void RenderThread::drawNull(QPainter &painter) const
     painter.restore();
 }
 
-void RenderThread::drawWmf(QPainter &painter) const
-{
-    Libwmf::WmfPainterBackend  wmfPainter(&painter, m_size);
-    if (!wmfPainter.load(m_contents)) {
-        drawNull(painter);
-        return;
-    }
-    painter.save();
-    // Actually paint the WMF.
-    wmfPainter.play();
-    painter.restore();
-}
-
-void RenderThread::drawEmf(QPainter &painter) const
-{
-    // FIXME: Make emfOutput use QSizeF
-    QSize  shapeSizeInt( m_size.width(), m_size.height() );
-    //debugVector << "-------------------------------------------";
-    //debugVector << "size:     " << shapeSizeInt << m_size;
-    //debugVector << "position: " << position();
-    //debugVector << "-------------------------------------------";
-
-    Libemf::Parser  emfParser;
-
-#if 1  // Set to 0 to get debug output
-    // Create a new painter output strategy.  Last param = true means keep aspect ratio.
-    Libemf::OutputPainterStrategy  emfPaintOutput( painter, shapeSizeInt, true );
-    emfParser.setOutput( &emfPaintOutput );
-#else
-    Libemf::OutputDebugStrategy  emfDebugOutput;
-    emfParser.setOutput( &emfDebugOutput );
-#endif
-    emfParser.load(m_contents);
-}
-
-void RenderThread::drawSvm(QPainter &painter) const
-{
-    QSize  shapeSizeInt( m_size.width(), m_size.height() );
-
-    Libsvm::SvmParser  svmParser;
-
-    // Create a new painter backend.
-    Libsvm::SvmPainterBackend  svmPaintOutput(&painter, shapeSizeInt);
-    svmParser.setBackend(&svmPaintOutput);
-    svmParser.parse(m_contents);
-}
-
 void RenderThread::drawSvg(QPainter &painter) const
 {
     QSvgRenderer renderer(m_contents);
@@ -249,23 +224,88 @@ void VectorShape::paint(QPainter &painter, const KoViewConverter &converter, KoS
     bool asynchronous = QFontDatabase::supportsThreadedFontRendering();
 #endif
 
-    QImage *cache = render(converter, asynchronous, useCache);
-    if (cache) { // paint cached image
-        Q_ASSERT(!cache->isNull());
+    QImage cache = render(converter, asynchronous, useCache);
+    if (!cache.isNull()) { // paint cached image
         QVector<QRect> clipRects = painter.clipRegion().rects();
         foreach (const QRect &rc, clipRects) {
-            painter.drawImage(rc.topLeft(), *cache, rc);
+            painter.drawImage(rc.topLeft(), cache, rc);
+        }
+    } else if (useCache) {
+        // while the current zoom level is rendered show the closest one we have
+        const QSize boundingSize = converter.documentToView(boundingRect()).size().toSize();
+        const QImage nearest = nearestCachedImage(boundingSize);
+        if (!nearest.isNull()) {
+            painter.drawImage(QRectF(QPointF(0, 0), boundingSize), nearest);
         }
     }
 }
 
-void VectorShape::renderFinished(const QSize &boundingSize, QImage *image)
+void VectorShape::renderFinished(qint64 cacheKey, const QImage &image, const VectorImageDisplayList &displayList)
 {
-    if (image) {
-        m_cache.insert(boundingSize.height(), image);
-        update();
+    if (displayList.size() == size()) {
+        m_displayList = displayList;
     }
     m_isRendering = false;
+    if (image.isNull()) {
+        // painting again would only start another render that fails the same way
+        return;
+    }
+    m_lastImage = image;
+    m_lastImageKey = cacheKey;
+    m_renderedSizes.removeOne(image.size());
+    m_renderedSizes.prepend(image.size());
+    while (m_renderedSizes.count() > MAX_RENDERED_SIZES) {
+        m_renderedSizes.removeLast();
+    }
+    update();
+}
+
+qint64 VectorShape::cacheKey() const
+{
+    const QSizeF shapeSize = size();
+    if (m_cacheKeySize != shapeSize) {
+        // shapes showing the same image at the same size share the rendered images
+        QMutexLocker locker(&m_mutex);
+        QCryptographicHash md5(QCryptographicHash::Md5);
+        md5.addData(m_contents);
+        md5.addData(reinterpret_cast<const char*>(&m_type), sizeof(m_type));
+        const qreal dimensions[2] = { shapeSize.width(), shapeSize.height() };
+        md5.addData(reinterpret_cast<const char*>(dimensions), sizeof(dimensions));
+        const QByteArray hash = md5.result();
+        memcpy(&m_cacheKey, hash.constData(), sizeof(m_cacheKey));
+        m_cacheKeySize = shapeSize;
+        m_renderedSizes.clear();
+    }
+    return m_cacheKey;
+}
+
+QImage VectorShape::nearestCachedImage(const QSize &size) const
+{
+    const qint64 key = cacheKey();
+    KoImageCache *cache = KoImageCache::instance();
+    QImage nearest;
+    qreal nearestRatio = 0;
+    foreach (const QSize &renderedSize, m_renderedSizes) {
+        if (!cache->contains(key, renderedSize, QImage::Format_ARGB32_Premultiplied)) {
+            continue;
+        }
+        // prefer the image that has to be scaled the least, up or down
+        qreal ratio = qreal(renderedSize.height()) / qMax(1, size.height());
+        if (ratio > 1) {
+            ratio = 1 / ratio;
+        }
+        if (ratio > nearestRatio) {
+            const QImage image = cache->find(key, renderedSize, QImage::Format_ARGB32_Premultiplied);
+            if (!image.isNull()) {
+                nearest = image;
+                nearestRatio = ratio;
+            }
+        }
+    }
+    if (nearest.isNull() && m_lastImageKey == key) {
+        nearest = m_lastImage;
+    }
+    return nearest;
 }
 
 
@@ -378,28 +418,38 @@ void VectorShape::waitUntilReady(const KoViewConverter &converter, bool asynchro
     render(converter, asynchronous, true);
 }
 
-QImage* VectorShape::render(const KoViewConverter &converter, bool asynchronous, bool useCache) const
+QImage VectorShape::render(const KoViewConverter &converter, bool asynchronous, bool useCache) const
 {
     QRectF rect = converter.documentToView(boundingRect());
-    int id = rect.size().toSize().height();
-    QImage *cache = useCache ? m_cache[id] : 0;
+    const QSize boundingSize = rect.size().toSize();
+    const qint64 key = cacheKey();
+    QImage cache = useCache
+        ? KoImageCache::instance()->find(key, boundingSize, QImage::Format_ARGB32_Premultiplied) : QImage();
+    if (cache.isNull() && useCache && m_lastImageKey == key && m_lastImage.size() == boundingSize) {
+        // the image cache dropped the image, or it was too big to go in
+        cache = m_lastImage;
+    }
 
-    if (!cache || cache->isNull()) { // recreate the cached image
-        cache = 0;
+    if (cache.isNull()) { // recreate the cached image
         if (!m_isRendering) {
             m_isRendering = true;
             qreal zoomX, zoomY;
             converter.zoom(&zoomX, &zoomY);
             QMutexLocker locker(&m_mutex);
+            // the contents are only needed when they were not parsed for this size yet
+            const bool parse = m_displayList.isNull() || m_displayList.size() != size();
             const QByteArray uncompressedContents =
-                m_type != VectorShape::VectorTypeNone ? qUncompress(m_contents) : QByteArray();
-            RenderThread *t = new RenderThread(uncompressedContents, m_type, size(), rect.size().toSize(), zoomX, zoomY);
-            connect(t, SIGNAL(finished(QSize,QImage*)), this, SLOT(renderFinished(QSize,QImage*)));
+                parse && m_type != VectorShape::VectorTypeNone ? qUncompress(m_contents) : QByteArray();
+            RenderThread *t = new RenderThread(m_displayList, uncompressedContents, m_type, size(),
+                                               boundingSize, zoomX, zoomY, key);
+            connect(t, SIGNAL(finished(qint64,QImage,VectorImageDisplayList)), this, SLOT(renderFinished(qint64,QImage,VectorImageDisplayList)));
             if (asynchronous) { // render and paint the image threaded
                 QThreadPool::globalInstance()->start(t);
             } else { // non-threaded rendering and painting of the image
+                locker.unlock();
                 t->run();
-                cache = m_cache[id];
+                cache = t->image();
+                delete t;
             }
         }
     }
@@ -26,7 +26,8 @@
 
 // Qt
 #include <QByteArray>
-#include <QCache>
+#include <QImage>
+#include <QList>
 #include <QSize>
 #include <QRunnable>
 #include <QMutex>
@@ -34,6 +35,7 @@
 // Calligra
 #include <KoShape.h>
 #include <KoFrameShape.h>
+#include <VectorImageDisplayList.h>
 
 
 #define DEBUG_VECTORSHAPE 0
@@ -82,7 +84,7 @@ public:
     static VectorShape::VectorType vectorType(const QByteArray &contents);
 
 private Q_SLOTS:
-    void renderFinished(const QSize &boundingSize, QImage *image);
+    void renderFinished(qint64 cacheKey, const QImage &image, const VectorImageDisplayList &displayList);
 
 private:
     static bool isWmf(const QByteArray &bytes);
@@ -90,14 +92,28 @@ private:
     static bool isSvm(const QByteArray &bytes);
     static bool isSvg(const QByteArray &bytes);
 
+    /// @return the key of the rendered images in KoImageCache, for the current contents and size
+    qint64 cacheKey() const;
+    /// @return the cached image with the size closest to @p size, or a null image
+    QImage nearestCachedImage(const QSize &size) const;
+
     // Member variables
     mutable VectorType  m_type;
     mutable QByteArray  m_contents;
     mutable bool m_isRendering;
     mutable QMutex m_mutex;
-    QCache<int, QImage> m_cache;
-
-    QImage* render(const KoViewConverter &converter, bool asynchronous, bool useCache) const;
+    /// the contents as parsed for the current size, to render other zoom levels from
+    mutable VectorImageDisplayList m_displayList;
+    mutable qint64 m_cacheKey;
+    mutable QSizeF m_cacheKeySize;
+    /// the sizes rendered into KoImageCache for m_cacheKey, most recent first
+    mutable QList<QSize> m_renderedSizes;
+    /// the last rendered image, for when KoImageCache dropped it or did not take it
+    QImage m_lastImage;
+    /// the cacheKey() m_lastImage was rendered for
+    qint64 m_lastImageKey;
+
+    QImage render(const KoViewConverter &converter, bool asynchronous, bool useCache) const;
 };
 
 
@@ -105,18 +121,24 @@ class RenderThread : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    RenderThread(const QByteArray &contents, VectorShape::VectorType type,
-                 const QSizeF &size, const QSize &boundingSize, qreal zoomX, qreal zoomY);
+    /**
+     * @param displayList the already parsed contents; if it is null or was recorded
+     *        for another size the contents are parsed first
+     * @param cacheKey the key the image is put into KoImageCache with
+     */
+    RenderThread(const VectorImageDisplayList &displayList, const QByteArray &contents,
+                 VectorShape::VectorType type, const QSizeF &size, const QSize &boundingSize,
+                 qreal zoomX, qreal zoomY, qint64 cacheKey);
     virtual ~RenderThread();
     virtual void run();
+    /// the rendered image, once run() returned
+    QImage image() const;
 Q_SIGNALS:
-    void finished(const QSize &boundingSize, QImage *image);
+    /// @p image is null if rendering failed
+    void finished(qint64 cacheKey, const QImage &image, const VectorImageDisplayList &displayList);
 private:
-    void draw(QPainter &painter);
+    VectorImageDisplayList record() const;
     void drawNull(QPainter &painter) const;
-    void drawWmf(QPainter &painter) const;
-    void drawEmf(QPainter &painter) const;
-    void drawSvm(QPainter &painter) const;
     void drawSvg(QPainter &painter) const;
 private:
     const QByteArray m_contents;
@@ -124,6 +146,9 @@ private:
     QSizeF m_size;
     QSize m_boundingSize;
     qreal m_zoomX, m_zoomY;
+    qint64 m_cacheKey;
+    VectorImageDisplayList m_displayList;
+    QImage m_image;
 };
 
 #endif
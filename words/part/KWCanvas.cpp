@@ -28,6 +28,7 @@
 #include "KWView.h"
 #include "KWViewMode.h"
 #include "KWPage.h"
+#include "KWPageCacheManager.h"
 
 // calligra libs includes
 #include <KoAnnotationLayoutManager.h>
@@ -41,6 +42,9 @@
 #include <QPainter>
 #include <QPainterPath>
 
+// the time in ms the canvas has to be idle before pages are rendered ahead
+static const int PRERENDER_DELAY = 50;
+
 KWCanvas::KWCanvas(const QString &viewMode, KWDocument *document, KWView *view, KWGui *parent)
         : QWidget(parent),
         KWCanvasBase(document, this),
@@ -52,6 +56,9 @@ KWCanvas::KWCanvas(const QString &viewMode, KWDocument *document, KWView *view,
     connect(document, SIGNAL(pageSetupChanged()), this, SLOT(pageSetupChanged()));
     m_viewConverter = m_view->viewConverter();
     m_viewMode = KWViewMode::create(viewMode, document);
+
+    m_prerenderTimer.setSingleShot(true);
+    connect(&m_prerenderTimer, SIGNAL(timeout()), this, SLOT(prerender()));
 }
 
 KWCanvas::~KWCanvas()
@@ -60,10 +67,21 @@ KWCanvas::~KWCanvas()
 
 void KWCanvas::pageSetupChanged()
 {
+    // the cached pages may have the old size
+    if (m_pageCacheManager) {
+        m_pageCacheManager->clear();
+    }
     m_viewMode->pageSetupChanged();
     updateSize();
 }
 
+void KWCanvas::prerender()
+{
+    if (prerenderPages(rect())) {
+        m_prerenderTimer.start(0);
+    }
+}
+
 void KWCanvas::updateSize()
 {
     resourceManager()->setResource(Words::CurrentPageCount, m_document->pageCount());
@@ -185,6 +203,11 @@ void KWCanvas::paintEvent(QPaintEvent *ev)
     paint(painter, ev->rect()); // In KWCanvasBase
 
     painter.end();
+
+    // render the neighbouring pages once the painting stops
+    if (m_cacheEnabled) {
+        m_prerenderTimer.start(PRERENDER_DELAY);
+    }
 }
 
 void KWCanvas::setCursor(const QCursor &cursor)
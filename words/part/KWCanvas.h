@@ -30,6 +30,7 @@
 
 #include "KWViewMode.h"
 
+#include <QTimer>
 #include <QWidget>
 
 class QRect;
@@ -134,10 +135,13 @@ protected: // QWidget
 private Q_SLOTS:
     /// Called whenever there was a page added/removed or simply resized.
     void pageSetupChanged();
+    /// render the pages around the visible ones into the page cache while the canvas is idle
+    void prerender();
 
 private:
 
     KWView *m_view;
+    QTimer m_prerenderTimer;
 };
 
 #endif
@@ -52,6 +52,11 @@
 
 #include <sys/time.h>
 
+// the number of pages before and after the visible pages that prerenderPages() renders
+static const int PRERENDER_PAGES = 2;
+// the height in pixels of the part of a page that prerenderPage() renders at once
+static const int PRERENDER_BAND_HEIGHT = 256;
+
 //#define DEBUG_REPAINT
 
 
@@ -65,8 +70,8 @@ KWCanvasBase::KWCanvasBase(KWDocument *document, QObject *parent)
       m_showAnnotations(false),
       m_cacheEnabled(false),
       m_currentZoom(0.0),
-      m_maxZoom(2.0),
-      m_pageCacheManager(0)
+      m_pageCacheManager(0),
+      m_cacheSize(0)
 {
     m_shapeManager = new KoShapeManager(this);
     m_toolProxy = new KoToolProxy(this, parent);
@@ -292,359 +297,267 @@ void KWCanvasBase::paint(QPainter &painter, const QRectF &paintRect)
             }
         }
         else {
+            QVector<KWViewMode::ViewMap> map =
+                    m_viewMode->mapExposedRects(paintRect.translated(m_documentOffset),
+                                                viewConverter());
 
-#if 0
-    // at the moment we're always caching at the actual zoomlevel anyway, but if we want to
-    // re-enable this distinction, the massive code duplication between these two code paths
-    // should first be removed
-            if (viewConverter()->zoom() <= m_maxZoom) { // we cache at the actual zoom level
-#endif
-                QVector<KWViewMode::ViewMap> map =
-                        m_viewMode->mapExposedRects(paintRect.translated(m_documentOffset),
-                                                    viewConverter());
-
-                foreach (KWViewMode::ViewMap vm, map) {
+            foreach (KWViewMode::ViewMap vm, map) {
 
-                    painter.save();
+                painter.save();
 
-                    // Set up the painter to clip the part of the canvas that contains the rect.
-                    painter.translate(vm.distance.x(), vm.distance.y());
-                    vm.clipRect = vm.clipRect.adjusted(-1, -1, 1, 1);
-                    painter.setClipRect(vm.clipRect);
+                // Set up the painter to clip the part of the canvas that contains the rect.
+                painter.translate(vm.distance.x(), vm.distance.y());
+                vm.clipRect = vm.clipRect.adjusted(-1, -1, 1, 1);
+                painter.setClipRect(vm.clipRect);
 
-                    // Paint the background of the page.
-                    QColor color = Qt::white;
-#ifdef DEBUG_REPAINT
-                    color = QColor(random() % 255, random() % 255, random() % 255);
-#endif
-                    painter.fillRect(vm.clipRect, QBrush(color));
+                // Paint the background of the page.  This includes
+                // the annotation area if that should be shown.
+                paintBackgrounds(painter, vm);
 
-                    // Paint the contents of the page.
-                    painter.setRenderHint(QPainter::Antialiasing);
+                // Paint the contents of the page.
+                painter.setRenderHint(QPainter::Antialiasing);
 
-                    // clear the cache if the zoom changed
-                    qreal zoom = viewConverter()->zoom();
-                    if (m_currentZoom != zoom) {
-                        m_pageCacheManager->clear();
-                        m_currentZoom = zoom;
-                    }
+                KWPageCache *pageCache = takePageCache(vm.page);
 
-                    KWPageCache *pageCache = m_pageCacheManager->take(vm.page);
+                // vm.page is in points, not view units
+                QSizeF pageSizeDocument(vm.page.width(), vm.page.height());
+                QSizeF pageSizeView = viewConverter()->documentToView(pageSizeDocument);
 
-                    if (!pageCache) {
-                        pageCache = m_pageCacheManager->cache(QSize(viewConverter()->documentToViewX(vm.page.width()),
-                                                                    viewConverter()->documentToViewY(vm.page.height())));
-                    }
+                qreal  pageTopDocument = vm.page.offsetInDocument();
+                qreal  pageTopView = viewConverter()->documentToViewY(pageTopDocument);
 
-                    Q_ASSERT(!pageCache->cache.isEmpty());
+                QRectF pageRectDocument = vm.page.rect();
+                QRectF pageRectView = viewConverter()->documentToView(pageRectDocument);
 
-                    // vm.page is in points, not view units
-                    QSizeF pageSizeDocument(vm.page.width(), vm.page.height());
-                    QSizeF pageSizeView = viewConverter()->documentToView(pageSizeDocument);
+                // translated from the page topleft to 0,0 for our cache image
+                QRectF clipRectOnPage = vm.clipRect.translated(-pageRectView.x(), -pageTopView);
 
-                    qreal  pageTopDocument = vm.page.offsetInDocument();
-                    qreal  pageTopView = viewConverter()->documentToViewY(pageTopDocument);
+                renderPageCache(pageCache, pageSizeView, pageTopView, clipRectOnPage);
 
-                    QRectF pageRectDocument = vm.page.rect();
-                    QRectF pageRectView = viewConverter()->documentToView(pageRectDocument);
+                // paint from the cached page image on the original painter
 
-                    // translated from the page topleft to 0,0 for our cache image
-                    QRectF clipRectOnPage = vm.clipRect.translated(-pageRectView.x(), -pageTopView);
-
-                    // create exposed rects when the page is to be completely repainted.
-                    // we cannot wait for the updateCanvas calls to actually tell us which parts
-                    // need painting, because updateCanvas is not called when a page is done
-                    // layouting.
-                    if (pageCache->allExposed)  {
-
-                        pageCache->exposed.clear();
-                        QRect rc(QPoint(0,0), pageSizeView.toSize());
-
-                        const int UPDATE_WIDTH = 900;
-                        const int UPDATE_HEIGHT = 128;
-
-                        int row = 0;
-                        int heightLeft = rc.height();
-                        while (heightLeft > 0) {
-                            int height = qMin(heightLeft, UPDATE_HEIGHT);
-                            int column = 0;
-                            int columnLeft = rc.width();
-                            while (columnLeft > 0) {
-                                int width = qMin(columnLeft, UPDATE_WIDTH);
-                                QRect rc2(column, row, width, height);
-                                pageCache->exposed << rc2;
-                                columnLeft -= width;
-                                column += width;
-                            }
-                            heightLeft -= height;
-                            row += height;
-                        }
-                        pageCache->allExposed = false;
+                int tilex = 0, tiley = 0;
+                for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
+                    int dx = pageCache->cache[i].width();
+                    for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
+                        const QImage& cacheImage = pageCache->cache[i];
+                        QRectF tile(tilex, tiley, cacheImage.width(), cacheImage.height());
+                        QRectF toPaint = tile.intersected(clipRectOnPage);
+                        QRectF dst = toPaint.translated(pageRectView.topLeft());
+                        QRectF src = toPaint.translated(-tilex, -tiley);
+                        painter.drawImage(dst, cacheImage, src);
+                        tiley += cacheImage.height();
                     }
+                    tilex += dx;
+                    tiley = 0;
+                }
 
-                    // There is stuff to be repainted, so collect all the repaintable
-                    // rects that are in view and paint them.
-                    if (!pageCache->exposed.isEmpty()) {
-                        QRegion paintRegion;
-                        QVector<QRect> remainingUnExposed;
-                        const QVector<QRect> &exposed = pageCache->exposed;
-                        for (int i = 0; i < exposed.size(); ++i) {
-
-                            QRect rc = exposed.at(i);
-
-                            if (rc.intersects(clipRectOnPage.toRect())) {
-                                paintRegion += rc;
-                                int tilex = 0, tiley = 0;
-                                for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
-                                    int dx = pageCache->cache[i].width();
-                                    for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
-                                        QImage& img = pageCache->cache[i];
-                                        QRect tile(tilex, tiley, img.width(), img.height());
-                                        QRect toClear = tile.intersected(rc);
-                                        if (!toClear.isEmpty()) {
-                                            QPainter gc(&img);
-                                            gc.eraseRect(toClear.translated(-tilex, -tiley));
-                                            gc.end();
-                                        }
-                                        tiley += img.height();
-                                    }
-                                    tilex += dx;
-                                    tiley = 0;
-                                }
-                            }
-                            else {
-                                remainingUnExposed << rc;
-                            }
-                        }
-                        pageCache->exposed = remainingUnExposed;
-                        if (!paintRegion.isEmpty()) {
-                            // paint the exposed regions of the page
-
-                            QRect r = paintRegion.boundingRect();
-                            QImage img(r.size(), QImage::Format_RGB16);
-                            img.fill(0xffff);
-
-                            // we paint to a small image as it is much faster the painting to the big image
-                            QPainter tilePainter(&img);
-                            tilePainter.setClipRect(QRect(QPoint(0,0), r.size()));
-                            tilePainter.translate(-r.left(), -pageTopView - r.top());
-                            tilePainter.setRenderHint(QPainter::Antialiasing);
-                            shapeManager()->paint(tilePainter, *viewConverter(), false);
-
-                            int tilex = 0, tiley = 0;
-                            for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
-                                int dx = pageCache->cache[i].width();
-                                for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
-                                    QImage& tileImg = pageCache->cache[i];
-                                    QRect tile(tilex, tiley, tileImg.width(), tileImg.height());
-                                    QRect toPaint = tile.intersected(r);
-                                    if (!toPaint.isEmpty()) {
-                                        QPainter imagePainter(&tileImg);
-                                        imagePainter.drawImage(r.topLeft() - QPoint(tilex, tiley), img);
-                                    }
-                                    tiley += tileImg.height();
-                                }
-                                tilex += dx;
-                                tiley = 0;
-                            }
-                        }
-                    }
-                    // paint from the cached page image on the original painter
-
-                    int tilex = 0, tiley = 0;
-                    for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
-                        int dx = pageCache->cache[i].width();
-                        for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
-                            const QImage& cacheImage = pageCache->cache[i];
-                            QRectF tile(tilex, tiley, cacheImage.width(), cacheImage.height());
-                            QRectF toPaint = tile.intersected(clipRectOnPage);
-                            QRectF dst = toPaint.translated(pageRectView.topLeft());
-                            QRectF src = toPaint.translated(-tilex, -tiley);
-                            painter.drawImage(dst, cacheImage, src);
-                            tiley += cacheImage.height();
-                        }
-                        tilex += dx;
-                        tiley = 0;
-                    }
+                // put the cache back
+                m_pageCacheManager->insert(vm.page, pageCache);
+                paintBorder(painter, vm);
 
-                    // put the cache back
-                    m_pageCacheManager->insert(vm.page, pageCache);
-                    // Paint the page decorations: border, shadow, etc.
-                    paintPageDecorations(painter, vm);
+                // Paint the page decorations: shadow, etc.
+                paintPageDecorations(painter, vm);
 
-                    // Paint the grid
-                    paintGrid(painter, vm);
+                // Paint the grid
+                paintGrid(painter, vm);
 
-                    // paint whatever the tool wants to paint
-                    m_toolProxy->paint(painter, *(viewConverter()));
-                    painter.restore();
+                // paint whatever the tool wants to paint
+                m_toolProxy->paint(painter, *(viewConverter()));
+                painter.restore();
 
-                    int contentArea = vm.clipRect.width() * vm.clipRect.height();
-                    if (contentArea > pageContentArea) {
-                        pageContentArea = contentArea;
-                    }
+                int contentArea = vm.clipRect.width() * vm.clipRect.height();
+                if (contentArea > pageContentArea) {
+                    pageContentArea = contentArea;
                 }
-#if 0
             }
-            else { // we cache at 100%, but paint at the actual zoom level
-
-                KoViewConverter localViewConverter;
-                localViewConverter.setZoom(1.0);
-
-                QVector<KWViewMode::ViewMap> map =
-                        m_viewMode->mapExposedRects(paintRect.translated(m_documentOffset),
-                                                    viewConverter());
-                foreach (KWViewMode::ViewMap vm, map) {
-
-                    painter.save();
-
-                    // Set up the painter to clip the part of the canvas that contains the rect.
-                    painter.translate(vm.distance.x(), vm.distance.y());
-                    vm.clipRect = vm.clipRect.adjusted(-1, -1, 1, 1);
-                    painter.setClipRect(vm.clipRect);
-
-                    // Paint the background of the page.
-                    QColor color = Qt::white;
-#ifdef DEBUG_REPAINT
-                    color = QColor(random() % 255, random() % 255, random() % 255);
-#endif
-                    painter.fillRect(vm.clipRect, QBrush(color));
-
-                    // Paint the contents of the page.
-                    painter.setRenderHint(QPainter::Antialiasing);
-
-                    // clear the cache if the zoom changed
-                    qreal zoom = 1.0;
-                    if (m_currentZoom != zoom) {
-                        m_pageCacheManager->clear();
-                        m_currentZoom = zoom;
-                    }
-
-                    KWPageCache *pageCache = m_pageCacheManager->take(vm.page);
-                    if (!pageCache) {
-                        pageCache = m_pageCacheManager->cache(QSize(localViewConverter.documentToViewX(vm.page.width()),
-                                                                    localViewConverter.documentToViewY(vm.page.height())));
-                    }
-                    Q_ASSERT(pageCache->cache);
-
-                    // vm.page is in points, not view units
-                    QSizeF pageSizeDocument(vm.page.width(), vm.page.height());
-                    QSizeF pageSizeView = localViewConverter.documentToView(pageSizeDocument);
-
-                    qreal  pageTopDocument = vm.page.offsetInDocument();
-                    qreal  pageTopView = localViewConverter.documentToViewY(pageTopDocument);
+        }
+    } else {
+        // TODO paint the main-text-flake directly
+        warnWordsUI << "Non-page painting not implemented yet!";
+    }
+}
 
-                    QRectF pageRectDocument = vm.page.rect();
-                    QRectF pageRectView = localViewConverter.documentToView(pageRectDocument);
+KWPageCache *KWCanvasBase::takePageCache(const KWPage &page)
+{
+    // clear the cache if the zoom changed
+    qreal zoom = viewConverter()->zoom();
+    if (m_currentZoom != zoom) {
+        m_pageCacheManager->clear();
+        m_currentZoom = zoom;
+    }
 
-                    // translated from the page topleft to 0,0 for our cache image
-                    QRectF documentClipRect = m_viewMode->viewToDocument(vm.clipRect, viewConverter());
-                    QRectF clipRectOnPage = localViewConverter.documentToView(documentClipRect);
-                    clipRectOnPage = clipRectOnPage.translated(-pageRectView.x(), -pageTopView);
+    KWPageCache *pageCache = m_pageCacheManager->take(page);
 
-                    // create exposed rects when the page is to be completely repainted.
-                    // we cannot wait for the updateCanvas calls to actually tell us which parts
-                    // need painting, because updateCanvas is not called when a page is done
-                    // layouting.
-                    if (pageCache->allExposed)  {
+    if (!pageCache) {
+        pageCache = m_pageCacheManager->cache(QSize(viewConverter()->documentToViewX(page.width()),
+                                                    viewConverter()->documentToViewY(page.height())));
+    }
 
-                        pageCache->exposed.clear();
-                        QRect rc(QPoint(0,0), pageSizeView.toSize());
+    Q_ASSERT(!pageCache->cache.isEmpty());
+    return pageCache;
+}
 
-                        const int UPDATE_SIZE = 64; //pixels
+void KWCanvasBase::renderPageCache(KWPageCache *pageCache, const QSizeF &pageSizeView, qreal pageTopView,
+                                   const QRectF &clipRectOnPage)
+{
+    // a page new to the cache is rendered completely, in bands. Afterwards only
+    // the rects passed to updateCanvas are rendered again, so the cache relies on
+    // the shapes asking for an update whenever their content changes.
+    if (pageCache->allExposed)  {
+
+        pageCache->exposed.clear();
+        QRect rc(QPoint(0,0), pageSizeView.toSize());
+
+        const int UPDATE_WIDTH = 900;
+        const int UPDATE_HEIGHT = 128;
+
+        int row = 0;
+        int heightLeft = rc.height();
+        while (heightLeft > 0) {
+            int height = qMin(heightLeft, UPDATE_HEIGHT);
+            int column = 0;
+            int columnLeft = rc.width();
+            while (columnLeft > 0) {
+                int width = qMin(columnLeft, UPDATE_WIDTH);
+                QRect rc2(column, row, width, height);
+                pageCache->exposed << rc2;
+                columnLeft -= width;
+                column += width;
+            }
+            heightLeft -= height;
+            row += height;
+        }
+        pageCache->allExposed = false;
+    }
 
-                        if (rc.height() < UPDATE_SIZE) {
-                            pageCache->exposed << rc;
+    // There is stuff to be repainted, so collect all the repaintable
+    // rects that are in view and paint them.
+    if (!pageCache->exposed.isEmpty()) {
+        QRegion paintRegion;
+        QVector<QRect> remainingUnExposed;
+        const QVector<QRect> &exposed = pageCache->exposed;
+        for (int i = 0; i < exposed.size(); ++i) {
+
+            QRect rc = exposed.at(i);
+
+            if (rc.intersects(clipRectOnPage.toRect())) {
+                paintRegion += rc;
+                int tilex = 0, tiley = 0;
+                for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
+                    int dx = pageCache->cache[i].width();
+                    for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
+                        QImage& img = pageCache->cache[i];
+                        QRect tile(tilex, tiley, img.width(), img.height());
+                        QRect toClear = tile.intersected(rc);
+                        if (!toClear.isEmpty()) {
+                            QPainter gc(&img);
+                            gc.eraseRect(toClear.translated(-tilex, -tiley));
+                            gc.end();
                         }
-                        else {
-                            int row = 0;
-                            int hleft = rc.height();
-                            int w = rc.width();
-                            while (hleft > 0) {
-                                QRect rc2(0, row, w, qMin(hleft, UPDATE_SIZE));
-                                pageCache->exposed << rc2;
-                                hleft -= UPDATE_SIZE;
-                                row += UPDATE_SIZE;
-                            }
-                        }
-                        pageCache->allExposed = false;
+                        tiley += img.height();
                     }
-
-                    // There is stuff to be repainted, so collect all the repaintable
-                    // rects that are in view and paint them.
-                    if (!pageCache->exposed.isEmpty()) {
-                        QRegion paintRegion;
-                        QVector<QRect> remainingUnExposed;
-                        const QVector<QRect> &exposed = pageCache->exposed;
-                        for (int i = 0; i < exposed.size(); ++i) {
-
-                            QRect rc = exposed.at(i);
-
-                            if (rc.intersects(clipRectOnPage.toRect())) {
-                                paintRegion += rc;
-                                QPainter gc(pageCache->cache);
-                                gc.eraseRect(rc);
-                                gc.end();
-                            }
-                            else {
-                                remainingUnExposed << rc;
-                            }
-                        }
-
-                        pageCache->exposed = remainingUnExposed;
-
-                        // paint the exposed regions of the page
-                        QPainter gc(pageCache->cache);
-                        gc.translate(0, -pageTopView);
-                        gc.setClipRegion(paintRegion.translated(0, pageTopView));
-
-                        // paint into the cache
-                        shapeManager()->paint(gc, localViewConverter, false);
+                    tilex += dx;
+                    tiley = 0;
+                }
+            }
+            else {
+                remainingUnExposed << rc;
+            }
+        }
+        pageCache->exposed = remainingUnExposed;
+        if (!paintRegion.isEmpty()) {
+            // paint the exposed regions of the page
+
+            QRect r = paintRegion.boundingRect();
+            QImage img(r.size(), QImage::Format_RGB16);
+            img.fill(0xffff);
+
+            // we paint to a small image as it is much faster the painting to the big image
+            QPainter tilePainter(&img);
+            tilePainter.setClipRect(QRect(QPoint(0,0), r.size()));
+            tilePainter.translate(-r.left(), -pageTopView - r.top());
+            tilePainter.setRenderHint(QPainter::Antialiasing);
+            shapeManager()->paint(tilePainter, *viewConverter(), false);
+
+            int tilex = 0, tiley = 0;
+            for (int x = 0, i = 0; x < pageCache->m_tilesx; ++x) {
+                int dx = pageCache->cache[i].width();
+                for (int y = 0; y < pageCache->m_tilesy; ++y, ++i) {
+                    QImage& tileImg = pageCache->cache[i];
+                    QRect tile(tilex, tiley, tileImg.width(), tileImg.height());
+                    QRect toPaint = tile.intersected(r);
+                    if (!toPaint.isEmpty()) {
+                        QPainter imagePainter(&tileImg);
+                        imagePainter.drawImage(r.topLeft() - QPoint(tilex, tiley), img);
                     }
-                    QImage copy = pageCache->cache->copy(clipRectOnPage.toRect());
-
-                    // Now calculate where to paint pour stuff
-                    pageTopView = viewConverter()->documentToViewY(pageTopDocument);
-                    pageRectView = viewConverter()->documentToView(pageRectDocument);
-                    clipRectOnPage = viewConverter()->documentToView(documentClipRect);
-                    clipRectOnPage = clipRectOnPage.translated(-pageRectView.x(), -pageTopView);
-
-                    copy = copy.scaled(clipRectOnPage.width(), clipRectOnPage.height(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-                    // paint from the cached page image on the original painter.
-                    QRect dst = QRect(pageRectView.x() + clipRectOnPage.x(),
-                                      pageRectView.y() + clipRectOnPage.y(),
-                                      clipRectOnPage.width(),
-                                      clipRectOnPage.height());
-
-                    painter.drawImage(dst.x(), dst.y(), copy, 0, 0, copy.width(), copy.height());
-                    painter.restore();
-
-                    // put the cache back
-                    m_pageCacheManager->insert(vm.page, pageCache);
+                    tiley += tileImg.height();
+                }
+                tilex += dx;
+                tiley = 0;
+            }
+        }
+    }
+}
 
-                    // Paint the page decorations: border, shadow, etc.
-                    paintPageDecorations(painter, vm);
+bool KWCanvasBase::prerenderPages(const QRectF &visibleRect)
+{
+    if (!m_cacheEnabled || !m_pageCacheManager || !m_viewMode->hasPages()) {
+        return false;
+    }
 
-                    // Paint the grid
-                    paintGrid(painter, vm);
+    int firstPage = -1;
+    int lastPage = -1;
+    QVector<KWViewMode::ViewMap> map =
+            m_viewMode->mapExposedRects(visibleRect.translated(m_documentOffset), viewConverter());
+    foreach (const KWViewMode::ViewMap &vm, map) {
+        const int pageNumber = vm.page.pageNumber();
+        if (firstPage == -1 || pageNumber < firstPage) {
+            firstPage = pageNumber;
+        }
+        lastPage = qMax(lastPage, pageNumber);
+    }
+    if (firstPage == -1) {
+        return false;
+    }
 
-                    // paint whatever the tool wants to paint
-                    m_toolProxy->paint(painter, *(viewConverter()));
+    // the nearest pages first, the ones after the visible pages before the ones in front of them
+    for (int distance = 1; distance <= PRERENDER_PAGES; ++distance) {
+        const KWPage pages[] = {
+            m_document->pageManager()->page(lastPage + distance),
+            m_document->pageManager()->page(firstPage - distance)
+        };
+        for (int i = 0; i < 2; ++i) {
+            if (pages[i].isValid() && prerenderPage(pages[i])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
+bool KWCanvasBase::prerenderPage(const KWPage &page)
+{
+    const QSizeF pageSizeView = viewConverter()->documentToView(QSizeF(page.width(), page.height()));
+    // do not push pages out of the cache that were really shown
+    if (m_currentZoom == viewConverter()->zoom() && !m_pageCacheManager->contains(page)
+            && !m_pageCacheManager->hasRoomFor(pageSizeView.toSize())) {
+        return false;
+    }
 
-                    int contentArea = qRound(vm.clipRect.width() * vm.clipRect.height());
-                    if (contentArea > pageContentArea) {
-                        pageContentArea = contentArea;
-                    }
-                }
-            }
-#endif
+    KWPageCache *pageCache = takePageCache(page);
+    const bool rendered = !pageCache->allExposed && pageCache->exposed.isEmpty();
+    if (!rendered) {
+        // only a band of the page, so the canvas stays responsive
+        QRectF band(0, 0, pageSizeView.width(), PRERENDER_BAND_HEIGHT);
+        if (!pageCache->allExposed) {
+            band.moveTop(pageCache->exposed.first().top());
         }
-    } else {
-        // TODO paint the main-text-flake directly
-        warnWordsUI << "Non-page painting not implemented yet!";
+        const qreal pageTopView = viewConverter()->documentToViewY(page.offsetInDocument());
+        renderPageCache(pageCache, pageSizeView, pageTopView, band);
     }
+    m_pageCacheManager->insert(page, pageCache);
+    return !rendered;
 }
 
 void KWCanvasBase::updateCanvas(const QRectF &rc)
@@ -662,116 +575,42 @@ void KWCanvasBase::updateCanvas(const QRectF &rc)
         }
     }
     else { // Caching at the actual zoom level
-        if (viewConverter()->zoom() <= m_maxZoom) {
-            QRectF zoomedRect = m_viewMode->documentToView(rc, viewConverter());
-            QVector<KWViewMode::ViewMap> map = m_viewMode->mapExposedRects(zoomedRect,
-                                                                         viewConverter());
-            foreach (KWViewMode::ViewMap vm, map) {
-                vm.clipRect.adjust(-2, -2, 2, 2); // grow for anti-aliasing
-                QRect finalClip((int)(vm.clipRect.x() + vm.distance.x() - m_documentOffset.x()),
-                                (int)(vm.clipRect.y() + vm.distance.y() - m_documentOffset.y()),
-                                vm.clipRect.width(), vm.clipRect.height());
-
-                if (!m_pageCacheManager) {
-                    // no pageCacheManager, so create one for the current view. This happens only once!
-                    // so on zoom change, we don't re-pre-generate weight/zoom images.
-                    m_pageCacheManager = new KWPageCacheManager(m_cacheSize);
-                }
-
-                if (m_currentZoom != viewConverter()->zoom()) {
-                    m_currentZoom = viewConverter()->zoom();
-                    m_pageCacheManager->clear();
-                }
-
-                KWPageCache *pageCache = m_pageCacheManager->take(vm.page);
-                if (pageCache) {
-                    //if (rc.isNull()) {
-                        pageCache->allExposed = true;
-                        pageCache->exposed.clear();
-#if 0
-                    }
-                    else {
-                        qreal  pageTopDocument = vm.page.offsetInDocument();
-                        qreal  pageTopView = viewConverter()->documentToViewY(pageTopDocument);
-                        QRectF pageRectDocument = vm.page.rect();
-                        QRectF pageRectView = viewConverter()->documentToView(pageRectDocument);
-
-                        // translated from the page topleft to 0,0 for our cache image
-                        QRect clipRectOnPage = vm.clipRect.translated(-pageRectView.x(), -pageTopView);
+        QRectF zoomedRect = m_viewMode->documentToView(rc, viewConverter());
+        QVector<KWViewMode::ViewMap> map = m_viewMode->mapExposedRects(zoomedRect,
+                                                                     viewConverter());
+        foreach (KWViewMode::ViewMap vm, map) {
+            vm.clipRect.adjust(-2, -2, 2, 2); // grow for anti-aliasing
+            QRect finalClip((int)(vm.clipRect.x() + vm.distance.x() - m_documentOffset.x()),
+                            (int)(vm.clipRect.y() + vm.distance.y() - m_documentOffset.y()),
+                            vm.clipRect.width(), vm.clipRect.height());
 
-                        pageCache->exposed.append(clipRectOnPage);
-                    }
-#endif
-                    m_pageCacheManager->insert(vm.page, pageCache);
-                }
-                updateCanvasInternal(finalClip);
+            if (!m_pageCacheManager) {
+                // no pageCacheManager, so create one for the current view. This happens only once!
+                // so on zoom change, we don't re-pre-generate weight/zoom images.
+                m_pageCacheManager = new KWPageCacheManager(m_cacheSize);
             }
-        }
-        else { // Cache at 100%, but update the canvas at the actual zoom level
-
-            KoViewConverter localViewConverter;
-            localViewConverter.setZoom(1.0);
-
-            // Viewmap scaled to 100% for calculating which parts of the cached page image
-            // are exposed.
-            QRectF zoomedRect = m_viewMode->documentToView(rc, &localViewConverter);
-            QVector<KWViewMode::ViewMap> map = m_viewMode->mapExposedRects(zoomedRect, &localViewConverter);
 
-            // Viewmap scaled to the actual size of the canvas, so we know which areas to call
-            // update() for.
-            zoomedRect = m_viewMode->documentToView(rc, viewConverter());
-            QVector<KWViewMode::ViewMap> actualMap = m_viewMode->mapExposedRects(zoomedRect, viewConverter());
-
-            Q_ASSERT(actualMap.size() == map.size());
-
-            for (int index = 0; index < map.size(); ++index) {
-
-                Q_ASSERT(index < map.size());
-                KWViewMode::ViewMap vm = map.at(index);
-                vm.clipRect.adjust(-2, -2, 2, 2); // grow for anti-aliasing
-
-                Q_ASSERT(index < actualMap.size());
-                KWViewMode::ViewMap actualVm = actualMap.at(index);
-                actualVm.clipRect.adjust(-2, -2, 2, 2); // grow for anti-aliasing
-                QRect finalClip = QRect((int)(actualVm.clipRect.x() + vm.distance.x() - m_documentOffset.x()),
-                                        (int)(actualVm.clipRect.y() + vm.distance.y() - m_documentOffset.y()),
-                                        actualVm.clipRect.width(),
-                                        actualVm.clipRect.height());
-
-                if (!m_pageCacheManager) {
-                    // no pageCacheManager, so create one for the current view. This happens only once!
-                    // so on zoom change, we don't re-pre-generate weight/zoom images.
-                    m_pageCacheManager = new KWPageCacheManager(m_cacheSize);
-                }
-
-                if (m_currentZoom != 1.0) {
-                    m_pageCacheManager->clear();
-                    m_currentZoom = 1.0;
-                }
+            if (m_currentZoom != viewConverter()->zoom()) {
+                m_currentZoom = viewConverter()->zoom();
+                m_pageCacheManager->clear();
+            }
 
-                KWPageCache *pageCache = m_pageCacheManager->take(vm.page);
-                if (pageCache) {
-                    //if (rc.isNull()) {
-                        pageCache->allExposed = true;
-                        pageCache->exposed.clear();
-#if 0
-                    }
-                    else {
-                        qreal pageTopDocument = vm.page.offsetInDocument();
-                        qreal pageTopView = localViewConverter.documentToViewY(pageTopDocument);
-                        QRectF pageRectDocument = vm.page.rect();
-                        QRectF pageRectView = localViewConverter.documentToView(pageRectDocument);
+            KWPageCache *pageCache = m_pageCacheManager->take(vm.page);
+            if (pageCache) {
+                if (!pageCache->allExposed) {
+                    qreal  pageTopDocument = vm.page.offsetInDocument();
+                    qreal  pageTopView = viewConverter()->documentToViewY(pageTopDocument);
+                    QRectF pageRectDocument = vm.page.rect();
+                    QRectF pageRectView = viewConverter()->documentToView(pageRectDocument);
 
-                        // translated from the page topleft to 0,0 for our cache image
-                        QRect clipRectOnPage = vm.clipRect.translated(-pageRectView.x(), -pageTopView);
+                    // translated from the page topleft to 0,0 for our cache image
+                    QRect clipRectOnPage = QRectF(vm.clipRect).translated(-pageRectView.x(), -pageTopView).toAlignedRect();
 
-                        pageCache->exposed.append(clipRectOnPage);
-                    }
-#endif
-                    m_pageCacheManager->insert(vm.page, pageCache);
+                    pageCache->exposed.append(clipRectOnPage);
                 }
-                updateCanvasInternal(finalClip);
+                m_pageCacheManager->insert(vm.page, pageCache);
             }
+            updateCanvasInternal(finalClip);
         }
     }
 }
@@ -782,7 +621,7 @@ KoViewConverter *KWCanvasBase::viewConverter() const
     return m_viewConverter;
 }
 
-void KWCanvasBase::setCacheEnabled(bool enabled, int cacheSize, qreal maxZoom)
+void KWCanvasBase::setCacheEnabled(bool enabled, int cacheSize)
 {
     if ((!m_pageCacheManager && enabled) || (m_cacheSize != cacheSize)) {
         delete m_pageCacheManager;
@@ -790,7 +629,6 @@ void KWCanvasBase::setCacheEnabled(bool enabled, int cacheSize, qreal maxZoom)
     }
     m_cacheEnabled = enabled;
     m_cacheSize = cacheSize;
-    m_maxZoom = maxZoom;
 }
 
 QPoint KWCanvasBase::documentOffset() const
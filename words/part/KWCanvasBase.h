@@ -42,6 +42,7 @@ class QPainter;
 class KoToolProxy;
 class KoShape;
 class KoViewConverter;
+class KWPageCache;
 class KWPageCacheManager;
 
 class WORDS_EXPORT KWCanvasBase : public KoCanvasBase
@@ -92,17 +93,16 @@ public: // KoCanvasBase interface methods.
 
     /**
      * Enable or disable the page cache. The cache stores the rendered pages. It is
-     * emptied when the zoomlevel changes.
+     * emptied when the zoomlevel changes. It is disabled by default; the pages are
+     * cached in 16 bit color, and only the areas passed to updateCanvas() are
+     * rendered into the cache again.
      *
      * @param enabled: if true, we cache the contents of the document for this canvas,
      *  for the current zoomlevel
-     * @param cacheSize: the maximum size for the cache. The cache will throw away
-     *  pages once this size is reached. Depending on Qt's implementation of QCache, the
-     *  unit is pages.
-     * @param maxZoom above this zoomlevel we'll paint a scaled version of the cache, instead
-     *  of creating a new cache
+     * @param cacheSize: the maximum memory the cached pages may take, in megabytes. The
+     *  cache will throw away the pages used longest ago once this size is reached.
      */
-    virtual void setCacheEnabled(bool enabled, int cacheSize = 50, qreal maxZoom = 2.0);
+    virtual void setCacheEnabled(bool enabled, int cacheSize = 50);
 
     /**
      * return whether annotations are shown in the canvas.
@@ -113,6 +113,16 @@ public: // KoCanvasBase interface methods.
     /// @return the offset of the document in this canvas
     QPoint documentOffset() const;
 
+    /**
+     * Render a part of one of the pages around the visible pages into the page
+     * cache, so they do not have to be painted when they are scrolled into view.
+     * Call this again while it returns true, when the canvas is idle.
+     *
+     * @param visibleRect the visible part of the canvas, in view coordinates
+     * @return true if there is more to render
+     */
+    bool prerenderPages(const QRectF &visibleRect);
+
 protected:
 
     void paint(QPainter &painter, const QRectF &paintRect);
@@ -142,6 +152,17 @@ protected:
 
     virtual void updateCanvasInternal(const QRectF &clip) = 0;
 
+private:
+    /// @return the cache of @p page for the current zoom, taken out of the page cache manager
+    KWPageCache *takePageCache(const KWPage &page);
+
+    /// render the outdated parts of @p pageCache that are within @p clipRectOnPage
+    void renderPageCache(KWPageCache *pageCache, const QSizeF &pageSizeView, qreal pageTopView,
+                         const QRectF &clipRectOnPage);
+
+    /// render a band of @p page into its cache, return true if something was rendered
+    bool prerenderPage(const KWPage &page);
+
 protected:
 
     KWDocument *m_document;
@@ -154,7 +175,6 @@ protected:
 
     bool m_cacheEnabled;
     qreal m_currentZoom;
-    qreal m_maxZoom; //< above this zoomlevel we scale the cached image, instead of recreating the cache.
     KWPageCacheManager *m_pageCacheManager;
     int m_cacheSize;
 
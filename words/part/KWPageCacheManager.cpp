@@ -24,6 +24,7 @@
 
 static const int MAX_TILE_SIZE = 1024;
 
+
 /*
 KWPageCache::KWPageCache(KWPageCacheManager *manager, QImage *img)
     : m_manager(manager), cache(img), allExposed(true)
@@ -57,8 +58,17 @@ KWPageCache::~KWPageCache()
 {
 }
 
+int KWPageCache::memoryUsage() const
+{
+    int bytes = 0;
+    foreach (const QImage &image, cache) {
+        bytes += image.byteCount();
+    }
+    return bytes;
+}
+
 KWPageCacheManager::KWPageCacheManager(int cacheSize)
-    : m_cache(cacheSize)
+    : m_cache(cacheSize * 1024)
 {
 }
 
@@ -78,9 +88,7 @@ KWPageCache *KWPageCacheManager::take(const KWPage &page)
 
 void KWPageCacheManager::insert(const KWPage &page, KWPageCache *cache)
 {
-    QSize size = cache->m_size;
-    // make sure always at least two pages can be cached
-    m_cache.insert(page, cache, qMin(m_cache.maxCost() / 2, size.width() * size.height()));
+    m_cache.insert(page, cache, cost(cache->memoryUsage()));
 }
 
 KWPageCache *KWPageCacheManager::cache(const QSize &size)
@@ -92,6 +100,23 @@ KWPageCache *KWPageCacheManager::cache(const QSize &size)
     return cache;
 }
 
+bool KWPageCacheManager::contains(const KWPage &page) const
+{
+    return m_cache.contains(page);
+}
+
+bool KWPageCacheManager::hasRoomFor(const QSize &size) const
+{
+    // the images are in Format_RGB16
+    return m_cache.totalCost() + cost(qint64(size.width()) * size.height() * 2) <= m_cache.maxCost();
+}
+
+int KWPageCacheManager::cost(qint64 bytes) const
+{
+    // in kilobytes of image memory; make sure always at least two pages can be cached
+    return qMin<qint64>(m_cache.maxCost() / 2, qMax<qint64>(1, bytes / 1024));
+}
+
 void KWPageCacheManager::clear()
 {
     m_cache.clear();
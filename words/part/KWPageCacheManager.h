@@ -41,6 +41,9 @@ public:
     KWPageCache(KWPageCacheManager *manager, int w, int h);
     ~KWPageCache();
 
+    /// @return the number of bytes the images of this cache take
+    int memoryUsage() const;
+
     KWPageCacheManager* m_manager;
     QVector<QImage> cache;
     int m_tilesx, m_tilesy;
@@ -53,10 +56,16 @@ public:
     bool allExposed;
 };
 
+/**
+ * Keeps the rendered images of the pages of a canvas. The images may take up
+ * to a given amount of memory; when that is used up the pages that were used
+ * the longest time ago are dropped.
+ */
 class KWPageCacheManager {
 
 public:
 
+    /// @param cacheSize the memory the page images may take, in megabytes
     explicit KWPageCacheManager(int cacheSize);
 
     ~KWPageCacheManager();
@@ -67,9 +76,18 @@ public:
 
     KWPageCache *cache(const QSize &size);
 
+    /// @return true if there is a cache for @p page
+    bool contains(const KWPage &page) const;
+
+    /// @return true if a cache for a page of @p size fits in without dropping other pages
+    bool hasRoomFor(const QSize &size) const;
+
     void clear();
 
 private:
+    /// @return the cost in the cache of a page whose images take @p bytes
+    int cost(qint64 bytes) const;
+
     QCache<KWPage, KWPageCache> m_cache;
     friend class KWPageCache;
 };
@@ -180,6 +180,10 @@ void KWTextFrameSet::setupDocument()
     // the KoTextDocumentLayout needs to be setup after the actions above are done to prepare the document
     KoTextDocumentLayout *lay = new KoTextDocumentLayout(m_document, m_rootAreaProvider);
     lay->setWordprocessingMode();
+    if (m_textFrameSetType == Words::MainTextFrameSet) {
+        // layout long documents in slices so the first pages can be used while the rest is layouted
+        lay->setLayoutTimeSlice(50);
+    }
 
     QObject::connect(lay, SIGNAL(foundAnnotation(KoShape*,QPointF)),
                      m_wordsDocument->annotationLayoutManager(), SLOT(registerAnnotationRefPosition(KoShape*,QPointF)));
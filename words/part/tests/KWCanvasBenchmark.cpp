@@ -0,0 +1,122 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "KWCanvasBenchmark.h"
+
+#include <KWDocument.h>
+#include <KWCanvasItem.h>
+#include <KWViewModeNormal.h>
+
+#include "MockPart.h"
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QTest>
+
+/// the size of the visible part of the canvas, in pixels
+#define VIEW_WIDTH 1000
+#define VIEW_HEIGHT 800
+/// the distance scrolled for each frame, in pixels
+#define SCROLL_STEP 120
+/// the number of prerender calls done between two frames, for an idle canvas
+#define IDLE_PRERENDER_CALLS 4
+
+class BenchmarkCanvas : public KWCanvasItem
+{
+public:
+    explicit BenchmarkCanvas(KWDocument *document)
+        : KWCanvasItem(KWViewModeNormal::viewMode(), document)
+    {
+    }
+
+    void paintView(QPainter &painter, const QRectF &paintRect)
+    {
+        KWCanvasBase::paint(painter, paintRect);
+    }
+};
+
+KWCanvasBenchmark::KWCanvasBenchmark()
+    : m_document(0)
+{
+}
+
+void KWCanvasBenchmark::initTestCase()
+{
+    QString odt = QString::fromLocal8Bit(qgetenv("KWCANVASBENCHMARK_ODT"));
+    if (odt.isEmpty()) {
+        odt = QString(FILES_DATA_DIR) + "/weekend-hike.odt";
+    }
+
+    m_document = new KWDocument(new MockPart);
+    QVERIFY(m_document->loadNativeFormat(odt));
+    QTRY_VERIFY_WITH_TIMEOUT(m_document->layoutFinishedAtleastOnce(), 10 * 60 * 1000);
+    qDebug() << odt << "has" << m_document->pageCount() << "pages";
+}
+
+void KWCanvasBenchmark::cleanupTestCase()
+{
+    delete m_document;
+}
+
+void KWCanvasBenchmark::benchmarkScrolling_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::addColumn<bool>("prerendered");
+
+    QTest::newRow("uncached") << false << false;
+    QTest::newRow("cached") << true << false;
+    QTest::newRow("cached and prerendered") << true << true;
+}
+
+void KWCanvasBenchmark::benchmarkScrolling()
+{
+    QFETCH(bool, cached);
+    QFETCH(bool, prerendered);
+
+    BenchmarkCanvas canvas(m_document);
+    canvas.setCacheEnabled(cached);
+    const QRectF viewRect(0, 0, VIEW_WIDTH, VIEW_HEIGHT);
+    const int contentsHeight = canvas.viewMode()->contentsSize().height();
+
+    QImage view(VIEW_WIDTH, VIEW_HEIGHT, QImage::Format_RGB32);
+    QElapsedTimer timer;
+    qint64 paintTime = 0;
+    int frames = 0;
+    for (int offset = 0; offset + VIEW_HEIGHT < contentsHeight; offset += SCROLL_STEP) {
+        canvas.setDocumentOffset(QPoint(0, offset));
+
+        // only the painting counts, prerendering happens while the user does not scroll
+        timer.start();
+        QPainter painter(&view);
+        canvas.paintView(painter, viewRect);
+        painter.end();
+        paintTime += timer.nsecsElapsed();
+        ++frames;
+
+        if (prerendered) {
+            for (int i = 0; i < IDLE_PRERENDER_CALLS && canvas.prerenderPages(viewRect); ++i) {
+            }
+        }
+    }
+    QVERIFY(frames > 0);
+
+    // the time it takes to paint one frame
+    QTest::setBenchmarkResult(qreal(paintTime) / frames / 1000000, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(KWCanvasBenchmark)
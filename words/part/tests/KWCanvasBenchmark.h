@@ -0,0 +1,50 @@
+/* This file is part of the KDE project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KWCANVASBENCHMARK_H
+#define KWCANVASBENCHMARK_H
+
+#include <QObject>
+
+class KWDocument;
+
+/**
+ * Measures how fast the canvas paints while scrolling through a document.
+ *
+ * The document is weekend-hike.odt, or the file the environment variable
+ * KWCANVASBENCHMARK_ODT points to; use a large document there to get
+ * meaningful numbers.
+ */
+class KWCanvasBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    KWCanvasBenchmark();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkScrolling_data();
+    void benchmarkScrolling();
+
+private:
+    KWDocument *m_document;
+};
+
+#endif // KWCANVASBENCHMARK_H